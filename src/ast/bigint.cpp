@@ -0,0 +1,391 @@
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <limits>
+
+#include "bigint.h"
+#include "../error.h"
+
+namespace {
+    using limb_t    = yasc::BigInt::limb_t;
+    using wide_t    = yasc::BigInt::wide_t;
+    using Magnitude = std::vector<limb_t>;
+
+    constexpr int limb_bits = 32;
+
+    void trim(Magnitude& mag) {
+        while(!mag.empty() && 0 == mag.back()) {
+            mag.pop_back();
+        }
+    }
+
+    int compare_magnitude(Magnitude const& lhs, Magnitude const& rhs) {
+        if(lhs.size() != rhs.size()) {
+            return (lhs.size() < rhs.size()) ? -1 : 1;
+        }
+        for(auto i = lhs.size(); i-- > 0;) {
+            if(lhs[i] != rhs[i]) {
+                return (lhs[i] < rhs[i]) ? -1 : 1;
+            }
+        }
+        return 0;
+    }
+
+    // acc += val << (shift limbs)
+    void add_into(Magnitude& acc, Magnitude const& val, std::size_t shift = 0) {
+        if(acc.size() < val.size() + shift) {
+            acc.resize(val.size() + shift, 0);
+        }
+        wide_t carry = 0;
+        auto i = std::size_t{0};
+        for(; i < val.size(); ++i) {
+            carry += wide_t{acc[i + shift]} + val[i];
+            acc[i + shift] = static_cast<limb_t>(carry);
+            carry >>= limb_bits;
+        }
+        for(i += shift; carry && i < acc.size(); ++i) {
+            carry += acc[i];
+            acc[i] = static_cast<limb_t>(carry);
+            carry >>= limb_bits;
+        }
+        if(carry) {
+            acc.push_back(static_cast<limb_t>(carry));
+        }
+    }
+
+    // acc -= val, which must not be larger than acc
+    void sub_from(Magnitude& acc, Magnitude const& val) {
+        std::int64_t borrow = 0;
+        for(auto i = std::size_t{0}; i < acc.size(); ++i) {
+            auto diff = std::int64_t{acc[i]} - borrow - ((i < val.size()) ? std::int64_t{val[i]} : 0);
+            borrow = (diff < 0) ? 1 : 0;
+            acc[i] = static_cast<limb_t>(diff + (borrow << limb_bits));
+            if(0 == borrow && i >= val.size()) {
+                break;
+            }
+        }
+        trim(acc);
+    }
+
+    Magnitude add(Magnitude const& lhs, Magnitude const& rhs) {
+        Magnitude sum{lhs};
+        add_into(sum, rhs);
+        return sum;
+    }
+
+    Magnitude schoolbook(limb_t const* lhs, std::size_t ln, limb_t const* rhs, std::size_t rn) {
+        Magnitude product(ln + rn, 0);
+        for(auto i = std::size_t{0}; i < ln; ++i) {
+            wide_t carry = 0;
+            for(auto j = std::size_t{0}; j < rn; ++j) {
+                carry += wide_t{lhs[i]} * rhs[j] + product[i + j];
+                product[i + j] = static_cast<limb_t>(carry);
+                carry >>= limb_bits;
+            }
+            product[i + rn] = static_cast<limb_t>(carry);
+        }
+        trim(product);
+        return product;
+    }
+
+    Magnitude slice(Magnitude const& mag, std::size_t from, std::size_t to) {
+        from = std::min(from, mag.size());
+        to   = std::min(to, mag.size());
+        Magnitude part(mag.begin() + from, mag.begin() + to);
+        trim(part);
+        return part;
+    }
+
+    Magnitude multiply(Magnitude const& lhs, Magnitude const& rhs) {
+        if(lhs.empty() || rhs.empty()) {
+            return {};
+        }
+        if(std::min(lhs.size(), rhs.size()) < yasc::BigInt::karatsuba_threshold) {
+            return schoolbook(lhs.data(), lhs.size(), rhs.data(), rhs.size());
+        }
+
+        // lhs = l1 B^m + l0, rhs = r1 B^m + r0, and
+        // lhs rhs = z2 B^2m + ((l0 + l1)(r0 + r1) - z2 - z0) B^m + z0
+        auto m  = std::max(lhs.size(), rhs.size()) / 2;
+        auto l0 = slice(lhs, 0, m), l1 = slice(lhs, m, lhs.size());
+        auto r0 = slice(rhs, 0, m), r1 = slice(rhs, m, rhs.size());
+
+        auto z0 = multiply(l0, r0);
+        auto z2 = multiply(l1, r1);
+        auto z1 = multiply(add(l0, l1), add(r0, r1));
+        sub_from(z1, z0);
+        sub_from(z1, z2);
+
+        Magnitude product{z0};
+        add_into(product, z1, m);
+        add_into(product, z2, 2 * m);
+        trim(product);
+        return product;
+    }
+
+    // divides in place by a single limb and returns the remainder
+    limb_t divide_small(Magnitude& mag, limb_t divisor) {
+        wide_t rem = 0;
+        for(auto i = mag.size(); i-- > 0;) {
+            auto cur = (rem << limb_bits) | mag[i];
+            mag[i] = static_cast<limb_t>(cur / divisor);
+            rem    = cur % divisor;
+        }
+        trim(mag);
+        return static_cast<limb_t>(rem);
+    }
+
+    // knuth's algorithm D (taocp 4.3.1), for divisors of two limbs or more
+    void divide_knuth(Magnitude const& u, Magnitude const& v, Magnitude& quot, Magnitude& rem) {
+        auto const n = v.size();
+        auto const m = u.size();
+        auto const s = __builtin_clz(v.back());
+
+        // normalize so the divisor's top limb has its high bit set
+        auto shl = [s] (limb_t hi, limb_t lo) -> limb_t {
+            return (0 == s) ? hi : static_cast<limb_t>((hi << s) | (lo >> (limb_bits - s)));
+        };
+        Magnitude vn(n), un(m + 1);
+        for(auto i = n - 1; i > 0; --i) {
+            vn[i] = shl(v[i], v[i - 1]);
+        }
+        vn[0] = static_cast<limb_t>(v[0] << s);
+        un[m] = (0 == s) ? 0 : static_cast<limb_t>(u[m - 1] >> (limb_bits - s));
+        for(auto i = m - 1; i > 0; --i) {
+            un[i] = shl(u[i], u[i - 1]);
+        }
+        un[0] = static_cast<limb_t>(u[0] << s);
+
+        constexpr wide_t base = wide_t{1} << limb_bits;
+        quot.assign(m - n + 1, 0);
+        for(auto j = m - n + 1; j-- > 0;) {
+            auto num  = (wide_t{un[j + n]} << limb_bits) | un[j + n - 1];
+            auto qhat = num / vn[n - 1];
+            auto rhat = num % vn[n - 1];
+            while(qhat >= base || qhat * vn[n - 2] > ((rhat << limb_bits) | un[j + n - 2])) {
+                --qhat;
+                rhat += vn[n - 1];
+                if(rhat >= base) {
+                    break;
+                }
+            }
+
+            // un[j..j+n] -= qhat * vn
+            std::int64_t borrow = 0, t = 0;
+            for(auto i = std::size_t{0}; i < n; ++i) {
+                auto p = qhat * vn[i];
+                t = std::int64_t{un[i + j]} - borrow - static_cast<std::int64_t>(p & 0xffffffffu);
+                un[i + j] = static_cast<limb_t>(t);
+                borrow = static_cast<std::int64_t>(p >> limb_bits) - (t >> limb_bits);
+            }
+            t = std::int64_t{un[j + n]} - borrow;
+            un[j + n] = static_cast<limb_t>(t);
+
+            quot[j] = static_cast<limb_t>(qhat);
+            if(t < 0) {
+                // qhat was one too large; add the divisor back
+                --quot[j];
+                wide_t carry = 0;
+                for(auto i = std::size_t{0}; i < n; ++i) {
+                    carry += wide_t{un[i + j]} + vn[i];
+                    un[i + j] = static_cast<limb_t>(carry);
+                    carry >>= limb_bits;
+                }
+                un[j + n] = static_cast<limb_t>(un[j + n] + carry);
+            }
+        }
+        trim(quot);
+
+        rem.resize(n);
+        for(auto i = std::size_t{0}; i < n; ++i) {
+            rem[i] = (0 == s) ? un[i] : static_cast<limb_t>((un[i] >> s) | (un[i + 1] << (limb_bits - s)));
+        }
+        trim(rem);
+    }
+}
+
+namespace yasc {
+    BigInt::BigInt(std::intmax_t val)
+        : negative_{val < 0}
+    {
+        // negate as unsigned, so the most negative value survives
+        auto mag = static_cast<std::uintmax_t>(val);
+        if(negative_) {
+            mag = ~mag + 1;
+        }
+        for(; 0 != mag; mag >>= limb_bits) {
+            mag_.push_back(static_cast<limb_t>(mag));
+        }
+    }
+
+    BigInt::BigInt(bool negative, Magnitude mag)
+        : negative_{negative}
+        , mag_{std::move(mag)}
+    {
+        trim(mag_);
+        negative_ = negative_ && !mag_.empty();
+    }
+
+    BigInt BigInt::parse(std::string_view digits) {
+        auto negative = false;
+        if(!digits.empty() && ('+' == digits[0] || '-' == digits[0])) {
+            negative = ('-' == digits[0]);
+            digits.remove_prefix(1);
+        }
+        if(digits.empty()) {
+            throw Error{"malformed integer"};
+        }
+
+        // nine decimal digits at a time still fit a limb
+        Magnitude mag;
+        while(!digits.empty()) {
+            auto len   = digits.size() - (digits.size() - 1) / 9 * 9;
+            auto chunk = limb_t{0};
+            auto scale = limb_t{1};
+            for(auto c : digits.substr(0, len)) {
+                if(!std::isdigit(static_cast<unsigned char>(c))) {
+                    throw Error{"malformed integer"};
+                }
+                chunk = chunk * 10 + static_cast<limb_t>(c - '0');
+                scale *= 10;
+            }
+            digits.remove_prefix(len);
+
+            wide_t carry = chunk;
+            for(auto& limb : mag) {
+                carry += wide_t{limb} * scale;
+                limb = static_cast<limb_t>(carry);
+                carry >>= limb_bits;
+            }
+            if(carry) {
+                mag.push_back(static_cast<limb_t>(carry));
+            }
+        }
+        return BigInt{negative, std::move(mag)};
+    }
+
+    bool BigInt::to_int(std::intmax_t& out) const {
+        static_assert(sizeof(std::intmax_t) <= 2 * sizeof(limb_t), "intmax_t wider than two limbs");
+        if(mag_.size() > 2) {
+            return false;
+        }
+        auto mag = std::uintmax_t{0};
+        for(auto i = mag_.size(); i-- > 0;) {
+            mag = (mag << limb_bits) | mag_[i];
+        }
+        auto const max = static_cast<std::uintmax_t>(std::numeric_limits<std::intmax_t>::max());
+        if(negative_) {
+            if(mag > max + 1) {
+                return false;
+            }
+            out = static_cast<std::intmax_t>(~mag + 1);
+        } else {
+            if(mag > max) {
+                return false;
+            }
+            out = static_cast<std::intmax_t>(mag);
+        }
+        return true;
+    }
+
+    double BigInt::to_double() const {
+        auto val = 0.0;
+        for(auto i = mag_.size(); i-- > 0;) {
+            val = std::ldexp(val, limb_bits) + mag_[i];
+        }
+        return negative_ ? -val : val;
+    }
+
+    std::string BigInt::to_string() const {
+        if(mag_.empty()) {
+            return "0";
+        }
+
+        // peel off nine decimal digits at a time, least significant first
+        std::vector<limb_t> chunks;
+        Magnitude mag{mag_};
+        while(!mag.empty()) {
+            chunks.push_back(divide_small(mag, 1000000000u));
+        }
+
+        std::string str = negative_ ? "-" : "";
+        str += std::to_string(chunks.back());
+        for(auto i = chunks.size() - 1; i-- > 0;) {
+            auto part = std::to_string(chunks[i]);
+            str.append(9 - part.size(), '0');
+            str += part;
+        }
+        return str;
+    }
+
+    BigInt BigInt::operator-() const {
+        return BigInt{!negative_, mag_};
+    }
+
+    BigInt operator+(BigInt const& lhs, BigInt const& rhs) {
+        if(lhs.negative_ == rhs.negative_) {
+            return BigInt{lhs.negative_, add(lhs.mag_, rhs.mag_)};
+        }
+        // opposite signs: the larger magnitude wins
+        if(compare_magnitude(lhs.mag_, rhs.mag_) >= 0) {
+            auto diff = lhs.mag_;
+            sub_from(diff, rhs.mag_);
+            return BigInt{lhs.negative_, std::move(diff)};
+        }
+        auto diff = rhs.mag_;
+        sub_from(diff, lhs.mag_);
+        return BigInt{rhs.negative_, std::move(diff)};
+    }
+
+    BigInt operator-(BigInt const& lhs, BigInt const& rhs) {
+        return lhs + (-rhs);
+    }
+
+    BigInt operator*(BigInt const& lhs, BigInt const& rhs) {
+        return BigInt{lhs.negative_ != rhs.negative_, multiply(lhs.mag_, rhs.mag_)};
+    }
+
+    void BigInt::divmod(BigInt const& lhs, BigInt const& rhs, BigInt& quot, BigInt& rem) {
+        if(rhs.mag_.empty()) {
+            throw Error{"division by zero"};
+        }
+
+        Magnitude q, r;
+        if(compare_magnitude(lhs.mag_, rhs.mag_) < 0) {
+            r = lhs.mag_;
+        } else if(1 == rhs.mag_.size()) {
+            // the common case of a small divisor needs no normalization
+            q = lhs.mag_;
+            auto small = divide_small(q, rhs.mag_[0]);
+            if(0 != small) {
+                r.push_back(small);
+            }
+        } else {
+            divide_knuth(lhs.mag_, rhs.mag_, q, r);
+        }
+
+        auto negative = lhs.negative_;
+        quot = BigInt{negative != rhs.negative_, std::move(q)};
+        rem  = BigInt{negative, std::move(r)};
+    }
+
+    BigInt operator/(BigInt const& lhs, BigInt const& rhs) {
+        BigInt quot, rem;
+        BigInt::divmod(lhs, rhs, quot, rem);
+        return quot;
+    }
+
+    BigInt operator%(BigInt const& lhs, BigInt const& rhs) {
+        BigInt quot, rem;
+        BigInt::divmod(lhs, rhs, quot, rem);
+        return rem;
+    }
+
+    int compare(BigInt const& lhs, BigInt const& rhs) {
+        if(lhs.sign() != rhs.sign()) {
+            return (lhs.sign() < rhs.sign()) ? -1 : 1;
+        }
+        auto mag = compare_magnitude(lhs.mag_, rhs.mag_);
+        return lhs.negative_ ? -mag : mag;
+    }
+};
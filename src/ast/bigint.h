@@ -0,0 +1,87 @@
+#ifndef __YASC_AST_BIGINT_H_
+#define __YASC_AST_BIGINT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace yasc {
+    // an arbitrary precision integer: a sign and a little-endian magnitude
+    // of 32 bit limbs, without leading zero limbs (so zero has none).
+    //
+    // exact integers only end up here once they overflow a fixnum; see
+    // number_traits<BigInt>, which turns results that fit back into one.
+    class BigInt {
+    public:
+        using limb_t = std::uint32_t;
+        using wide_t = std::uint64_t;
+
+        // operands of at least this many limbs are multiplied with
+        // karatsuba, smaller ones by the schoolbook method
+        static constexpr std::size_t karatsuba_threshold = 32;
+
+        BigInt() = default;
+
+        BigInt(std::intmax_t val);
+
+        // parses an optionally signed string of decimal digits. throws an
+        // Error for anything else.
+        static BigInt parse(std::string_view digits);
+
+        int sign() const {
+            return mag_.empty() ? 0 : (negative_ ? -1 : 1);
+        }
+
+        std::size_t limbs() const {
+            return mag_.size();
+        }
+
+        // stores the value in `out' if it fits
+        bool to_int(std::intmax_t& out) const;
+
+        double to_double() const;
+
+        std::string to_string() const;
+
+        BigInt operator-() const;
+
+        friend BigInt operator+(BigInt const& lhs, BigInt const& rhs);
+        friend BigInt operator-(BigInt const& lhs, BigInt const& rhs);
+        friend BigInt operator*(BigInt const& lhs, BigInt const& rhs);
+
+        // truncates towards zero, like the built in integers; the remainder
+        // takes the sign of the dividend. throws an Error when dividing by
+        // zero.
+        static void divmod(BigInt const& lhs, BigInt const& rhs, BigInt& quot, BigInt& rem);
+
+        friend BigInt operator/(BigInt const& lhs, BigInt const& rhs);
+        friend BigInt operator%(BigInt const& lhs, BigInt const& rhs);
+
+        // <0, 0 or >0 as lhs is less than, equal to or greater than rhs
+        friend int compare(BigInt const& lhs, BigInt const& rhs);
+
+        friend bool operator==(BigInt const& lhs, BigInt const& rhs) { return 0 == compare(lhs, rhs); }
+        friend bool operator!=(BigInt const& lhs, BigInt const& rhs) { return 0 != compare(lhs, rhs); }
+        friend bool operator< (BigInt const& lhs, BigInt const& rhs) { return compare(lhs, rhs) <  0; }
+        friend bool operator> (BigInt const& lhs, BigInt const& rhs) { return compare(lhs, rhs) >  0; }
+        friend bool operator<=(BigInt const& lhs, BigInt const& rhs) { return compare(lhs, rhs) <= 0; }
+        friend bool operator>=(BigInt const& lhs, BigInt const& rhs) { return compare(lhs, rhs) >= 0; }
+
+    private:
+        using Magnitude = std::vector<limb_t>;
+
+        BigInt(bool negative, Magnitude mag);
+
+        bool      negative_ = false;
+        Magnitude mag_;
+    };
+
+    inline std::ostream& operator<<(std::ostream& o, BigInt const& val) {
+        return o << val.to_string();
+    }
+} // end of namespace yasc
+
+#endif // __YASC_AST_BIGINT_H_
@@ -0,0 +1,193 @@
+#ifndef __YASC_AST_CHANNEL_H_
+#define __YASC_AST_CHANNEL_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "value.h"
+#include "object.h"
+#include "../error.h"
+#include "../gc/heap.h"
+
+namespace yasc {
+    // a bounded queue of messages between threads, and so between isolates
+    // (see isolate.h), which share no heap. a message is copied out of the
+    // sender's heap into a region of its own when it is sent, and moved
+    // from there into the receiver's heap when it is received.
+    //
+    // copies of a channel, such as the one a channel sent over another
+    // channel arrives as, are the same channel
+    class Channel : public Value {
+    public:
+        explicit Channel(std::size_t capacity)
+            : Value(Value::Type::Channel)
+            , queue_{std::make_shared<Queue>(capacity)}
+        {}
+
+        Channel(Channel const& rhs)
+            : Value(Value::Type::Channel)
+            , queue_{rhs.queue_}
+        {}
+
+        Channel(Channel&& rhs)
+            : Value(Value::Type::Channel)
+            , queue_{std::move(rhs.queue_)}
+        {}
+
+        std::size_t capacity() const {
+            return queue_->capacity;
+        }
+
+        // sends a copy of `msg', waiting while the channel is full. what
+        // is sent may not hold procedures other than the builtins: their
+        // code refers to the globals of the isolate that compiled them
+        void send(Object const& msg) {
+            auto packed = pack(msg);
+            std::unique_lock<std::mutex> guard{queue_->lock};
+            queue_->not_full.wait(guard, [&] {
+                return queue_->closed || queue_->messages.size() < queue_->capacity;
+            });
+            if(queue_->closed) {
+                throw Error{"channel-send: the channel is closed"};
+            }
+            queue_->messages.push_back(std::move(packed));
+            queue_->not_empty.notify_one();
+        }
+
+        // the oldest message, in the current heap, waiting while there is
+        // none. once the channel is closed and drained, throws
+        Object receive() {
+            Message msg;
+            {
+                std::unique_lock<std::mutex> guard{queue_->lock};
+                queue_->not_empty.wait(guard, [&] {
+                    return queue_->closed || !queue_->messages.empty();
+                });
+                if(queue_->messages.empty()) {
+                    throw Error{"channel-receive: the channel is closed"};
+                }
+                msg = take();
+            }
+            return unpack(msg);
+        }
+
+        // the oldest message, or the null Object rather than waiting
+        Object try_receive() {
+            Message msg;
+            {
+                std::lock_guard<std::mutex> guard{queue_->lock};
+                if(queue_->messages.empty()) {
+                    return Object{};
+                }
+                msg = take();
+            }
+            return unpack(msg);
+        }
+
+        // wakes everyone waiting. what was sent before can still be
+        // received, but nothing more can be sent
+        void close() {
+            std::lock_guard<std::mutex> guard{queue_->lock};
+            queue_->closed = true;
+            queue_->not_full.notify_all();
+            queue_->not_empty.notify_all();
+        }
+
+        bool closed() const {
+            std::lock_guard<std::mutex> guard{queue_->lock};
+            return queue_->closed;
+        }
+
+        std::ostream& print(std::ostream& o) const override {
+            return o << "[channel]";
+        }
+
+    private:
+        // a message and the region it was copied into; immediates and the
+        // builtins need none
+        struct Message {
+            std::unique_ptr<gc::Region> region;
+            Object value;
+        };
+
+        struct Queue {
+            explicit Queue(std::size_t capacity)
+                : capacity{capacity}
+            {}
+
+            std::size_t const capacity;
+            std::mutex lock;
+            std::condition_variable not_full;
+            std::condition_variable not_empty;
+            std::deque<Message> messages;
+            bool closed = false;
+        };
+
+        // rejects what cannot leave the isolate it belongs to
+        class Sendable : public gc::Tracer {
+        public:
+            void operator()(Object& slot) override {
+                if(!slot.is_heap() || !seen_.insert(slot.get()).second) {
+                    return;
+                }
+                if(Value::Type::Closure == slot.type() || Value::Type::Code == slot.type()) {
+                    throw Error{"channel-send: procedures cannot be sent"};
+                }
+                gray_.push_back(slot.get());
+            }
+
+            void drain() {
+                while(!gray_.empty()) {
+                    auto val = gray_.back();
+                    gray_.pop_back();
+                    val->trace(*this);
+                }
+            }
+
+        private:
+            std::unordered_set<Value const*> seen_;
+            std::vector<Value*> gray_;
+        };
+
+        static Message pack(Object const& msg) {
+            auto copy = msg;
+            Sendable check;
+            check(copy);
+            check.drain();
+
+            auto& heap = gc::current_heap();
+            auto region = std::make_unique<gc::Region>(std::size_t{1} << 10);
+            {
+                gc::RegionScope scope{*region, heap};
+                copy = heap.copy(msg);
+            }
+            if(!gc::Heap::in_region(copy)) {
+                region.reset();
+            }
+            return Message{std::move(region), copy};
+        }
+
+        static Object unpack(Message& msg) {
+            return (nullptr == msg.region) ? msg.value : gc::current_heap().escape(msg.value);
+        }
+
+        // the lock must be held
+        Message take() {
+            auto msg = std::move(queue_->messages.front());
+            queue_->messages.pop_front();
+            queue_->not_full.notify_one();
+            return msg;
+        }
+
+        std::shared_ptr<Queue> queue_;
+    };
+};
+
+#endif // __YASC_AST_CHANNEL_H_
@@ -6,40 +6,51 @@
 #include <iostream>
 
 #include "value.h"
+#include "object.h"
+#include "symbol.h"
+#include "../gc/heap.h"
 
 namespace yasc {
     class Identifier : public Value {
     public:
-        Identifier(std::string id, Value::Ptr val)
+        explicit Identifier(Symbol sym, Object val = Object{})
             : Value(Value::Type::Identifier)
-            , id_(std::move(id))
+            , sym_(std::move(sym))
             , val_(std::move(val))
         {}
 
-        std::string id() const {
-            return id_;
+        Symbol const& symbol() const {
+            return sym_;
         }
 
-        Value* val() {
-            return val_.get();
+        std::string const& id() const {
+            return sym_.name();
         }
 
-        bool operator==(std::string const& rhs) {
-            return id_ == rhs;
+        Object const& val() const {
+            return val_;
         }
 
-        bool operator==(Identifier const& rhs) {
-            return id_ == rhs.id();
+        bool operator==(Symbol const& rhs) const {
+            return sym_ == rhs;
+        }
+
+        bool operator==(Identifier const& rhs) const {
+            return sym_ == rhs.sym_;
         }
 
         std::ostream& print(std::ostream& o) const override {
-            o << id();
+            o << sym_;
             return o;
         }
 
+        void trace(gc::Tracer& t) override {
+            t(val_);
+        }
+
     private:
-        std::string id_;
-        Value::Ptr val_;
+        Symbol sym_;
+        Object val_;
     };
 } // end of namespace yasc
 
@@ -2,6 +2,9 @@
 #define __YASC_AST_LIST_H_
 
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
 #include <numeric>
 #include <memory>
 #include <iostream>
@@ -9,85 +12,136 @@
 #include <vector>
 
 #include "value.h"
+#include "object.h"
 #include "pair.h"
+#include "../gc/heap.h"
 
 namespace yasc {
     // r6rs: "Scheme also has a distinguished empty list, which is the last cdr
-    // in a chain of pairs that form a list"
-    class EmptyList : public Value {
+    // in a chain of pairs that form a list". it is an immediate, so there is
+    // exactly one of it and it never allocates.
+    inline Object get_empty_list() {
+        return Object::empty_list();
+    }
+
+    // a run of consecutive list elements, stored contiguously instead of one
+    // pair per element (cdr-coding). a list is a chain of these, all full but
+    // the last, so walking it touches one block of two cache lines per
+    // `capacity' elements instead of one pair per element.
+    class ListChunk : public Value {
     public:
-        EmptyList()
-            : Value(Value::Type::EmptyList)
+        static constexpr std::uint32_t capacity = 11;
+
+        ListChunk()
+            : Value{Value::Type::ListChunk}
+            , next_{}
+            , size_{0}
         {}
 
+        std::uint32_t size() const {
+            return size_;
+        }
+
+        bool full() const {
+            return capacity == size_;
+        }
+
+        Object const& operator[](std::uint32_t i) const {
+            return elems_[i];
+        }
+
+        // the next chunk, or nullptr for the last one
+        ListChunk* next() const {
+            return next_.is_null() ? nullptr : value_cast<ListChunk*>(next_);
+        }
+
+        // `owner' is the value that holds this chunk: the chunk itself, or
+        // the list it is embedded in
+        void push_back(Value* owner, Object val) {
+            assert(!full());
+            gc::write_barrier(owner, val);
+            elems_[size_++] = val;
+        }
+
+        void set_next(Value* owner, Object next) {
+            gc::write_barrier(owner, next);
+            next_ = next;
+        }
+
         std::ostream& print(std::ostream& o) const override {
-            o << "\\0";
+            o << "[chunk of " << size_ << "]";
             return o;
         }
+
+        void trace(gc::Tracer& t) override {
+            t(next_);
+            for(auto i = 0u; i < size_; ++i) {
+                t(elems_[i]);
+            }
+        }
+
+    private:
+        Object next_;
+        std::uint32_t size_;
+        Object elems_[capacity];
     };
 
-    inline std::shared_ptr<EmptyList> get_empty_list() {
-        return std::make_shared<EmptyList>();
-    }
+    static_assert(sizeof(ListChunk) == 128, "a chunk should fill two cache lines");
 
     namespace detail {
         // never checks for nullptr
         class ListIterator {
         public:
-            enum class Loc {
-                Car,
-                Cdr
-            };
+            using iterator_category = std::forward_iterator_tag;
+            using value_type        = Object;
+            using difference_type   = std::ptrdiff_t;
+            using pointer           = Object const*;
+            using reference         = Object const&;
 
             ListIterator()
-                : pair_{nullptr}
-                , loc_{Loc::Car}
+                : chunk_{nullptr}
+                , index_{0}
             {}
 
-            ListIterator(Pair* pair, Loc loc)
-                : pair_{pair}
-                , loc_{loc}
+            ListIterator(ListChunk const* chunk, std::uint32_t index)
+                : chunk_{chunk}
+                , index_{index}
             {}
 
             ListIterator(ListIterator const&) = default;
 
-            Value& operator*() const {
-                if(Loc::Car == loc_) {
-                    return *pair_->car();
-                } else {
-                    return *pair_->cdr();
-                }
+            Object const& operator*() const {
+                return (*chunk_)[index_];
             }
 
+            // only the last chunk has no successor, so the end of a full
+            // last chunk is the end of the list
             ListIterator& operator++() {
-                if(Loc::Car == loc_ && Value::Type::EmptyList == pair_->cdr()->type()) {
-                    loc_ = Loc::Cdr;
-                } else {
-                    pair_ = value_cast<Pair*>(pair_->cdr());
+                if(++index_ == ListChunk::capacity) {
+                    if(auto next = chunk_->next()) {
+                        chunk_ = next;
+                        index_ = 0;
+                    }
                 }
                 return *this;
             }
 
             ListIterator operator++(int) {
                 auto pre_inc = *this;
-                if(Loc::Car == loc_ && Value::Type::EmptyList == pair_->cdr()->type()) {
-                    loc_ = Loc::Cdr;
-                } else {
-                    pair_ = value_cast<Pair*>(pair_->cdr());
-                }
+                ++*this;
                 return pre_inc;
             }
 
             bool operator==(ListIterator const& rhs) const {
-                return (pair_ == rhs.pair_) && (loc_ == rhs.loc_);
+                return (chunk_ == rhs.chunk_) && (index_ == rhs.index_);
             }
             bool operator!=(ListIterator const& rhs) const {
                 return !(*this == rhs);
             };
 
         private:
-            Pair* pair_;
-            Loc loc_;
+            ListChunk const* chunk_;
+            std::uint32_t index_;
         };
     };
 
@@ -97,21 +151,23 @@ namespace yasc {
 
         List()
             : Value{Value::Type::List}
-            , head_{get_empty_list(), get_empty_list()}
-            , back_{&head_}
+            , tail_{}
+            , rest_{}
             , size_{0}
         {}
 
-        ~List() override = default;
-
-        void push_back(Value::Ptr val) {
-            if(size() == 0) {
-                head_.set_car(std::move(val));
-            } else {
-                assert(Value::Type::EmptyList == back_->cdr()->type());
-                back_->set_cdr(std::make_shared<Pair>(std::move(val), get_empty_list()));
-                back_ = value_cast<Pair*>(back_->cdr());
+        void push_back(Object val) {
+            // head_ is part of this value, so stores into it (and into
+            // tail_) have to go through our own barrier
+            auto tail = back();
+            if(tail->full()) {
+                auto chunk = make_object<ListChunk>();
+                tail->set_next(owner(tail), chunk);
+                gc::write_barrier(this, chunk);
+                tail_ = chunk;
+                tail = value_cast<ListChunk*>(chunk);
             }
+            tail->push_back(owner(tail), val);
             ++size_;
         }
 
@@ -119,49 +175,80 @@ namespace yasc {
             return size_;
         }
 
-        Value* car() {
-            return head_.car();
+        Object const& car() const {
+            static Object const empty = get_empty_list();
+            return (0 == size_) ? empty : head_[0];
         }
 
-        Value* cdr() {
-            return head_.cdr();
+        // all but the first element, as a chain of pairs: what cdr gives.
+        // it is made the first time it is asked for and then kept, so
+        // walking a list down with cdr makes one pair per element in all.
+        // the elements are shared, not converted. a list in a region cannot
+        // hold on to the heap, so it makes a new chain each time
+        Object rest() {
+            assert(size_ > 0);
+            if(!rest_.is_null()) {
+                return rest_;
+            }
+            std::vector<Object> elems(++begin(), end());
+            auto ret = get_empty_list();
+            for(auto i = elems.size(); i > 0; --i) {
+                ret = make_object<Pair>(elems[i - 1], ret);
+            }
+            if(!gc::Heap::in_region(Object{this})) {
+                gc::write_barrier(this, ret);
+                rest_ = ret;
+            }
+            return ret;
         }
 
         iterator begin() const {
-            return iterator{const_cast<Pair*>(&head_), iterator::Loc::Car};
+            return iterator{&head_, 0};
         }
 
         iterator end() const {
-            return iterator{back_, iterator::Loc::Cdr};
+            return iterator{back(), back()->size()};
         }
 
         std::ostream& print(std::ostream& o) const override {
-            o << "(";
-            for(auto& val : *this) {
-                o << val << " ";
-            }
-            o << ")";
-            return o;
+            return print_nested(o, *this);
+        }
+
+        void trace(gc::Tracer& t) override {
+            head_.trace(t);
+            t(tail_);
+            t(rest_);
         }
 
     private:
-        Pair head_;
-        Pair* back_;
+        ListChunk* back() const {
+            return tail_.is_null()
+                ? const_cast<ListChunk*>(&head_)
+                : value_cast<ListChunk*>(tail_);
+        }
+
+        Value* owner(ListChunk* chunk) {
+            return (&head_ == chunk) ? static_cast<Value*>(this) : chunk;
+        }
+
+        ListChunk head_;
+        Object tail_; // last chunk, or null while that is head_
+        Object rest_; // see rest(), null until asked for
         int size_;
     };
 
     namespace detail {
         template<class T>
-        std::shared_ptr<Pair> make_list_helper(T&& car) {
-             return std::make_shared<Pair>(
+        Object make_list_helper(T&& car) {
+             return make_object<Pair>(
                 std::forward<T>(car),
-                std::make_shared<EmptyList>()
+                get_empty_list()
             );
         }
 
         template<class T, class...Ts>
-        std::shared_ptr<Pair> make_list_helper(T&& car, Ts&&...cdr) {
-             return std::make_shared<Pair>(
+        Object make_list_helper(T&& car, Ts&&...cdr) {
+             return make_object<Pair>(
                 std::forward<T>(car),
                 make_list_helper<Ts...>(std::forward<Ts>(cdr)...)
             );
@@ -172,7 +259,7 @@ namespace yasc {
     Pair make_list(T&& car) {
         return Pair{
             std::forward<T>(car),
-            std::shared_ptr<EmptyList>(nullptr)
+            get_empty_list()
         };
     }
 
@@ -1,87 +1,90 @@
 #ifndef __YASC_AST_NUMBER_H_
 #define __YASC_AST_NUMBER_H_
 
+#include <charconv>
+#include <cmath>
 #include <memory>
-#include <numeric>
 #include <complex>
 #include <iostream>
+#include <string_view>
+#include <type_traits>
 
-namespace yasc {
-    template<typename T>
-    using fraction_t = std::pair<T, T>;
+#include "value.h"
+#include "object.h"
+#include "bigint.h"
+#include "ratio.h"
+#include "../gc/heap.h"
 
+namespace yasc {
     template<typename T>
-    std::ostream& operator<<(std::ostream& o, fraction_t<T> const& f) {
-        o << f.first << "/" << f.second;
+    constexpr NumberKind number_kind = NumberKind::Count;
+
+    template<> constexpr NumberKind number_kind<BigInt>               = NumberKind::Bignum;
+    template<> constexpr NumberKind number_kind<Ratio>                = NumberKind::Rational;
+    template<> constexpr NumberKind number_kind<double>               = NumberKind::Real;
+    template<> constexpr NumberKind number_kind<std::complex<double>> = NumberKind::Complex;
+
+    // the shortest text that reads back as the same double. it always has
+    // a `.' or an exponent, so it reads back inexact
+    inline std::ostream& print_real(std::ostream& o, double val) {
+        if(std::isnan(val)) {
+            return o << "+nan.0";
+        }
+        if(std::isinf(val)) {
+            return o << ((val < 0) ? "-inf.0" : "+inf.0");
+        }
+        char buf[32];
+        auto end = std::to_chars(buf, buf + sizeof(buf), val).ptr;
+        auto text = std::string_view{buf, static_cast<std::size_t>(end - buf)};
+        o << text;
+        if(std::string_view::npos == text.find_first_of(".e")) {
+            o << ".0";
+        }
         return o;
     }
 
-    template<typename T>
-    fraction_t<T> operator+(fraction_t<T> const& lhs, fraction_t<T> const& rhs) {
-        fraction_t<T> ret{};
-        if(lhs.second == rhs.second) {
-            ret.second = lhs.second;
-            ret.first = rhs.first + lhs.first;
-        } else {
-            ret.second = std::lcm(lhs.second, rhs.second);
-            ret.first  = (lhs.first * ret.second / lhs.second)
-                       + (rhs.first * ret.second / rhs.second);
-        }
-        return ret;
-    }
-
-    template<typename T>
-    fraction_t<T> operator-(fraction_t<T> const& f) {
-        fraction_t<T> ret{f};
-        ret.second *= -1;
-        return ret;
-    }
-
-    template<typename T>
-    fraction_t<T> operator-(fraction_t<T> const& lhs, fraction_t<T> const& rhs) {
-        return lhs + (-rhs);
-    }
-
-    template<typename T>
-    fraction_t<T> operator*(fraction_t<T> const& lhs, fraction_t<T> const& rhs) {
-        fraction_t<T> ret{lhs};
-        ret.first  *= rhs.first;
-        ret.second *= rhs.second;
-        return ret;
-    }
-
-    template<typename T>
-    fraction_t<T> operator/(fraction_t<T> const& lhs, fraction_t<T> const& rhs) {
-        fraction_t<T> ret{lhs};
-        ret.first  *= rhs.second;
-        ret.second *= rhs.first;
+    // as a+bi, the way the lexer reads it back
+    inline std::ostream& print_complex(std::ostream& o, std::complex<double> const& val) {
+        print_real(o, val.real());
+        // infinities and NaN carry their own sign
+        if(std::isfinite(val.imag()) && !std::signbit(val.imag())) {
+            o << '+';
+        }
+        return print_real(o, val.imag()) << 'i';
     }
 
     template<typename T>
     class Number : public Value {
     public:
-        using Ptr = std::shared_ptr<Number>;
+        using value_type = T;
+
+        static_assert(NumberKind::Count != number_kind<T>, "not a level of the numeric tower");
 
-        constexpr Number()
-            : Value(Value::Type::Number)
+        Number()
+            : Value(Value::Type::Number, static_cast<std::uint8_t>(number_kind<T>))
             , val_{}
         {}
 
-        constexpr explicit Number(T val)
-            : Value(Value::Type::Number)
-            , val_{val}
+        explicit Number(T val)
+            : Value(Value::Type::Number, static_cast<std::uint8_t>(number_kind<T>))
+            , val_{std::move(val)}
         {}
 
         Number(Number<T> const& num)
-            : Value(Value::Type::Number)
+            : Value(Value::Type::Number, static_cast<std::uint8_t>(number_kind<T>))
             , val_{num.get()}
         {}
 
+        Number(Number<T>&& num)
+            : Value(Value::Type::Number, static_cast<std::uint8_t>(number_kind<T>))
+            , val_{std::move(num.val_)}
+        {}
+
         void set(T val) {
-            val_ = val;
+            val_ = std::move(val);
         }
 
-        T get() const {
+        T const& get() const {
             return val_;
         }
 
@@ -94,18 +97,89 @@ namespace yasc {
         Number<T>& operator=(Number<T>&&) = default;
 
         std::ostream& print(std::ostream& o) const override {
-            o << get();
-            return o;
+            if constexpr(std::is_same_v<T, double>) {
+                return print_real(o, val_);
+            } else if constexpr(std::is_same_v<T, std::complex<double>>) {
+                return print_complex(o, val_);
+            } else {
+                return o << val_;
+            }
         }
 
     private:
         T val_;
     };
 
-    using Complex  = Number<std::complex<double>>;
-    using Real     = Number<double>;
-    using Rational = Number<fraction_t<int>>;
-    using Integer  = Number<int>;
+    // moves raw numbers in and out of Objects. anything that fits in a fixnum
+    // is stored inline, everything else is boxed in a heap Number<T>.
+    template<typename T>
+    struct number_traits {
+        static Object box(T val) {
+            return make_object<Number<T>>(val);
+        }
+
+        static T unbox(Object const& obj) {
+            return value_cast<Number<T>*>(obj)->get();
+        }
+    };
+
+    template<>
+    struct number_traits<std::intptr_t> {
+        static Object box(std::intptr_t val) {
+            return Object::fits_fixnum(val) ? Object::fixnum(val) : make_object<Bignum>(BigInt{val});
+        }
+
+        static std::intptr_t unbox(Object const& obj) {
+            return obj.as_fixnum();
+        }
+    };
+
+    // exact integers are only ever boxed while they do not fit a fixnum
+    template<>
+    struct number_traits<BigInt> {
+        static Object box(BigInt val) {
+            std::intmax_t small;
+            if(val.to_int(small) && Object::fits_fixnum(small)) {
+                return Object::fixnum(static_cast<std::intptr_t>(small));
+            }
+            return make_object<Bignum>(std::move(val));
+        }
+
+        static BigInt const& unbox(Object const& obj) {
+            return value_cast<Bignum*>(obj)->get();
+        }
+    };
+
+    // and ratios only while they are not integers
+    template<>
+    struct number_traits<Ratio> {
+        static Object box(Ratio val) {
+            std::intmax_t small;
+            if(val.to_int(small)) {
+                return number_traits<std::intptr_t>::box(static_cast<std::intptr_t>(small));
+            }
+            if(val.is_integer()) {
+                return number_traits<BigInt>::box(val.numerator());
+            }
+            return make_object<Rational>(std::move(val));
+        }
+
+        static Ratio const& unbox(Object const& obj) {
+            return value_cast<Rational*>(obj)->get();
+        }
+    };
+
+    // the level of the numeric tower `obj' is on, or Count if it is not a
+    // number
+    inline NumberKind number_kind_of(Object const& obj) {
+        if(obj.is_fixnum()) {
+            return NumberKind::Fixnum;
+        }
+        if(obj.is_heap() && Value::Type::Number == obj->type()) {
+            return static_cast<NumberKind>(obj->subtype());
+        }
+        return NumberKind::Count;
+    }
 } // end of namespace yasc
 
 #endif // __YASC_AST_NUMBER_H_
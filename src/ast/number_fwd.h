@@ -2,19 +2,32 @@
 #define __YASC_AST_NUMBER_FWD_
 
 #include <complex>
-#include <utility>
+#include <cstdint>
 
 namespace yasc {
-    template<typename T>
-    using fraction_t = std::pair<T, T>;
+    // the levels of the numeric tower, lowest first. an operation on two
+    // numbers is carried out at the higher of their levels. fixnums live
+    // inline in an Object; every other level is a heap Number<T>, which
+    // records its level as its subtype.
+    enum class NumberKind : std::uint8_t {
+        Fixnum,
+        Bignum,
+        Rational,
+        Real,
+        Complex,
+        Count
+    };
 
     template<typename T>
     class Number;
 
+    class BigInt;
+    class Ratio;
+
     using Complex  = Number<std::complex<double>>;
     using Real     = Number<double>;
-    using Rational = Number<fraction_t<int>>;
-    using Integer  = Number<int>;
+    using Rational = Number<Ratio>;
+    using Bignum   = Number<BigInt>;
 }
 
 
@@ -0,0 +1,231 @@
+#ifndef __YASC_AST_OBJECT_H_
+#define __YASC_AST_OBJECT_H_
+
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <type_traits>
+#include <utility>
+
+#include "value.h"
+
+namespace yasc {
+    // A single tagged machine word. Everything the evaluator passes around is
+    // an Object; only values that cannot be represented inline are boxed on
+    // the heap. The low bits select the representation:
+    //
+    //     ...xxxxxxx1   fixnum, the upper 63 bits are the (signed) integer
+    //     ...ttttt010   immediate constant, `t` selects which (see Immediate)
+    //     ...xxxxx000   pointer to a heap Value (all zero bits is `null')
+    //
+    // An Object is a plain word: copying one is free and it does not own
+    // what it points to. Heap values are kept alive by the tracing collector
+    // in gc/heap.h.
+    class Object {
+    public:
+        static constexpr int fixnum_bits = 8 * sizeof(std::intptr_t) - 1;
+        static constexpr std::intptr_t fixnum_max = (std::intptr_t{1} << (fixnum_bits - 1)) - 1;
+        static constexpr std::intptr_t fixnum_min = -fixnum_max - 1;
+
+        Object()
+            : bits_{0}
+        {}
+
+        Object(std::nullptr_t)
+            : bits_{0}
+        {}
+
+        explicit Object(Value* val)
+            : bits_{reinterpret_cast<std::uintptr_t>(val)}
+        {
+            assert(0 == (bits_ & tag_mask));
+        }
+
+        static Object fixnum(std::intptr_t val) {
+            return Object{(static_cast<std::uintptr_t>(val) << 1) | fixnum_tag, raw_tag{}};
+        }
+
+        static Object boolean(bool val) {
+            return immediate(val ? Immediate::True : Immediate::False);
+        }
+
+        static Object character(char32_t val) {
+            return Object{
+                (static_cast<std::uintptr_t>(val) << char_shift)
+                    | (static_cast<std::uintptr_t>(Immediate::Character) << immediate_shift)
+                    | immediate_tag,
+                raw_tag{}
+            };
+        }
+
+        static Object empty_list() {
+            return immediate(Immediate::EmptyList);
+        }
+
+        // the value of forms whose value r6rs leaves unspecified
+        static Object unspecified() {
+            return immediate(Immediate::Unspecified);
+        }
+
+        static constexpr bool fits_fixnum(std::intmax_t val) {
+            return fixnum_min <= val && val <= fixnum_max;
+        }
+
+        bool is_null() const {
+            return 0 == bits_;
+        }
+
+        explicit operator bool() const {
+            return !is_null();
+        }
+
+        bool is_fixnum() const {
+            return fixnum_tag == (bits_ & 1);
+        }
+
+        bool is_immediate() const {
+            return immediate_tag == (bits_ & tag_mask);
+        }
+
+        bool is_heap() const {
+            return 0 == (bits_ & tag_mask) && !is_null();
+        }
+
+        bool is_boolean() const {
+            return is_immediate()
+                && (Immediate::True == immediate_kind() || Immediate::False == immediate_kind());
+        }
+
+        bool is_character() const {
+            return is_immediate() && Immediate::Character == immediate_kind();
+        }
+
+        bool is_empty_list() const {
+            return bits_ == empty_list().bits_;
+        }
+
+        bool is_unspecified() const {
+            return bits_ == unspecified().bits_;
+        }
+
+        // everything but #f counts as true
+        bool is_true() const {
+            return bits_ != boolean(false).bits_;
+        }
+
+        std::intptr_t as_fixnum() const {
+            assert(is_fixnum());
+            return static_cast<std::intptr_t>(bits_) >> 1;
+        }
+
+        bool as_boolean() const {
+            assert(is_boolean());
+            return Immediate::True == immediate_kind();
+        }
+
+        char32_t as_character() const {
+            assert(is_character());
+            return static_cast<char32_t>(bits_ >> char_shift);
+        }
+
+        Value* get() const {
+            return is_heap() ? reinterpret_cast<Value*>(bits_) : nullptr;
+        }
+
+        Value& operator*() const {
+            assert(is_heap());
+            return *get();
+        }
+
+        Value* operator->() const {
+            assert(is_heap());
+            return get();
+        }
+
+        Value::Type type() const {
+            if(is_fixnum()) {
+                return Value::Type::Number;
+            }
+            if(is_heap()) {
+                return get()->type();
+            }
+            switch(immediate_kind()) {
+                case Immediate::EmptyList:   return Value::Type::EmptyList;
+                case Immediate::Character:   return Value::Type::Character;
+                case Immediate::Unspecified: return Value::Type::Unspecified;
+                default:                     return Value::Type::Boolean;
+            }
+        }
+
+        std::uintptr_t bits() const {
+            return bits_;
+        }
+
+        // identity, ie scheme's eq?
+        bool operator==(Object const& rhs) const {
+            return bits_ == rhs.bits_;
+        }
+
+        bool operator!=(Object const& rhs) const {
+            return bits_ != rhs.bits_;
+        }
+
+    private:
+        enum class Immediate : std::uintptr_t {
+            False,
+            True,
+            EmptyList,
+            Character,
+            Unspecified
+        };
+
+        static constexpr std::uintptr_t tag_mask        = 0b111;
+        static constexpr std::uintptr_t fixnum_tag      = 0b1;
+        static constexpr std::uintptr_t immediate_tag   = 0b010;
+        static constexpr int            immediate_shift = 3;
+        static constexpr int            char_shift      = 8;
+
+        struct raw_tag {};
+
+        Object(std::uintptr_t bits, raw_tag)
+            : bits_{bits}
+        {}
+
+        static Object immediate(Immediate kind) {
+            return Object{
+                (static_cast<std::uintptr_t>(kind) << immediate_shift) | immediate_tag,
+                raw_tag{}
+            };
+        }
+
+        Immediate immediate_kind() const {
+            return static_cast<Immediate>((bits_ & 0xff) >> immediate_shift);
+        }
+
+        std::uintptr_t bits_;
+    };
+
+    template<typename T>
+    T value_cast(Object const& obj) {
+        static_assert(std::is_pointer_v<T>, "only heap values can be cast out of an Object");
+        assert(obj.is_heap());
+        return value_cast<T>(obj.get());
+    }
+
+    inline std::ostream& operator<<(std::ostream& o, Object const& obj) {
+        if(obj.is_fixnum()) {
+            o << obj.as_fixnum();
+        } else if(obj.is_heap()) {
+            o << *obj;
+        } else if(obj.is_empty_list()) {
+            o << "()";
+        } else if(obj.is_boolean()) {
+            o << (obj.as_boolean() ? "#t" : "#f");
+        } else if(obj.is_character()) {
+            o << "#\\" << static_cast<char>(obj.as_character());
+        }
+        return o;
+    }
+}; // end of namespace yasc
+
+#endif // __YASC_AST_OBJECT_H_
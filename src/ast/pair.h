@@ -1,47 +1,57 @@
 #ifndef __YASC_AST_PAIR_H_
 #define __YASC_AST_PAIR_H_
 
+#include <iostream>
 #include <memory>
 
 #include "value.h"
+#include "object.h"
+#include "../gc/heap.h"
 
 namespace yasc {
+    // prints a List or a chain of pairs, however deeply nested, with a
+    // stack of its own rather than the native one (see print.cpp)
+    std::ostream& print_nested(std::ostream& o, Value const& val);
+
     class Pair : public Value {
     public:
-        template<typename CarT, typename CdrT> // must be moveable into Value
-        Pair(CarT&& car, CdrT&& cdr)
+        Pair(Object car, Object cdr)
             : Value(Value::Type::Pair)
             , car_{std::move(car)}
             , cdr_{std::move(cdr)}
         {}
 
-        ~Pair() override = default;
-
-        template<typename T>
-        void set_car(T&& car) {
-            car_ = std::move(car);
+        void set_car(Object car) {
+            gc::write_barrier(this, car);
+            car_ = car;
         }
 
-        template<typename T>
-        void set_cdr(T&& cdr) {
-            cdr_ = std::move(cdr);
+        void set_cdr(Object cdr) {
+            gc::write_barrier(this, cdr);
+            cdr_ = cdr;
         }
 
-        Value* car() const {
-            return car_.get();
+        Object const& car() const {
+            return car_;
         }
 
-        Value* cdr() const {
-            return cdr_.get();
+        Object const& cdr() const {
+            return cdr_;
         }
 
+        // a chain of pairs prints like the List it stands for, down to
+        // its last cdr when that is not the empty list
         std::ostream& print(std::ostream& o) const override {
-            o << "(" << *car() << ", " << *cdr() << ")";
-            return o;
+            return print_nested(o, *this);
+        }
+
+        void trace(gc::Tracer& t) override {
+            t(car_);
+            t(cdr_);
         }
     private:
-        Value::Ptr car_;
-        Value::Ptr cdr_;
+        Object car_;
+        Object cdr_;
     };
 };
 
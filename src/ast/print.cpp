@@ -0,0 +1,66 @@
+#include <vector>
+
+#include "value.h"
+#include "object.h"
+#include "pair.h"
+#include "list.h"
+
+namespace {
+    using namespace yasc;
+
+    // what is left to print, in reverse: a datum, or text around one
+    struct Item {
+        Object datum;
+        char const* text;
+    };
+
+    // queues the parts of the List or chain of pairs `val', as (a b c) or
+    // (a b . c)
+    void expand(Value const& val, std::vector<Item>& todo) {
+        std::vector<Item> parts;
+        parts.push_back({Object{}, "("});
+        if(Value::Type::List == val.type()) {
+            for(auto const& elem : static_cast<List const&>(val)) {
+                if(parts.size() > 1) {
+                    parts.push_back({Object{}, " "});
+                }
+                parts.push_back({elem, nullptr});
+            }
+        } else {
+            auto cur = &static_cast<Pair const&>(val);
+            for(;;) {
+                parts.push_back({cur->car(), nullptr});
+                if(Value::Type::Pair != cur->cdr().type()) {
+                    break;
+                }
+                parts.push_back({Object{}, " "});
+                cur = value_cast<Pair*>(cur->cdr());
+            }
+            if(!cur->cdr().is_empty_list()) {
+                parts.push_back({Object{}, " . "});
+                parts.push_back({cur->cdr(), nullptr});
+            }
+        }
+        parts.push_back({Object{}, ")"});
+        todo.insert(todo.end(), parts.rbegin(), parts.rend());
+    }
+}
+
+namespace yasc {
+    std::ostream& print_nested(std::ostream& o, Value const& val) {
+        std::vector<Item> todo;
+        expand(val, todo);
+        while(!todo.empty()) {
+            auto item = todo.back();
+            todo.pop_back();
+            if(nullptr != item.text) {
+                o << item.text;
+            } else if(item.datum.is_heap() && (Value::Type::List == item.datum.type() || Value::Type::Pair == item.datum.type())) {
+                expand(*item.datum, todo);
+            } else {
+                o << item.datum;
+            }
+        }
+        return o;
+    }
+};
@@ -1,34 +1,148 @@
 #ifndef __YASC_AST_PROCEDURE_H_
 #define __YASC_AST_PROCEDURE_H_
 
-#include <memory>
+#include <cstdint>
+#include <limits>
+#include <string>
 #include <vector>
-#include <functional>
 
 #include "value.h"
+#include "object.h"
+#include "../error.h"
+#include "../gc/heap.h"
+#include "../trace.h"
 #include "number.h"
 #include "pair.h"
 
 namespace yasc {
+    // the arguments of a primitive, `size' values laid out contiguously.
+    // when called from the VM they live on its stack, so they are only good
+    // until the primitive calls back into the VM.
+    class Args {
+    public:
+        Args(Object const* data, std::uint32_t size)
+            : data_{data}
+            , size_{size}
+        {}
+
+        Object const& operator[](std::uint32_t i) const {
+            return data_[i];
+        }
+
+        std::uint32_t size() const {
+            return size_;
+        }
+
+        Object const* begin() const {
+            return data_;
+        }
+
+        Object const* end() const {
+            return data_ + size_;
+        }
+
+    private:
+        Object const* data_;
+        std::uint32_t size_;
+    };
+
+    struct Arity {
+        static constexpr std::uint32_t variadic = std::numeric_limits<std::uint32_t>::max();
+
+        std::uint32_t min;
+        std::uint32_t max;
+
+        bool accepts(std::uint32_t argc) const {
+            return min <= argc && argc <= max;
+        }
+    };
+
+    // everything the VM needs to call a native procedure. primitives are
+    // described by a static Primitive each, and a Procedure pairs one with
+    // its closure data. the fixed arity entries are optional shortcuts that
+    // are taken instead of `call' when the argument count matches.
+    struct Primitive {
+        using Native  = Object (*)(Args args, void* data);
+        using Native0 = Object (*)(void* data);
+        using Native1 = Object (*)(Object const& a, void* data);
+        using Native2 = Object (*)(Object const& a, Object const& b, void* data);
+        using Native3 = Object (*)(Object const& a, Object const& b, Object const& c, void* data);
+
+        char const* name;
+        Arity       arity;
+        Native      call;
+        Native0     call0;
+        Native1     call1;
+        Native2     call2;
+        Native3     call3;
+    };
+
     class Procedure : public Value {
     public:
-        template<typename Callable>
-        explicit Procedure(Callable impl)
+        // a primitive written against the old convention, taking its
+        // arguments as a list
+        using ListNative = Object (*)(Object const& args);
+
+        // `data' is handed to the primitive untouched; the collector does
+        // not trace it
+        explicit Procedure(Primitive const& prim, void* data = nullptr)
             : Value(Value::Type::Procedure)
-            , impl_{impl}
+            , prim_{&prim}
+            , data_{data}
+        {}
+
+        explicit Procedure(ListNative impl)
+            : Procedure(list_adapter, reinterpret_cast<void*>(impl))
         {}
 
-        Value::Ptr apply(Value const& v) const {
-            return impl_(v);
+        Object call(Args args) const {
+            trace::Span span{prim_->name, "primitive"};
+            if(!prim_->arity.accepts(args.size())) {
+                throw Error{"wrong number of arguments to " + std::string{prim_->name}
+                    + ": got " + std::to_string(args.size())};
+            }
+            switch(args.size()) {
+                case 0: if(prim_->call0) return prim_->call0(data_);                            break;
+                case 1: if(prim_->call1) return prim_->call1(args[0], data_);                   break;
+                case 2: if(prim_->call2) return prim_->call2(args[0], args[1], data_);          break;
+                case 3: if(prim_->call3) return prim_->call3(args[0], args[1], args[2], data_); break;
+            }
+            return prim_->call(args, data_);
+        }
+
+        // calls with the arguments in a list
+        Object apply(Object const& list) const {
+            std::vector<Object> args;
+            for(auto cur = list; !cur.is_empty_list(); cur = value_cast<Pair*>(cur)->cdr()) {
+                args.push_back(value_cast<Pair*>(cur)->car());
+            }
+            return call(Args{args.data(), static_cast<std::uint32_t>(args.size())});
+        }
+
+        Primitive const& primitive() const {
+            return *prim_;
         }
 
         std::ostream& print(std::ostream& o) const override {
-            o << "[proc]";
+            o << "[proc " << prim_->name << "]";
             return o;
         }
 
     private:
-        std::function<Value::Ptr(Value const&)> const impl_;
+        static Object call_list(Args args, void* data) {
+            auto list = Object::empty_list();
+            for(auto i = args.size(); i > 0; --i) {
+                list = make_object<Pair>(args[i - 1], list);
+            }
+            return reinterpret_cast<ListNative>(data)(list);
+        }
+
+        static constexpr Primitive list_adapter = {
+            "list-primitive", {0, Arity::variadic}, call_list, nullptr, nullptr, nullptr, nullptr
+        };
+
+        Primitive const* prim_;
+        void* data_;
     };
 } // end of namespace yasc
 
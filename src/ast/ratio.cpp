@@ -0,0 +1,323 @@
+#include <algorithm>
+#include <cctype>
+#include <limits>
+
+#include "ratio.h"
+#include "../error.h"
+
+namespace {
+    using wide_t  = __int128;
+    using uwide_t = unsigned __int128;
+
+    bool fits_word(wide_t val) {
+        return std::numeric_limits<std::int64_t>::min() <= val && val <= std::numeric_limits<std::int64_t>::max();
+    }
+
+    // every canonical numerator and denominator of a word sized ratio, and
+    // their negations, fit here
+    std::uint64_t magnitude(wide_t val) {
+        return static_cast<std::uint64_t>(val < 0 ? -val : val);
+    }
+
+    // division is slow, the more so the wider it is, and on 128 bits a
+    // library call; it is skipped where it can be and otherwise done on the
+    // narrowest integers that hold the operands
+    wide_t divide(wide_t val, std::uint64_t by) {
+        if(1 == by) {
+            return val;
+        }
+        auto mag = static_cast<uwide_t>(val < 0 ? -val : val);
+        if(mag <= std::numeric_limits<std::uint32_t>::max() && by <= std::numeric_limits<std::uint32_t>::max()) {
+            auto quot = static_cast<std::uint32_t>(mag) / static_cast<std::uint32_t>(by);
+            return val < 0 ? -wide_t{quot} : wide_t{quot};
+        }
+        if(fits_word(val) && by <= static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max())) {
+            return static_cast<std::int64_t>(val) / static_cast<std::int64_t>(by);
+        }
+        return val / static_cast<wide_t>(by);
+    }
+
+    // stein's algorithm works on words, so a wider value is first reduced
+    // modulo the other one
+    std::uint64_t gcd(wide_t val, std::uint64_t other) {
+        auto mag = static_cast<uwide_t>(val < 0 ? -val : val);
+        if(mag >> 64) {
+            mag %= other;
+        }
+        return yasc::binary_gcd(static_cast<std::uint64_t>(mag), other);
+    }
+
+    yasc::BigInt to_big(wide_t val) {
+        auto mag = static_cast<uwide_t>(val < 0 ? -val : val);
+        auto const base = yasc::BigInt{std::intmax_t{1} << 32};
+        auto big = yasc::BigInt{};
+        for(auto shift = 96; shift >= 0; shift -= 32) {
+            big = big * base + yasc::BigInt{static_cast<std::intmax_t>((mag >> shift) & 0xffffffffu)};
+        }
+        return val < 0 ? -big : big;
+    }
+
+    // euclid's algorithm; the bignum division already works a limb at a
+    // time, which is what stein's algorithm would buy on words
+    yasc::BigInt gcd(yasc::BigInt a, yasc::BigInt b) {
+        if(a.sign() < 0) {
+            a = -a;
+        }
+        if(b.sign() < 0) {
+            b = -b;
+        }
+        while(0 != b.sign()) {
+            auto rem = a % b;
+            a = std::move(b);
+            b = std::move(rem);
+        }
+        return a;
+    }
+
+    bool is_digits(std::string_view text) {
+        return !text.empty() && std::all_of(text.begin(), text.end(), [] (char c) {
+            return std::isdigit(static_cast<unsigned char>(c));
+        });
+    }
+}
+
+namespace yasc {
+    Ratio::Ratio(std::intmax_t num, std::intmax_t den) {
+        if(0 == den) {
+            throw Error{"division by zero"};
+        }
+        auto n = wide_t{num};
+        auto d = wide_t{den};
+        if(d < 0) {
+            n = -n;
+            d = -d;
+        }
+        reduce(n, static_cast<std::uint64_t>(d));
+    }
+
+    Ratio::Ratio(BigInt const& num, BigInt const& den) {
+        reduce(num, den);
+    }
+
+    Ratio Ratio::parse(std::string_view text) {
+        auto slash = text.find('/');
+        auto num = text.substr(0, slash);
+        auto den = (std::string_view::npos == slash) ? std::string_view{"1"} : text.substr(slash + 1);
+        auto sign = (!num.empty() && ('+' == num[0] || '-' == num[0])) ? 1u : 0u;
+        if(!is_digits(num.substr(sign)) || !is_digits(den)) {
+            throw Error{"malformed rational"};
+        }
+        // eighteen digits always fit a word
+        if(num.size() - sign <= 18 && den.size() <= 18) {
+            return Ratio{std::stoll(std::string{num}), std::stoll(std::string{den})};
+        }
+        return Ratio{BigInt::parse(num), BigInt::parse(den)};
+    }
+
+    int Ratio::sign() const {
+        if(big_) {
+            return big_->num.sign();
+        }
+        return (num_ > 0) - (num_ < 0);
+    }
+
+    bool Ratio::is_integer() const {
+        return big_ ? BigInt{1} == big_->den : 1 == den_;
+    }
+
+    bool Ratio::to_int(std::intmax_t& out) const {
+        if(big_ || 1 != den_) {
+            return false;
+        }
+        out = num_;
+        return true;
+    }
+
+    BigInt Ratio::numerator() const {
+        return big_ ? big_->num : BigInt{num_};
+    }
+
+    BigInt Ratio::denominator() const {
+        return big_ ? big_->den : BigInt{den_};
+    }
+
+    double Ratio::to_double() const {
+        if(big_) {
+            return big_->num.to_double() / big_->den.to_double();
+        }
+        return static_cast<double>(num_) / static_cast<double>(den_);
+    }
+
+    std::string Ratio::to_string() const {
+        if(is_integer()) {
+            return numerator().to_string();
+        }
+        return numerator().to_string() + "/" + denominator().to_string();
+    }
+
+    void Ratio::assign(wide_t num, wide_t den) {
+        if(fits_word(num) && fits_word(den)) {
+            num_ = static_cast<std::int64_t>(num);
+            den_ = static_cast<std::int64_t>(den);
+        } else {
+            big_ = std::make_shared<Big const>(Big{to_big(num), to_big(den)});
+        }
+    }
+
+    void Ratio::assign(BigInt num, BigInt den) {
+        std::intmax_t n, d;
+        if(num.to_int(n) && den.to_int(d)) {
+            num_ = n;
+            den_ = d;
+        } else {
+            big_ = std::make_shared<Big const>(Big{std::move(num), std::move(den)});
+        }
+    }
+
+    void Ratio::reduce(wide_t num, std::uint64_t den) {
+        auto g = (1 == den) ? 1 : gcd(num, den);
+        if(1 == g) {
+            assign(num, den);
+        } else {
+            assign(divide(num, g), divide(den, g));
+        }
+    }
+
+    // all values here are at most 2^63 in magnitude, so no product or sum of
+    // two products leaves 128 bits. the general case is knuth's: with
+    // g = gcd(b, d), the sum a/b + c/d is t / (b/g * d) for
+    // t = a * d/g + c * b/g, and only g can still share factors with t.
+    void Ratio::add(wide_t a, wide_t b, wide_t c, wide_t d) {
+        if(b == d) {
+            reduce(a + c, static_cast<std::uint64_t>(b));
+            return;
+        }
+        auto ub = static_cast<std::uint64_t>(b);
+        auto ud = static_cast<std::uint64_t>(d);
+        auto g = binary_gcd(ub, ud);
+        if(1 == g) {
+            assign(a * d + c * b, b * d);
+            return;
+        }
+        auto t = a * divide(ud, g) + c * divide(ub, g);
+        auto g2 = gcd(t, g);
+        assign(divide(t, g2), divide(ub, g) * divide(ud, g2));
+    }
+
+    // cancelling across before multiplying leaves the product canonical
+    void Ratio::mul(wide_t a, wide_t b, wide_t c, wide_t d) {
+        if(0 == a || 0 == c) {
+            return;
+        }
+        if(1 == b && 1 == d) {
+            assign(a * c, 1);
+            return;
+        }
+        auto g1 = binary_gcd(magnitude(a), static_cast<std::uint64_t>(d));
+        auto g2 = binary_gcd(magnitude(c), static_cast<std::uint64_t>(b));
+        assign(divide(a, g1) * divide(c, g2), divide(b, g2) * divide(d, g1));
+    }
+
+    void Ratio::reduce(BigInt num, BigInt den) {
+        if(0 == den.sign()) {
+            throw Error{"division by zero"};
+        }
+        if(den.sign() < 0) {
+            num = -num;
+            den = -den;
+        }
+        auto g = gcd(num, den);
+        if(BigInt{1} != g) {
+            num = num / g;
+            den = den / g;
+        }
+        assign(std::move(num), std::move(den));
+    }
+
+    void Ratio::add(Ratio const& lhs, Ratio const& rhs, bool negate) {
+        auto a = lhs.numerator(), b = lhs.denominator();
+        auto c = rhs.numerator(), d = rhs.denominator();
+        if(negate) {
+            c = -c;
+        }
+        if(b == d) {
+            reduce(a + c, std::move(b));
+        } else {
+            reduce(a * d + c * b, b * d);
+        }
+    }
+
+    void Ratio::mul(Ratio const& lhs, Ratio const& rhs, bool invert) {
+        auto a = lhs.numerator(), b = lhs.denominator();
+        auto c = rhs.numerator(), d = rhs.denominator();
+        if(invert) {
+            std::swap(c, d);
+        }
+        reduce(a * c, b * d);
+    }
+
+    Ratio Ratio::operator-() const {
+        Ratio ret;
+        if(big_) {
+            ret.big_ = std::make_shared<Big const>(Big{-big_->num, big_->den});
+        } else {
+            ret.assign(-wide_t{num_}, den_);
+        }
+        return ret;
+    }
+
+    Ratio operator+(Ratio const& lhs, Ratio const& rhs) {
+        Ratio ret;
+        if(lhs.big_ || rhs.big_) {
+            ret.add(lhs, rhs, false);
+        } else {
+            ret.add(lhs.num_, lhs.den_, rhs.num_, rhs.den_);
+        }
+        return ret;
+    }
+
+    Ratio operator-(Ratio const& lhs, Ratio const& rhs) {
+        Ratio ret;
+        if(lhs.big_ || rhs.big_) {
+            ret.add(lhs, rhs, true);
+        } else {
+            ret.add(lhs.num_, lhs.den_, -Ratio::wide_t{rhs.num_}, rhs.den_);
+        }
+        return ret;
+    }
+
+    Ratio operator*(Ratio const& lhs, Ratio const& rhs) {
+        Ratio ret;
+        if(lhs.big_ || rhs.big_) {
+            ret.mul(lhs, rhs, false);
+        } else {
+            ret.mul(lhs.num_, lhs.den_, rhs.num_, rhs.den_);
+        }
+        return ret;
+    }
+
+    Ratio operator/(Ratio const& lhs, Ratio const& rhs) {
+        if(0 == rhs.sign()) {
+            throw Error{"division by zero"};
+        }
+        Ratio ret;
+        if(lhs.big_ || rhs.big_) {
+            ret.mul(lhs, rhs, true);
+        } else if(rhs.num_ < 0) {
+            // multiply by the reciprocal, keeping its denominator positive
+            ret.mul(lhs.num_, lhs.den_, -Ratio::wide_t{rhs.den_}, -Ratio::wide_t{rhs.num_});
+        } else {
+            ret.mul(lhs.num_, lhs.den_, rhs.den_, rhs.num_);
+        }
+        return ret;
+    }
+
+    int compare(Ratio const& lhs, Ratio const& rhs) {
+        if(lhs.big_ || rhs.big_) {
+            return compare(lhs.numerator() * rhs.denominator(), rhs.numerator() * lhs.denominator());
+        }
+        auto l = Ratio::wide_t{lhs.num_} * rhs.den_;
+        auto r = Ratio::wide_t{rhs.num_} * lhs.den_;
+        return (l > r) - (l < r);
+    }
+};
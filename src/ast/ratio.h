@@ -0,0 +1,125 @@
+#ifndef __YASC_AST_RATIO_H_
+#define __YASC_AST_RATIO_H_
+
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "bigint.h"
+
+namespace yasc {
+    // the greatest common divisor by stein's algorithm, which gets by with
+    // shifts and subtractions where euclid's needs a division per step
+    inline std::uint64_t binary_gcd(std::uint64_t a, std::uint64_t b) {
+        if(0 == a) {
+            return b;
+        }
+        if(0 == b) {
+            return a;
+        }
+        auto shift = __builtin_ctzll(a | b);
+        a >>= __builtin_ctzll(a);
+        do {
+            b >>= __builtin_ctzll(b);
+            if(a > b) {
+                std::swap(a, b);
+            }
+            b -= a;
+        } while(0 != b);
+        return a << shift;
+    }
+
+    // an exact rational number, always in canonical form: the denominator
+    // is positive and shares no factor with the numerator, so zero is 0/1
+    // and equal values have equal representations.
+    //
+    // numerator and denominator are machine words as long as they fit, and
+    // operations on those compute their intermediates in 128 bits, which
+    // cannot overflow; only results that do not fit back are kept as a pair
+    // of bignums.
+    class Ratio {
+    public:
+        Ratio() = default;
+
+        // throws an Error when `den' is zero
+        Ratio(std::intmax_t num, std::intmax_t den = 1);
+
+        Ratio(BigInt const& num, BigInt const& den = BigInt{1});
+
+        // parses `n/d', each side a string of decimal digits and the
+        // numerator optionally signed. throws an Error for anything else.
+        static Ratio parse(std::string_view text);
+
+        int sign() const;
+
+        bool is_integer() const;
+
+        // stores the value in `out' if it is an integer and fits
+        bool to_int(std::intmax_t& out) const;
+
+        BigInt numerator() const;
+        BigInt denominator() const;
+
+        double to_double() const;
+
+        std::string to_string() const;
+
+        Ratio operator-() const;
+
+        friend Ratio operator+(Ratio const& lhs, Ratio const& rhs);
+        friend Ratio operator-(Ratio const& lhs, Ratio const& rhs);
+        friend Ratio operator*(Ratio const& lhs, Ratio const& rhs);
+
+        // throws an Error when dividing by zero
+        friend Ratio operator/(Ratio const& lhs, Ratio const& rhs);
+
+        // <0, 0 or >0 as lhs is less than, equal to or greater than rhs
+        friend int compare(Ratio const& lhs, Ratio const& rhs);
+
+        friend bool operator==(Ratio const& lhs, Ratio const& rhs) { return 0 == compare(lhs, rhs); }
+        friend bool operator!=(Ratio const& lhs, Ratio const& rhs) { return 0 != compare(lhs, rhs); }
+        friend bool operator< (Ratio const& lhs, Ratio const& rhs) { return compare(lhs, rhs) <  0; }
+        friend bool operator> (Ratio const& lhs, Ratio const& rhs) { return compare(lhs, rhs) >  0; }
+        friend bool operator<=(Ratio const& lhs, Ratio const& rhs) { return compare(lhs, rhs) <= 0; }
+        friend bool operator>=(Ratio const& lhs, Ratio const& rhs) { return compare(lhs, rhs) >= 0; }
+
+    private:
+        using wide_t = __int128;
+
+        // the bignum form, shared between copies as it is never modified
+        struct Big {
+            BigInt num;
+            BigInt den;
+        };
+
+        // the helpers below fill in a Ratio that is still zero, so results
+        // are built in place instead of being moved out of temporaries.
+        //
+        // from a canonical pair that may not fit a word
+        void assign(wide_t num, wide_t den);
+
+        // from a canonical pair of bignums, which may fit words again
+        void assign(BigInt num, BigInt den);
+
+        void reduce(wide_t num, std::uint64_t den);
+        void add(wide_t a, wide_t b, wide_t c, wide_t d);
+        void mul(wide_t a, wide_t b, wide_t c, wide_t d);
+
+        void reduce(BigInt num, BigInt den);
+        void add(Ratio const& lhs, Ratio const& rhs, bool negate);
+        void mul(Ratio const& lhs, Ratio const& rhs, bool invert);
+
+        std::int64_t num_ = 0;
+        std::int64_t den_ = 1;
+        std::shared_ptr<Big const> big_;
+    };
+
+    inline std::ostream& operator<<(std::ostream& o, Ratio const& val) {
+        return o << val.to_string();
+    }
+} // end of namespace yasc
+
+#endif // __YASC_AST_RATIO_H_
@@ -0,0 +1,194 @@
+#include <algorithm>
+#include <memory>
+#include <thread>
+
+#include "symbol.h"
+
+namespace yasc {
+    struct SymbolTable::Buckets {
+        explicit Buckets(std::size_t capacity)
+            : mask{capacity - 1}
+            , slots{new std::atomic<Symbol::Entry*>[capacity]}
+        {
+            for(std::size_t i = 0; i < capacity; ++i) {
+                slots[i].store(nullptr, std::memory_order_relaxed);
+            }
+        }
+
+        std::size_t capacity() const {
+            return mask + 1;
+        }
+
+        std::size_t mask;
+        std::unique_ptr<std::atomic<Symbol::Entry*>[]> slots;
+    };
+
+    // a thread that looks names up. it is active for as long as it may hold
+    // an entry or buckets it has not retained
+    struct SymbolTable::Reader {
+        explicit Reader(SymbolTable& table)
+            : table{table}
+        {
+            std::lock_guard<std::mutex> lock{table.readers_mutex_};
+            table.readers_.push_back(this);
+        }
+
+        ~Reader() {
+            std::lock_guard<std::mutex> lock{table.readers_mutex_};
+            table.readers_.erase(std::find(table.readers_.begin(), table.readers_.end(), this));
+        }
+
+        SymbolTable& table;
+        std::atomic<bool> active{false};
+    };
+
+    Symbol::Entry SymbolTable::tombstone_;
+
+    SymbolTable::SymbolTable()
+        : buckets_{new Buckets{16}}
+    {}
+
+    SymbolTable::~SymbolTable() {
+        auto buckets = buckets_.load(std::memory_order_relaxed);
+        for(std::size_t i = 0; i < buckets->capacity(); ++i) {
+            auto entry = buckets->slots[i].load(std::memory_order_relaxed);
+            if(nullptr != entry && &tombstone_ != entry) {
+                delete entry;
+            }
+        }
+        delete buckets;
+    }
+
+    Symbol SymbolTable::intern(std::string_view name) {
+        auto hash = std::hash<std::string_view>{}(name);
+        // the loads below are ordered after this store, and the unlinking
+        // in collect() and grow() before their check of it, so either they
+        // wait for this lookup or it never sees what they free
+        auto& self = reader();
+        self.active.store(true);
+        auto entry = find(*buckets_.load(), name, hash);
+        auto found = nullptr != entry && retain(entry);
+        self.active.store(false, std::memory_order_release);
+        if(found) {
+            return Symbol{entry, Symbol::Adopt{}};
+        }
+        return add(name, hash);
+    }
+
+    std::size_t SymbolTable::collect() {
+        std::lock_guard<std::mutex> lock{mutex_};
+        auto& buckets = *buckets_.load(std::memory_order_relaxed);
+        std::vector<Symbol::Entry*> dropped;
+        for(std::size_t i = 0; i < buckets.capacity(); ++i) {
+            auto entry = buckets.slots[i].load(std::memory_order_relaxed);
+            if(nullptr == entry || &tombstone_ == entry) {
+                continue;
+            }
+            // a lookup that found it first keeps it
+            auto refs = std::size_t{0};
+            if(entry->refs.compare_exchange_strong(refs, Symbol::Entry::dead, std::memory_order_acquire)) {
+                buckets.slots[i].store(&tombstone_);
+                dropped.push_back(entry);
+            }
+        }
+        size_ -= dropped.size();
+        if(!dropped.empty()) {
+            synchronize();
+        }
+        for(auto entry : dropped) {
+            delete entry;
+        }
+        return dropped.size();
+    }
+
+    Symbol::Entry* SymbolTable::find(Buckets const& buckets, std::string_view name, std::size_t hash) {
+        for(auto i = hash & buckets.mask;; i = (i + 1) & buckets.mask) {
+            auto entry = buckets.slots[i].load();
+            if(nullptr == entry) {
+                return nullptr;
+            }
+            if(&tombstone_ != entry && hash == entry->hash && name == entry->name) {
+                return entry;
+            }
+        }
+    }
+
+    bool SymbolTable::retain(Symbol::Entry* entry) {
+        auto refs = entry->refs.load(std::memory_order_relaxed);
+        do {
+            if(Symbol::Entry::dead == refs) {
+                return false;
+            }
+        } while(!entry->refs.compare_exchange_weak(refs, refs + 1, std::memory_order_relaxed));
+        return true;
+    }
+
+    Symbol SymbolTable::add(std::string_view name, std::size_t hash) {
+        std::lock_guard<std::mutex> lock{mutex_};
+        // another thread may have added it since, or collect() dropped what
+        // the lookup found
+        if(auto entry = find(*buckets_.load(std::memory_order_relaxed), name, hash)) {
+            return Symbol{entry};
+        }
+        // at most half full, so that every probe ends at an empty slot
+        if(2 * (used_ + 1) > buckets_.load(std::memory_order_relaxed)->capacity()) {
+            grow();
+        }
+
+        auto entry = new Symbol::Entry{};
+        entry->name = std::string{name};
+        entry->hash = hash;
+        auto& buckets = *buckets_.load(std::memory_order_relaxed);
+        auto i = hash & buckets.mask;
+        for(auto slot = buckets.slots[i].load(std::memory_order_relaxed);
+            nullptr != slot && &tombstone_ != slot;
+            slot = buckets.slots[i].load(std::memory_order_relaxed)) {
+            i = (i + 1) & buckets.mask;
+        }
+        if(nullptr == buckets.slots[i].load(std::memory_order_relaxed)) {
+            ++used_;
+        }
+        ++size_;
+        Symbol sym{entry};
+        buckets.slots[i].store(entry);
+        return sym;
+    }
+
+    void SymbolTable::grow() {
+        auto old = buckets_.load(std::memory_order_relaxed);
+        auto capacity = std::size_t{16};
+        while(capacity < 4 * (size_ + 1)) {
+            capacity *= 2;
+        }
+        auto buckets = new Buckets{capacity};
+        for(std::size_t i = 0; i < old->capacity(); ++i) {
+            auto entry = old->slots[i].load(std::memory_order_relaxed);
+            if(nullptr == entry || &tombstone_ == entry) {
+                continue;
+            }
+            auto j = entry->hash & buckets->mask;
+            while(nullptr != buckets->slots[j].load(std::memory_order_relaxed)) {
+                j = (j + 1) & buckets->mask;
+            }
+            buckets->slots[j].store(entry, std::memory_order_relaxed);
+        }
+        used_ = size_;
+        buckets_.store(buckets);
+        synchronize();
+        delete old;
+    }
+
+    SymbolTable::Reader& SymbolTable::reader() {
+        thread_local Reader self{*this};
+        return self;
+    }
+
+    void SymbolTable::synchronize() {
+        std::lock_guard<std::mutex> lock{readers_mutex_};
+        for(auto other : readers_) {
+            while(other->active.load()) {
+                std::this_thread::yield();
+            }
+        }
+    }
+};
@@ -0,0 +1,185 @@
+#ifndef __YASC_AST_SYMBOL_H_
+#define __YASC_AST_SYMBOL_H_
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace yasc {
+    class SymbolTable;
+
+    // a handle to an interned name. there is only ever one entry per name,
+    // so two symbols are equal exactly when they point at the same entry,
+    // and the hash is computed once when the name is interned.
+    class Symbol {
+    public:
+        Symbol() = default;
+
+        Symbol(Symbol const& rhs)
+            : entry_{rhs.entry_}
+        {
+            retain();
+        }
+
+        Symbol(Symbol&& rhs) noexcept
+            : entry_{rhs.entry_}
+        {
+            rhs.entry_ = nullptr;
+        }
+
+        Symbol& operator=(Symbol rhs) noexcept {
+            std::swap(entry_, rhs.entry_);
+            return *this;
+        }
+
+        ~Symbol() {
+            // released, so the entry is done with before collect frees it
+            if(nullptr != entry_) {
+                entry_->refs.fetch_sub(1, std::memory_order_release);
+            }
+        }
+
+        // interns `name' in the process wide table
+        static Symbol intern(std::string_view name);
+
+        std::string const& name() const {
+            return entry_->name;
+        }
+
+        std::size_t hash() const {
+            return entry_->hash;
+        }
+
+        bool operator==(Symbol const& rhs) const {
+            return entry_ == rhs.entry_;
+        }
+
+        bool operator!=(Symbol const& rhs) const {
+            return entry_ != rhs.entry_;
+        }
+
+        explicit operator bool() const {
+            return nullptr != entry_;
+        }
+
+    private:
+        friend class SymbolTable;
+
+        struct Entry {
+            // the count of an entry SymbolTable::collect dropped
+            static constexpr std::size_t dead = std::numeric_limits<std::size_t>::max();
+
+            std::string name;
+            std::size_t hash;
+            // live handles; an entry nobody holds may be dropped by
+            // SymbolTable::collect
+            std::atomic<std::size_t> refs{0};
+        };
+
+        // for an entry whose count was already raised for this handle
+        struct Adopt {};
+
+        explicit Symbol(Entry* entry)
+            : entry_{entry}
+        {
+            retain();
+        }
+
+        Symbol(Entry* entry, Adopt)
+            : entry_{entry}
+        {}
+
+        void retain() {
+            if(nullptr != entry_) {
+                entry_->refs.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        Entry* entry_ = nullptr;
+    };
+
+    inline std::ostream& operator<<(std::ostream& o, Symbol const& sym) {
+        return o << sym.name();
+    }
+
+    class SymbolTable {
+    public:
+        static SymbolTable& global() {
+            static SymbolTable table;
+            return table;
+        }
+
+        ~SymbolTable();
+
+        SymbolTable(SymbolTable const&) = delete;
+        SymbolTable& operator=(SymbolTable const&) = delete;
+
+        // looks `name' up without copying it, and only allocates the first
+        // time a name is seen. the table is shared by every thread (and
+        // every isolate), which mostly look up names they have seen before:
+        // those lookups take no lock, and write nothing shared but the
+        // count of the symbol found. only adding a name takes the lock
+        Symbol intern(std::string_view name);
+
+        // drops every symbol no handle refers to any more, and returns how
+        // many were dropped. symbols are otherwise never freed.
+        std::size_t collect();
+
+        std::size_t size() const {
+            std::lock_guard<std::mutex> lock{mutex_};
+            return size_;
+        }
+
+    private:
+        struct Buckets;
+        struct Reader;
+
+        SymbolTable();
+
+        // marks the slot of a dropped entry
+        static Symbol::Entry tombstone_;
+
+        static Symbol::Entry* find(Buckets const& buckets, std::string_view name, std::size_t hash);
+        static bool retain(Symbol::Entry* entry);
+
+        Symbol add(std::string_view name, std::size_t hash);
+        void grow();
+        Reader& reader();
+        // waits until no lookup that started before it is still running,
+        // after which what they might have seen can be freed
+        void synchronize();
+
+        // held to add, drop or move entries; never by a lookup that hits
+        mutable std::mutex mutex_;
+        // open addressed, so a lookup follows nothing but atomic pointers.
+        // a dropped entry leaves a tombstone behind until the next grow()
+        std::atomic<Buckets*> buckets_;
+        std::size_t size_ = 0;
+        // entries and tombstones
+        std::size_t used_ = 0;
+
+        std::mutex readers_mutex_;
+        std::vector<Reader*> readers_;
+    };
+
+    inline Symbol Symbol::intern(std::string_view name) {
+        return SymbolTable::global().intern(name);
+    }
+} // end of namespace yasc
+
+namespace std {
+    template<>
+    struct hash<yasc::Symbol> {
+        std::size_t operator()(yasc::Symbol const& sym) const {
+            return sym.hash();
+        }
+    };
+}
+
+#endif // __YASC_AST_SYMBOL_H_
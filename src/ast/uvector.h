@@ -0,0 +1,110 @@
+#ifndef __YASC_AST_UVECTOR_H_
+#define __YASC_AST_UVECTOR_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <type_traits>
+#include <vector>
+
+#include "value.h"
+#include "object.h"
+#include "number.h"
+
+namespace yasc {
+    template<typename T>
+    constexpr VectorKind vector_kind = VectorKind::Count;
+
+    template<> constexpr VectorKind vector_kind<std::uint8_t> = VectorKind::U8;
+    template<> constexpr VectorKind vector_kind<std::int64_t> = VectorKind::S64;
+    template<> constexpr VectorKind vector_kind<double>       = VectorKind::F64;
+
+    // a vector of unboxed numbers, stored contiguously so it can be worked
+    // on a whole register at a time (see libscheme/simd.h)
+    template<typename T>
+    class NumVector : public Value {
+    public:
+        using value_type = T;
+
+        static_assert(VectorKind::Count != vector_kind<T>, "not a numeric vector element type");
+
+        explicit NumVector(std::size_t size, T fill = T{})
+            : Value(Value::Type::NumVector, static_cast<std::uint8_t>(vector_kind<T>))
+            , data_(size, fill)
+        {}
+
+        explicit NumVector(std::vector<T> data)
+            : Value(Value::Type::NumVector, static_cast<std::uint8_t>(vector_kind<T>))
+            , data_{std::move(data)}
+        {}
+
+        NumVector(NumVector<T> const& vec)
+            : Value(Value::Type::NumVector, static_cast<std::uint8_t>(vector_kind<T>))
+            , data_{vec.data_}
+        {}
+
+        NumVector(NumVector<T>&& vec)
+            : Value(Value::Type::NumVector, static_cast<std::uint8_t>(vector_kind<T>))
+            , data_{std::move(vec.data_)}
+        {}
+
+        std::size_t size() const {
+            return data_.size();
+        }
+
+        T const* data() const {
+            return data_.data();
+        }
+
+        T* data() {
+            return data_.data();
+        }
+
+        T const& operator[](std::size_t i) const {
+            return data_[i];
+        }
+
+        T& operator[](std::size_t i) {
+            return data_[i];
+        }
+
+        std::ostream& print(std::ostream& o) const override {
+            o << prefix() << "(";
+            for(auto i = std::size_t{0}; i < data_.size(); ++i) {
+                if(0 != i) {
+                    o << " ";
+                }
+                if constexpr(std::is_same_v<T, std::uint8_t>) {
+                    o << static_cast<unsigned>(data_[i]);
+                } else if constexpr(std::is_same_v<T, double>) {
+                    print_real(o, data_[i]);
+                } else {
+                    o << data_[i];
+                }
+            }
+            return o << ")";
+        }
+
+    private:
+        static constexpr char const* prefix() {
+            switch(vector_kind<T>) {
+                case VectorKind::U8:  return "#u8";
+                case VectorKind::S64: return "#s64";
+                default:              return "#f64";
+            }
+        }
+
+        std::vector<T> data_;
+    };
+
+    // the element type of the numeric vector `obj', or Count if it is not
+    // one
+    inline VectorKind vector_kind_of(Object const& obj) {
+        if(obj.is_heap() && Value::Type::NumVector == obj->type()) {
+            return static_cast<VectorKind>(obj->subtype());
+        }
+        return VectorKind::Count;
+    }
+} // end of namespace yasc
+
+#endif // __YASC_AST_UVECTOR_H_
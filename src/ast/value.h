@@ -2,41 +2,94 @@
 #define __YASC_AST_VALUE_H_
 
 #include <cassert>
+#include <cstdint>
 #include <type_traits>
 #include <memory>
 
 #include "number_fwd.h"
 
 namespace yasc {
+    class Object;
+
+    namespace gc {
+        class Heap;
+        class Tracer;
+        struct Descriptor;
+    };
+
+    // base of every heap-allocated scheme object. small integers, booleans,
+    // characters and the empty list never get here -- they live inline in an
+    // Object word (see object.h).
+    //
+    // values are owned by the collector (see gc/heap.h), which destroys them
+    // through their exact type; hence the non-virtual, protected destructor.
     class Value {
     public:
-        enum class Type {
+        enum class Type : std::uint8_t {
             Number,
             Pair,
             List,
             EmptyList,
             Identifier,
-            Procedure
+            Procedure,
+            Boolean,
+            Character,
+            Unspecified,
+            Code,
+            Closure,
+            NumVector,
+            Future,
+            Channel,
+            ListChunk
         };
 
-        using Ptr  = std::shared_ptr<Value>;
-
-        constexpr explicit Value(Type type)
+        constexpr explicit Value(Type type, std::uint8_t subtype = 0)
             : type_(type)
+            , subtype_(subtype)
+            , gc_(0)
+            , desc_(nullptr)
         {}
 
-        virtual ~Value() = default;
-
         constexpr Type type() const {
             return type_;
         }
 
+        // refines the type where one Type covers several representations;
+        // numbers keep their place in the numeric tower here, numeric
+        // vectors their element type
+        constexpr std::uint8_t subtype() const {
+            return subtype_;
+        }
+
         virtual std::ostream& print(std::ostream&) const = 0;
 
-        Value& operator=(Value const&) = default;
+        // must hand every Object field to the tracer, which may rewrite it
+        // when the referenced value is moved out of the nursery
+        virtual void trace(gc::Tracer&) {}
+
+        // the collector's header belongs to the allocation, not to the value
+        Value& operator=(Value const& rhs) {
+            type_    = rhs.type_;
+            subtype_ = rhs.subtype_;
+            return *this;
+        }
+
+    protected:
+        ~Value() = default;
 
     private:
+        friend class gc::Heap;
+
         Type type_;
+        std::uint8_t subtype_;
+
+        // collector header, see gc::Heap. zero for values it does not own
+        // (eg. ones living on the C++ stack)
+        std::uint32_t gc_;
+        union {
+            gc::Descriptor const* desc_;
+            Value* forward_;
+        };
     };
 
     inline std::ostream& operator<<(std::ostream& o, Value const& v) {
@@ -44,78 +97,136 @@ namespace yasc {
     }
 
     class Pair;
-    class EmptyList;
     class List;
+    class ListChunk;
     class Identifier;
     class Procedure;
+    class Code;
+    class Closure;
+    class Future;
+    class Channel;
+
+    // the element types of homogeneous numeric vectors (srfi 4). a vector
+    // records its element type as its subtype, and operations on two of
+    // them are carried out on the higher of the two kinds.
+    enum class VectorKind : std::uint8_t {
+        U8,
+        S64,
+        F64,
+        Count
+    };
+
+    template<typename T>
+    class NumVector;
+
+    using U8Vector  = NumVector<std::uint8_t>;
+    using S64Vector = NumVector<std::int64_t>;
+    using F64Vector = NumVector<double>;
 
     namespace detail {
+        // whether `val' is a T, down to the level of the numeric tower or
+        // the kind of numeric vector
         template<typename T>
-        constexpr bool check_type(Value::Type type) {
+        constexpr bool check_type(Value const&) {
             return false;
         }
 
         template<>
-        constexpr bool check_type<Integer>(Value::Type type) {
-            return Value::Type::Number == type;
+        constexpr bool check_type<Bignum>(Value const& val) {
+            return Value::Type::Number == val.type() && NumberKind::Bignum == static_cast<NumberKind>(val.subtype());
+        }
+
+        template<>
+        constexpr bool check_type<Rational>(Value const& val) {
+            return Value::Type::Number == val.type() && NumberKind::Rational == static_cast<NumberKind>(val.subtype());
+        }
+
+        template<>
+        constexpr bool check_type<Real>(Value const& val) {
+            return Value::Type::Number == val.type() && NumberKind::Real == static_cast<NumberKind>(val.subtype());
+        }
+
+        template<>
+        constexpr bool check_type<Complex>(Value const& val) {
+            return Value::Type::Number == val.type() && NumberKind::Complex == static_cast<NumberKind>(val.subtype());
+        }
+
+        template<>
+        constexpr bool check_type<Pair>(Value const& val) {
+            return Value::Type::Pair == val.type();
+        }
+
+        template<>
+        constexpr bool check_type<List>(Value const& val) {
+            return Value::Type::List == val.type();
+        }
+
+        template<>
+        constexpr bool check_type<ListChunk>(Value const& val) {
+            return Value::Type::ListChunk == val.type();
+        }
+
+        template<>
+        constexpr bool check_type<Identifier>(Value const& val) {
+            return Value::Type::Identifier == val.type();
         }
 
         template<>
-        constexpr bool check_type<Rational>(Value::Type type) {
-            return Value::Type::Number == type;
+        constexpr bool check_type<Procedure>(Value const& val) {
+            return Value::Type::Procedure == val.type();
         }
 
         template<>
-        constexpr bool check_type<Real>(Value::Type type) {
-            return Value::Type::Number == type;
+        constexpr bool check_type<Code>(Value const& val) {
+            return Value::Type::Code == val.type();
         }
 
         template<>
-        constexpr bool check_type<Complex>(Value::Type type) {
-            return Value::Type::Number == type;
+        constexpr bool check_type<Closure>(Value const& val) {
+            return Value::Type::Closure == val.type();
         }
 
         template<>
-        constexpr bool check_type<Pair>(Value::Type type) {
-            return Value::Type::Pair == type;
+        constexpr bool check_type<Future>(Value const& val) {
+            return Value::Type::Future == val.type();
         }
 
         template<>
-        constexpr bool check_type<List>(Value::Type type) {
-            return Value::Type::List == type;
+        constexpr bool check_type<Channel>(Value const& val) {
+            return Value::Type::Channel == val.type();
         }
 
         template<>
-        constexpr bool check_type<EmptyList>(Value::Type type) {
-            return Value::Type::EmptyList == type;
+        constexpr bool check_type<U8Vector>(Value const& val) {
+            return Value::Type::NumVector == val.type() && VectorKind::U8 == static_cast<VectorKind>(val.subtype());
         }
 
         template<>
-        constexpr bool check_type<Identifier>(Value::Type type) {
-            return Value::Type::Identifier == type;
+        constexpr bool check_type<S64Vector>(Value const& val) {
+            return Value::Type::NumVector == val.type() && VectorKind::S64 == static_cast<VectorKind>(val.subtype());
         }
 
         template<>
-        constexpr bool check_type<Procedure>(Value::Type type) {
-            return Value::Type::Procedure == type;
+        constexpr bool check_type<F64Vector>(Value const& val) {
+            return Value::Type::NumVector == val.type() && VectorKind::F64 == static_cast<VectorKind>(val.subtype());
         }
     };
 
     template<typename T>
     T& value_cast(Value& val) {
-        assert(detail::check_type<std::remove_reference_t<T>>(val.type()));
+        assert(detail::check_type<std::remove_const_t<std::remove_reference_t<T>>>(val));
         return static_cast<T&>(val);
     }
 
     template<typename T>
     T const& value_cast(Value const& val) {
-        assert(detail::check_type<std::remove_const_t<std::remove_reference_t<T>>>(val.type()));
+        assert(detail::check_type<std::remove_const_t<std::remove_reference_t<T>>>(val));
         return static_cast<T const&>(val);
     }
 
     template<typename T>
     T value_cast(Value* val) {
-        assert(detail::check_type<std::remove_pointer_t<T>>(val->type()));
+        assert(detail::check_type<std::remove_const_t<std::remove_pointer_t<T>>>(*val));
         return static_cast<T>(val);
     }
 }; // end of namespace yasc
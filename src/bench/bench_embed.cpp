@@ -0,0 +1,85 @@
+#include <cstdint>
+
+#include <benchmark/benchmark.h>
+
+#include "../parser.h"
+#include "../evaluator.h"
+#include "../isolate.h"
+#include "../gc/heap.h"
+
+// a small rule run 10^7 times the way a host embedding the interpreter
+// would: compiled once, with its inputs set through their globals
+namespace {
+    using namespace yasc;
+
+    constexpr auto rule = "(if (> amount limit) (* (- amount limit) rate) 0)";
+    constexpr benchmark::IterationCount invocations = 10000000;
+
+    void setup(Isolate& isolate) {
+        isolate.global("limit").set(500);
+        isolate.global("rate").set(3);
+    }
+
+    // the thread stays in the isolate across runs
+    void embed_rule(benchmark::State& state) {
+        Isolate isolate;
+        setup(isolate);
+        auto expr = isolate.compile(rule);
+        auto amount = isolate.global("amount");
+        Isolate::Scope scope{isolate};
+        std::int64_t i = 0;
+        for(auto _ : state) {
+            amount.set(i++ & 1023);
+            benchmark::DoNotOptimize(expr.run<std::int64_t>());
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+    BENCHMARK(embed_rule)->Iterations(invocations);
+
+    // each run enters and leaves the isolate
+    void embed_rule_entering(benchmark::State& state) {
+        Isolate isolate;
+        setup(isolate);
+        auto expr = isolate.compile(rule);
+        isolate.global("amount").set(700);
+        for(auto _ : state) {
+            benchmark::DoNotOptimize(expr.run<std::int64_t>());
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+    BENCHMARK(embed_rule_entering)->Iterations(invocations);
+
+    // calling back into the host
+    void embed_rule_native(benchmark::State& state) {
+        Isolate isolate;
+        setup(isolate);
+        isolate.define_native("clamp", [] (std::int64_t x, std::int64_t lo, std::int64_t hi) {
+            return x < lo ? lo : (x > hi ? hi : x);
+        });
+        auto expr = isolate.compile("(clamp (* (- amount limit) rate) 0 1000)");
+        auto amount = isolate.global("amount");
+        Isolate::Scope scope{isolate};
+        std::int64_t i = 0;
+        for(auto _ : state) {
+            amount.set(i++ & 1023);
+            benchmark::DoNotOptimize(expr.run<std::int64_t>());
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+    BENCHMARK(embed_rule_native)->Iterations(invocations);
+
+    // what there was before: parsing the rule each time, and running it
+    // in a copy of an environment
+    void embed_rule_reparsed(benchmark::State& state) {
+        Evaluator eval;
+        eval.globals()["limit"] = Object::fixnum(500);
+        eval.globals()["rate"] = Object::fixnum(3);
+        eval.globals()["amount"] = Object::fixnum(700);
+        for(auto _ : state) {
+            benchmark::DoNotOptimize(eval(Parser{}(rule), eval.globals()));
+            gc::safepoint();
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+    BENCHMARK(embed_rule_reparsed);
+}
@@ -0,0 +1,96 @@
+#include <cstdint>
+
+#include <benchmark/benchmark.h>
+
+#include "../parser.h"
+#include "../evaluator.h"
+#include "../ast/number.h"
+#include "../ast/procedure.h"
+#include "../gc/heap.h"
+#include "../libscheme/arithmetic.h"
+
+namespace {
+    using namespace yasc;
+
+    // a rule of the kind the interpreter is mostly given
+    constexpr auto form = "(+ 1 2 (* 4 5 (- 8 9)) (/ 10 4) (quotient 100 7))";
+
+    void parser_call(benchmark::State& state) {
+        gc::Region region;
+        for(auto _ : state) {
+            benchmark::DoNotOptimize(Parser{}(form, region));
+            region.release();
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+    BENCHMARK(parser_call);
+
+    void evaluator_value_reduce(benchmark::State& state) {
+        Evaluator eval{Evaluator::Mode::Ast};
+        auto ctx = Evaluator::get_scheme_context();
+        gc::Root ast{Parser{}(form)};
+        for(auto _ : state) {
+            benchmark::DoNotOptimize(eval.value_reduce(ast, ctx));
+            gc::safepoint();
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+    BENCHMARK(evaluator_value_reduce);
+
+    // compiling the form and running it on the VM, as the repl does
+    void evaluator_bytecode(benchmark::State& state) {
+        Evaluator eval{Evaluator::Mode::Quickening, static_cast<unsigned>(state.range(0))};
+        gc::Root ast{Parser{}(form)};
+        for(auto _ : state) {
+            benchmark::DoNotOptimize(eval(ast));
+            gc::safepoint();
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+    BENCHMARK(evaluator_bytecode)->ArgName("opt")->Arg(0)->Arg(1);
+
+    enum class Operands {
+        Fixnums,
+        Reals
+    };
+
+    Object operand(Operands kind, int val) {
+        if(Operands::Fixnums == kind) {
+            return Object::fixnum(val);
+        }
+        return number_traits<double>::box(val + 0.5);
+    }
+
+    // one call of a primitive through its Procedure, as the VM makes them
+    void primitive(benchmark::State& state, Object (*get)(), Operands kind) {
+        gc::Root proc{get()};
+        gc::Root lhs{operand(kind, 7)};
+        gc::Root rhs{operand(kind, 3)};
+        for(auto _ : state) {
+            Object args[] = {lhs, rhs};
+            benchmark::DoNotOptimize(value_cast<Procedure*>(proc.get())->call(Args{args, 2}));
+            gc::safepoint();
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+
+#define YASC_PRIMITIVE(name, get)                                                           \
+    BENCHMARK_CAPTURE(primitive, name##_fixnums, arithmetic::get, Operands::Fixnums);       \
+    BENCHMARK_CAPTURE(primitive, name##_reals,   arithmetic::get, Operands::Reals);
+
+    YASC_PRIMITIVE(plus,          get_plus)
+    YASC_PRIMITIVE(minus,         get_minus)
+    YASC_PRIMITIVE(multiplies,    get_multiplies)
+    YASC_PRIMITIVE(divides,       get_divides)
+    YASC_PRIMITIVE(equal,         get_equal)
+    YASC_PRIMITIVE(less,          get_less)
+    YASC_PRIMITIVE(greater,       get_greater)
+    YASC_PRIMITIVE(less_equal,    get_less_equal)
+    YASC_PRIMITIVE(greater_equal, get_greater_equal)
+#undef YASC_PRIMITIVE
+
+    // integer division is for exact integers only
+    BENCHMARK_CAPTURE(primitive, quotient_fixnums,  arithmetic::get_quotient,  Operands::Fixnums);
+    BENCHMARK_CAPTURE(primitive, remainder_fixnums, arithmetic::get_remainder, Operands::Fixnums);
+    BENCHMARK_CAPTURE(primitive, modulo_fixnums,    arithmetic::get_modulo,    Operands::Fixnums);
+}
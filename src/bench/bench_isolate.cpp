@@ -0,0 +1,71 @@
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "../isolate.h"
+#include "../ast/channel.h"
+#include "../ast/pair.h"
+#include "../gc/heap.h"
+
+namespace {
+    using namespace yasc;
+
+    // what one more tenant costs before it runs anything
+    void isolate_create(benchmark::State& state) {
+        for(auto _ : state) {
+            Isolate isolate;
+            benchmark::DoNotOptimize(&isolate);
+        }
+    }
+
+    // a message to another isolate and back, through a pair of channels
+    void isolate_round_trip(benchmark::State& state) {
+        gc::Root ping{make_object<Channel>(1)};
+        gc::Root pong{make_object<Channel>(1)};
+        auto echo = std::make_shared<Isolate>();
+        echo->define("in", ping);
+        echo->define("out", pong);
+        IsolatePool pool{1};
+        auto done = pool.run(echo,
+            "(define (echo)"
+            "  (let ((msg (channel-receive in)))"
+            "    (channel-send out msg)"
+            "    (if (null? msg) (quote done) (echo))))"
+            "(echo)");
+
+        gc::Root msg{make_object<Pair>(Object::fixnum(1), make_object<Pair>(Object::fixnum(2), Object::empty_list()))};
+        for(auto _ : state) {
+            value_cast<Channel*>(ping.get())->send(msg);
+            benchmark::DoNotOptimize(value_cast<Channel*>(pong.get())->receive());
+            gc::safepoint();
+        }
+        value_cast<Channel*>(ping.get())->send(Object::empty_list());
+        value_cast<Channel*>(pong.get())->receive();
+        done.get();
+    }
+
+    // many small scripts, each in an isolate of its own, on a pool
+    void isolate_pool(benchmark::State& state) {
+        IsolatePool pool{static_cast<unsigned>(state.range(0))};
+        constexpr int scripts = 64;
+        for(auto _ : state) {
+            std::vector<std::future<std::string>> results;
+            for(int i = 0; i < scripts; ++i) {
+                results.push_back(pool.run(std::make_shared<Isolate>(),
+                    "(define (fib n) (if (< n 2) n (+ (fib (- n 1)) (fib (- n 2)))))"
+                    "(fib 15)"));
+            }
+            for(auto& result : results) {
+                benchmark::DoNotOptimize(result.get());
+            }
+        }
+        state.SetItemsProcessed(state.iterations() * scripts);
+    }
+
+    BENCHMARK(isolate_create)->Unit(benchmark::kMicrosecond);
+    BENCHMARK(isolate_round_trip)->Unit(benchmark::kMicrosecond)->UseRealTime();
+    BENCHMARK(isolate_pool)->ArgName("threads")->DenseRange(1, 4)->UseRealTime()->Unit(benchmark::kMillisecond);
+}
@@ -0,0 +1,163 @@
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "../lexer.h"
+#include "../parser.h"
+#include "../reader.h"
+#include "../number_lexer.h"
+#include "../gc/heap.h"
+#include "../libscheme/simd.h"
+
+namespace {
+    using namespace yasc;
+
+    // about 8MB of records like a data dump would hold, spread over lines
+    std::string const& dump() {
+        static auto const text = [] {
+            std::string ret;
+            for(auto i = 0; ret.size() < (std::size_t{8} << 20); ++i) {
+                ret += "(record (id " + std::to_string(i) + ") (name item-" + std::to_string(i % 977)
+                     + ")\n  (weight " + std::to_string(i % 1000) + ".25) (tags alpha beta gamma))\n";
+            }
+            return ret;
+        }();
+        return text;
+    }
+
+    void processed(benchmark::State& state) {
+        state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * dump().size()));
+    }
+
+    // the input path the repl had before: a std::string per line
+    void getline_copies(benchmark::State& state) {
+        for(auto _ : state) {
+            std::istringstream in{dump()};
+            std::string line;
+            auto count = std::size_t{0};
+            while(std::getline(in, line)) {
+                count += line.size();
+            }
+            benchmark::DoNotOptimize(count);
+        }
+        processed(state);
+    }
+    BENCHMARK(getline_copies);
+
+    void lex_memory(benchmark::State& state) {
+        for(auto _ : state) {
+            Lexer lexer{dump()};
+            auto count = std::size_t{0};
+            while(Token::Kind::End != lexer.next().kind) {
+                ++count;
+            }
+            benchmark::DoNotOptimize(count);
+        }
+        processed(state);
+    }
+    BENCHMARK(lex_memory);
+
+    void lex_stream(benchmark::State& state) {
+        for(auto _ : state) {
+            std::istringstream in{dump()};
+            StreamSource source{in};
+            Lexer lexer{source};
+            auto count = std::size_t{0};
+            while(Token::Kind::End != lexer.next().kind) {
+                ++count;
+            }
+            benchmark::DoNotOptimize(count);
+        }
+        processed(state);
+    }
+    BENCHMARK(lex_stream);
+
+    // whole datums, each built in a region that is released right after
+    void parse_memory(benchmark::State& state) {
+        gc::Region region;
+        for(auto _ : state) {
+            Lexer lexer{dump()};
+            Parser parser;
+            while(!parser.next(lexer, region).is_null()) {
+                region.release();
+            }
+        }
+        processed(state);
+    }
+    BENCHMARK(parse_memory);
+
+    // the same datums through the two stage reader
+    void read_memory(benchmark::State& state) {
+        gc::Region region;
+        for(auto _ : state) {
+            Reader reader{dump()};
+            while(!reader.next(region).is_null()) {
+                region.release();
+            }
+        }
+        processed(state);
+    }
+    BENCHMARK(read_memory);
+
+    // stage one alone, for each instruction set
+    void structurals(benchmark::State& state) {
+        auto const& kernels = *simd::available()[static_cast<std::size_t>(state.range(0))];
+        state.SetLabel(kernels.name);
+        std::vector<std::uint32_t> index(Reader::batch_size);
+        for(auto _ : state) {
+            simd::ScanState scan;
+            auto count = std::size_t{0};
+            for(auto at = std::size_t{0}; at < dump().size(); at += Reader::batch_size) {
+                auto size = std::min(Reader::batch_size, dump().size() - at);
+                count += kernels.structurals(dump().data() + at, size, scan, index.data());
+            }
+            benchmark::DoNotOptimize(count);
+        }
+        processed(state);
+    }
+    BENCHMARK(structurals)->DenseRange(0, static_cast<int>(simd::available().size()) - 1);
+
+    // the numeric columns of a data file: integers and reals
+    std::vector<std::string> const& numerals() {
+        static auto const tokens = [] {
+            std::vector<std::string> ret;
+            for(auto i = 0; i < 4096; ++i) {
+                ret.push_back(std::to_string(i * 7919 % 100000));
+                ret.push_back(std::to_string(i % 1000) + "." + std::to_string(i % 97) + "e-3");
+            }
+            return ret;
+        }();
+        return tokens;
+    }
+
+    // how numbers used to be read: a string copy and strtod
+    void numbers_stod(benchmark::State& state) {
+        for(auto _ : state) {
+            auto sum = 0.0;
+            for(auto const& tok : numerals()) {
+                sum += std::stod(std::string{std::string_view{tok}});
+            }
+            benchmark::DoNotOptimize(sum);
+        }
+        state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * numerals().size()));
+    }
+    BENCHMARK(numbers_stod);
+
+    void numbers_lexed(benchmark::State& state) {
+        gc::Region region;
+        gc::RegionScope scope{region};
+        for(auto _ : state) {
+            for(auto const& tok : numerals()) {
+                Object out;
+                lex_number(tok, out);
+                benchmark::DoNotOptimize(out);
+            }
+            region.release();
+        }
+        state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * numerals().size()));
+    }
+    BENCHMARK(numbers_lexed);
+}
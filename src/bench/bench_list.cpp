@@ -0,0 +1,172 @@
+#include <cstdint>
+
+#include <benchmark/benchmark.h>
+
+#include "../ast/list.h"
+#include "../ast/pair.h"
+#include "../ast/procedure.h"
+#include "../gc/heap.h"
+#include "../libscheme/arithmetic.h"
+
+namespace {
+    using namespace yasc;
+
+    constexpr int elements = 1000000;
+
+    // the representation List replaced: one pair per element, appended at
+    // the tail
+    Object build_pairs(int size) {
+        auto head = make_object<Pair>(Object::fixnum(0), get_empty_list());
+        auto tail = value_cast<Pair*>(head);
+        for(auto i = 1; i < size; ++i) {
+            auto cell = make_object<Pair>(Object::fixnum(i), get_empty_list());
+            tail->set_cdr(cell);
+            tail = value_cast<Pair*>(cell);
+        }
+        return head;
+    }
+
+    Object build_list(int size) {
+        auto list = make_object<List>();
+        auto raw  = value_cast<List*>(list);
+        for(auto i = 0; i < size; ++i) {
+            raw->push_back(Object::fixnum(i));
+        }
+        return list;
+    }
+
+    void pairs_build(benchmark::State& state) {
+        for(auto _ : state) {
+            benchmark::DoNotOptimize(build_pairs(elements));
+            gc::current_heap().collect_minor();
+        }
+        state.SetItemsProcessed(state.iterations() * elements);
+    }
+    BENCHMARK(pairs_build)->Unit(benchmark::kMillisecond);
+
+    void list_build(benchmark::State& state) {
+        for(auto _ : state) {
+            benchmark::DoNotOptimize(build_list(elements));
+            gc::current_heap().collect_minor();
+        }
+        state.SetItemsProcessed(state.iterations() * elements);
+    }
+    BENCHMARK(list_build)->Unit(benchmark::kMillisecond);
+
+    // the traversals run over lists that survived a collection, so both
+    // have been laid out by the collector's copying, like any long lived
+    // list would
+    void pairs_traverse(benchmark::State& state) {
+        gc::Root list{build_pairs(elements)};
+        gc::current_heap().collect_minor();
+        for(auto _ : state) {
+            auto sum = std::intptr_t{0};
+            for(auto cur = list.get(); !cur.is_empty_list(); cur = value_cast<Pair*>(cur)->cdr()) {
+                sum += value_cast<Pair*>(cur)->car().as_fixnum();
+            }
+            benchmark::DoNotOptimize(sum);
+        }
+        state.SetItemsProcessed(state.iterations() * elements);
+    }
+    BENCHMARK(pairs_traverse)->Unit(benchmark::kMillisecond);
+
+    void list_traverse(benchmark::State& state) {
+        gc::Root list{build_list(elements)};
+        gc::current_heap().collect_minor();
+        for(auto _ : state) {
+            auto sum = std::intptr_t{0};
+            for(auto const& val : *value_cast<List*>(list.get())) {
+                sum += val.as_fixnum();
+            }
+            benchmark::DoNotOptimize(sum);
+        }
+        state.SetItemsProcessed(state.iterations() * elements);
+    }
+    BENCHMARK(list_traverse)->Unit(benchmark::kMillisecond);
+
+    // freshly built lists, still in the order they were allocated in, with
+    // other allocations interleaved as a reader would do
+    Object build_pairs_interleaved(int size) {
+        auto head = make_object<Pair>(Object::fixnum(0), get_empty_list());
+        auto tail = value_cast<Pair*>(head);
+        for(auto i = 1; i < size; ++i) {
+            make_object<Pair>(Object::fixnum(i), Object::fixnum(i));
+            auto cell = make_object<Pair>(Object::fixnum(i), get_empty_list());
+            tail->set_cdr(cell);
+            tail = value_cast<Pair*>(cell);
+        }
+        return head;
+    }
+
+    Object build_list_interleaved(int size) {
+        auto list = make_object<List>();
+        auto raw  = value_cast<List*>(list);
+        for(auto i = 0; i < size; ++i) {
+            make_object<Pair>(Object::fixnum(i), Object::fixnum(i));
+            raw->push_back(Object::fixnum(i));
+        }
+        return list;
+    }
+
+    void pairs_traverse_young(benchmark::State& state) {
+        auto list = build_pairs_interleaved(elements);
+        for(auto _ : state) {
+            auto sum = std::intptr_t{0};
+            for(auto cur = list; !cur.is_empty_list(); cur = value_cast<Pair*>(cur)->cdr()) {
+                sum += value_cast<Pair*>(cur)->car().as_fixnum();
+            }
+            benchmark::DoNotOptimize(sum);
+        }
+        state.SetItemsProcessed(state.iterations() * elements);
+        gc::current_heap().collect_minor();
+    }
+    BENCHMARK(pairs_traverse_young)->Unit(benchmark::kMillisecond);
+
+    void list_traverse_young(benchmark::State& state) {
+        auto list = build_list_interleaved(elements);
+        for(auto _ : state) {
+            auto sum = std::intptr_t{0};
+            for(auto const& val : *value_cast<List*>(list)) {
+                sum += val.as_fixnum();
+            }
+            benchmark::DoNotOptimize(sum);
+        }
+        state.SetItemsProcessed(state.iterations() * elements);
+        gc::current_heap().collect_minor();
+    }
+    BENCHMARK(list_traverse_young)->Unit(benchmark::kMillisecond);
+
+    // folding `+' over the elements, the way a primitive called with a
+    // list's elements works through them
+    void pairs_reduce(benchmark::State& state) {
+        gc::Root plus{arithmetic::get_plus()};
+        gc::Root list{build_pairs(elements)};
+        gc::current_heap().collect_minor();
+        auto const& prim = value_cast<Procedure*>(plus.get())->primitive();
+        for(auto _ : state) {
+            auto acc = Object::fixnum(0);
+            for(auto cur = list.get(); !cur.is_empty_list(); cur = value_cast<Pair*>(cur)->cdr()) {
+                acc = prim.call2(acc, value_cast<Pair*>(cur)->car(), nullptr);
+            }
+            benchmark::DoNotOptimize(acc);
+        }
+        state.SetItemsProcessed(state.iterations() * elements);
+    }
+    BENCHMARK(pairs_reduce)->Unit(benchmark::kMillisecond);
+
+    void list_reduce(benchmark::State& state) {
+        gc::Root plus{arithmetic::get_plus()};
+        gc::Root list{build_list(elements)};
+        gc::current_heap().collect_minor();
+        auto const& prim = value_cast<Procedure*>(plus.get())->primitive();
+        for(auto _ : state) {
+            auto acc = Object::fixnum(0);
+            for(auto const& val : *value_cast<List*>(list.get())) {
+                acc = prim.call2(acc, val, nullptr);
+            }
+            benchmark::DoNotOptimize(acc);
+        }
+        state.SetItemsProcessed(state.iterations() * elements);
+    }
+    BENCHMARK(list_reduce)->Unit(benchmark::kMillisecond);
+}
@@ -0,0 +1,92 @@
+#include <sstream>
+#include <string>
+#include <string_view>
+
+#include <benchmark/benchmark.h>
+
+#include "../lexer.h"
+#include "../parser.h"
+#include "../evaluator.h"
+#include "../gc/heap.h"
+#include "../par/scheduler.h"
+
+// programs split up with futures, run on 1 to 4 threads. the times are
+// wall clock times: what the threads other than the timed one do counts
+namespace {
+    using namespace yasc;
+
+    struct Program {
+        char const* setup;    // defines the program's procedures
+        char const* run;      // the form timed
+        char const* expected; // what `run' prints as
+    };
+
+    void parallel(benchmark::State& state, Program program) {
+        par::set_threads(static_cast<unsigned>(state.range(0)));
+        Evaluator eval;
+        {
+            Parser parser;
+            gc::Region region;
+            Lexer lexer{std::string_view{program.setup}};
+            for(;;) {
+                auto form = parser.next(lexer, region);
+                if(form.is_null()) {
+                    break;
+                }
+                eval(form);
+            }
+        }
+
+        gc::Root form{Parser{}(program.run)};
+        std::ostringstream printed;
+        printed << gc::Root{eval(form)}.get();
+        if(printed.str() != program.expected) {
+            state.SkipWithError(("got " + printed.str()).c_str());
+            return;
+        }
+
+        auto const before = par::stats();
+        for(auto _ : state) {
+            benchmark::DoNotOptimize(eval(form));
+            gc::safepoint();
+        }
+        auto const after = par::stats();
+        state.counters["stolen"] = benchmark::Counter(
+            static_cast<double>(after.stolen - before.stolen), benchmark::Counter::kAvgIterations);
+    }
+
+    // futures down to a cutoff, below which it is plain fib
+    constexpr Program pfib = {
+        "(define (fib n) (if (< n 2) n (+ (fib (- n 1)) (fib (- n 2)))))"
+        "(define (pfib n)"
+        "  (if (< n 20)"
+        "      (fib n)"
+        "      (let ((a (future (pfib (- n 1))))"
+        "            (b (pfib (- n 2))))"
+        "        (+ (touch a) b))))",
+        "(pfib 27)",
+        "196418"
+    };
+
+    constexpr Program map = {
+        "(define (fib n) (if (< n 2) n (+ (fib (- n 1)) (fib (- n 2)))))"
+        "(define (one-to n)"
+        "  (let loop ((i n) (l (quote ()))) (if (= i 0) l (loop (- i 1) (cons i l)))))"
+        "(define work (one-to 64))",
+        "(car (par-map (lambda (i) (fib (+ 12 (remainder i 8)))) work))",
+        "233"
+    };
+
+    constexpr Program fold = {
+        "(define v (make-f64vector 1000000 0.5))",
+        "(par-fold + 0.0 v)",
+        "500000"
+    };
+
+    BENCHMARK_CAPTURE(parallel, pfib, pfib)->ArgName("threads")->DenseRange(1, 4)
+        ->UseRealTime()->Unit(benchmark::kMillisecond);
+    BENCHMARK_CAPTURE(parallel, map,  map)->ArgName("threads")->DenseRange(1, 4)
+        ->UseRealTime()->Unit(benchmark::kMillisecond);
+    BENCHMARK_CAPTURE(parallel, fold, fold)->ArgName("threads")->DenseRange(1, 4)
+        ->UseRealTime()->Unit(benchmark::kMillisecond);
+}
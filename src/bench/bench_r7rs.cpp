@@ -0,0 +1,158 @@
+#include <sstream>
+#include <string>
+#include <string_view>
+
+#include <benchmark/benchmark.h>
+
+#include "../lexer.h"
+#include "../parser.h"
+#include "../evaluator.h"
+#include "../gc/heap.h"
+
+// a few programs of the r7rs-benchmarks suite, cut down to what yasc can
+// evaluate so far (no cond, and or, nor ' yet) and to sizes that finish in
+// milliseconds
+namespace {
+    using namespace yasc;
+
+    struct Program {
+        char const* setup;    // defines the program's procedures
+        char const* run;      // the form timed
+        char const* expected; // what `run' prints as
+    };
+
+    // evaluates `run' once per iteration, the procedures it calls having been
+    // compiled once beforehand
+    void r7rs(benchmark::State& state, Program program) {
+        Evaluator eval;
+        {
+            Parser parser;
+            gc::Region region;
+            Lexer lexer{std::string_view{program.setup}};
+            for(;;) {
+                auto form = parser.next(lexer, region);
+                if(form.is_null()) {
+                    break;
+                }
+                eval(form);
+            }
+        }
+
+        gc::Root form{Parser{}(program.run)};
+        std::ostringstream printed;
+        printed << gc::Root{eval(form)}.get();
+        if(printed.str() != program.expected) {
+            state.SkipWithError(("got " + printed.str()).c_str());
+            return;
+        }
+
+        for(auto _ : state) {
+            benchmark::DoNotOptimize(eval(form));
+            gc::safepoint();
+        }
+    }
+
+    constexpr Program fib = {
+        "(define (fib n) (if (< n 2) n (+ (fib (- n 1)) (fib (- n 2)))))",
+        "(fib 25)",
+        "75025"
+    };
+
+    constexpr Program tak = {
+        "(define (tak x y z)"
+        "  (if (not (< y x))"
+        "      z"
+        "      (tak (tak (- x 1) y z) (tak (- y 1) z x) (tak (- z 1) x y))))",
+        "(tak 18 12 6)",
+        "7"
+    };
+
+    constexpr Program ack = {
+        "(define (ack m n)"
+        "  (if (= m 0)"
+        "      (+ n 1)"
+        "      (if (= n 0)"
+        "          (ack (- m 1) 1)"
+        "          (ack (- m 1) (ack m (- n 1))))))",
+        "(ack 3 5)",
+        "253"
+    };
+
+    constexpr Program nqueens = {
+        "(define (one-to n)"
+        "  (let loop ((i n) (l (quote ())))"
+        "    (if (= i 0) l (loop (- i 1) (cons i l)))))"
+        "(define (my-append a b)"
+        "  (if (null? a) b (cons (car a) (my-append (cdr a) b))))"
+        "(define (ok? row dist placed)"
+        "  (if (null? placed)"
+        "      #t"
+        "      (if (= (car placed) (+ row dist))"
+        "          #f"
+        "          (if (= (car placed) (- row dist))"
+        "              #f"
+        "              (ok? row (+ dist 1) (cdr placed))))))"
+        "(define (try-it x y z)"
+        "  (if (null? x)"
+        "      (if (null? y) 1 0)"
+        "      (+ (if (ok? (car x) 1 z)"
+        "             (try-it (my-append (cdr x) y) (quote ()) (cons (car x) z))"
+        "             0)"
+        "         (try-it (cdr x) (cons (car x) y) z))))"
+        "(define (queens n) (try-it (one-to n) (quote ()) (quote ())))",
+        "(queens 8)",
+        "92"
+    };
+
+    constexpr Program deriv = {
+        "(define (map-deriv l)"
+        "  (if (null? l) (quote ()) (cons (deriv (car l)) (map-deriv (cdr l)))))"
+        "(define (map-quotients l)"
+        "  (if (null? l)"
+        "      (quote ())"
+        "      (cons (list (quote /) (deriv (car l)) (car l)) (map-quotients (cdr l)))))"
+        "(define (deriv a)"
+        "  (if (not (pair? a))"
+        "      (if (eq? a (quote x)) 1 0)"
+        "      (if (eq? (car a) (quote +))"
+        "          (cons (quote +) (map-deriv (cdr a)))"
+        "          (if (eq? (car a) (quote -))"
+        "              (cons (quote -) (map-deriv (cdr a)))"
+        "              (if (eq? (car a) (quote *))"
+        "                  (list (quote *) a (cons (quote +) (map-quotients (cdr a))))"
+        "                  (quote error))))))"
+        "(define (run n)"
+        "  (let loop ((i 1) (r (deriv (quote (+ (* 3 x x) (* a x x) (* b x) 5)))))"
+        "    (if (= i n)"
+        "        r"
+        "        (loop (+ i 1) (deriv (quote (+ (* 3 x x) (* a x x) (* b x) 5)))))))",
+        "(run 1000)",
+        "(+ (* (* 3 x x) (+ (/ 0 3) (/ 1 x) (/ 1 x))) "
+        "(* (* a x x) (+ (/ 0 a) (/ 1 x) (/ 1 x))) "
+        "(* (* b x) (+ (/ 0 b) (/ 1 x))) 0)"
+    };
+
+    constexpr Program primes = {
+        "(define (interval-list m n)"
+        "  (if (> m n) (quote ()) (cons m (interval-list (+ 1 m) n))))"
+        "(define (remove-multiples n l)"
+        "  (if (null? l)"
+        "      (quote ())"
+        "      (if (= (remainder (car l) n) 0)"
+        "          (remove-multiples n (cdr l))"
+        "          (cons (car l) (remove-multiples n (cdr l))))))"
+        "(define (sieve l)"
+        "  (if (null? l) (quote ()) (cons (car l) (sieve (remove-multiples (car l) (cdr l))))))"
+        "(define (length l)"
+        "  (let loop ((l l) (n 0)) (if (null? l) n (loop (cdr l) (+ n 1)))))",
+        "(length (sieve (interval-list 2 1000)))",
+        "168"
+    };
+
+    BENCHMARK_CAPTURE(r7rs, fib,     fib)->Unit(benchmark::kMillisecond);
+    BENCHMARK_CAPTURE(r7rs, tak,     tak)->Unit(benchmark::kMillisecond);
+    BENCHMARK_CAPTURE(r7rs, ack,     ack)->Unit(benchmark::kMillisecond);
+    BENCHMARK_CAPTURE(r7rs, nqueens, nqueens)->Unit(benchmark::kMillisecond);
+    BENCHMARK_CAPTURE(r7rs, deriv,   deriv)->Unit(benchmark::kMillisecond);
+    BENCHMARK_CAPTURE(r7rs, primes,  primes)->Unit(benchmark::kMillisecond);
+}
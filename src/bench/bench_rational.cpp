@@ -0,0 +1,175 @@
+#include <cstdint>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "../ast/ratio.h"
+#include "../ast/number.h"
+#include "../ast/procedure.h"
+#include "../gc/heap.h"
+#include "../libscheme/arithmetic.h"
+
+namespace {
+    // the representation Ratio replaced: an unreduced pair of ints added
+    // over the lcm of the denominators. it overflows quickly, so the
+    // workloads below stay within what it gets right.
+    namespace legacy {
+        using fraction_t = std::pair<int, int>;
+
+        fraction_t add(fraction_t const& lhs, fraction_t const& rhs) {
+            fraction_t ret{};
+            if(lhs.second == rhs.second) {
+                ret.second = lhs.second;
+                ret.first  = rhs.first + lhs.first;
+            } else {
+                ret.second = std::lcm(lhs.second, rhs.second);
+                ret.first  = (lhs.first * ret.second / lhs.second)
+                           + (rhs.first * ret.second / rhs.second);
+            }
+            return ret;
+        }
+
+        fraction_t mul(fraction_t const& lhs, fraction_t const& rhs) {
+            return {lhs.first * rhs.first, lhs.second * rhs.second};
+        }
+    }
+
+    // 1/1 + 1/2 + ... + 1/20, as lcm(1..20) still fits an int
+    constexpr int harmonic_terms = 20;
+
+    // 1/2 * 2/3 * ... * 10/11, as 11! still fits an int
+    constexpr int product_terms = 10;
+
+    void legacy_harmonic(benchmark::State& state) {
+        for(auto _ : state) {
+            legacy::fraction_t sum{0, 1};
+            for(auto k = 1; k <= harmonic_terms; ++k) {
+                benchmark::DoNotOptimize(k);
+                sum = legacy::add(sum, {1, k});
+            }
+            benchmark::DoNotOptimize(sum);
+        }
+    }
+    BENCHMARK(legacy_harmonic);
+
+    void ratio_harmonic(benchmark::State& state) {
+        for(auto _ : state) {
+            yasc::Ratio sum;
+            for(auto k = 1; k <= harmonic_terms; ++k) {
+                benchmark::DoNotOptimize(k);
+                sum = sum + yasc::Ratio{1, k};
+            }
+            benchmark::DoNotOptimize(sum);
+        }
+    }
+    BENCHMARK(ratio_harmonic);
+
+    // single operations on fixed operands, one pair with a common
+    // denominator and one without
+    void legacy_add_same_denominator(benchmark::State& state) {
+        legacy::fraction_t lhs{5, 64}, rhs{7, 64};
+        for(auto _ : state) {
+            benchmark::DoNotOptimize(lhs);
+            benchmark::DoNotOptimize(legacy::add(lhs, rhs));
+        }
+    }
+    BENCHMARK(legacy_add_same_denominator);
+
+    void ratio_add_same_denominator(benchmark::State& state) {
+        yasc::Ratio lhs{5, 64}, rhs{7, 64};
+        for(auto _ : state) {
+            benchmark::DoNotOptimize(lhs);
+            benchmark::DoNotOptimize(lhs + rhs);
+        }
+    }
+    BENCHMARK(ratio_add_same_denominator);
+
+    void legacy_add(benchmark::State& state) {
+        legacy::fraction_t lhs{1, 6}, rhs{3, 10};
+        for(auto _ : state) {
+            benchmark::DoNotOptimize(lhs);
+            benchmark::DoNotOptimize(legacy::add(lhs, rhs));
+        }
+    }
+    BENCHMARK(legacy_add);
+
+    void ratio_add(benchmark::State& state) {
+        yasc::Ratio lhs{1, 6}, rhs{3, 10};
+        for(auto _ : state) {
+            benchmark::DoNotOptimize(lhs);
+            benchmark::DoNotOptimize(lhs + rhs);
+        }
+    }
+    BENCHMARK(ratio_add);
+
+    void legacy_mul(benchmark::State& state) {
+        legacy::fraction_t lhs{2, 3}, rhs{9, 4};
+        for(auto _ : state) {
+            benchmark::DoNotOptimize(lhs);
+            benchmark::DoNotOptimize(legacy::mul(lhs, rhs));
+        }
+    }
+    BENCHMARK(legacy_mul);
+
+    void ratio_mul(benchmark::State& state) {
+        yasc::Ratio lhs{2, 3}, rhs{9, 4};
+        for(auto _ : state) {
+            benchmark::DoNotOptimize(lhs);
+            benchmark::DoNotOptimize(lhs * rhs);
+        }
+    }
+    BENCHMARK(ratio_mul);
+
+    void legacy_product(benchmark::State& state) {
+        for(auto _ : state) {
+            legacy::fraction_t prod{1, 1};
+            for(auto k = 1; k <= product_terms; ++k) {
+                benchmark::DoNotOptimize(k);
+                prod = legacy::mul(prod, {k, k + 1});
+            }
+            benchmark::DoNotOptimize(prod);
+        }
+    }
+    BENCHMARK(legacy_product);
+
+    void ratio_product(benchmark::State& state) {
+        for(auto _ : state) {
+            auto prod = yasc::Ratio{1};
+            for(auto k = 1; k <= product_terms; ++k) {
+                benchmark::DoNotOptimize(k);
+                prod = prod * yasc::Ratio{k, k + 1};
+            }
+            benchmark::DoNotOptimize(prod);
+        }
+    }
+    BENCHMARK(ratio_product);
+
+    // the harmonic sum again, through the `+' primitive on boxed numbers
+    void primitive_harmonic(benchmark::State& state) {
+        using namespace yasc;
+        gc::Root plus{arithmetic::get_plus()};
+        auto const& prim = value_cast<Procedure*>(plus.get())->primitive();
+        for(auto _ : state) {
+            auto sum = Object::fixnum(0);
+            for(auto k = 1; k <= harmonic_terms; ++k) {
+                benchmark::DoNotOptimize(k);
+                sum = prim.call2(sum, number_traits<Ratio>::box(Ratio{1, k}), nullptr);
+            }
+            benchmark::DoNotOptimize(sum);
+            gc::safepoint();
+        }
+    }
+    BENCHMARK(primitive_harmonic);
+
+    // 128 bit intermediates that do not fit back into words
+    void ratio_overflow_to_bignum(benchmark::State& state) {
+        auto const lhs = yasc::Ratio{INT64_MAX, 3};
+        auto const rhs = yasc::Ratio{INT64_MAX - 1, 5};
+        for(auto _ : state) {
+            benchmark::DoNotOptimize(lhs * rhs);
+        }
+    }
+    BENCHMARK(ratio_overflow_to_bignum);
+}
@@ -0,0 +1,135 @@
+#include <cstdint>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "../libscheme/simd.h"
+
+namespace {
+    using yasc::simd::Kernels;
+    using yasc::simd::Op;
+
+    constexpr std::size_t elements = 1 << 16;
+
+    template<typename T>
+    std::vector<T> random(T lo, T hi) {
+        std::mt19937_64 rng{3};
+        std::vector<T> ret(elements);
+        for(auto& val : ret) {
+            if constexpr(std::is_floating_point_v<T>) {
+                val = std::uniform_real_distribution<T>{lo, hi}(rng);
+            } else {
+                val = static_cast<T>(std::uniform_int_distribution<std::int64_t>{lo, hi}(rng));
+            }
+        }
+        return ret;
+    }
+
+    // each benchmark runs once per set of kernels the CPU supports, the
+    // argument being the set's index in available()
+    Kernels const& kernels(benchmark::State& state) {
+        auto const& all = yasc::simd::available();
+        auto const& ret = *all[static_cast<std::size_t>(state.range(0)) % all.size()];
+        state.SetLabel(ret.name);
+        return ret;
+    }
+
+    void processed(benchmark::State& state) {
+        state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * elements));
+    }
+
+    void every_set(benchmark::internal::Benchmark* b) {
+        for(auto i = 0u; i < yasc::simd::available().size(); ++i) {
+            b->Arg(i);
+        }
+    }
+
+    void sum_f64(benchmark::State& state) {
+        auto data = random<double>(-1.0, 1.0);
+        auto const& k = kernels(state);
+        for(auto _ : state) {
+            benchmark::DoNotOptimize(k.sum_f64(data.data(), data.size()));
+        }
+        processed(state);
+    }
+    BENCHMARK(sum_f64)->Apply(every_set);
+
+    void dot_f64(benchmark::State& state) {
+        auto lhs = random<double>(-1.0, 1.0), rhs = random<double>(-1.0, 1.0);
+        auto const& k = kernels(state);
+        for(auto _ : state) {
+            benchmark::DoNotOptimize(k.dot_f64(lhs.data(), rhs.data(), lhs.size()));
+        }
+        processed(state);
+    }
+    BENCHMARK(dot_f64)->Apply(every_set);
+
+    void sum_s64(benchmark::State& state) {
+        auto data = random<std::int64_t>(INT64_MIN, INT64_MAX);
+        auto const& k = kernels(state);
+        for(auto _ : state) {
+            benchmark::DoNotOptimize(k.sum_s64(data.data(), data.size()));
+        }
+        processed(state);
+    }
+    BENCHMARK(sum_s64)->Apply(every_set);
+
+    void sum_u8(benchmark::State& state) {
+        auto data = random<std::uint8_t>(0, 255);
+        auto const& k = kernels(state);
+        for(auto _ : state) {
+            benchmark::DoNotOptimize(k.sum_u8(data.data(), data.size()));
+        }
+        processed(state);
+    }
+    BENCHMARK(sum_u8)->Apply(every_set);
+
+    void max_s64(benchmark::State& state) {
+        auto data = random<std::int64_t>(INT64_MIN, INT64_MAX);
+        auto const& k = kernels(state);
+        for(auto _ : state) {
+            benchmark::DoNotOptimize(k.max_s64(data.data(), data.size()));
+        }
+        processed(state);
+    }
+    BENCHMARK(max_s64)->Apply(every_set);
+
+    void add_f64(benchmark::State& state) {
+        auto lhs = random<double>(-1.0, 1.0), rhs = random<double>(-1.0, 1.0);
+        std::vector<double> out(elements);
+        auto const& k = kernels(state);
+        for(auto _ : state) {
+            k.map_f64(Op::Add, {lhs.data(), false}, {rhs.data(), false}, out.data(), elements);
+            benchmark::ClobberMemory();
+        }
+        processed(state);
+    }
+    BENCHMARK(add_f64)->Apply(every_set);
+
+    // the checked exact maps, which never overflow here
+    void add_s64(benchmark::State& state) {
+        auto lhs = random<std::int64_t>(-1000, 1000), rhs = random<std::int64_t>(-1000, 1000);
+        std::vector<std::int64_t> out(elements);
+        auto const& k = kernels(state);
+        for(auto _ : state) {
+            benchmark::DoNotOptimize(k.map_s64(Op::Add, {lhs.data(), false}, {rhs.data(), false}, out.data(), elements));
+            benchmark::ClobberMemory();
+        }
+        processed(state);
+    }
+    BENCHMARK(add_s64)->Apply(every_set);
+
+    void mul_u8(benchmark::State& state) {
+        auto lhs = random<std::uint8_t>(0, 15), rhs = random<std::uint8_t>(0, 15);
+        std::vector<std::uint8_t> out(elements);
+        auto const& k = kernels(state);
+        for(auto _ : state) {
+            benchmark::DoNotOptimize(k.map_u8(Op::Mul, {lhs.data(), false}, {rhs.data(), false}, out.data(), elements));
+            benchmark::ClobberMemory();
+        }
+        processed(state);
+    }
+    BENCHMARK(mul_u8)->Apply(every_set);
+}
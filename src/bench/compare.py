@@ -0,0 +1,70 @@
+#!/usr/bin/env python3
+"""Compares two runs of yasc-bench.
+
+Each run is the JSON google-benchmark writes with
+
+    yasc-bench --benchmark_out=FILE --benchmark_out_format=json
+
+Benchmarks are matched by name, and their times printed side by side with the
+ratio of the new to the old. Exits with 1 when any benchmark got slower by
+more than the threshold, so a script can fail on a regression.
+"""
+
+import argparse
+import json
+import sys
+
+
+def load(path, metric):
+    with open(path) as f:
+        run = json.load(f)
+    times = {}
+    for bench in run["benchmarks"]:
+        # with --benchmark_repetitions, only the mean is compared
+        if bench.get("run_type") == "aggregate" and bench.get("aggregate_name") != "mean":
+            continue
+        if "error_occurred" in bench and bench["error_occurred"]:
+            continue
+        name = bench.get("run_name", bench["name"])
+        times[name] = (bench[metric], bench["time_unit"])
+    return times
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("old", help="the baseline run")
+    parser.add_argument("new", help="the run compared against it")
+    parser.add_argument("--threshold", type=float, default=5.0,
+                        help="the slowdown, in percent, counted as a regression (default 5)")
+    parser.add_argument("--metric", choices=["real_time", "cpu_time"], default="cpu_time",
+                        help="which time to compare (default cpu_time)")
+    args = parser.parse_args()
+
+    old = load(args.old, args.metric)
+    new = load(args.new, args.metric)
+
+    width = max((len(name) for name in old.keys() | new.keys()), default=0)
+    regressions = 0
+    for name in sorted(old.keys() | new.keys()):
+        if name not in old or name not in new:
+            where = args.new if name in new else args.old
+            print(f"{name:<{width}}  only in {where}")
+            continue
+        (before, unit), (after, _) = old[name], new[name]
+        ratio = after / before if before else float("inf")
+        flag = ""
+        if (ratio - 1) * 100 > args.threshold:
+            flag = "  REGRESSION"
+            regressions += 1
+        elif (1 - ratio) * 100 > args.threshold:
+            flag = "  improved"
+        print(f"{name:<{width}}  {before:12.2f} {unit}  {after:12.2f} {unit}  {ratio:6.3f}x{flag}")
+
+    if regressions:
+        print(f"{regressions} benchmark(s) slower by more than {args.threshold:g}%")
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
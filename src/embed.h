@@ -0,0 +1,224 @@
+#ifndef __YASC_EMBED_H_
+#define __YASC_EMBED_H_
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "error.h"
+#include "ast/value.h"
+#include "ast/object.h"
+#include "ast/number.h"
+#include "ast/procedure.h"
+
+namespace yasc {
+    namespace embed {
+        // moves host values in and out of Objects: integers, floating point
+        // numbers, bool, char32_t, and Object itself, which is left alone.
+        // integers that fit a fixnum cost no allocation either way
+        template<typename T, typename = void>
+        struct convert {
+            static_assert(sizeof(T) == 0, "no conversion between this type and Object");
+        };
+
+        template<>
+        struct convert<Object> {
+            static Object to_object(Object const& val) {
+                return val;
+            }
+
+            static Object from_object(Object const& obj) {
+                return obj;
+            }
+        };
+
+        template<>
+        struct convert<bool> {
+            static Object to_object(bool val) {
+                return Object::boolean(val);
+            }
+
+            // as an `if' would see it
+            static bool from_object(Object const& obj) {
+                return obj.is_true();
+            }
+        };
+
+        template<>
+        struct convert<char32_t> {
+            static Object to_object(char32_t val) {
+                return Object::character(val);
+            }
+
+            static char32_t from_object(Object const& obj) {
+                if(!obj.is_character()) {
+                    throw Error{"expects a character"};
+                }
+                return obj.as_character();
+            }
+        };
+
+        template<typename T>
+        struct convert<T, std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool> && !std::is_same_v<T, char32_t>>> {
+            static Object to_object(T val) {
+                if constexpr(std::is_signed_v<T>) {
+                    if(Object::fits_fixnum(val)) {
+                        return Object::fixnum(static_cast<std::intptr_t>(val));
+                    }
+                    return number_traits<BigInt>::box(BigInt{static_cast<std::intmax_t>(val)});
+                } else {
+                    if(val <= static_cast<std::uintmax_t>(Object::fixnum_max)) {
+                        return Object::fixnum(static_cast<std::intptr_t>(val));
+                    }
+                    if(val <= static_cast<std::uintmax_t>(std::numeric_limits<std::intmax_t>::max())) {
+                        return number_traits<BigInt>::box(BigInt{static_cast<std::intmax_t>(val)});
+                    }
+                    throw Error{"integer too large"};
+                }
+            }
+
+            static T from_object(Object const& obj) {
+                std::intmax_t val;
+                if(obj.is_fixnum()) {
+                    val = obj.as_fixnum();
+                } else if(NumberKind::Bignum != number_kind_of(obj) || !number_traits<BigInt>::unbox(obj).to_int(val)) {
+                    throw Error{"expects an integer that fits " + std::to_string(8 * sizeof(T)) + " bits"};
+                }
+                if constexpr(std::is_signed_v<T>) {
+                    if(val < std::numeric_limits<T>::min() || val > std::numeric_limits<T>::max()) {
+                        throw Error{"expects an integer that fits " + std::to_string(8 * sizeof(T)) + " bits"};
+                    }
+                } else {
+                    if(val < 0 || static_cast<std::uintmax_t>(val) > std::numeric_limits<T>::max()) {
+                        throw Error{"expects an unsigned integer that fits " + std::to_string(8 * sizeof(T)) + " bits"};
+                    }
+                }
+                return static_cast<T>(val);
+            }
+        };
+
+        template<typename T>
+        struct convert<T, std::enable_if_t<std::is_floating_point_v<T>>> {
+            static Object to_object(T val) {
+                return number_traits<double>::box(static_cast<double>(val));
+            }
+
+            // any number but a complex one
+            static T from_object(Object const& obj) {
+                switch(number_kind_of(obj)) {
+                    case NumberKind::Fixnum:   return static_cast<T>(obj.as_fixnum());
+                    case NumberKind::Bignum:   return static_cast<T>(number_traits<BigInt>::unbox(obj).to_double());
+                    case NumberKind::Rational: return static_cast<T>(number_traits<Ratio>::unbox(obj).to_double());
+                    case NumberKind::Real:     return static_cast<T>(number_traits<double>::unbox(obj));
+                    default:                   throw Error{"expects a real number"};
+                }
+            }
+        };
+
+        template<typename T>
+        Object to_object(T const& val) {
+            return convert<std::decay_t<T>>::to_object(val);
+        }
+
+        template<typename T>
+        T from_object(Object const& obj) {
+            return convert<std::decay_t<T>>::from_object(obj);
+        }
+
+        // the result and argument types of a function pointer, or of the
+        // call operator of a lambda or other function object
+        template<typename F>
+        struct signature : signature<decltype(&F::operator())> {};
+
+        template<typename R, typename... A>
+        struct signature<R (*)(A...)> {
+            using result = R;
+            using args   = std::tuple<std::decay_t<A>...>;
+        };
+
+        template<typename R, typename... A>
+        struct signature<R (A...)> : signature<R (*)(A...)> {};
+
+        template<typename C, typename R, typename... A>
+        struct signature<R (C::*)(A...)> : signature<R (*)(A...)> {};
+
+        template<typename C, typename R, typename... A>
+        struct signature<R (C::*)(A...) const> : signature<R (*)(A...)> {};
+
+        // a host function made callable from scheme, with a Primitive of its
+        // own that gives its name and the arity it was declared with. the
+        // arguments are converted to the declared types, the result back
+        // into an Object; a function returning void gives the unspecified
+        // value. the Procedure calling it must not outlive it
+        class Native {
+        public:
+            virtual ~Native() = default;
+
+            Native(Native const&) = delete;
+            Native& operator=(Native const&) = delete;
+
+            Primitive const& primitive() const {
+                return prim_;
+            }
+
+        protected:
+            Native(std::string name, std::uint32_t arity, Primitive::Native call)
+                : name_{std::move(name)}
+                , prim_{name_.c_str(), {arity, arity}, call, nullptr, nullptr, nullptr, nullptr}
+            {}
+
+            std::string const& name() const {
+                return name_;
+            }
+
+        private:
+            std::string name_;
+            Primitive prim_;
+        };
+
+        template<typename F>
+        class Function : public Native {
+        public:
+            using Args = typename signature<F>::args;
+            using Result = typename signature<F>::result;
+
+            Function(std::string name, F fn)
+                : Native(std::move(name), std::tuple_size_v<Args>, call)
+                , fn_{std::move(fn)}
+            {}
+
+        private:
+            static Object call(yasc::Args args, void* data) {
+                auto self = static_cast<Function*>(data);
+                return self->invoke(args, std::make_index_sequence<std::tuple_size_v<Args>>{});
+            }
+
+            template<std::size_t... I>
+            Object invoke(yasc::Args args, std::index_sequence<I...>) {
+                Args converted{argument<I>(args)...};
+                if constexpr(std::is_void_v<Result>) {
+                    std::apply(fn_, std::move(converted));
+                    return Object::unspecified();
+                } else {
+                    return to_object(std::apply(fn_, std::move(converted)));
+                }
+            }
+
+            template<std::size_t I>
+            std::tuple_element_t<I, Args> argument(yasc::Args args) const {
+                try {
+                    return from_object<std::tuple_element_t<I, Args>>(args[I]);
+                } catch(Error const& err) {
+                    throw Error{name() + ": argument " + std::to_string(I + 1) + " " + err.what()};
+                }
+            }
+
+            F fn_;
+        };
+    };
+};
+
+#endif // __YASC_EMBED_H_
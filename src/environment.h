@@ -0,0 +1,157 @@
+#ifndef __YASC_ENVIRONMENT_H_
+#define __YASC_ENVIRONMENT_H_
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "error.h"
+#include "ast/object.h"
+#include "ast/symbol.h"
+#include "gc/heap.h"
+
+namespace yasc {
+    // one global variable. cells are never moved or freed while their
+    // Context lives, so compiled code can hold on to them
+    struct GlobalCell {
+        Object value; // null while unbound
+        Symbol name;
+    };
+
+    // the global environment. every global name is given a slot the first
+    // time it is mentioned, so compiled code refers to globals by index and
+    // only the compiler ever looks a name up; the VM then resolves each
+    // slot to its cell once per Code (see VM::run).
+    //
+    // an environment is a root of the collector for as long as it exists.
+    // each one has a stamp no other environment ever had, which tells code
+    // linked to its cells from code linked to some other environment's, and
+    // a version that moves on whenever a global may have been (re)bound.
+    class Context {
+    public:
+        Context()
+            : stamp_{next_stamp()}
+            , roots_{[this] (gc::Tracer& t) { trace(t); }}
+        {}
+
+        // a copy has cells of its own, and so a stamp of its own
+        Context(Context const& other)
+            : slots_{other.slots_}
+            , cells_{other.cells_}
+            , stamp_{next_stamp()}
+            , roots_{[this] (gc::Tracer& t) { trace(t); }}
+        {}
+
+        // moving keeps the cells where they are, and with them the stamp
+        Context(Context&& other)
+            : slots_{std::move(other.slots_)}
+            , cells_{std::move(other.cells_)}
+            , stamp_{other.stamp_}
+            , roots_{[this] (gc::Tracer& t) { trace(t); }}
+        {
+            other.stamp_ = next_stamp();
+        }
+
+        Context& operator=(Context const&) = delete;
+        Context& operator=(Context&&) = delete;
+
+        // the slot bound to `name', allocated (and unbound) on first use
+        std::uint32_t slot(Symbol const& name) {
+            auto itr = slots_.find(name);
+            if(slots_.end() != itr) {
+                return itr->second;
+            }
+            auto index = static_cast<std::uint32_t>(cells_.size());
+            slots_.emplace(name, index);
+            cells_.push_back({Object{}, name});
+            return index;
+        }
+
+        std::uint32_t slot(std::string_view name) {
+            return slot(Symbol::intern(name));
+        }
+
+        Object& operator[](std::string_view name) {
+            changed();
+            return cells_[slot(name)].value;
+        }
+
+        // an unbound slot holds the null Object
+        Object const& at(std::uint32_t slot) const {
+            return cells_[slot].value;
+        }
+
+        // binds `slot', which moves the version on
+        void set(std::uint32_t slot, Object const& val) {
+            changed();
+            cells_[slot].value = val;
+        }
+
+        Object const& at(Symbol const& name) const {
+            auto itr = slots_.find(name);
+            if(slots_.end() == itr || cells_[itr->second].value.is_null()) {
+                throw Error{"unbound variable `" + name.name() + "'"};
+            }
+            return cells_[itr->second].value;
+        }
+
+        // the value of `name', or the null Object when it is unbound; never
+        // allocates a slot
+        Object lookup(Symbol const& name) const {
+            auto itr = slots_.find(name);
+            return (slots_.end() == itr) ? Object{} : cells_[itr->second].value;
+        }
+
+        GlobalCell& cell(std::uint32_t slot) {
+            return cells_[slot];
+        }
+
+        Symbol const& name(std::uint32_t slot) const {
+            return cells_[slot].name;
+        }
+
+        std::size_t size() const {
+            return cells_.size();
+        }
+
+        std::uint64_t stamp() const {
+            return stamp_;
+        }
+
+        // to be called by whoever binds a global through its cell
+        void changed() {
+            ++version_;
+        }
+
+        std::uint64_t version() const {
+            return version_;
+        }
+
+        void trace(gc::Tracer& t) {
+            for(auto& cell : cells_) {
+                t(cell.value);
+            }
+        }
+
+    private:
+        static std::uint64_t next_stamp() {
+            static std::atomic<std::uint64_t> stamps{1};
+            return stamps++;
+        }
+
+        std::unordered_map<Symbol, std::uint32_t> slots_;
+
+        // a deque never moves its elements as it grows
+        std::deque<GlobalCell> cells_;
+
+        std::uint64_t stamp_;
+        std::uint64_t version_ = 0;
+        gc::ScopedRoots roots_;
+    };
+};
+
+#endif // __YASC_ENVIRONMENT_H_
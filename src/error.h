@@ -0,0 +1,46 @@
+#ifndef __YASC_ERROR_H_
+#define __YASC_ERROR_H_
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+
+namespace yasc {
+    // raised for malformed programs and for errors while running them. the
+    // repl reports it and carries on with the next line.
+    class Error : public std::runtime_error {
+    public:
+        using std::runtime_error::runtime_error;
+    };
+
+    // how deeply lists may nest in what is read. the passes over a program
+    // recurse on the native stack, and this keeps them well inside it
+    constexpr std::size_t max_nesting = 1000;
+
+    // one more level in `depth' for as long as it lives, so that an Error
+    // thrown from deep inside a pass leaves the count as it was
+    class Nesting {
+    public:
+        explicit Nesting(std::size_t& depth)
+            : depth_{depth}
+        {
+            ++depth_;
+        }
+
+        ~Nesting() {
+            --depth_;
+        }
+
+        Nesting(Nesting const&) = delete;
+        Nesting& operator=(Nesting const&) = delete;
+
+        bool deeper_than(std::size_t limit) const {
+            return depth_ > limit;
+        }
+
+    private:
+        std::size_t& depth_;
+    };
+};
+
+#endif // __YASC_ERROR_H_
@@ -1,78 +1,255 @@
 #ifndef __YASC_EVALUATOR_H_
 #define __YASC_EVALUATOR_H_
 
-#include <unordered_map>
+#include <deque>
+#include <memory>
 #include <utility>
+#include <vector>
 
 #include "ast/value.h"
+#include "ast/object.h"
 #include "ast/procedure.h"
 #include "ast/number.h"
 #include "ast/list.h"
 #include "ast/identifier.h"
 
+#include "gc/heap.h"
+
+#include "vm/compiler.h"
+#include "vm/optimizer.h"
+#include "vm/profiler.h"
+#include "vm/vm.h"
+
 #include "libscheme/arithmetic.h"
+#include "libscheme/uvector.h"
+#include "libscheme/io.h"
+#include "libscheme/lists.h"
+#include "libscheme/memory.h"
+#include "libscheme/parallel.h"
+#include "libscheme/channels.h"
+
+#include "environment.h"
+#include "trace.h"
 
 namespace yasc {
-    using Context = std::unordered_map<std::string, Value::Ptr>;
     struct Expression {
-        using Ptr = std::shared_ptr<Expression>;
+        using Ptr = std::unique_ptr<Expression>;
+
+        Expression() = default;
+        Expression(Expression&&) = default;
+        Expression& operator=(Expression&&) = default;
 
-        Value::Ptr value;
+        // unlink iteratively, a long program must not recurse once per form
+        ~Expression() {
+            for(auto cur = std::move(next); cur; cur = std::move(cur->next)) {}
+        }
+
+        Object value;
         Expression::Ptr next;
     };
 
     class Evaluator {
     public:
+        // forms are compiled and run on the VM, which quickens its call
+        // sites unless told not to; the AST walker is kept around so the
+        // two can be diffed
+        enum class Mode {
+            Quickening,
+            Bytecode,
+            Ast
+        };
+
+        // the evaluator keeps a global environment of its own, set up once
+        // with the builtins, which definitions are made in and which lasts
+        // from one form to the next. forms are run through the Optimizer at
+        // `opt_level' first
+        explicit Evaluator(Mode mode = Mode::Quickening, unsigned opt_level = 1)
+            : mode_{mode}
+            , opt_level_{opt_level}
+            , globals_{get_scheme_context()}
+            , vm_{Mode::Quickening == mode}
+            , profiler_{std::make_shared<vm::Profiler>()}
+        {}
+
+        Mode mode() const {
+            return mode_;
+        }
+
+        Context& globals() {
+            return globals_;
+        }
+
+        vm::QuickeningStats const& quickening() const {
+            return vm_.quickening();
+        }
+
+        // how many calls that are not tail calls may be nested
+        void set_max_depth(std::size_t depth) {
+            vm_.set_max_depth(depth);
+        }
+
+        vm::OptimizationStats const& optimizations() const {
+            return optimizations_;
+        }
+
+        // profiles what the VM runs from now on, until stop_profiling();
+        // the tree walker is never profiled. copies of the evaluator share
+        // its profiler
+        void start_profiling(vm::Profiler::Mode mode) {
+            profiler_->start(mode);
+            vm_.set_profiler(profiler_.get());
+        }
+
+        void stop_profiling() {
+            profiler_->stop();
+            vm_.set_profiler(nullptr);
+        }
+
+        vm::Profiler const& profiler() const {
+            return *profiler_;
+        }
+
+        // the primitives every environment starts out with, made once for
+        // the whole process and shared by every environment (and so by
+        // every isolate). they are made outside of any heap, which the
+        // collector leaves alone, and a primitive never changes
+        static std::vector<std::pair<Symbol, Object>> const& builtins() {
+            static std::deque<Procedure> procedures;
+            static std::vector<std::pair<Symbol, Object>> const bindings = [] {
+                std::vector<std::pair<Symbol, Object>> ret;
+                for(auto const* prims : {&arithmetic::primitives(), &uvector::primitives(), &io::primitives(),
+                                         &lists::primitives(), &memory::primitives(), &parallel::primitives(),
+                                         &channels::primitives()}) {
+                    for(auto prim : *prims) {
+                        ret.emplace_back(Symbol::intern(prim->name), Object{&procedures.emplace_back(*prim)});
+                    }
+                }
+                return ret;
+            }();
+            return bindings;
+        }
+
         static Context get_scheme_context() {
             Context ctx;
-            ctx["+"] = arithmetic::get_plus<Integer>();
-            ctx["-"] = arithmetic::get_minus<Integer>();
-            ctx["*"] = arithmetic::get_multiplies<Integer>();
-            ctx["/"] = arithmetic::get_divides<Integer>();
+            for(auto const& [name, proc] : builtins()) {
+                ctx.set(ctx.slot(name), proc);
+            }
             return ctx;
         }
 
-        std::pair<Value::Ptr, Context> value_reduce(Value* val, Context ctx) {
-            auto reduction = Value::Ptr{nullptr};
-            switch(val->type()) {
-                case Value::Type::Number: {
-                    auto num = value_cast<Integer*>(val);
-                    return std::make_pair(std::make_shared<Integer>(*num), ctx);
-                }
+        Object value_reduce(Object const& val, Context const& ctx) {
+            auto reduction = Object{};
+            switch(val.type()) {
+                case Value::Type::Number:
+                case Value::Type::Boolean:
+                case Value::Type::Character:
+                case Value::Type::EmptyList:
+                case Value::Type::NumVector:
+                    return val;
                 case Value::Type::Identifier: {
                     auto id = value_cast<Identifier*>(val);
-                    return std::make_pair(ctx.at(id->id()), ctx);
+                    return ctx.at(id->symbol());
                 }
                 case Value::Type::List: {
                     auto list = value_cast<List*>(val);
-                    auto new_list= List{};
-                    for(auto& i : *list) {
-                        auto [result, _] = value_reduce(&i, ctx);
-                        new_list.push_back(result);
+                    auto func = value_reduce(list->car(), ctx);
+                    std::vector<Object> args;
+                    args.reserve(list->size() - 1);
+                    for(auto itr = ++list->begin(); itr != list->end(); ++itr) {
+                        args.push_back(value_reduce(*itr, ctx));
                     }
-                    auto func = value_cast<Procedure*>(new_list.car());
-                    reduction = func->apply(*new_list.cdr());
+                    reduction = value_cast<Procedure*>(func)->call(Args{args.data(), static_cast<std::uint32_t>(args.size())});
                     break;
                 }
                 default: break;
                     //reduction = std::make_shared<Value>(*val);
             }
-            return std::make_pair(reduction, ctx);
+            return reduction;
+        }
+
+        // evaluates the forms in the evaluator's own environment
+        Object operator()(Expression* expr) {
+            return run(expr, globals_);
+        }
+
+        Object operator()(Object const& value) {
+            return eval(value, globals_);
+        }
+
+        // and in `ctx' instead, leaving the evaluator's alone
+        Object operator()(Expression* expr, Context ctx) {
+            return run(expr, ctx);
+        }
+
+        Object operator()(Object const& value, Context ctx) {
+            return eval(value, ctx);
+        }
+
+        // compiles a form into a procedure of no arguments, to be run with
+        // apply() as often as needed without compiling it again
+        Object compile(Object const& value) {
+            if(Mode::Ast == mode_) {
+                throw Error{"compile: the tree walker does not compile"};
+            }
+            return make_object<Closure>(compile(value, globals_));
+        }
+
+        // calls `proc', a closure or a primitive, in the evaluator's own
+        // environment
+        Object apply(Object const& proc, Args args) {
+            return vm_.apply(proc, args, globals_);
         }
 
-        Value::Ptr operator()(Expression* expr, Context ctx) {
-            auto result = Value::Ptr{nullptr};
+    private:
+        Object run(Expression* expr, Context& ctx) {
+            auto result = Object{};
+
+            // between two top level forms the only live values are the
+            // environment (a root of its own), the forms still to run and
+            // the last result
+            gc::ScopedRoots roots{[&] (gc::Tracer& t) {
+                for(auto cur = expr; cur; cur = cur->next.get()) {
+                    t(cur->value);
+                }
+                t(result);
+            }};
+
             while(expr) {
-                std::tie(result, ctx) = value_reduce(expr->value.get(), ctx);
+                result = eval(expr->value, ctx);
                 expr = expr->next.get();
+                gc::safepoint();
             }
             return result;
         }
 
-        Value::Ptr operator()(Value& value, Context ctx) {
-            auto [result, _] = value_reduce(&value, ctx);
-            return result;
+        // a top level form, traced as a span of its own
+        Object eval(Object const& value, Context& ctx) {
+            trace::Span span{"eval", "eval"};
+            if(Mode::Ast == mode_) {
+                return value_reduce(value, ctx);
+            }
+            auto code = compile(value, ctx);
+            trace::Span running{"run", "eval"};
+            return vm_.run(code, ctx);
+        }
+
+        // the Code of a top level form
+        Object compile(Object const& value, Context& ctx) {
+            auto form = Object{};
+            {
+                trace::Span optimizing{"optimize", "eval"};
+                form = vm::Optimizer{ctx, opt_level_, optimizations_}.optimize(value);
+            }
+            trace::Span compiling{"compile", "eval"};
+            return vm::Compiler{ctx}.compile(form);
         }
+
+        Mode mode_;
+        unsigned opt_level_;
+        vm::OptimizationStats optimizations_;
+        Context globals_;
+        vm::VM vm_;
+        std::shared_ptr<vm::Profiler> profiler_;
     };
 };
 
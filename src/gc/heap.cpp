@@ -0,0 +1,611 @@
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <string>
+
+#if defined(YASC_ALLOCATION_SITES)
+#   include <cstdlib>
+#   include <sstream>
+#   include <cxxabi.h>
+#   include <dlfcn.h>
+#endif
+
+#include "heap.h"
+#include "../error.h"
+#include "../trace.h"
+
+namespace yasc {
+    namespace gc {
+        namespace {
+            thread_local Heap* current = nullptr;
+
+            using clock = std::chrono::steady_clock;
+
+            double to_ms(std::chrono::nanoseconds ns) {
+                return std::chrono::duration<double, std::milli>(ns).count();
+            }
+
+            double to_s(std::chrono::nanoseconds ns) {
+                return std::chrono::duration<double>(ns).count();
+            }
+
+#if defined(YASC_ALLOCATION_SITES)
+            // the function `site' is in, and where in its binary, which
+            // addr2line turns into a line when the function's name is not
+            // exported
+            std::string describe(void const* site) {
+                Dl_info info{};
+                if(0 == dladdr(site, &info) || nullptr == info.dli_fname) {
+                    return "?";
+                }
+                std::string name = info.dli_fname;
+                name = name.substr(name.rfind('/') + 1);
+                auto offset = static_cast<std::uintptr_t>(static_cast<char const*>(site) - static_cast<char const*>(info.dli_fbase));
+                std::ostringstream o;
+                o << name << "+0x" << std::hex << offset;
+                if(nullptr != info.dli_sname) {
+                    int status = 0;
+                    auto demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+                    o << " " << ((0 == status) ? demangled : info.dli_sname);
+                    std::free(demangled);
+                }
+                return o.str();
+            }
+#endif
+        }
+
+        char const* type_name(Value::Type type) {
+            switch(type) {
+                case Value::Type::Number:      return "number";
+                case Value::Type::Pair:        return "pair";
+                case Value::Type::List:        return "list";
+                case Value::Type::EmptyList:   return "empty-list";
+                case Value::Type::Identifier:  return "identifier";
+                case Value::Type::Procedure:   return "procedure";
+                case Value::Type::Boolean:     return "boolean";
+                case Value::Type::Character:   return "character";
+                case Value::Type::Unspecified: return "unspecified";
+                case Value::Type::Code:        return "code";
+                case Value::Type::Closure:     return "closure";
+                case Value::Type::NumVector:   return "numeric-vector";
+                case Value::Type::Future:      return "future";
+                case Value::Type::Channel:     return "channel";
+                case Value::Type::ListChunk:   return "list-chunk";
+            }
+            return "?";
+        }
+
+        // copies young values reachable from the slots it visits into the
+        // old space, leaving a forwarding pointer behind
+        class Evacuator : public Tracer {
+        public:
+            explicit Evacuator(Heap& heap)
+                : heap_{heap}
+            {}
+
+            void operator()(Object& slot) override {
+                if(slot.is_heap() && (Heap::header(slot.get()) & Heap::Young)) {
+                    slot = Object{heap_.evacuate(slot.get(), gray_)};
+                }
+            }
+
+            void drain() {
+                while(!gray_.empty()) {
+                    auto val = gray_.back();
+                    gray_.pop_back();
+                    val->trace(*this);
+                }
+            }
+
+        private:
+            Heap& heap_;
+            std::vector<Value*> gray_;
+        };
+
+        // marks old values reachable from the slots it visits. uses an
+        // explicit stack so that long cdr chains cannot overflow the C++ one
+        class Marker : public Tracer {
+        public:
+            void operator()(Object& slot) override {
+                if(!slot.is_heap()) {
+                    return;
+                }
+                auto& header = Heap::header(slot.get());
+                if((header & Heap::Old) && !(header & Heap::Marked)) {
+                    header |= Heap::Marked;
+                    gray_.push_back(slot.get());
+                }
+            }
+
+            void drain() {
+                while(!gray_.empty()) {
+                    auto val = gray_.back();
+                    gray_.pop_back();
+                    val->trace(*this);
+                }
+            }
+
+        private:
+            std::vector<Value*> gray_;
+        };
+
+        // moves region-resident values reachable from the slots it visits
+        // into the heap, see Heap::escape
+        class Escaper : public Tracer {
+        public:
+            explicit Escaper(Heap& heap)
+                : heap_{heap}
+            {}
+
+            void operator()(Object& slot) override {
+                if(slot.is_heap() && (Heap::header(slot.get()) & Heap::InRegion)) {
+                    slot = Object{heap_.escape(slot.get(), gray_)};
+                }
+            }
+
+            void drain() {
+                while(!gray_.empty()) {
+                    auto val = gray_.back();
+                    gray_.pop_back();
+                    val->trace(*this);
+                }
+            }
+
+        private:
+            Heap& heap_;
+            std::vector<Value*> gray_;
+        };
+
+        // copies the values reachable from the slots it visits, see
+        // Heap::copy. what was copied once is shared thereafter, so cycles
+        // and shared structure survive the copy
+        class Copier : public Tracer {
+        public:
+            explicit Copier(Heap& heap)
+                : heap_{heap}
+            {}
+
+            void operator()(Object& slot) override {
+                if(slot.is_heap()) {
+                    slot = Object{heap_.copy(slot.get(), copies_, gray_)};
+                }
+            }
+
+            void drain() {
+                while(!gray_.empty()) {
+                    auto val = gray_.back();
+                    gray_.pop_back();
+                    val->trace(*this);
+                }
+            }
+
+        private:
+            Heap& heap_;
+            std::unordered_map<Value const*, Value*> copies_;
+            std::vector<Value*> gray_;
+        };
+
+        Region::Region(std::size_t chunk_size)
+            : chunk_size_{chunk_size}
+            , top_{nullptr}
+            , limit_{nullptr}
+            , bytes_{0}
+        {
+            chunks_.emplace_back(new std::byte[chunk_size_]);
+            top_   = chunks_.front().get();
+            limit_ = top_ + chunk_size_;
+        }
+
+        Region::~Region() {
+            release();
+        }
+
+        void* Region::allocate(std::size_t size) {
+            if(size > static_cast<std::size_t>(limit_ - top_)) {
+                auto chunk = std::max(size, chunk_size_);
+                chunks_.emplace_back(new std::byte[chunk]);
+                top_   = chunks_.back().get();
+                limit_ = top_ + chunk;
+            }
+            auto mem = top_;
+            top_   += size;
+            bytes_ += size;
+            return mem;
+        }
+
+        void Region::release() {
+            // the descriptor is kept on the side: an escaped value's own
+            // header has been overwritten with its forwarding address
+            for(auto [val, desc] : finalizable_) {
+                desc->destroy(val);
+            }
+            finalizable_.clear();
+
+            chunks_.resize(1);
+            top_   = chunks_.front().get();
+            limit_ = top_ + chunk_size_;
+            bytes_ = 0;
+        }
+
+        OldSpace::OldSpace()
+            : top_{nullptr}
+            , limit_{nullptr}
+        {
+            free_.fill(nullptr);
+        }
+
+        void OldSpace::next_block() {
+            // whatever is left of the current block is wasted, at most a
+            // cell of the largest class
+            blocks_.emplace_back(new std::byte[block_size]);
+            top_   = blocks_.back().get();
+            limit_ = top_ + block_size;
+        }
+
+        Heap::Heap(Config config)
+            : config_{config}
+            , chunk_index_{0}
+            , top_{nullptr}
+            , limit_{nullptr}
+            , young_bytes_{0}
+            , old_bytes_{0}
+            , old_limit_{config.old_size}
+            , region_{nullptr}
+            , created_{clock::now()}
+        {
+            chunks_.emplace_back(new std::byte[config_.chunk_size]);
+            top_   = chunks_.front().get();
+            limit_ = top_ + config_.chunk_size;
+        }
+
+        Heap::~Heap() {
+            if(nullptr != dump_) {
+                dump();
+            }
+            for(auto val : finalizable_) {
+                val->desc_->destroy(val);
+            }
+            for(auto val : old_) {
+                auto size = round_up(val->desc_->size);
+                if(nullptr != val->desc_->destroy) {
+                    val->desc_->destroy(val);
+                }
+                old_space_.free(val, size);
+            }
+        }
+
+        void Heap::next_chunk() {
+            chunk_ends_.push_back(top_);
+            if(++chunk_index_ == chunks_.size()) {
+                chunks_.emplace_back(new std::byte[config_.chunk_size]);
+            }
+            // whatever is left of the current chunk is wasted
+            young_bytes_ += limit_ - top_;
+            top_   = chunks_[chunk_index_].get();
+            limit_ = top_ + config_.chunk_size;
+        }
+
+        void Heap::reset_nursery() {
+            // hold on to enough chunks for a full nursery, give back the
+            // ones an oversized burst of allocation left behind
+            auto keep = std::max<std::size_t>(1, config_.nursery_size / config_.chunk_size);
+            if(chunks_.size() > keep) {
+                chunks_.resize(keep);
+            }
+            chunk_index_ = 0;
+            chunk_ends_.clear();
+            top_   = chunks_.front().get();
+            limit_ = top_ + config_.chunk_size;
+            young_bytes_ = 0;
+        }
+
+        void Heap::scan_roots(Tracer& tracer) {
+            for(auto root : roots_) {
+                tracer(*root);
+            }
+            for(auto scan : scanners_) {
+                (*scan)(tracer);
+            }
+        }
+
+        Value* Heap::evacuate(Value* val, std::vector<Value*>& gray) {
+            if(val->gc_ & Forwarded) {
+                return val->forward_;
+            }
+
+            auto desc = val->desc_;
+            auto size = round_up(desc->size);
+            auto copy = desc->relocate(val, allocate_old(size));
+            copy->gc_   = Old;
+            copy->desc_ = desc;
+
+            val->gc_ |= Forwarded;
+            val->forward_ = copy;
+
+            old_.push_back(copy);
+            old_bytes_ += size;
+            stats_.bytes_promoted += size;
+            gray.push_back(copy);
+            return copy;
+        }
+
+        Value* Heap::escape(Value* val, std::vector<Value*>& gray) {
+            if(val->gc_ & Forwarded) {
+                return val->forward_;
+            }
+
+            auto desc  = val->desc_;
+            auto size  = round_up(desc->size);
+            auto large = size > config_.chunk_size / 4;
+            auto copy  = desc->relocate(val, large ? allocate_old(size) : allocate_young(size));
+            adopt(copy, *desc, large);
+
+            val->gc_ |= Forwarded;
+            val->forward_ = copy;
+
+            gray.push_back(copy);
+            return copy;
+        }
+
+        Object Heap::escape(Object obj) {
+            Escaper escaper{*this};
+            escaper(obj);
+            escaper.drain();
+            return obj;
+        }
+
+        Value* Heap::copy(Value* val, std::unordered_map<Value const*, Value*>& copies, std::vector<Value*>& gray) {
+            // values the collector does not own are never freed, nor changed
+            auto desc = val->desc_;
+            if(nullptr == desc) {
+                return val;
+            }
+            auto [itr, fresh] = copies.try_emplace(val, nullptr);
+            if(!fresh) {
+                return itr->second;
+            }
+            if(nullptr == desc->clone) {
+                throw Error{std::string{"cannot copy a "} + type_name(val->type())};
+            }
+
+            auto size = round_up(desc->size);
+            Value* copy = nullptr;
+            if(nullptr != region_) {
+                copy = desc->clone(val, region_->allocate(size));
+                copy->desc_ = desc;
+                copy->gc_   = InRegion;
+                if(nullptr != desc->destroy) {
+                    region_->finalizable_.emplace_back(copy, desc);
+                }
+                count_region(copy, size);
+            } else {
+                auto large = size > config_.chunk_size / 4;
+                copy = desc->clone(val, large ? allocate_old(size) : allocate_young(size));
+                adopt(copy, *desc, large);
+            }
+
+            itr->second = copy;
+            gray.push_back(copy);
+            return copy;
+        }
+
+        Object Heap::copy(Object obj) {
+            Copier copier{*this};
+            copier(obj);
+            copier.drain();
+            return obj;
+        }
+
+        void Heap::copy(std::vector<Object>& objs) {
+            Copier copier{*this};
+            for(auto& obj : objs) {
+                copier(obj);
+            }
+            copier.drain();
+        }
+
+        void Heap::collect_minor() {
+            trace::Span span{"minor gc", "gc"};
+            note_peak();
+            auto start = clock::now();
+
+            Evacuator evacuator{*this};
+            scan_roots(evacuator);
+            for(auto val : remembered_) {
+                val->gc_ &= ~Remembered;
+                val->trace(evacuator);
+            }
+            remembered_.clear();
+            evacuator.drain();
+
+            // everything left in the nursery is either garbage or the
+            // moved-from husk of a promoted value
+            for(auto val : finalizable_) {
+                if(val->gc_ & Forwarded) {
+                    val->forward_->desc_->destroy(val);
+                } else {
+                    val->desc_->destroy(val);
+                }
+            }
+            finalizable_.clear();
+            reset_nursery();
+
+            stats_.minor.record(clock::now() - start);
+            if(nullptr != dump_ && clock::now() >= next_dump_) {
+                dump();
+            }
+        }
+
+        void Heap::collect_major() {
+            trace::Span span{"major gc", "gc"};
+            // with the nursery empty, every live value is in the old space
+            collect_minor();
+
+            auto start = clock::now();
+
+            Marker marker;
+            scan_roots(marker);
+            marker.drain();
+
+            auto live = std::size_t{0};
+            auto survivors = std::remove_if(old_.begin(), old_.end(), [&] (Value* val) {
+                auto size = round_up(val->desc_->size);
+                if(val->gc_ & Marked) {
+                    val->gc_ &= ~Marked;
+                    live += size;
+                    return false;
+                }
+                if(nullptr != val->desc_->destroy) {
+                    val->desc_->destroy(val);
+                }
+                old_space_.free(val, size);
+                stats_.bytes_freed += size;
+                return true;
+            });
+            old_.erase(survivors, old_.end());
+
+            old_bytes_ = live;
+            old_limit_ = std::max(config_.old_size,
+                static_cast<std::size_t>(static_cast<double>(live) * config_.old_growth));
+
+            stats_.major.record(clock::now() - start);
+            if(nullptr != dump_ && clock::now() >= next_dump_) {
+                dump();
+            }
+        }
+
+        Stats const& Heap::stats() {
+            note_peak();
+            stats_.nursery_bytes = young_bytes_;
+            stats_.old_bytes     = old_bytes_;
+            stats_.old_objects   = old_.size();
+            stats_.uptime        = clock::now() - created_;
+            return stats_;
+        }
+
+        Stats const& Heap::census() {
+            for(auto& type : stats_.types) {
+                type.live       = 0;
+                type.live_bytes = 0;
+            }
+            auto count = [&] (Value const* val) {
+                auto& type = stats_.types[static_cast<std::size_t>(val->type())];
+                ++type.live;
+                type.live_bytes += round_up(val->desc_->size);
+            };
+            for(auto val : old_) {
+                count(val);
+            }
+            // the nursery is values back to back, up to where each chunk
+            // was left off
+            for(std::size_t i = 0; i <= chunk_index_; ++i) {
+                auto pos = chunks_[i].get();
+                auto end = (i == chunk_index_) ? top_ : chunk_ends_[i];
+                while(pos < end) {
+                    auto val = std::launder(reinterpret_cast<Value*>(pos));
+                    count(val);
+                    pos += round_up(val->desc_->size);
+                }
+            }
+            return stats();
+        }
+
+        void Heap::report(std::ostream& o) {
+            auto const& stats = census();
+            auto flags = o.flags();
+            auto precision = o.precision();
+            o << std::fixed << std::setprecision(1);
+            o << "heap " << stats.nursery_bytes + stats.old_bytes << "B (peak " << stats.peak_bytes << "B), "
+              << stats.bytes_allocated << "B allocated in " << stats.allocations << " values over "
+              << std::setprecision(3) << to_s(stats.uptime) << "s ("
+              << std::setprecision(1) << stats.bytes_allocated / std::max(to_s(stats.uptime), 1e-9) / (1 << 20)
+              << "MB/s), " << stats.region_bytes << "B in " << stats.region_allocations << " region values" << std::endl;
+            o << std::left << std::setw(16) << "type" << std::right
+              << std::setw(12) << "live" << std::setw(14) << "live bytes"
+              << std::setw(14) << "allocated" << std::setw(16) << "alloc bytes"
+              << std::setw(14) << "in regions" << std::setw(16) << "region bytes" << std::endl;
+            for(std::size_t i = 0; i < type_count; ++i) {
+                auto const& type = stats.types[i];
+                if(0 == type.allocations && 0 == type.live && 0 == type.region_allocations) {
+                    continue;
+                }
+                o << std::left << std::setw(16) << type_name(static_cast<Value::Type>(i)) << std::right
+                  << std::setw(12) << type.live << std::setw(14) << type.live_bytes
+                  << std::setw(14) << type.allocations << std::setw(16) << type.bytes
+                  << std::setw(14) << type.region_allocations << std::setw(16) << type.region_bytes << std::endl;
+            }
+#if defined(YASC_ALLOCATION_SITES)
+            // the sites that allocated the most
+            std::vector<std::pair<void const*, SiteStats>> sites(sites_.begin(), sites_.end());
+            std::sort(sites.begin(), sites.end(), [] (auto const& a, auto const& b) {
+                return a.second.bytes > b.second.bytes;
+            });
+            if(sites.size() > 20) {
+                sites.resize(20);
+            }
+            if(!sites.empty()) {
+                o << std::setw(12) << "allocations" << std::setw(14) << "bytes" << "  site" << std::endl;
+            }
+            for(auto const& [site, counts] : sites) {
+                o << std::setw(12) << counts.allocations << std::setw(14) << counts.bytes << "  "
+                  << type_name(counts.type) << " at " << describe(site) << std::endl;
+            }
+#endif
+            o.flags(flags);
+            o.precision(precision);
+        }
+
+        void Heap::dump_to(std::unique_ptr<std::ostream> out, std::chrono::milliseconds every) {
+            dump_       = std::move(out);
+            dump_every_ = every;
+            next_dump_  = clock::now();
+        }
+
+        void Heap::dump() {
+            report(*dump_);
+            *dump_ << std::endl;
+            next_dump_ = clock::now() + dump_every_;
+        }
+
+        std::ostream& operator<<(std::ostream& o, Stats const& stats) {
+            auto flags = o.flags();
+            auto precision = o.precision();
+            auto generation = [&] (char const* name, GenerationStats const& gen) {
+                o << name << ": " << gen.collections << " collections, "
+                  << std::fixed << std::setprecision(3)
+                  << "pause total " << to_ms(gen.total_pause) << "ms, "
+                  << "max " << to_ms(gen.max_pause) << "ms, "
+                  << "last " << to_ms(gen.last_pause) << "ms" << std::endl;
+            };
+            generation("minor", stats.minor);
+            generation("major", stats.major);
+            o << "allocated " << stats.bytes_allocated << "B in " << stats.allocations << " values, "
+              << "promoted " << stats.bytes_promoted << "B, "
+              << "freed " << stats.bytes_freed << "B" << std::endl;
+            o << "nursery " << stats.nursery_bytes << "B, "
+              << "old " << stats.old_bytes << "B in " << stats.old_objects << " objects, "
+              << "peak " << stats.peak_bytes << "B";
+            o.flags(flags);
+            o.precision(precision);
+            return o;
+        }
+
+        Heap& current_heap() {
+            if(nullptr == current) {
+                thread_local Heap heap;
+                current = &heap;
+            }
+            return *current;
+        }
+
+        HeapScope::HeapScope(Heap& heap)
+            : prev_{&current_heap()}
+        {
+            current = &heap;
+        }
+
+        HeapScope::~HeapScope() {
+            current = prev_;
+        }
+    };
+};
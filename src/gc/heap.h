@@ -0,0 +1,640 @@
+#ifndef __YASC_GC_HEAP_H_
+#define __YASC_GC_HEAP_H_
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "../ast/value.h"
+#include "../ast/object.h"
+
+namespace yasc {
+    namespace gc {
+        // visits (and may rewrite) every Object slot reachable from a value
+        // or root. see Value::trace.
+        class Tracer {
+        public:
+            virtual void operator()(Object& slot) = 0;
+
+        protected:
+            ~Tracer() = default;
+        };
+
+        // per-type information the collector needs to move, copy and
+        // destroy a value without knowing its static type
+        struct Descriptor {
+            std::size_t size;
+            Value* (*relocate)(Value* from, void* to);
+            Value* (*clone)(Value const* from, void* to); // nullptr if not copyable
+            void   (*destroy)(Value* val); // nullptr if trivially destructible
+        };
+
+        namespace detail {
+            template<typename T>
+            Value* relocate(Value* from, void* to) {
+                return new(to) T(std::move(*static_cast<T*>(from)));
+            }
+
+            template<typename T>
+            Value* clone(Value const* from, void* to) {
+                return new(to) T(*static_cast<T const*>(from));
+            }
+
+            template<typename T>
+            constexpr Value* (*cloner())(Value const*, void*) {
+                if constexpr(std::is_copy_constructible_v<T>) {
+                    return &clone<T>;
+                } else {
+                    return nullptr;
+                }
+            }
+
+            template<typename T>
+            void destroy(Value* val) {
+                static_cast<T*>(val)->~T();
+            }
+
+            template<typename T>
+            inline constexpr Descriptor descriptor {
+                sizeof(T),
+                &relocate<T>,
+                cloner<T>(),
+                std::is_trivially_destructible_v<T> ? nullptr : &destroy<T>
+            };
+        };
+
+        struct Config {
+            // bytes allocated in the nursery before the next safepoint runs a
+            // minor collection
+            std::size_t nursery_size = std::size_t{4} << 20;
+
+            // the nursery is carved out of chunks of this size. allocations
+            // larger than a quarter of a chunk go straight to the old space
+            std::size_t chunk_size = std::size_t{256} << 10;
+
+            // old space size that triggers the first major collection. after
+            // each major collection the limit becomes live bytes * old_growth
+            std::size_t old_size   = std::size_t{32} << 20;
+            double      old_growth = 2.0;
+        };
+
+        struct GenerationStats {
+            using duration = std::chrono::nanoseconds;
+
+            std::uint64_t collections = 0;
+            duration      total_pause{0};
+            duration      max_pause{0};
+            duration      last_pause{0};
+
+            void record(duration pause) {
+                ++collections;
+                total_pause += pause;
+                last_pause   = pause;
+                max_pause    = std::max(max_pause, pause);
+            }
+        };
+
+        // one for each Value::Type
+        constexpr std::size_t type_count = static_cast<std::size_t>(Value::Type::ListChunk) + 1;
+
+        // the name of a Value::Type, for reports
+        char const* type_name(Value::Type type);
+
+        struct TypeStats {
+            std::uint64_t allocations = 0; // since the heap was created
+            std::uint64_t bytes       = 0;
+
+            // allocated in regions, likewise, which never count as live
+            std::uint64_t region_allocations = 0;
+            std::uint64_t region_bytes       = 0;
+
+            // in the heap as of the last census. values that died since the
+            // last collection are counted too, bar right after a major one
+            std::size_t live       = 0;
+            std::size_t live_bytes = 0;
+        };
+
+        struct Stats {
+            GenerationStats minor;
+            GenerationStats major;
+
+            std::uint64_t bytes_allocated = 0; // since the heap was created
+            std::uint64_t allocations     = 0; // values allocated, likewise
+            std::uint64_t bytes_promoted  = 0; // nursery survivors moved to the old space
+            std::uint64_t bytes_freed     = 0; // reclaimed from the old space
+
+            // values allocated in regions, which are released wholesale
+            std::uint64_t region_allocations = 0;
+            std::uint64_t region_bytes       = 0;
+
+            std::size_t nursery_bytes = 0;     // currently in use
+            std::size_t old_bytes     = 0;
+            std::size_t old_objects   = 0;
+
+            // the most the nursery and the old space held together, as
+            // seen before each collection and whenever stats are taken
+            std::size_t peak_bytes = 0;
+
+            std::chrono::nanoseconds uptime{0}; // since the heap was created
+
+            std::array<TypeStats, type_count> types;
+        };
+
+        std::ostream& operator<<(std::ostream& o, Stats const& stats);
+
+        // where values were allocated from, when the build counts it; see
+        // make_object
+        struct SiteStats {
+            Value::Type   type;
+            std::uint64_t allocations = 0;
+            std::uint64_t bytes       = 0;
+        };
+
+        // A bump allocator whose values are never collected one by one: they
+        // all go away together when the region is released. Used for data
+        // with an obvious lifetime, like the AST of the line being evaluated.
+        //
+        // Values in a region are not moved or traced by the collector, so a
+        // region must only point into itself (or hold immediates). Anything
+        // that has to outlive the region is copied out with Heap::escape.
+        class Region {
+        public:
+            explicit Region(std::size_t chunk_size = std::size_t{16} << 10);
+            ~Region();
+
+            Region(Region const&) = delete;
+            Region& operator=(Region const&) = delete;
+
+            // destroys every value in the region in one go. the first chunk
+            // is kept for the next round
+            void release();
+
+            std::size_t bytes() const {
+                return bytes_;
+            }
+
+        private:
+            friend class Heap;
+
+            void* allocate(std::size_t size);
+
+            std::size_t chunk_size_;
+            std::vector<std::unique_ptr<std::byte[]>> chunks_;
+            std::byte*  top_;
+            std::byte*  limit_;
+            std::size_t bytes_;
+            std::vector<std::pair<Value*, Descriptor const*>> finalizable_;
+        };
+
+        // Where the old space keeps its values. Small values come out of
+        // blocks, carved into cells of a size class per multiple of the
+        // alignment; a freed cell goes on its class' free list and is handed
+        // out again before anything new is carved. Values larger than the
+        // largest class get memory of their own from operator new.
+        //
+        // Blocks are never given back before the heap goes away: the old
+        // space is non-moving, so a block is only empty by chance.
+        class OldSpace {
+        public:
+            static constexpr std::size_t alignment  = alignof(std::max_align_t);
+            static constexpr std::size_t max_small  = 512;
+            static constexpr std::size_t block_size = std::size_t{64} << 10;
+
+            OldSpace();
+
+            OldSpace(OldSpace const&) = delete;
+            OldSpace& operator=(OldSpace const&) = delete;
+
+            // `size' must be a multiple of the alignment, and is passed
+            // again to free the memory
+            void* allocate(std::size_t size) {
+                if(size > max_small) {
+                    return ::operator new(size);
+                }
+                auto& head = free_[size / alignment - 1];
+                if(nullptr != head) {
+                    auto cell = head;
+                    head = cell->next;
+                    return cell;
+                }
+                if(size > static_cast<std::size_t>(limit_ - top_)) {
+                    next_block();
+                }
+                auto mem = top_;
+                top_ += size;
+                return mem;
+            }
+
+            void free(void* mem, std::size_t size) {
+                if(size > max_small) {
+                    ::operator delete(mem);
+                    return;
+                }
+                auto& head = free_[size / alignment - 1];
+                head = ::new(mem) Cell{head};
+            }
+
+            // held in blocks, whether in use or not
+            std::size_t reserved() const {
+                return blocks_.size() * block_size;
+            }
+
+        private:
+            struct Cell {
+                Cell* next;
+            };
+
+            void next_block();
+
+            std::vector<std::unique_ptr<std::byte[]>> blocks_;
+            std::byte* top_;
+            std::byte* limit_;
+            std::array<Cell*, max_small / alignment> free_;
+        };
+
+        // A precise, two generation collector.
+        //
+        // New values are bump-allocated in the nursery. A minor collection
+        // copies everything reachable from the roots (and from old values
+        // recorded by the write barrier) into the old space, after which the
+        // nursery is reused wholesale. The old space is non-moving and is
+        // reclaimed by mark & sweep during a major collection, which hands
+        // the dead values' cells back to the OldSpace.
+        //
+        // Collections only ever happen at safepoints. Between two safepoints
+        // C++ code is free to hold raw pointers into the heap; anything that
+        // must survive a safepoint has to be reachable from a Root or a
+        // ScopedRoots scanner.
+        class Heap {
+        public:
+            static constexpr std::size_t alignment = alignof(std::max_align_t);
+
+            explicit Heap(Config config = Config{});
+            ~Heap();
+
+            Heap(Heap const&) = delete;
+            Heap& operator=(Heap const&) = delete;
+
+            template<typename T, typename...Args>
+            T* make(Args&&...args) {
+                static_assert(std::is_base_of_v<Value, T>);
+                static_assert(alignof(T) <= alignment);
+
+                constexpr auto size = round_up(sizeof(T));
+                auto const& desc = detail::descriptor<T>;
+
+                if(nullptr != region_) {
+                    T* val = new(region_->allocate(size)) T(std::forward<Args>(args)...);
+                    val->desc_ = &desc;
+                    val->gc_   = InRegion;
+                    if(nullptr != desc.destroy) {
+                        region_->finalizable_.emplace_back(val, &desc);
+                    }
+                    count_region(val, size);
+                    return val;
+                }
+
+                auto large = size > config_.chunk_size / 4;
+                T* val = new(large ? allocate_old(size) : allocate_young(size))
+                    T(std::forward<Args>(args)...);
+                adopt(val, desc, large);
+                return val;
+            }
+
+            // copies every region-resident value reachable from `obj` into
+            // this heap and returns the (possibly new) root of the copy
+            Object escape(Object obj);
+
+            // copies every value reachable from `obj', wherever it lives,
+            // into this heap (or the region a RegionScope sends allocations
+            // to) and returns the root of the copy; the original is left as
+            // it was. this is how values cross from one thread's heap to
+            // another's, see par/scheduler.h
+            Object copy(Object obj);
+
+            // likewise for several roots at once, which go on sharing what
+            // they shared
+            void copy(std::vector<Object>& objs);
+
+            // must be called before an Object is stored into a field of
+            // `owner`, so that old-to-young pointers are found by the next
+            // minor collection
+            void write_barrier(Value* owner, Object const& val) {
+                assert(!(owner->gc_ & InRegion) || !val.is_heap() || (val->gc_ & InRegion) || nullptr == val->desc_);
+                if((owner->gc_ & Old) && !(owner->gc_ & Remembered)
+                    && val.is_heap() && (val->gc_ & Young)) {
+                    owner->gc_ |= Remembered;
+                    remembered_.push_back(owner);
+                }
+            }
+
+            // collects if either generation has outgrown its limit
+            void safepoint() {
+                if(young_bytes_ >= config_.nursery_size) {
+                    collect_minor();
+                }
+                if(old_bytes_ >= old_limit_) {
+                    collect_major();
+                }
+            }
+
+            void collect_minor();
+            void collect_major();
+
+            Stats const& stats();
+
+            // stats with every value in the heap counted by type. walks the
+            // whole heap, so it is meant for reports
+            Stats const& census();
+
+            // a census, in a table of a line per type
+            void report(std::ostream& o);
+
+            // writes a report to `out' after a collection, at most once every
+            // `every', and once more when the heap goes away
+            void dump_to(std::unique_ptr<std::ostream> out, std::chrono::milliseconds every);
+
+            // counts a value allocated by the code at `site'
+            void record_site(void const* site, Value const* val) {
+                auto& counts = sites_.try_emplace(site, SiteStats{val->type()}).first->second;
+                ++counts.allocations;
+                counts.bytes += round_up(val->desc_->size);
+            }
+
+            std::unordered_map<void const*, SiteStats> const& sites() const {
+                return sites_;
+            }
+
+            Config const& config() const {
+                return config_;
+            }
+
+            static bool is_young(Object const& obj) {
+                return obj.is_heap() && (obj->gc_ & Young);
+            }
+
+            static bool is_old(Object const& obj) {
+                return obj.is_heap() && (obj->gc_ & Old);
+            }
+
+            static bool in_region(Object const& obj) {
+                return obj.is_heap() && (obj->gc_ & InRegion);
+            }
+
+        private:
+            friend class Root;
+            friend class ScopedRoots;
+            friend class RegionScope;
+            friend class Evacuator;
+            friend class Marker;
+            friend class Escaper;
+            friend class Copier;
+
+            enum Flags : std::uint32_t {
+                Young      = 1 << 0,
+                Old        = 1 << 1,
+                Marked     = 1 << 2,
+                Remembered = 1 << 3,
+                Forwarded  = 1 << 4,
+                InRegion   = 1 << 5
+            };
+
+            static std::uint32_t& header(Value* val) {
+                return val->gc_;
+            }
+
+            static constexpr std::size_t round_up(std::size_t size) {
+                return (size + alignment - 1) & ~(alignment - 1);
+            }
+
+            void* allocate_young(std::size_t size) {
+                if(size > static_cast<std::size_t>(limit_ - top_)) {
+                    next_chunk();
+                }
+                auto mem = top_;
+                top_ += size;
+                young_bytes_ += size;
+                return mem;
+            }
+
+            void* allocate_old(std::size_t size) {
+                return old_space_.allocate(size);
+            }
+
+            // takes ownership of a freshly constructed value
+            void adopt(Value* val, Descriptor const& desc, bool large) {
+                auto size = round_up(desc.size);
+                val->desc_ = &desc;
+                if(large) {
+                    // the constructor may have stored young values without
+                    // going through the write barrier
+                    val->gc_ = Old | Remembered;
+                    old_.push_back(val);
+                    remembered_.push_back(val);
+                    old_bytes_ += size;
+                } else {
+                    val->gc_ = Young;
+                    if(nullptr != desc.destroy) {
+                        finalizable_.push_back(val);
+                    }
+                }
+                stats_.bytes_allocated += size;
+                ++stats_.allocations;
+                auto& type = stats_.types[static_cast<std::size_t>(val->type())];
+                ++type.allocations;
+                type.bytes += size;
+            }
+
+            void count_region(Value const* val, std::size_t size) {
+                ++stats_.region_allocations;
+                stats_.region_bytes += size;
+                auto& type = stats_.types[static_cast<std::size_t>(val->type())];
+                ++type.region_allocations;
+                type.region_bytes += size;
+            }
+
+            void note_peak() {
+                stats_.peak_bytes = std::max(stats_.peak_bytes, young_bytes_ + old_bytes_);
+            }
+
+            void dump();
+
+            void next_chunk();
+            void reset_nursery();
+            void scan_roots(Tracer& tracer);
+            Value* evacuate(Value* val, std::vector<Value*>& gray);
+            Value* escape(Value* val, std::vector<Value*>& gray);
+            Value* copy(Value* val, std::unordered_map<Value const*, Value*>& copies, std::vector<Value*>& gray);
+
+            Config config_;
+            Stats  stats_;
+
+            // nursery
+            std::vector<std::unique_ptr<std::byte[]>> chunks_;
+            std::vector<std::byte*> chunk_ends_; // of the chunks before chunk_index_
+            std::size_t chunk_index_;
+            std::byte*  top_;
+            std::byte*  limit_;
+            std::size_t young_bytes_;
+            std::vector<Value*> finalizable_;
+
+            // old space
+            OldSpace old_space_;
+            std::vector<Value*> old_;
+            std::vector<Value*> remembered_;
+            std::size_t old_bytes_;
+            std::size_t old_limit_;
+
+            // set while a RegionScope is active
+            Region* region_;
+
+            // roots
+            std::vector<Object*> roots_;
+            std::vector<std::function<void(Tracer&)> const*> scanners_;
+
+            std::chrono::steady_clock::time_point created_;
+            std::unordered_map<void const*, SiteStats> sites_;
+
+            std::unique_ptr<std::ostream> dump_;
+            std::chrono::milliseconds dump_every_{0};
+            std::chrono::steady_clock::time_point next_dump_;
+        };
+
+        // the heap new values are allocated from on this thread
+        Heap& current_heap();
+
+        // makes `heap` the current heap of this thread for its lifetime
+        class HeapScope {
+        public:
+            explicit HeapScope(Heap& heap);
+            ~HeapScope();
+
+            HeapScope(HeapScope const&) = delete;
+            HeapScope& operator=(HeapScope const&) = delete;
+
+        private:
+            Heap* prev_;
+        };
+
+        // sends every allocation on `heap` into `region` for its lifetime
+        class RegionScope {
+        public:
+            explicit RegionScope(Region& region, Heap& heap = current_heap())
+                : heap_{heap}
+                , prev_{heap.region_}
+            {
+                heap_.region_ = &region;
+            }
+
+            ~RegionScope() {
+                heap_.region_ = prev_;
+            }
+
+            RegionScope(RegionScope const&) = delete;
+            RegionScope& operator=(RegionScope const&) = delete;
+
+        private:
+            Heap&   heap_;
+            Region* prev_;
+        };
+
+        // keeps a single Object alive (and up to date) across safepoints
+        class Root {
+        public:
+            explicit Root(Object obj = Object{}, Heap& heap = current_heap())
+                : heap_{heap}
+                , obj_{obj}
+            {
+                heap_.roots_.push_back(&obj_);
+            }
+
+            ~Root() {
+                auto& roots = heap_.roots_;
+                roots.erase(std::find(roots.rbegin(), roots.rend(), &obj_).base() - 1);
+            }
+
+            Root(Root const&) = delete;
+            Root& operator=(Root const&) = delete;
+
+            Root& operator=(Object obj) {
+                obj_ = obj;
+                return *this;
+            }
+
+            Object const& get() const {
+                return obj_;
+            }
+
+            operator Object const&() const {
+                return obj_;
+            }
+
+        private:
+            Heap&  heap_;
+            Object obj_;
+        };
+
+        // registers a callback that reports a whole set of roots, eg. an
+        // environment or the evaluator's stack
+        class ScopedRoots {
+        public:
+            explicit ScopedRoots(std::function<void(Tracer&)> scan, Heap& heap = current_heap())
+                : heap_{heap}
+                , scan_{std::move(scan)}
+            {
+                heap_.scanners_.push_back(&scan_);
+            }
+
+            ~ScopedRoots() {
+                auto& scanners = heap_.scanners_;
+                scanners.erase(std::find(scanners.rbegin(), scanners.rend(), &scan_).base() - 1);
+            }
+
+            ScopedRoots(ScopedRoots const&) = delete;
+            ScopedRoots& operator=(ScopedRoots const&) = delete;
+
+        private:
+            Heap& heap_;
+            std::function<void(Tracer&)> const scan_;
+        };
+
+        inline void write_barrier(Value* owner, Object const& val) {
+            current_heap().write_barrier(owner, val);
+        }
+
+        inline void safepoint() {
+            current_heap().safepoint();
+        }
+    };
+
+    // built with YASC_ALLOCATION_SITES defined, the heap also counts what
+    // each caller of make_object allocated, by its return address; it is
+    // kept out of line to have one
+#if defined(YASC_ALLOCATION_SITES)
+    template<typename T, typename...Args>
+    __attribute__((noinline)) Object make_object(Args&&...args) {
+        auto& heap = gc::current_heap();
+        auto val = heap.make<T>(std::forward<Args>(args)...);
+        heap.record_site(__builtin_return_address(0), val);
+        return Object{val};
+    }
+#else
+    template<typename T, typename...Args>
+    Object make_object(Args&&...args) {
+        return Object{gc::current_heap().make<T>(std::forward<Args>(args)...)};
+    }
+#endif
+}; // end of namespace yasc
+
+#endif // __YASC_GC_HEAP_H_
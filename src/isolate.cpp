@@ -0,0 +1,168 @@
+#include <sstream>
+#include <utility>
+
+#include "isolate.h"
+#include "error.h"
+#include "lexer.h"
+#include "parser.h"
+#include "trace.h"
+#include "par/scheduler.h"
+
+namespace yasc {
+    namespace {
+        // the isolate this thread is in, innermost first
+        thread_local Isolate* entered = nullptr;
+    }
+
+    Isolate::Scope::Scope(Isolate& isolate)
+        : isolate_{isolate}
+        , prev_{entered}
+        , nested_{&isolate == entered}
+    {
+        if(nested_) {
+            return;
+        }
+        if(isolate_.running_.exchange(true, std::memory_order_acquire)) {
+            throw Error{"isolate: already running on another thread"};
+        }
+        par::detach();
+        heap_.emplace(isolate_.heap_);
+        entered = &isolate_;
+    }
+
+    Isolate::Scope::~Scope() {
+        if(nested_) {
+            return;
+        }
+        par::detach();
+        entered = prev_;
+        heap_.reset();
+        isolate_.running_.store(false, std::memory_order_release);
+    }
+
+    Isolate::Isolate(Evaluator::Mode mode, gc::Config config)
+        : heap_{config}
+    {
+        Scope scope{*this};
+        evaluator_ = std::make_unique<Evaluator>(mode);
+    }
+
+    Isolate::~Isolate() {
+        Scope scope{*this};
+        evaluator_.reset();
+    }
+
+    std::string Isolate::run(std::string_view source) {
+        Scope scope{*this};
+        trace::Span span{"isolate", "isolate"};
+        Lexer lexer{source};
+        Parser parser;
+        gc::Region region;
+        gc::Root result;
+        for(;;) {
+            auto form = parser.next(lexer, region);
+            if(form.is_null()) {
+                break;
+            }
+            result = heap_.escape((*evaluator_)(form));
+            region.release();
+            gc::safepoint();
+        }
+        std::ostringstream o;
+        if(!result.get().is_null()) {
+            o << result.get();
+        }
+        return o.str();
+    }
+
+    void Isolate::define(std::string_view name, Object const& val) {
+        Scope scope{*this};
+        auto copy = heap_.copy(val);
+        evaluator_->globals()[name] = copy;
+    }
+
+    CompiledExpr Isolate::compile(std::string_view source) {
+        Scope scope{*this};
+        Lexer lexer{source};
+        Parser parser;
+        gc::Region region;
+        auto form = parser.next(lexer, region);
+        if(form.is_null() || !parser.next(lexer, region).is_null()) {
+            throw Error{"compile: expects a single expression"};
+        }
+        return CompiledExpr{*this, evaluator_->compile(form)};
+    }
+
+    Global Isolate::global(std::string_view name) {
+        Scope scope{*this};
+        auto& globals = evaluator_->globals();
+        return Global{*this, globals.cell(globals.slot(name))};
+    }
+
+    CompiledExpr::CompiledExpr(Isolate& isolate, Object closure)
+        : isolate_{&isolate}
+        , closure_{std::make_unique<gc::Root>(closure, isolate.heap())}
+    {}
+
+    CompiledExpr::~CompiledExpr() {
+        if(closure_) {
+            Isolate::Scope scope{*isolate_};
+            closure_.reset();
+        }
+    }
+
+    // a collection may only move the closure before it is read
+    Object CompiledExpr::invoke() {
+        gc::safepoint();
+        return isolate_->evaluator().apply(closure_->get(), Args{nullptr, 0});
+    }
+
+    IsolatePool::IsolatePool(unsigned threads) {
+        for(unsigned i = 0; i < std::max(1u, threads); ++i) {
+            threads_.emplace_back([this, i] {
+                trace::name_thread("isolates " + std::to_string(i));
+                work();
+            });
+        }
+    }
+
+    IsolatePool::~IsolatePool() {
+        {
+            std::lock_guard<std::mutex> guard{lock_};
+            stopping_ = true;
+        }
+        ready_.notify_all();
+        for(auto& thread : threads_) {
+            thread.join();
+        }
+    }
+
+    std::future<std::string> IsolatePool::run(std::shared_ptr<Isolate> isolate, std::string source) {
+        std::packaged_task<std::string()> job{[isolate = std::move(isolate), source = std::move(source)] {
+            return isolate->run(source);
+        }};
+        auto ret = job.get_future();
+        {
+            std::lock_guard<std::mutex> guard{lock_};
+            jobs_.push_back(std::move(job));
+        }
+        ready_.notify_one();
+        return ret;
+    }
+
+    void IsolatePool::work() {
+        for(;;) {
+            std::packaged_task<std::string()> job;
+            {
+                std::unique_lock<std::mutex> guard{lock_};
+                ready_.wait(guard, [this] { return stopping_ || !jobs_.empty(); });
+                if(jobs_.empty()) {
+                    return;
+                }
+                job = std::move(jobs_.front());
+                jobs_.pop_front();
+            }
+            job();
+        }
+    }
+};
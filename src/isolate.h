@@ -0,0 +1,229 @@
+#ifndef __YASC_ISOLATE_H_
+#define __YASC_ISOLATE_H_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "embed.h"
+#include "evaluator.h"
+#include "environment.h"
+#include "ast/object.h"
+#include "ast/procedure.h"
+#include "gc/heap.h"
+
+namespace yasc {
+    class CompiledExpr;
+    class Global;
+
+    // an interpreter of its own: a heap, a global environment and a VM.
+    // isolates share nothing that changes, so any number of them run in
+    // parallel, one per thread, without ever waiting on one another. what
+    // they do share is read only: the builtins (see Evaluator::builtins)
+    // and the table of symbols, which only makes them wait to add a name
+    // none has seen. they talk through channels (see
+    // ast/channel.h), which copy what is sent from one heap to the other.
+    //
+    // an isolate runs on whichever thread calls into it, one thread at a
+    // time. making one allocates nothing on its heap.
+    //
+    // to embed it, compile() an expression once and run the CompiledExpr
+    // as often as needed, with its inputs in globals set through their
+    // Global handles, and define_native() the host functions it calls
+    class Isolate {
+    public:
+        // the calling thread running the isolate, on its heap, for as long
+        // as it lives. entering the isolate the thread is already in costs
+        // nothing, so a thread that makes many calls in a row enters it
+        // once around them. the futures the thread made elsewhere are left
+        // behind, and so are the isolate's when it leaves: their tasks live
+        // on the heap they were made on (see par::detach)
+        class Scope {
+        public:
+            explicit Scope(Isolate& isolate);
+            ~Scope();
+
+            Scope(Scope const&) = delete;
+            Scope& operator=(Scope const&) = delete;
+
+        private:
+            Isolate& isolate_;
+            Isolate* prev_;
+            bool nested_;
+            std::optional<gc::HeapScope> heap_;
+        };
+
+        explicit Isolate(Evaluator::Mode mode = Evaluator::Mode::Quickening, gc::Config config = gc::Config{});
+        ~Isolate();
+
+        Isolate(Isolate const&) = delete;
+        Isolate& operator=(Isolate const&) = delete;
+
+        // evaluates the forms of `source' in turn, and returns the value of
+        // the last one as printed. rethrows what the forms raised
+        std::string run(std::string_view source);
+
+        // binds the global `name' to a copy of `val', which may live in any
+        // heap: a channel to talk to the isolate through, say
+        void define(std::string_view name, Object const& val);
+
+        // binds the global `name' to the host function `fn', a function
+        // pointer or a function object. its arity and the types of its
+        // arguments and result are those it is declared with (see
+        // embed::convert), and a call with arguments of the wrong type is an
+        // Error. the procedure lives as long as the isolate, and only works
+        // within it
+        template<typename F>
+        void define_native(std::string_view name, F fn) {
+            auto native = std::make_unique<embed::Function<F>>(std::string{name}, std::move(fn));
+            Scope scope{*this};
+            evaluator_->globals()[name] = make_object<Procedure>(native->primitive(), native.get());
+            natives_.push_back(std::move(native));
+        }
+
+        // compiles the one expression in `source' into code that can be run
+        // any number of times. the globals it refers to need not be bound
+        // until it runs
+        CompiledExpr compile(std::string_view source);
+
+        // the global `name', to be set and read by its slot rather than by
+        // name from now on
+        Global global(std::string_view name);
+
+        // whether a thread is running the isolate right now
+        bool running() const {
+            return running_.load(std::memory_order_acquire);
+        }
+
+        gc::Heap& heap() {
+            return heap_;
+        }
+
+        // only to be used by the thread running the isolate
+        Evaluator& evaluator() {
+            return *evaluator_;
+        }
+
+    private:
+        gc::Heap heap_;
+        std::unique_ptr<Evaluator> evaluator_;
+        std::vector<std::unique_ptr<embed::Native>> natives_;
+        std::atomic<bool> running_{false};
+    };
+
+    // an expression compiled once by an isolate, run in it as often as
+    // needed. a run neither parses nor compiles, and when the globals it
+    // reads and the value it returns are fixnums, it allocates nothing.
+    //
+    // it may be run from any thread, as long as no other thread runs the
+    // isolate at the same time (see Isolate::Scope), and must not outlive
+    // the isolate
+    class CompiledExpr {
+    public:
+        CompiledExpr(CompiledExpr&&) = default;
+        CompiledExpr& operator=(CompiledExpr&&) = delete;
+        ~CompiledExpr();
+
+        // the value of the expression, as `R' (see embed::convert). an
+        // Object is only good until the next call into the isolate
+        template<typename R = Object>
+        R run() {
+            Isolate::Scope scope{*isolate_};
+            return embed::from_object<R>(invoke());
+        }
+
+    private:
+        friend class Isolate;
+
+        CompiledExpr(Isolate& isolate, Object closure);
+
+        Object invoke();
+
+        Isolate* isolate_;
+        std::unique_ptr<gc::Root> closure_;
+    };
+
+    // a global of an isolate, bound to its slot: setting it writes its cell
+    // without looking the name up. it may be used from any thread under the
+    // same terms as a CompiledExpr
+    class Global {
+    public:
+        // binds the global to `val', converted (see embed::convert) or, if
+        // it is an Object, copied into the isolate's heap
+        template<typename T>
+        void set(T const& val) {
+            Isolate::Scope scope{*isolate_};
+            if constexpr(std::is_convertible_v<T const&, Object const&>) {
+                cell_->value = isolate_->heap().copy(val);
+            } else {
+                cell_->value = embed::to_object(val);
+            }
+            isolate_->evaluator().globals().changed();
+        }
+
+        // the value bound to the global, as `R'; an Error while unbound
+        template<typename R = Object>
+        R get() const {
+            Isolate::Scope scope{*isolate_};
+            if(cell_->value.is_null()) {
+                throw Error{"unbound variable `" + cell_->name.name() + "'"};
+            }
+            return embed::from_object<R>(cell_->value);
+        }
+
+    private:
+        friend class Isolate;
+
+        Global(Isolate& isolate, GlobalCell& cell)
+            : isolate_{&isolate}
+            , cell_{&cell}
+        {}
+
+        Isolate* isolate_;
+        GlobalCell* cell_;
+    };
+
+    // a fixed set of threads that run isolates. a thread takes the oldest
+    // job queued, and runs it to the end: an isolate waiting on a channel
+    // holds on to its thread meanwhile, so isolates that wait on each other
+    // need a thread each
+    class IsolatePool {
+    public:
+        explicit IsolatePool(unsigned threads = std::max(1u, std::thread::hardware_concurrency()));
+
+        // runs what was queued, then stops
+        ~IsolatePool();
+
+        IsolatePool(IsolatePool const&) = delete;
+        IsolatePool& operator=(IsolatePool const&) = delete;
+
+        // runs `source' in `isolate' on one of the pool's threads. an
+        // isolate must not be given a job while it runs another
+        std::future<std::string> run(std::shared_ptr<Isolate> isolate, std::string source);
+
+        unsigned threads() const {
+            return static_cast<unsigned>(threads_.size());
+        }
+
+    private:
+        void work();
+
+        std::mutex lock_; // guards what follows
+        std::condition_variable ready_;
+        std::deque<std::packaged_task<std::string()>> jobs_;
+        bool stopping_ = false;
+
+        std::vector<std::thread> threads_;
+    };
+};
+
+#endif // __YASC_ISOLATE_H_
@@ -0,0 +1,226 @@
+#include <array>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "lexer.h"
+#include "error.h"
+
+namespace {
+    enum Class : std::uint8_t {
+        Other,
+        Space,
+        Newline,
+        Paren,
+        Comment
+    };
+
+    // one lookup per byte instead of a chain of comparisons
+    constexpr std::array<Class, 256> make_classes() {
+        std::array<Class, 256> classes{};
+        classes[' ']  = Space;
+        classes['\t'] = Space;
+        classes['\r'] = Space;
+        classes['\f'] = Space;
+        classes['\v'] = Space;
+        classes['\n'] = Newline;
+        classes['(']  = Paren;
+        classes[')']  = Paren;
+        classes[';']  = Comment;
+        return classes;
+    }
+
+    constexpr auto classes = make_classes();
+
+    Class classify(char c) {
+        return classes[static_cast<unsigned char>(c)];
+    }
+
+    std::string system_error(std::string const& what) {
+        return what + ": " + std::strerror(errno);
+    }
+}
+
+namespace yasc {
+    std::ostream& operator<<(std::ostream& o, Position const& pos) {
+        return o << pos.line << ":" << pos.column;
+    }
+
+    std::size_t StreamSource::read(char* buf, std::size_t size) {
+        in_.read(buf, static_cast<std::streamsize>(size));
+        return static_cast<std::size_t>(in_.gcount());
+    }
+
+    std::size_t FdSource::read(char* buf, std::size_t size) {
+        for(;;) {
+            auto got = ::read(fd_, buf, size);
+            if(got >= 0) {
+                return static_cast<std::size_t>(got);
+            }
+            if(EINTR != errno) {
+                throw Error{system_error("read")};
+            }
+        }
+    }
+
+    MappedFile::MappedFile(std::string const& path)
+        : data_{nullptr}
+        , size_{0}
+    {
+        auto fd = ::open(path.c_str(), O_RDONLY);
+        if(fd < 0) {
+            throw Error{system_error(path)};
+        }
+        struct stat st;
+        if(0 != ::fstat(fd, &st)) {
+            ::close(fd);
+            throw Error{system_error(path)};
+        }
+        size_ = static_cast<std::size_t>(st.st_size);
+        // an empty file cannot be mapped, and needs not be
+        if(0 != size_) {
+            auto addr = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if(MAP_FAILED == addr) {
+                ::close(fd);
+                throw Error{system_error(path)};
+            }
+            ::madvise(addr, size_, MADV_SEQUENTIAL);
+            data_ = static_cast<char const*>(addr);
+        }
+        ::close(fd);
+    }
+
+    MappedFile::~MappedFile() {
+        if(nullptr != data_) {
+            ::munmap(const_cast<char*>(data_), size_);
+        }
+    }
+
+    Lexer::Lexer(Source& source)
+        : source_{&source}
+        , storage_(block_size)
+        , data_{storage_.data()}
+        , pos_{data_}
+        , end_{data_}
+        , base_{0}
+        , line_start_{0}
+        , line_{1}
+        , peeked_{false}
+        , token_{}
+    {}
+
+    Lexer::Lexer(std::string_view input)
+        : source_{nullptr}
+        , data_{input.data()}
+        , pos_{input.data()}
+        , end_{input.data() + input.size()}
+        , base_{0}
+        , line_start_{0}
+        , line_{1}
+        , peeked_{false}
+        , token_{}
+    {}
+
+    Token Lexer::next() {
+        if(peeked_) {
+            peeked_ = false;
+            return token_;
+        }
+        return lex();
+    }
+
+    Token const& Lexer::peek() {
+        if(!peeked_) {
+            token_  = lex();
+            peeked_ = true;
+        }
+        return token_;
+    }
+
+    void Lexer::skip_line() {
+        peeked_ = false;
+        while(pos_ < end_ && '\n' != *pos_) {
+            ++pos_;
+        }
+    }
+
+    // keeps the bytes from `start' on, which belong to the token being
+    // lexed, and reads a block after them; the buffer only grows for a
+    // token longer than it
+    bool Lexer::fill(char const*& start) {
+        if(nullptr == source_) {
+            return false;
+        }
+        auto from = static_cast<std::size_t>(start - data_);
+        auto keep = static_cast<std::size_t>(end_ - start);
+        auto scan = static_cast<std::size_t>(pos_ - start);
+        base_ += from;
+        if(keep == storage_.size()) {
+            storage_.resize(2 * storage_.size());
+        }
+        auto buf = storage_.data();
+        std::memmove(buf, buf + from, keep);
+        auto got = source_->read(buf + keep, storage_.size() - keep);
+
+        data_  = buf;
+        start  = buf;
+        pos_   = buf + scan;
+        end_   = buf + keep + got;
+        return 0 != got;
+    }
+
+    void Lexer::skip_space() {
+        auto in_comment = false;
+        for(;;) {
+            for(; pos_ < end_; ++pos_) {
+                auto cls = classify(*pos_);
+                if(Newline == cls) {
+                    ++line_;
+                    line_start_ = base_ + static_cast<std::uint64_t>(pos_ - data_) + 1;
+                    in_comment = false;
+                } else if(Comment == cls) {
+                    in_comment = true;
+                } else if(Space != cls && !in_comment) {
+                    return;
+                }
+            }
+            auto start = pos_;
+            if(!fill(start)) {
+                return;
+            }
+        }
+    }
+
+    Token Lexer::lex() {
+        skip_space();
+
+        Position pos;
+        pos.offset = base_ + static_cast<std::uint64_t>(pos_ - data_);
+        pos.line   = line_;
+        pos.column = static_cast<std::uint32_t>(pos.offset - line_start_ + 1);
+        if(pos_ == end_) {
+            return {Token::Kind::End, {}, pos};
+        }
+
+        if(Paren == classify(*pos_)) {
+            auto kind = ('(' == *pos_) ? Token::Kind::Open : Token::Kind::Close;
+            ++pos_;
+            return {kind, {pos_ - 1, 1}, pos};
+        }
+
+        auto start = pos_;
+        for(;;) {
+            while(pos_ < end_ && Other == classify(*pos_)) {
+                ++pos_;
+            }
+            if(pos_ < end_ || !fill(start)) {
+                break;
+            }
+        }
+        return {Token::Kind::Atom, {start, static_cast<std::size_t>(pos_ - start)}, pos};
+    }
+}
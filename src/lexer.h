@@ -0,0 +1,146 @@
+#ifndef __YASC_LEXER_H_
+#define __YASC_LEXER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace yasc {
+    // where a token starts: a byte offset into the whole input, and the
+    // line and column (both from 1) it is on
+    struct Position {
+        std::uint64_t offset = 0;
+        std::uint32_t line   = 1;
+        std::uint32_t column = 1;
+    };
+
+    std::ostream& operator<<(std::ostream& o, Position const& pos);
+
+    struct Token {
+        enum class Kind : std::uint8_t {
+            Open,   // (
+            Close,  // )
+            Atom,   // anything between delimiters
+            End     // the input is exhausted
+        };
+
+        Kind kind;
+
+        // a view into the lexer's buffer, good until the next token is read
+        std::string_view text;
+
+        Position pos;
+    };
+
+    // somewhere bytes are read from in blocks. read answers how many bytes
+    // it stored in `buf', and 0 only once the input is exhausted.
+    class Source {
+    public:
+        virtual ~Source() = default;
+        virtual std::size_t read(char* buf, std::size_t size) = 0;
+    };
+
+    class StreamSource : public Source {
+    public:
+        explicit StreamSource(std::istream& in)
+            : in_{in}
+        {}
+
+        std::size_t read(char* buf, std::size_t size) override;
+
+    private:
+        std::istream& in_;
+    };
+
+    // reads a file descriptor, which is left open
+    class FdSource : public Source {
+    public:
+        explicit FdSource(int fd)
+            : fd_{fd}
+        {}
+
+        std::size_t read(char* buf, std::size_t size) override;
+
+    private:
+        int fd_;
+    };
+
+    // a whole file mapped into memory, read only. lexing it needs no copies
+    // and no buffer management at all.
+    class MappedFile {
+    public:
+        // throws an Error when the file cannot be opened or mapped
+        explicit MappedFile(std::string const& path);
+        ~MappedFile();
+
+        MappedFile(MappedFile const&) = delete;
+        MappedFile& operator=(MappedFile const&) = delete;
+
+        std::string_view data() const {
+            return {data_, size_};
+        }
+
+    private:
+        char const* data_;
+        std::size_t size_;
+    };
+
+    // splits input into parens and atoms, pulling from a Source as it goes.
+    // a token cut in two by the end of a block is put back together by
+    // moving the unread tail of the buffer to its front before refilling,
+    // so every token is handed out as a single view.
+    //
+    // whitespace separates tokens, and `;' starts a comment that runs to the
+    // end of the line.
+    class Lexer {
+    public:
+        static constexpr std::size_t block_size = std::size_t{64} << 10;
+
+        // lexes `source', which must outlive the lexer
+        explicit Lexer(Source& source);
+
+        // lexes memory that stays put for the lexer's lifetime, eg. a
+        // MappedFile, without copying it
+        explicit Lexer(std::string_view input);
+
+        Token next();
+
+        // the next token, without consuming it
+        Token const& peek();
+
+        // drops what is buffered of the current line, to resynchronise
+        // after an error in interactive input. never reads more.
+        void skip_line();
+
+    private:
+        // reads more input, keeping the bytes from `start' on (which it
+        // updates). false at the end of the input
+        bool fill(char const*& start);
+
+        void skip_space();
+        Token lex();
+
+        Source* source_;
+        std::vector<char> storage_;
+
+        // the bytes still to be lexed are [pos_, end_) of [data_, end_)
+        char const* data_;
+        char const* pos_;
+        char const* end_;
+
+        // where data_ lies in the whole input, and where the line `pos_' is
+        // on begins
+        std::uint64_t base_;
+        std::uint64_t line_start_;
+        std::uint32_t line_;
+
+        bool  peeked_;
+        Token token_;
+    };
+}
+
+#endif // __YASC_LEXER_H_
@@ -1,84 +1,451 @@
 #ifndef __YASC_LIBSCHEME_ARITHMETIC_H_
 #define __YASC_LIBSCHEME_ARITHMETIC_H_
 
-#include <algorithm>
-#include <numeric>
-#include <memory>
+#include <array>
+#include <complex>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
+#include "../error.h"
 #include "../ast/value.h"
+#include "../ast/object.h"
 #include "../ast/procedure.h"
 #include "../ast/number.h"
-#include "../ast/pair.h"
-#include "../ast/list.h"
+#include "../ast/bigint.h"
+#include "../ast/ratio.h"
+#include "../gc/heap.h"
+#include "uvector.h"
 
 namespace yasc {
 
     namespace arithmetic {
         namespace detail {
-            template<typename T, typename Callable>
-            T const unity = T{0};
+            constexpr auto levels = static_cast<std::size_t>(NumberKind::Count);
+
+            // the raw type each level of the tower computes with
+            template<NumberKind K> struct level;
+            template<> struct level<NumberKind::Fixnum>   { using type = std::intptr_t; };
+            template<> struct level<NumberKind::Bignum>   { using type = BigInt; };
+            template<> struct level<NumberKind::Rational> { using type = Ratio; };
+            template<> struct level<NumberKind::Real>     { using type = double; };
+            template<> struct level<NumberKind::Complex>  { using type = std::complex<double>; };
+
+            template<NumberKind K>
+            using level_t = typename level<K>::type;
+
+            template<NumberKind K>
+            decltype(auto) unbox(Object const& obj) {
+                if constexpr(NumberKind::Fixnum == K) {
+                    return obj.as_fixnum();
+                } else {
+                    return number_traits<level_t<K>>::unbox(obj);
+                }
+            }
+
+            // moves a raw number up the tower
+            template<typename To, typename From>
+            decltype(auto) coerce(From const& val) {
+                if constexpr(std::is_same_v<To, From>) {
+                    return (val);
+                } else if constexpr(std::is_same_v<To, BigInt> || std::is_same_v<To, Ratio>) {
+                    return To{val};
+                } else if constexpr(std::is_same_v<From, BigInt> || std::is_same_v<From, Ratio>) {
+                    return To{val.to_double()};
+                } else {
+                    return To{static_cast<double>(val)};
+                }
+            }
+
+            inline std::size_t kind_index(Object const& obj) {
+                auto kind = number_kind_of(obj);
+                if(NumberKind::Count == kind) {
+                    throw Error{"not a number"};
+                }
+                return static_cast<std::size_t>(kind);
+            }
+
+            using Entry = Object (*)(Object const& lhs, Object const& rhs);
+            using Table = std::array<Entry, levels * levels>;
+
+            // lifts both operands to the higher of levels L and R and applies
+            // Op there
+            template<typename Op, std::size_t L, std::size_t R>
+            Object entry(Object const& lhs, Object const& rhs) {
+                constexpr auto K = static_cast<NumberKind>(L > R ? L : R);
+                using T = level_t<K>;
+                return Op::apply(coerce<T>(unbox<static_cast<NumberKind>(L)>(lhs)),
+                                 coerce<T>(unbox<static_cast<NumberKind>(R)>(rhs)));
+            }
+
+            template<typename Op, std::size_t... I>
+            constexpr Table make_table(std::index_sequence<I...>) {
+                return {{&entry<Op, I / levels, I % levels>...}};
+            }
+
+            // one entry per pair of levels, so mixing types costs a single
+            // indexed call instead of a chain of casts
+            template<typename Op>
+            constexpr Table table =
+                make_table<Op>(std::make_index_sequence<levels * levels>{});
+
+            // operations that also work elementwise on numeric vectors name
+            // their kernel as `vector_op'
+            template<typename Op, typename = void>
+            constexpr bool has_vector_op = false;
+
+            template<typename Op>
+            constexpr bool has_vector_op<Op, std::void_t<decltype(Op::vector_op)>> = true;
+
+            // an operand that is not a number: either a numeric vector the
+            // operation maps over, or an error
+            template<typename Op>
+            Object non_number(Object const& lhs, Object const& rhs) {
+                if constexpr(has_vector_op<Op>) {
+                    if(uvector::is_operand(lhs) && uvector::is_operand(rhs)) {
+                        return uvector::elementwise(Op::name, Op::vector_op, lhs, rhs);
+                    }
+                }
+                throw Error{"not a number"};
+            }
+
+            template<typename Op>
+            Object dispatch(Object const& lhs, Object const& rhs) {
+                // two fixnums, by far the common case, skip the table
+                if(lhs.is_fixnum() && rhs.is_fixnum()) {
+                    return Op::apply(lhs.as_fixnum(), rhs.as_fixnum());
+                }
+                auto l = number_kind_of(lhs), r = number_kind_of(rhs);
+                if(NumberKind::Count == l || NumberKind::Count == r) {
+                    return non_number<Op>(lhs, rhs);
+                }
+                return table<Op>[static_cast<std::size_t>(l) * levels + static_cast<std::size_t>(r)](lhs, rhs);
+            }
 
             template<typename T>
-            T const unity<T, std::multiplies<T>> = T{1};
+            Object box(T const& val) {
+                return number_traits<T>::box(val);
+            }
 
             template<typename T>
-            T const unity<T, std::divides<T>> = T{1};
-
-            template<typename T, typename Callable>
-            std::shared_ptr<T> call_procedure(Value const& value, Callable c = Callable{}) {
-                switch(value.type()) {
-                    case Value::Type::Number:
-                        return std::make_shared<T>(value_cast<T>(value));
-                    case Value::Type::Pair: {
-                        auto const& pair = value_cast<Pair const&>(value);
-                        auto car = call_procedure<T>(*pair.car(), c);
-                        auto cdr = call_procedure<T>(*pair.cdr(), c);
-                        return std::make_shared<T>(c(*car, *cdr));
+            constexpr bool is_integer = std::is_same_v<T, std::intptr_t> || std::is_same_v<T, BigInt>;
+
+            // fixnums are 63 bits, so the machine operations on two of them
+            // can only overflow for multiplication; what does not fit a
+            // fixnum is redone on bignums
+            struct add {
+                static constexpr char const* name = "+";
+                static constexpr auto vector_op = simd::Op::Add;
+                static constexpr std::uint32_t min = 0;
+                static Object unity() { return Object::fixnum(0); }
+                static Object unary(Object const& val) { return val; }
+
+                static Object apply(std::intptr_t lhs, std::intptr_t rhs) {
+                    return box(lhs + rhs);
+                }
+
+                template<typename T>
+                static Object apply(T const& lhs, T const& rhs) {
+                    return box<T>(lhs + rhs);
+                }
+            };
+
+            struct sub {
+                static constexpr char const* name = "-";
+                static constexpr auto vector_op = simd::Op::Sub;
+                static constexpr std::uint32_t min = 1;
+                static Object unity() { return Object::fixnum(0); }
+                static Object unary(Object const& val) { return dispatch<sub>(Object::fixnum(0), val); }
+
+                static Object apply(std::intptr_t lhs, std::intptr_t rhs) {
+                    return box(lhs - rhs);
+                }
+
+                template<typename T>
+                static Object apply(T const& lhs, T const& rhs) {
+                    return box<T>(lhs - rhs);
+                }
+            };
+
+            struct mul {
+                static constexpr char const* name = "*";
+                static constexpr auto vector_op = simd::Op::Mul;
+                static constexpr std::uint32_t min = 0;
+                static Object unity() { return Object::fixnum(1); }
+                static Object unary(Object const& val) { return val; }
+
+                static Object apply(std::intptr_t lhs, std::intptr_t rhs) {
+                    std::intptr_t product;
+                    if(__builtin_mul_overflow(lhs, rhs, &product)) {
+                        return box(BigInt{lhs} * BigInt{rhs});
+                    }
+                    return box(product);
+                }
+
+                template<typename T>
+                static Object apply(T const& lhs, T const& rhs) {
+                    return box<T>(lhs * rhs);
+                }
+            };
+
+            // the quotient of two integers is exact: an integer when the
+            // division is, a ratio otherwise
+            struct div {
+                static constexpr char const* name = "/";
+                static constexpr auto vector_op = simd::Op::Div;
+                static constexpr std::uint32_t min = 1;
+                static Object unity() { return Object::fixnum(1); }
+                static Object unary(Object const& val) { return dispatch<div>(Object::fixnum(1), val); }
+
+                static Object apply(std::intptr_t lhs, std::intptr_t rhs) {
+                    if(0 == rhs) {
+                        throw Error{"division by zero"};
                     }
-                    case Value::Type::List: {
-                        auto const& list = value_cast<List const&>(value);
-                        auto acc = value_cast<T&>(*std::begin(list));
-                        auto result = std::accumulate(++std::begin(list), std::end(list), acc,
-                            [&] (auto const& acc, auto const& itr) {
-                                return c(acc, value_cast<T const&>(itr));
-                            }
-                        );
-                        return std::make_shared<T>(result);
+                    if(0 == lhs % rhs) {
+                        return box(lhs / rhs);
                     }
-                    case Value::Type::EmptyList:
-                        return std::make_shared<T>(unity<T, Callable>);
-                    default:
-                        return std::shared_ptr<T>{nullptr};
+                    return box(Ratio{lhs, rhs});
                 }
-            }
 
-            template<typename T, typename Callable>
-            Value::Ptr get_procedure(Callable c = Callable{}) {
-                return std::make_shared<Procedure>( [] (Value const& val) -> Value::Ptr {
-                    return call_procedure<T, Callable>(val);
-                });
+                static Object apply(BigInt const& lhs, BigInt const& rhs) {
+                    BigInt quot, rem;
+                    BigInt::divmod(lhs, rhs, quot, rem);
+                    if(0 == rem.sign()) {
+                        return box(quot);
+                    }
+                    return box(Ratio{lhs, rhs});
+                }
+
+                template<typename T>
+                static Object apply(T const& lhs, T const& rhs) {
+                    return box<T>(lhs / rhs);
+                }
+            };
+
+            // integer division, for exact integers only
+            template<typename Derived>
+            struct integer_op {
+                template<typename T>
+                static Object apply(T const& lhs, T const& rhs) {
+                    if constexpr(is_integer<T>) {
+                        if(T{0} == rhs) {
+                            throw Error{"division by zero"};
+                        }
+                        return box<T>(Derived::exact(lhs, rhs));
+                    } else {
+                        throw Error{std::string{Derived::name} + ": expects exact integers"};
+                    }
+                }
+            };
+
+            struct quotient : integer_op<quotient> {
+                static constexpr char const* name = "quotient";
+                template<typename T>
+                static T exact(T const& lhs, T const& rhs) { return lhs / rhs; }
+            };
+
+            struct remainder : integer_op<remainder> {
+                static constexpr char const* name = "remainder";
+                template<typename T>
+                static T exact(T const& lhs, T const& rhs) { return lhs % rhs; }
+            };
+
+            // like remainder, but takes the sign of the divisor
+            struct modulo : integer_op<modulo> {
+                static constexpr char const* name = "modulo";
+                template<typename T>
+                static T exact(T const& lhs, T const& rhs) {
+                    T rem = lhs % rhs;
+                    if(T{0} != rem && ((rem < T{0}) != (rhs < T{0}))) {
+                        rem = rem + rhs;
+                    }
+                    return rem;
+                }
+            };
+
+            // comparisons answer a boolean for one pair of arguments; complex
+            // numbers are only ever equal or not
+            template<typename Derived>
+            struct comparison {
+                template<typename T>
+                static Object apply(T const& lhs, T const& rhs) {
+                    if constexpr(std::is_same_v<T, std::complex<double>>) {
+                        if(!Derived::complex_ok) {
+                            throw Error{std::string{Derived::name} + ": complex numbers are not ordered"};
+                        }
+                        return Object::boolean(lhs == rhs);
+                    } else {
+                        return Object::boolean(Derived::holds(lhs, rhs));
+                    }
+                }
+            };
+
+#define YASC_COMPARISON(type, sym, op, complex)                                     \
+            struct type : comparison<type> {                                        \
+                static constexpr char const* name = sym;                            \
+                static constexpr bool complex_ok = complex;                         \
+                template<typename T>                                                \
+                static bool holds(T const& lhs, T const& rhs) { return lhs op rhs; }\
+            };
+
+            YASC_COMPARISON(equal,         "=",  ==, true)
+            YASC_COMPARISON(less,          "<",  <,  false)
+            YASC_COMPARISON(greater,       ">",  >,  false)
+            YASC_COMPARISON(less_equal,    "<=", <=, false)
+            YASC_COMPARISON(greater_equal, ">=", >=, false)
+#undef YASC_COMPARISON
+
+            // folds the arguments left to right: (op a b c) is ((a op b) op c)
+            template<typename Op>
+            struct fold {
+                static Object call(Args args, void*) {
+                    if(0 == args.size()) {
+                        return Op::unity();
+                    }
+                    if(1 == args.size()) {
+                        return call1(args[0], nullptr);
+                    }
+                    auto acc = args[0];
+                    for(auto i = 1u; i < args.size(); ++i) {
+                        acc = dispatch<Op>(acc, args[i]);
+                    }
+                    return acc;
+                }
+
+                static Object call1(Object const& a, void*) {
+                    if(VectorKind::Count == vector_kind_of(a) || !has_vector_op<Op>) {
+                        kind_index(a);
+                    }
+                    return Op::unary(a);
+                }
+
+                static Object call2(Object const& a, Object const& b, void*) {
+                    return dispatch<Op>(a, b);
+                }
+
+                static constexpr Primitive primitive = {
+                    Op::name, {Op::min, Arity::variadic}, call, nullptr, call1, call2, nullptr
+                };
+            };
+
+            // (op a b c) holds when it holds for every adjacent pair
+            template<typename Op>
+            struct chain {
+                static Object call(Args args, void*) {
+                    auto holds = true;
+                    for(auto i = 1u; i < args.size(); ++i) {
+                        // keep going to reject non-numbers further on
+                        holds = dispatch<Op>(args[i - 1], args[i]).is_true() && holds;
+                    }
+                    return Object::boolean(holds);
+                }
+
+                static Object call2(Object const& a, Object const& b, void*) {
+                    return dispatch<Op>(a, b);
+                }
+
+                static constexpr Primitive primitive = {
+                    Op::name, {2, Arity::variadic}, call, nullptr, nullptr, call2, nullptr
+                };
+            };
+
+            template<typename Op>
+            struct binary {
+                static Object call(Args args, void*) {
+                    return dispatch<Op>(args[0], args[1]);
+                }
+
+                static Object call2(Object const& a, Object const& b, void*) {
+                    return dispatch<Op>(a, b);
+                }
+
+                static constexpr Primitive primitive = {
+                    Op::name, {2, 2}, call, nullptr, nullptr, call2, nullptr
+                };
+            };
+
+            template<template<typename> class Shape, typename Op>
+            Object get_procedure() {
+                return make_object<Procedure>(Shape<Op>::primitive);
             }
         };
 
-        template<typename T>
-        Value::Ptr get_plus() {
-            return detail::get_procedure<T, std::plus<T>>();
+        inline Object get_plus()          { return detail::get_procedure<detail::fold,   detail::add>(); }
+        inline Object get_minus()         { return detail::get_procedure<detail::fold,   detail::sub>(); }
+        inline Object get_multiplies()    { return detail::get_procedure<detail::fold,   detail::mul>(); }
+        inline Object get_divides()       { return detail::get_procedure<detail::fold,   detail::div>(); }
+        inline Object get_quotient()      { return detail::get_procedure<detail::binary, detail::quotient>(); }
+        inline Object get_remainder()     { return detail::get_procedure<detail::binary, detail::remainder>(); }
+        inline Object get_modulo()        { return detail::get_procedure<detail::binary, detail::modulo>(); }
+        inline Object get_equal()         { return detail::get_procedure<detail::chain,  detail::equal>(); }
+        inline Object get_less()          { return detail::get_procedure<detail::chain,  detail::less>(); }
+        inline Object get_greater()       { return detail::get_procedure<detail::chain,  detail::greater>(); }
+        inline Object get_less_equal()    { return detail::get_procedure<detail::chain,  detail::less_equal>(); }
+        inline Object get_greater_equal() { return detail::get_procedure<detail::chain,  detail::greater_equal>(); }
+
+        // the arithmetic primitives, for registering by name
+        inline std::vector<Primitive const*> const& primitives() {
+            using namespace detail;
+            static std::vector<Primitive const*> const prims = {
+                &fold<add>::primitive,
+                &fold<sub>::primitive,
+                &fold<mul>::primitive,
+                &fold<div>::primitive,
+                &binary<quotient>::primitive,
+                &binary<remainder>::primitive,
+                &binary<modulo>::primitive,
+                &chain<equal>::primitive,
+                &chain<less>::primitive,
+                &chain<greater>::primitive,
+                &chain<less_equal>::primitive,
+                &chain<greater_equal>::primitive
+            };
+            return prims;
         }
 
-        template<typename T>
-        Value::Ptr get_minus() {
-            return detail::get_procedure<T, std::minus<T>>();
+        // the table `prim' dispatches a pair of numbers through, when it is
+        // one of the primitives above, or nullptr. the VM quickens calls to
+        // these on the levels of their operands (see VM::run)
+        inline detail::Table const* dispatch_table(Primitive const& prim) {
+            using namespace detail;
+            static constexpr std::pair<Primitive const*, Table const*> tables[] = {
+                {&fold<add>::primitive,               &table<add>},
+                {&fold<sub>::primitive,               &table<sub>},
+                {&fold<mul>::primitive,               &table<mul>},
+                {&fold<div>::primitive,               &table<div>},
+                {&binary<quotient>::primitive,        &table<quotient>},
+                {&binary<remainder>::primitive,       &table<remainder>},
+                {&binary<modulo>::primitive,          &table<modulo>},
+                {&chain<equal>::primitive,            &table<equal>},
+                {&chain<less>::primitive,             &table<less>},
+                {&chain<greater>::primitive,          &table<greater>},
+                {&chain<less_equal>::primitive,       &table<less_equal>},
+                {&chain<greater_equal>::primitive,    &table<greater_equal>}
+            };
+            for(auto const& [p, t] : tables) {
+                if(p == &prim) {
+                    return t;
+                }
+            }
+            return nullptr;
         }
 
-        template<typename T>
-        Value::Ptr get_multiplies() {
-            return detail::get_procedure<T, std::multiplies<T>>();
+        // whether `prim' folds its arguments left to right, so that a call
+        // of it whose first argument is another call of it with at least two
+        // arguments is the same as one call with all of them: (+ (+ a b) c)
+        // is (+ a b c)
+        inline bool left_fold(Primitive const& prim) {
+            using namespace detail;
+            return &prim == &fold<add>::primitive || &prim == &fold<sub>::primitive
+                || &prim == &fold<mul>::primitive || &prim == &fold<div>::primitive;
         }
 
-        template<typename T>
-        Value::Ptr get_divides() {
-            return detail::get_procedure<T, std::divides<T>>();
+        // the entry of `table' for two operands both on level `kind', the
+        // same one dispatch would reach for them
+        inline detail::Entry specialization(detail::Table const& table, NumberKind kind) {
+            auto k = static_cast<std::size_t>(kind);
+            return table[k * detail::levels + k];
         }
     };
 }
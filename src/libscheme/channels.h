@@ -0,0 +1,87 @@
+#ifndef __YASC_LIBSCHEME_CHANNELS_H_
+#define __YASC_LIBSCHEME_CHANNELS_H_
+
+#include <string>
+#include <vector>
+
+#include "../error.h"
+#include "../ast/value.h"
+#include "../ast/object.h"
+#include "../ast/procedure.h"
+#include "../ast/channel.h"
+#include "../par/scheduler.h"
+
+namespace yasc {
+    namespace channels {
+        namespace detail {
+            inline Channel& channel(Object const& obj, char const* who) {
+                if(Value::Type::Channel != obj.type()) {
+                    throw Error{std::string{who} + ": expects a channel"};
+                }
+                return *value_cast<Channel*>(obj);
+            }
+
+            // (make-channel capacity): a channel holding up to `capacity'
+            // messages not yet received
+            inline Object make_channel(Object const& capacity, void*) {
+                if(!capacity.is_fixnum() || capacity.as_fixnum() <= 0) {
+                    throw Error{"make-channel: expects a positive capacity"};
+                }
+                return make_object<Channel>(static_cast<std::size_t>(capacity.as_fixnum()));
+            }
+
+            inline Object is_channel(Object const& obj, void*) {
+                return Object::boolean(Value::Type::Channel == obj.type());
+            }
+
+            // a future cannot leave its thread, so what is sent is resolved
+            // first
+            inline Object send(Object const& ch, Object const& msg, void*) {
+                channel(ch, "channel-send");
+                gc::Root root{ch};
+                gc::Root val{msg};
+                par::resolve(val);
+                value_cast<Channel*>(root.get())->send(val);
+                return Object::unspecified();
+            }
+
+            inline Object receive(Object const& ch, void*) {
+                return channel(ch, "channel-receive").receive();
+            }
+
+            // (channel-try-receive ch default) is `default' when there is
+            // nothing to receive, rather than waiting
+            inline Object try_receive(Object const& ch, Object const& otherwise, void*) {
+                auto val = channel(ch, "channel-try-receive").try_receive();
+                return val.is_null() ? otherwise : val;
+            }
+
+            inline Object close(Object const& ch, void*) {
+                channel(ch, "channel-close").close();
+                return Object::unspecified();
+            }
+
+            inline constexpr Primitive make_channel_primitive = {"make-channel",        {1, 1}, nullptr, nullptr, make_channel, nullptr,     nullptr};
+            inline constexpr Primitive is_channel_primitive   = {"channel?",            {1, 1}, nullptr, nullptr, is_channel,   nullptr,     nullptr};
+            inline constexpr Primitive send_primitive         = {"channel-send",        {2, 2}, nullptr, nullptr, nullptr,      send,        nullptr};
+            inline constexpr Primitive receive_primitive      = {"channel-receive",     {1, 1}, nullptr, nullptr, receive,      nullptr,     nullptr};
+            inline constexpr Primitive try_receive_primitive  = {"channel-try-receive", {2, 2}, nullptr, nullptr, nullptr,      try_receive, nullptr};
+            inline constexpr Primitive close_primitive        = {"channel-close",       {1, 1}, nullptr, nullptr, close,        nullptr,     nullptr};
+        }
+
+        // every primitive on channels, for registering by name
+        inline std::vector<Primitive const*> const& primitives() {
+            static std::vector<Primitive const*> const prims = {
+                &detail::make_channel_primitive,
+                &detail::is_channel_primitive,
+                &detail::send_primitive,
+                &detail::receive_primitive,
+                &detail::try_receive_primitive,
+                &detail::close_primitive
+            };
+            return prims;
+        }
+    };
+}
+
+#endif // __YASC_LIBSCHEME_CHANNELS_H_
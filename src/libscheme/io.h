@@ -0,0 +1,46 @@
+#ifndef __YASC_LIBSCHEME_IO_H_
+#define __YASC_LIBSCHEME_IO_H_
+
+#include <vector>
+
+#include "../error.h"
+#include "../lexer.h"
+#include "../reader.h"
+#include "../ast/value.h"
+#include "../ast/object.h"
+#include "../ast/procedure.h"
+#include "../ast/identifier.h"
+
+namespace yasc {
+    namespace io {
+        namespace detail {
+            // there are no strings yet, so files are named by symbols, eg.
+            // (read-all 'data.scm)
+            inline Object read_all(Object const& path, void*) {
+                if(Value::Type::Identifier != path.type()) {
+                    throw Error{"read-all: expects a symbol naming a file"};
+                }
+                MappedFile file{value_cast<Identifier*>(path)->id()};
+                return Reader{file.data()}.all();
+            }
+
+            inline Object call_read_all(Args args, void*) {
+                return read_all(args[0], nullptr);
+            }
+
+            inline constexpr Primitive read_all_primitive = {
+                "read-all", {1, 1}, call_read_all, nullptr, read_all, nullptr, nullptr
+            };
+        }
+
+        // every input and output primitive, for registering by name
+        inline std::vector<Primitive const*> const& primitives() {
+            static std::vector<Primitive const*> const prims = {
+                &detail::read_all_primitive
+            };
+            return prims;
+        }
+    };
+}
+
+#endif // __YASC_LIBSCHEME_IO_H_
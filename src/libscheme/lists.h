@@ -0,0 +1,137 @@
+#ifndef __YASC_LIBSCHEME_LISTS_H_
+#define __YASC_LIBSCHEME_LISTS_H_
+
+#include <vector>
+
+#include "../error.h"
+#include "../ast/value.h"
+#include "../ast/object.h"
+#include "../ast/procedure.h"
+#include "../ast/identifier.h"
+#include "../ast/list.h"
+#include "../ast/pair.h"
+#include "../gc/heap.h"
+
+namespace yasc {
+    namespace lists {
+        // `datum' with every List in it, as the parser and the reader build
+        // them, turned into a chain of pairs, which is what the procedures
+        // on lists take apart. quoted data go through this once, when they
+        // are compiled
+        inline Object to_pairs(Object const& datum) {
+            if(Value::Type::Pair == datum.type()) {
+                // a dotted list, as (a b . c) is read, whose elements may be
+                // lists in turn
+                std::vector<Object> cars;
+                auto cur = datum;
+                for(; Value::Type::Pair == cur.type(); cur = value_cast<Pair*>(cur)->cdr()) {
+                    cars.push_back(to_pairs(value_cast<Pair*>(cur)->car()));
+                }
+                auto ret = to_pairs(cur);
+                for(auto i = cars.size(); i > 0; --i) {
+                    ret = make_object<Pair>(cars[i - 1], ret);
+                }
+                return ret;
+            }
+            if(Value::Type::List != datum.type()) {
+                return datum;
+            }
+            std::vector<Object> elems;
+            for(auto const& val : *value_cast<List*>(datum)) {
+                elems.push_back(to_pairs(val));
+            }
+            auto ret = Object::empty_list();
+            for(auto i = elems.size(); i > 0; --i) {
+                ret = make_object<Pair>(elems[i - 1], ret);
+            }
+            return ret;
+        }
+
+        namespace detail {
+            inline void expect_pair(char const* name, Object const& val) {
+                auto type = val.type();
+                if((Value::Type::List != type || 0 == value_cast<List*>(val)->size()) && Value::Type::Pair != type) {
+                    throw Error{std::string{name} + ": expects a pair"};
+                }
+            }
+
+            inline Object cons(Object const& a, Object const& b, void*) {
+                return make_object<Pair>(a, b);
+            }
+
+            // a List, as the parser and the reader build them, is taken
+            // apart where it is: its first element, and the chain of pairs
+            // it keeps for the rest
+            inline Object car(Object const& val, void*) {
+                expect_pair("car", val);
+                if(Value::Type::List == val.type()) {
+                    return value_cast<List*>(val)->car();
+                }
+                return value_cast<Pair*>(val)->car();
+            }
+
+            inline Object cdr(Object const& val, void*) {
+                expect_pair("cdr", val);
+                if(Value::Type::List == val.type()) {
+                    return value_cast<List*>(val)->rest();
+                }
+                return value_cast<Pair*>(val)->cdr();
+            }
+
+            inline Object is_null(Object const& val, void*) {
+                return Object::boolean(val.is_empty_list());
+            }
+
+            inline Object is_pair(Object const& val, void*) {
+                return Object::boolean(Value::Type::Pair == val.type() || Value::Type::List == val.type());
+            }
+
+            // symbols are the same symbol however many identifiers name them
+            inline Object is_eq(Object const& a, Object const& b, void*) {
+                if(Value::Type::Identifier == a.type() && Value::Type::Identifier == b.type()) {
+                    return Object::boolean(value_cast<Identifier*>(a)->symbol() == value_cast<Identifier*>(b)->symbol());
+                }
+                return Object::boolean(a == b);
+            }
+
+            inline Object negate(Object const& val, void*) {
+                return Object::boolean(!val.is_true());
+            }
+
+            inline Object list(Args args, void*) {
+                auto ret = Object::empty_list();
+                for(auto i = args.size(); i > 0; --i) {
+                    ret = make_object<Pair>(args[i - 1], ret);
+                }
+                return ret;
+            }
+
+            // every one of a fixed arity takes the shortcut for it
+            inline constexpr Primitive cons_primitive  = {"cons",  {2, 2}, nullptr, nullptr, nullptr, cons,  nullptr};
+            inline constexpr Primitive car_primitive   = {"car",   {1, 1}, nullptr, nullptr, car,     nullptr, nullptr};
+            inline constexpr Primitive cdr_primitive   = {"cdr",   {1, 1}, nullptr, nullptr, cdr,     nullptr, nullptr};
+            inline constexpr Primitive null_primitive  = {"null?", {1, 1}, nullptr, nullptr, is_null, nullptr, nullptr};
+            inline constexpr Primitive pair_primitive  = {"pair?", {1, 1}, nullptr, nullptr, is_pair, nullptr, nullptr};
+            inline constexpr Primitive eq_primitive    = {"eq?",   {2, 2}, nullptr, nullptr, nullptr, is_eq, nullptr};
+            inline constexpr Primitive not_primitive   = {"not",   {1, 1}, nullptr, nullptr, negate,  nullptr, nullptr};
+            inline constexpr Primitive list_primitive  = {"list",  {0, Arity::variadic}, list, nullptr, nullptr, nullptr, nullptr};
+        }
+
+        // the procedures on pairs and lists, for registering by name
+        inline std::vector<Primitive const*> const& primitives() {
+            static std::vector<Primitive const*> const prims = {
+                &detail::cons_primitive,
+                &detail::car_primitive,
+                &detail::cdr_primitive,
+                &detail::null_primitive,
+                &detail::pair_primitive,
+                &detail::eq_primitive,
+                &detail::not_primitive,
+                &detail::list_primitive
+            };
+            return prims;
+        }
+    };
+}
+
+#endif // __YASC_LIBSCHEME_LISTS_H_
@@ -0,0 +1,99 @@
+#ifndef __YASC_LIBSCHEME_MEMORY_H_
+#define __YASC_LIBSCHEME_MEMORY_H_
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "../ast/value.h"
+#include "../ast/object.h"
+#include "../ast/number.h"
+#include "../ast/procedure.h"
+#include "../ast/identifier.h"
+#include "../ast/pair.h"
+#include "../gc/heap.h"
+
+namespace yasc {
+    namespace memory {
+        namespace detail {
+            inline Object count(std::uint64_t n) {
+                return Object::fixnum(static_cast<std::intptr_t>(n));
+            }
+
+            inline Object symbol(char const* name) {
+                return make_object<Identifier>(Symbol::intern(name));
+            }
+
+            // (name . val)
+            inline Object entry(char const* name, Object const& val) {
+                return make_object<Pair>(symbol(name), val);
+            }
+
+            // what the heap holds and has allocated, as an association list:
+            //
+            //     ((heap . bytes) (peak . bytes) (allocated . bytes)
+            //      (allocations . values) (rate . bytes-per-second)
+            //      (minor . collections) (major . collections)
+            //      (types (type live live-bytes allocations bytes
+            //              region-allocations region-bytes) ...))
+            //
+            // only the types allocated so far are listed. counting the live
+            // values walks the heap, but does not collect it, so values not
+            // yet found dead are counted as well
+            inline Object heap_stats(void*) {
+                auto const& stats = gc::current_heap().census();
+
+                auto types = Object::empty_list();
+                for(auto i = gc::type_count; i > 0; --i) {
+                    auto const& type = stats.types[i - 1];
+                    if(0 == type.allocations && 0 == type.live && 0 == type.region_allocations) {
+                        continue;
+                    }
+                    auto row = Object::empty_list();
+                    for(auto val : {type.region_bytes, type.region_allocations, type.bytes, type.allocations,
+                                    std::uint64_t{type.live_bytes}, std::uint64_t{type.live}}) {
+                        row = make_object<Pair>(count(val), row);
+                    }
+                    row = make_object<Pair>(symbol(gc::type_name(static_cast<Value::Type>(i - 1))), row);
+                    types = make_object<Pair>(row, types);
+                }
+
+                auto seconds = std::chrono::duration<double>(stats.uptime).count();
+                auto rate = (seconds > 0) ? static_cast<double>(stats.bytes_allocated) / seconds : 0.0;
+                Object const entries[] = {
+                    entry("heap",        count(stats.nursery_bytes + stats.old_bytes)),
+                    entry("peak",        count(stats.peak_bytes)),
+                    entry("allocated",   count(stats.bytes_allocated)),
+                    entry("allocations", count(stats.allocations)),
+                    entry("rate",        number_traits<double>::box(rate)),
+                    entry("minor",       count(stats.minor.collections)),
+                    entry("major",       count(stats.major.collections)),
+                    make_object<Pair>(symbol("types"), types)
+                };
+                auto ret = Object::empty_list();
+                for(auto i = std::size(entries); i > 0; --i) {
+                    ret = make_object<Pair>(entries[i - 1], ret);
+                }
+                return ret;
+            }
+
+            inline Object call_heap_stats(Args, void*) {
+                return heap_stats(nullptr);
+            }
+
+            inline constexpr Primitive heap_stats_primitive = {
+                "heap-stats", {0, 0}, call_heap_stats, heap_stats, nullptr, nullptr, nullptr
+            };
+        }
+
+        // the primitives reporting on memory, for registering by name
+        inline std::vector<Primitive const*> const& primitives() {
+            static std::vector<Primitive const*> const prims = {
+                &detail::heap_stats_primitive
+            };
+            return prims;
+        }
+    };
+}
+
+#endif // __YASC_LIBSCHEME_MEMORY_H_
@@ -0,0 +1,258 @@
+#ifndef __YASC_LIBSCHEME_PARALLEL_H_
+#define __YASC_LIBSCHEME_PARALLEL_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../error.h"
+#include "../ast/value.h"
+#include "../ast/object.h"
+#include "../ast/procedure.h"
+#include "../ast/list.h"
+#include "../ast/pair.h"
+#include "../ast/uvector.h"
+#include "../gc/heap.h"
+#include "../par/future.h"
+#include "../par/scheduler.h"
+#include "../vm/vm.h"
+#include "uvector.h"
+
+namespace yasc {
+    namespace parallel {
+        namespace detail {
+            inline vm::VM::Running running(char const* who) {
+                auto running = vm::VM::running();
+                if(nullptr == running.vm) {
+                    throw Error{std::string{who} + ": not running in a VM"};
+                }
+                return running;
+            }
+
+            // the elements of a list, either representation
+            inline std::vector<Object> elements(Object const& list, char const* who) {
+                std::vector<Object> elems;
+                if(Value::Type::List == list.type()) {
+                    for(auto const& val : *value_cast<List*>(list)) {
+                        elems.push_back(val);
+                    }
+                    return elems;
+                }
+                auto cur = list;
+                for(; Value::Type::Pair == cur.type(); cur = value_cast<Pair*>(cur)->cdr()) {
+                    elems.push_back(value_cast<Pair*>(cur)->car());
+                }
+                if(!cur.is_empty_list()) {
+                    throw Error{std::string{who} + ": expects a list"};
+                }
+                return elems;
+            }
+
+            inline Object to_list(std::vector<Object> const& elems, std::size_t begin, std::size_t end) {
+                auto ret = Object::empty_list();
+                for(auto i = end; i > begin; --i) {
+                    ret = make_object<Pair>(elems[i - 1], ret);
+                }
+                return ret;
+            }
+
+            // how many pieces to split `size' elements of work into: a few
+            // per thread, so that a thread done early can take another
+            inline std::size_t pieces(std::size_t size) {
+                return std::max<std::size_t>(1, std::min<std::size_t>(size, 4 * par::threads()));
+            }
+
+            // what (future expr) compiles to a call of, with a thunk of expr
+            inline Object future(Object const& thunk, void*) {
+                return par::spawn(thunk, Args{nullptr, 0});
+            }
+
+            inline Object touch(Object const& obj, void*) {
+                return par::touch(Object{obj});
+            }
+
+            inline Object is_future(Object const& obj, void*) {
+                return Object::boolean(Value::Type::Future == obj.type());
+            }
+
+            // (f x) for each x of a piece of a par-map, in a list
+            inline Object map_piece(Object const& f, Object const& piece, void*) {
+                auto on = running("par-map");
+                auto proc = f;
+                auto cur  = piece;
+                std::vector<Object> out;
+                gc::ScopedRoots roots{[&] (gc::Tracer& t) {
+                    t(proc);
+                    t(cur);
+                    for(auto& val : out) {
+                        t(val);
+                    }
+                }};
+                for(; !cur.is_empty_list(); cur = value_cast<Pair*>(cur)->cdr()) {
+                    auto arg = value_cast<Pair*>(cur)->car();
+                    auto val = on.vm->apply(proc, Args{&arg, 1}, *on.globals);
+                    out.push_back(val);
+                }
+                return to_list(out, 0, out.size());
+            }
+
+            // folds a piece of a par-fold, a list or a numeric vector, from
+            // `init' on
+            inline Object fold_piece(Object const& f, Object const& init, Object const& piece, void*) {
+                auto on = running("par-fold");
+                auto proc = f;
+                auto acc  = init;
+                auto seq  = piece;
+                gc::ScopedRoots roots{[&] (gc::Tracer& t) {
+                    t(proc);
+                    t(acc);
+                    t(seq);
+                }};
+                auto step = [&] (Object const& x) {
+                    Object const args[] = {acc, x};
+                    acc = on.vm->apply(proc, Args{args, 2}, *on.globals);
+                };
+                if(VectorKind::Count != vector_kind_of(seq)) {
+                    // the vector may move whenever f runs
+                    auto size = uvector::detail::visit(seq, [] (auto vec) { return vec->size(); });
+                    for(std::size_t i = 0; i < size; ++i) {
+                        step(uvector::detail::visit(seq, [&] (auto vec) { return uvector::detail::box((*vec)[i]); }));
+                    }
+                } else {
+                    for(; !seq.is_empty_list(); seq = value_cast<Pair*>(seq)->cdr()) {
+                        step(value_cast<Pair*>(seq)->car());
+                    }
+                }
+                return acc;
+            }
+
+            inline Object call_fold_piece(Args args, void*) {
+                return fold_piece(args[0], args[1], args[2], nullptr);
+            }
+
+            inline constexpr Primitive future_primitive     = {"future",     {1, 1}, nullptr, nullptr, future,     nullptr,    nullptr};
+            inline constexpr Primitive touch_primitive      = {"touch",      {1, 1}, nullptr, nullptr, touch,      nullptr,    nullptr};
+            inline constexpr Primitive is_future_primitive  = {"future?",    {1, 1}, nullptr, nullptr, is_future,  nullptr,    nullptr};
+            inline constexpr Primitive map_piece_primitive  = {"par-map",    {2, 2}, nullptr, nullptr, nullptr,    map_piece,  nullptr};
+            inline constexpr Primitive fold_piece_primitive = {"par-fold",   {3, 3}, call_fold_piece, nullptr, nullptr, nullptr, fold_piece};
+
+            // (par-map f list) is (map f list), its pieces mapped in parallel
+            inline Object par_map(Object const& f, Object const& list, void*) {
+                auto proc  = f;
+                auto elems = elements(list, "par-map");
+                auto piece = make_object<Procedure>(map_piece_primitive);
+                std::vector<Object> futures;
+                std::vector<Object> out;
+                gc::ScopedRoots roots{[&] (gc::Tracer& t) {
+                    t(proc);
+                    t(piece);
+                    for(auto& val : elems) {
+                        t(val);
+                    }
+                    for(auto& val : futures) {
+                        t(val);
+                    }
+                    for(auto& val : out) {
+                        t(val);
+                    }
+                }};
+
+                auto n = pieces(elems.size());
+                for(std::size_t i = 0; i < n; ++i) {
+                    Object const args[] = {proc, to_list(elems, elems.size() * i / n, elems.size() * (i + 1) / n)};
+                    auto future = par::spawn(piece, Args{args, 2}, true);
+                    futures.push_back(future);
+                }
+                elems.clear();
+                for(auto& future : futures) {
+                    auto mapped = par::touch(future);
+                    for(; !mapped.is_empty_list(); mapped = value_cast<Pair*>(mapped)->cdr()) {
+                        out.push_back(value_cast<Pair*>(mapped)->car());
+                    }
+                }
+                return to_list(out, 0, out.size());
+            }
+
+            // elements `begin' to `end' of a numeric vector, in one of their own
+            inline Object slice(Object const& vec, std::size_t begin, std::size_t end) {
+                return uvector::detail::visit(vec, [&] (auto v) {
+                    using T = typename std::remove_pointer_t<decltype(v)>::value_type;
+                    return make_object<NumVector<T>>(std::vector<T>(v->data() + begin, v->data() + end));
+                });
+            }
+
+            // (par-fold f init seq) folds the list or numeric vector seq from
+            // the left with f, like (f (f (f init x0) x1) x2) ...; its pieces
+            // are folded in parallel, each from init, and the results folded
+            // again in order. so f must be associative, with init as its
+            // identity
+            inline Object par_fold(Object const& f, Object const& init, Object const& seq, void*) {
+                auto proc  = f;
+                auto acc   = init;
+                auto whole = seq;
+                auto piece = make_object<Procedure>(fold_piece_primitive);
+                std::vector<Object> elems;
+                std::vector<Object> futures;
+                gc::ScopedRoots roots{[&] (gc::Tracer& t) {
+                    t(proc);
+                    t(acc);
+                    t(whole);
+                    t(piece);
+                    for(auto& val : elems) {
+                        t(val);
+                    }
+                    for(auto& val : futures) {
+                        t(val);
+                    }
+                }};
+
+                auto vector = VectorKind::Count != vector_kind_of(whole);
+                auto size = vector
+                    ? uvector::detail::visit(whole, [] (auto vec) { return vec->size(); })
+                    : (elems = elements(whole, "par-fold")).size();
+                auto n = pieces(size);
+                for(std::size_t i = 0; i < n; ++i) {
+                    auto begin = size * i / n;
+                    auto end   = size * (i + 1) / n;
+                    Object const args[] = {proc, acc, vector ? slice(whole, begin, end) : to_list(elems, begin, end)};
+                    auto future = par::spawn(piece, Args{args, 3}, true);
+                    futures.push_back(future);
+                }
+                elems.clear();
+                auto on = running("par-fold");
+                for(auto& future : futures) {
+                    auto folded = par::touch(future);
+                    Object const args[] = {acc, folded};
+                    acc = on.vm->apply(proc, Args{args, 2}, *on.globals);
+                }
+                return acc;
+            }
+
+            inline Object call_par_fold(Args args, void*) {
+                return par_fold(args[0], args[1], args[2], nullptr);
+            }
+
+            inline constexpr Primitive par_map_primitive  = {"par-map",  {2, 2}, nullptr, nullptr, nullptr, par_map, nullptr};
+            inline constexpr Primitive par_fold_primitive = {"par-fold", {3, 3}, call_par_fold, nullptr, nullptr, nullptr, par_fold};
+        }
+
+        // the primitive (future expr) calls with a thunk of expr
+        inline Primitive const& future_primitive() {
+            return detail::future_primitive;
+        }
+
+        // every primitive on futures, for registering by name
+        inline std::vector<Primitive const*> const& primitives() {
+            static std::vector<Primitive const*> const prims = {
+                &detail::touch_primitive,
+                &detail::is_future_primitive,
+                &detail::par_map_primitive,
+                &detail::par_fold_primitive
+            };
+            return prims;
+        }
+    };
+}
+
+#endif // __YASC_LIBSCHEME_PARALLEL_H_
@@ -0,0 +1,48 @@
+#include "simd.h"
+#include "simd_kernels.h"
+
+namespace yasc {
+    namespace simd {
+        // defined in simd_avx2.cpp, the only file built for avx2. nullptr
+        // when the compiler cannot target it
+        Kernels const* avx2_kernels();
+
+        namespace {
+            Kernels const scalar = make_kernels<0>("scalar");
+
+            // sse2 is part of x86-64 itself; elsewhere gcc lowers 16 byte
+            // vectors to whatever the target has
+            Kernels const vector16 = make_kernels<16>(
+#if defined(__x86_64__)
+                "sse2"
+#else
+                "vector128"
+#endif
+            );
+
+            bool has_avx2() {
+#if defined(__x86_64__)
+                return nullptr != avx2_kernels() && __builtin_cpu_supports("avx2");
+#else
+                return false;
+#endif
+            }
+        }
+
+        std::vector<Kernels const*> const& available() {
+            static auto const sets = [] {
+                std::vector<Kernels const*> ret{&scalar, &vector16};
+                if(has_avx2()) {
+                    ret.push_back(avx2_kernels());
+                }
+                return ret;
+            }();
+            return sets;
+        }
+
+        Kernels const& kernels() {
+            static auto const& best = *available().back();
+            return best;
+        }
+    };
+};
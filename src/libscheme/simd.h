@@ -0,0 +1,83 @@
+#ifndef __YASC_LIBSCHEME_SIMD_H_
+#define __YASC_LIBSCHEME_SIMD_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace yasc {
+    namespace simd {
+        enum class Op : std::uint8_t {
+            Add,
+            Sub,
+            Mul,
+            Div
+        };
+
+        // one side of an elementwise operation: either `size' elements or a
+        // single one that is broadcast
+        template<typename T>
+        struct Operand {
+            T const* data;
+            bool     scalar;
+        };
+
+        // where stage one of the bulk reader (see reader.h) left off, for
+        // carrying on with the next batch of input
+        struct ScanState {
+            // whether the last byte scanned was inside a comment
+            bool in_comment = false;
+
+            // 1 when the last byte scanned ends an atom, or if nothing was
+            // scanned yet
+            std::uint64_t after_separator = 1;
+        };
+
+        // the numeric vector kernels for one instruction set. reductions
+        // over no elements answer the operation's unity; min and max must
+        // not be given empty input.
+        //
+        // exact kernels never wrap around: sums are answered in 128 bits
+        // and the elementwise ones report a result out of the element
+        // type's range by returning false. s64 and u8 vectors have no
+        // elementwise division, their quotients are reals.
+        struct Kernels {
+            char const* name;
+
+            double (*sum_f64)(double const* data, std::size_t size);
+            double (*product_f64)(double const* data, std::size_t size);
+            double (*min_f64)(double const* data, std::size_t size);
+            double (*max_f64)(double const* data, std::size_t size);
+            double (*dot_f64)(double const* lhs, double const* rhs, std::size_t size);
+            void   (*map_f64)(Op op, Operand<double> lhs, Operand<double> rhs, double* out, std::size_t size);
+
+            __int128     (*sum_s64)(std::int64_t const* data, std::size_t size);
+            std::int64_t (*min_s64)(std::int64_t const* data, std::size_t size);
+            std::int64_t (*max_s64)(std::int64_t const* data, std::size_t size);
+            bool         (*map_s64)(Op op, Operand<std::int64_t> lhs, Operand<std::int64_t> rhs,
+                                    std::int64_t* out, std::size_t size);
+
+            std::uint64_t (*sum_u8)(std::uint8_t const* data, std::size_t size);
+            std::uint8_t  (*min_u8)(std::uint8_t const* data, std::size_t size);
+            std::uint8_t  (*max_u8)(std::uint8_t const* data, std::size_t size);
+            bool          (*map_u8)(Op op, Operand<std::uint8_t> lhs, Operand<std::uint8_t> rhs,
+                                    std::uint8_t* out, std::size_t size);
+
+            // stage one of the bulk reader: stores in `out' the offset of
+            // every structural byte of `data', that is every paren outside
+            // a comment and the first byte of every atom, and answers how
+            // many there were. `out' must have room for `size' offsets, and
+            // `size' must be a multiple of 64 unless this is the last call.
+            std::size_t (*structurals)(char const* data, std::size_t size, ScanState& state,
+                                       std::uint32_t* out);
+        };
+
+        // the widest kernels the CPU supports, picked on first use
+        Kernels const& kernels();
+
+        // every set of kernels the CPU supports, scalar first
+        std::vector<Kernels const*> const& available();
+    };
+};
+
+#endif // __YASC_LIBSCHEME_SIMD_H_
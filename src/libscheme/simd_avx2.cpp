@@ -0,0 +1,20 @@
+// built with -mavx2 where the target is x86-64 (see CMakeLists.txt); its
+// kernels are only ever called after checking the CPU supports them
+#include "simd.h"
+
+#if defined(__AVX2__)
+#include "simd_kernels.h"
+#endif
+
+namespace yasc {
+    namespace simd {
+        Kernels const* avx2_kernels() {
+#if defined(__AVX2__)
+            static Kernels const avx2 = make_kernels<32>("avx2");
+            return &avx2;
+#else
+            return nullptr;
+#endif
+        }
+    };
+};
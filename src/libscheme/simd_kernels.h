@@ -0,0 +1,494 @@
+#ifndef __YASC_LIBSCHEME_SIMD_KERNELS_H_
+#define __YASC_LIBSCHEME_SIMD_KERNELS_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "simd.h"
+
+// the kernels, written once against gcc's vector extensions and
+// instantiated for each vector width: simd.cpp builds the scalar and sse2
+// ones, simd_avx2.cpp the avx2 ones with -mavx2.
+//
+// everything here has internal linkage and calls nothing from the standard
+// library. an inline function compiled with -mavx2 could otherwise be the
+// copy the linker keeps for the whole program, and fault on older CPUs.
+namespace {
+    using yasc::simd::Op;
+    using yasc::simd::Operand;
+
+    template<typename T, std::size_t Bytes>
+    struct Lanes {
+        typedef T vec __attribute__((vector_size(Bytes)));
+
+        static constexpr std::size_t count = Bytes / sizeof(T);
+
+        static vec load(T const* data) {
+            vec val;
+            __builtin_memcpy(&val, data, sizeof val);
+            return val;
+        }
+
+        static void store(T* data, vec val) {
+            __builtin_memcpy(data, &val, sizeof val);
+        }
+
+        static vec splat(T val) {
+            return vec{} + val;
+        }
+    };
+
+    // folds `data' with `f', which takes either two vectors or two
+    // elements. two accumulators keep two vector operations in flight.
+    // with Bytes == 0 only the scalar loop is left.
+    template<typename T, std::size_t Bytes, typename F>
+    T reduce(T const* data, std::size_t size, T init, F f) {
+        auto i   = std::size_t{0};
+        auto acc = init;
+        if constexpr(0 != Bytes) {
+            using L = Lanes<T, Bytes>;
+            if(size >= 2 * L::count) {
+                auto v0 = L::load(data);
+                auto v1 = L::load(data + L::count);
+                for(i = 2 * L::count; i + 2 * L::count <= size; i += 2 * L::count) {
+                    v0 = f(v0, L::load(data + i));
+                    v1 = f(v1, L::load(data + i + L::count));
+                }
+                v0 = f(v0, v1);
+                for(auto k = std::size_t{0}; k < L::count; ++k) {
+                    acc = f(acc, static_cast<T>(v0[k]));
+                }
+            }
+        }
+        for(; i < size; ++i) {
+            acc = f(acc, data[i]);
+        }
+        return acc;
+    }
+
+    struct Plus {
+        template<typename V> V operator()(V a, V b) const { return a + b; }
+    };
+
+    struct Times {
+        template<typename V> V operator()(V a, V b) const { return a * b; }
+    };
+
+    struct Min {
+        template<typename V> V operator()(V a, V b) const { return b < a ? b : a; }
+    };
+
+    struct Max {
+        template<typename V> V operator()(V a, V b) const { return a < b ? b : a; }
+    };
+
+    template<std::size_t Bytes>
+    double sum_f64(double const* data, std::size_t size) {
+        return reduce<double, Bytes>(data, size, 0.0, Plus{});
+    }
+
+    template<std::size_t Bytes>
+    double product_f64(double const* data, std::size_t size) {
+        return reduce<double, Bytes>(data, size, 1.0, Times{});
+    }
+
+    template<typename T, std::size_t Bytes>
+    T min(T const* data, std::size_t size) {
+        return reduce<T, Bytes>(data, size, data[0], Min{});
+    }
+
+    template<typename T, std::size_t Bytes>
+    T max(T const* data, std::size_t size) {
+        return reduce<T, Bytes>(data, size, data[0], Max{});
+    }
+
+    template<std::size_t Bytes>
+    double dot_f64(double const* lhs, double const* rhs, std::size_t size) {
+        auto i   = std::size_t{0};
+        auto acc = 0.0;
+        if constexpr(0 != Bytes) {
+            using L = Lanes<double, Bytes>;
+            typename L::vec v0 = {}, v1 = {};
+            for(; i + 2 * L::count <= size; i += 2 * L::count) {
+                v0 += L::load(lhs + i) * L::load(rhs + i);
+                v1 += L::load(lhs + i + L::count) * L::load(rhs + i + L::count);
+            }
+            v0 += v1;
+            for(auto k = std::size_t{0}; k < L::count; ++k) {
+                acc += v0[k];
+            }
+        }
+        for(; i < size; ++i) {
+            acc += lhs[i] * rhs[i];
+        }
+        return acc;
+    }
+
+    // biasing each element by 2^63 makes it unsigned, and its two 32 bit
+    // halves can then be summed separately without carries for up to 2^32
+    // elements. the exact sum is put back together in 128 bits.
+    template<std::size_t Bytes>
+    __int128 sum_s64(std::int64_t const* signed_data, std::size_t size) {
+        constexpr auto bias = std::uint64_t{1} << 63;
+        constexpr auto low  = std::uint64_t{0xffffffff};
+        constexpr auto block = std::size_t{1} << 31;
+
+        auto data  = reinterpret_cast<std::uint64_t const*>(signed_data);
+        auto total = __int128{0};
+        for(auto start = std::size_t{0}; start < size; start += block) {
+            auto end = (size - start < block) ? size : start + block;
+            auto i   = start;
+            auto hi  = std::uint64_t{0};
+            auto lo  = std::uint64_t{0};
+            if constexpr(0 != Bytes) {
+                using L = Lanes<std::uint64_t, Bytes>;
+                typename L::vec vhi = {}, vlo = {};
+                for(; i + L::count <= end; i += L::count) {
+                    auto val = L::load(data + i) ^ bias;
+                    vhi += val >> 32;
+                    vlo += val & low;
+                }
+                for(auto k = std::size_t{0}; k < L::count; ++k) {
+                    hi += vhi[k];
+                    lo += vlo[k];
+                }
+            }
+            for(; i < end; ++i) {
+                auto val = data[i] ^ bias;
+                hi += val >> 32;
+                lo += val & low;
+            }
+            total += (static_cast<__int128>(hi) << 32) + lo
+                   - static_cast<__int128>(end - start) * static_cast<__int128>(bias);
+        }
+        return total;
+    }
+
+    // bytes are summed in 16 bit lanes, which cannot overflow within 256
+    // vectors, and the lanes are added up after each such block. half a
+    // register of bytes is loaded at a time, so the widened lanes fill one.
+    template<std::size_t Bytes>
+    std::uint64_t sum_u8(std::uint8_t const* data, std::size_t size) {
+        auto i     = std::size_t{0};
+        auto total = std::uint64_t{0};
+        if constexpr(0 != Bytes) {
+            using L    = Lanes<std::uint8_t, Bytes / 2>;
+            using Wide = Lanes<std::uint16_t, Bytes>;
+            while(i + L::count <= size) {
+                typename Wide::vec acc = {};
+                for(auto n = 0; n < 256 && i + L::count <= size; ++n, i += L::count) {
+                    acc += __builtin_convertvector(L::load(data + i), typename Wide::vec);
+                }
+                for(auto k = std::size_t{0}; k < Wide::count; ++k) {
+                    total += acc[k];
+                }
+            }
+        }
+        for(; i < size; ++i) {
+            total += data[i];
+        }
+        return total;
+    }
+
+    // applies `f' elementwise; a scalar operand is broadcast. the exact
+    // operations also fold a flag over their lanes, in which they set the
+    // top bit of any lane whose result is out of range.
+    template<typename T, std::size_t Bytes, bool LhsScalar, bool RhsScalar, typename F>
+    bool map_with(T const* lhs, T const* rhs, T* out, std::size_t size, F f) {
+        auto i    = std::size_t{0};
+        auto flag = T{0};
+        if constexpr(0 != Bytes) {
+            using L = Lanes<T, Bytes>;
+            typename L::vec vflag = {};
+            typename L::vec a = {}, b = {};
+            if constexpr(LhsScalar) {
+                a = L::splat(*lhs);
+            }
+            if constexpr(RhsScalar) {
+                b = L::splat(*rhs);
+            }
+            for(; i + L::count <= size; i += L::count) {
+                if constexpr(!LhsScalar) {
+                    a = L::load(lhs + i);
+                }
+                if constexpr(!RhsScalar) {
+                    b = L::load(rhs + i);
+                }
+                L::store(out + i, f(a, b, vflag));
+            }
+            if constexpr(F::checked) {
+                for(auto k = std::size_t{0}; k < L::count; ++k) {
+                    flag |= vflag[k];
+                }
+            }
+        }
+        for(; i < size; ++i) {
+            out[i] = f(LhsScalar ? *lhs : lhs[i], RhsScalar ? *rhs : rhs[i], flag);
+        }
+        if constexpr(F::checked) {
+            return 0 == (flag >> (8 * sizeof(T) - 1));
+        }
+        return true;
+    }
+
+    template<typename T, std::size_t Bytes, typename F>
+    bool map(Operand<T> lhs, Operand<T> rhs, T* out, std::size_t size, F f) {
+        if(lhs.scalar) {
+            return map_with<T, Bytes, true, false>(lhs.data, rhs.data, out, size, f);
+        }
+        if(rhs.scalar) {
+            return map_with<T, Bytes, false, true>(lhs.data, rhs.data, out, size, f);
+        }
+        return map_with<T, Bytes, false, false>(lhs.data, rhs.data, out, size, f);
+    }
+
+    template<typename Fn>
+    struct Unchecked {
+        static constexpr bool checked = false;
+        template<typename V> V operator()(V a, V b, V&) const { return Fn{}(a, b); }
+    };
+
+    struct Minus {
+        template<typename V> V operator()(V a, V b) const { return a - b; }
+    };
+
+    struct Quotient {
+        template<typename V> V operator()(V a, V b) const { return a / b; }
+    };
+
+    // on the bit patterns of two's complement words, where wrapping is
+    // defined: a sum overflows when it differs in sign from both operands,
+    // a difference when the operands differ in sign and the result differs
+    // from the minuend
+    struct AddS64 {
+        static constexpr bool checked = true;
+        template<typename V> V operator()(V a, V b, V& flag) const {
+            V r = a + b;
+            flag |= (a ^ r) & (b ^ r);
+            return r;
+        }
+    };
+
+    struct SubS64 {
+        static constexpr bool checked = true;
+        template<typename V> V operator()(V a, V b, V& flag) const {
+            V r = a - b;
+            flag |= (a ^ b) & (a ^ r);
+            return r;
+        }
+    };
+
+    // the carry and borrow out of the top bit of a byte
+    struct AddU8 {
+        static constexpr bool checked = true;
+        template<typename V> V operator()(V a, V b, V& flag) const {
+            V r = a + b;
+            flag |= (a & b) | ((a | b) & ~r);
+            return r;
+        }
+    };
+
+    struct SubU8 {
+        static constexpr bool checked = true;
+        template<typename V> V operator()(V a, V b, V& flag) const {
+            V r = a - b;
+            flag |= (~a & b) | ((~a | b) & r);
+            return r;
+        }
+    };
+
+    // bytes are multiplied in 16 bits; anything in the upper byte is out of
+    // range. like the sum, it works on half registers of bytes.
+    template<std::size_t Bytes>
+    struct MulU8 {
+        static constexpr bool checked = true;
+
+        std::uint8_t operator()(std::uint8_t a, std::uint8_t b, std::uint8_t& flag) const {
+            auto r = static_cast<unsigned>(a) * b;
+            flag |= (r >> 8) ? 0x80 : 0;
+            return static_cast<std::uint8_t>(r);
+        }
+
+        template<typename V> V operator()(V a, V b, V& flag) const {
+            using Wide = Lanes<std::uint16_t, Bytes>;
+            auto r = __builtin_convertvector(a, typename Wide::vec) * __builtin_convertvector(b, typename Wide::vec);
+            flag |= __builtin_convertvector(r > 0xff, V);
+            return __builtin_convertvector(r, V);
+        }
+    };
+
+    template<std::size_t Bytes>
+    void map_f64(Op op, Operand<double> lhs, Operand<double> rhs, double* out, std::size_t size) {
+        switch(op) {
+            case Op::Add: map<double, Bytes>(lhs, rhs, out, size, Unchecked<Plus>{});     break;
+            case Op::Sub: map<double, Bytes>(lhs, rhs, out, size, Unchecked<Minus>{});    break;
+            case Op::Mul: map<double, Bytes>(lhs, rhs, out, size, Unchecked<Times>{});    break;
+            case Op::Div: map<double, Bytes>(lhs, rhs, out, size, Unchecked<Quotient>{}); break;
+        }
+    }
+
+    // there is no vector multiplication of words before avx-512, so their
+    // products are checked one at a time
+    inline bool mul_s64(Operand<std::int64_t> lhs, Operand<std::int64_t> rhs, std::int64_t* out, std::size_t size) {
+        for(auto i = std::size_t{0}; i < size; ++i) {
+            if(__builtin_mul_overflow(lhs.data[lhs.scalar ? 0 : i], rhs.data[rhs.scalar ? 0 : i], &out[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    template<std::size_t Bytes>
+    bool map_s64(Op op, Operand<std::int64_t> lhs, Operand<std::int64_t> rhs, std::int64_t* out, std::size_t size) {
+        auto bits = [] (Operand<std::int64_t> val) {
+            return Operand<std::uint64_t>{reinterpret_cast<std::uint64_t const*>(val.data), val.scalar};
+        };
+        auto uout = reinterpret_cast<std::uint64_t*>(out);
+        switch(op) {
+            case Op::Add: return map<std::uint64_t, Bytes>(bits(lhs), bits(rhs), uout, size, AddS64{});
+            case Op::Sub: return map<std::uint64_t, Bytes>(bits(lhs), bits(rhs), uout, size, SubS64{});
+            case Op::Mul: return mul_s64(lhs, rhs, out, size);
+            default:      return false;
+        }
+    }
+
+    template<std::size_t Bytes>
+    bool map_u8(Op op, Operand<std::uint8_t> lhs, Operand<std::uint8_t> rhs, std::uint8_t* out, std::size_t size) {
+        switch(op) {
+            case Op::Add: return map<std::uint8_t, Bytes>(lhs, rhs, out, size, AddU8{});
+            case Op::Sub: return map<std::uint8_t, Bytes>(lhs, rhs, out, size, SubU8{});
+            case Op::Mul: return map<std::uint8_t, Bytes / 2>(lhs, rhs, out, size, MulU8<Bytes>{});
+            default:      return false;
+        }
+    }
+
+    // the bytes of a 64 byte block of text, one bit each
+    struct Block {
+        std::uint64_t space;      // whitespace, newlines included
+        std::uint64_t newline;
+        std::uint64_t paren;
+        std::uint64_t semicolon;
+    };
+
+    // the lanes of a comparison's result (all ones or all zeros) as bits.
+    // x86 has an instruction for it, anything else goes lane by lane
+    template<std::size_t Bytes, typename M>
+    std::uint64_t movemask(M m) {
+#if defined(__AVX2__)
+        if constexpr(32 == Bytes) {
+            typedef char v32 __attribute__((vector_size(32)));
+            return static_cast<std::uint32_t>(__builtin_ia32_pmovmskb256(reinterpret_cast<v32>(m)));
+        }
+#endif
+#if defined(__SSE2__)
+        if constexpr(16 == Bytes) {
+            typedef char v16 __attribute__((vector_size(16)));
+            return static_cast<std::uint16_t>(__builtin_ia32_pmovmskb128(reinterpret_cast<v16>(m)));
+        }
+#endif
+        auto bits = std::uint64_t{0};
+        for(auto k = std::size_t{0}; k < Bytes; ++k) {
+            bits |= static_cast<std::uint64_t>(m[k] & 1) << k;
+        }
+        return bits;
+    }
+
+    template<std::size_t Bytes>
+    Block classify(std::uint8_t const* data) {
+        Block b{};
+        if constexpr(0 == Bytes) {
+            for(auto i = 0u; i < 64; ++i) {
+                auto c   = data[i];
+                auto bit = std::uint64_t{1} << i;
+                b.space     |= (' ' == c || static_cast<std::uint8_t>(c - '\t') < 5) ? bit : 0;
+                b.newline   |= ('\n' == c) ? bit : 0;
+                b.paren     |= ('(' == c || ')' == c) ? bit : 0;
+                b.semicolon |= (';' == c) ? bit : 0;
+            }
+        } else {
+            using L = Lanes<std::uint8_t, Bytes>;
+            for(auto i = 0u; i < 64; i += L::count) {
+                auto v = L::load(data + i);
+                // \t, \n, \v, \f and \r are consecutive
+                b.space     |= movemask<Bytes>((v == L::splat(' ')) | (v - L::splat('\t') < L::splat(5))) << i;
+                b.newline   |= movemask<Bytes>(v == L::splat('\n')) << i;
+                b.paren     |= movemask<Bytes>((v == L::splat('(')) | (v == L::splat(')'))) << i;
+                b.semicolon |= movemask<Bytes>(v == L::splat(';')) << i;
+            }
+        }
+        return b;
+    }
+
+    // the bits from `pos' up, none when it is 64
+    inline std::uint64_t from(unsigned pos) {
+        return (pos < 64) ? ~std::uint64_t{0} << pos : 0;
+    }
+
+    // the bytes of a block inside comments, from a `;' up to (but not
+    // including) the end of its line. comments are rare enough to be
+    // followed one at a time
+    inline std::uint64_t comments(Block const& b, bool& in_comment) {
+        auto mask = std::uint64_t{0};
+        for(auto pos = 0u; ; ) {
+            if(in_comment) {
+                auto newlines = b.newline & from(pos);
+                if(0 == newlines) {
+                    return mask | from(pos);
+                }
+                auto end = static_cast<unsigned>(__builtin_ctzll(newlines));
+                mask |= from(pos) & ~from(end);
+                in_comment = false;
+                pos = end + 1;
+            } else {
+                auto semicolons = b.semicolon & from(pos);
+                if(0 == semicolons) {
+                    return mask;
+                }
+                pos = static_cast<unsigned>(__builtin_ctzll(semicolons));
+                in_comment = true;
+            }
+        }
+    }
+
+    template<std::size_t Bytes>
+    std::size_t structurals(char const* data, std::size_t size, yasc::simd::ScanState& state, std::uint32_t* out) {
+        auto count = std::size_t{0};
+        for(auto i = std::size_t{0}; i < size; i += 64) {
+            auto bytes = reinterpret_cast<std::uint8_t const*>(data + i);
+            // the last partial block is padded with spaces, which add no
+            // structurals
+            std::uint8_t tail[64];
+            if(size - i < 64) {
+                for(auto k = std::size_t{0}; k < 64; ++k) {
+                    tail[k] = (k < size - i) ? bytes[k] : ' ';
+                }
+                bytes = tail;
+            }
+
+            auto b = classify<Bytes>(bytes);
+            auto comment = (state.in_comment || 0 != b.semicolon) ? comments(b, state.in_comment) : 0;
+            auto sep     = b.space | b.paren | comment;
+            auto bits    = (b.paren & ~comment) | (~sep & ((sep << 1) | state.after_separator));
+            state.after_separator = sep >> 63;
+
+            for(; 0 != bits; bits &= bits - 1) {
+                out[count++] = static_cast<std::uint32_t>(i + __builtin_ctzll(bits));
+            }
+        }
+        return count;
+    }
+
+    template<std::size_t Bytes>
+    yasc::simd::Kernels make_kernels(char const* name) {
+        return {
+            name,
+            &sum_f64<Bytes>, &product_f64<Bytes>, &min<double, Bytes>, &max<double, Bytes>,
+            &dot_f64<Bytes>, &map_f64<Bytes>,
+            &sum_s64<Bytes>, &min<std::int64_t, Bytes>, &max<std::int64_t, Bytes>, &map_s64<Bytes>,
+            &sum_u8<Bytes>, &min<std::uint8_t, Bytes>, &max<std::uint8_t, Bytes>, &map_u8<Bytes>,
+            &structurals<Bytes>
+        };
+    }
+}
+
+#endif // __YASC_LIBSCHEME_SIMD_KERNELS_H_
@@ -0,0 +1,465 @@
+#ifndef __YASC_LIBSCHEME_UVECTOR_H_
+#define __YASC_LIBSCHEME_UVECTOR_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "simd.h"
+#include "../error.h"
+#include "../ast/value.h"
+#include "../ast/object.h"
+#include "../ast/procedure.h"
+#include "../ast/number.h"
+#include "../ast/bigint.h"
+#include "../ast/uvector.h"
+#include "../gc/heap.h"
+
+namespace yasc {
+
+    namespace uvector {
+        namespace detail {
+            template<typename T>
+            NumVector<T>* cast(Object const& obj) {
+                return value_cast<NumVector<T>*>(obj);
+            }
+
+            // calls `f' with the vector `obj' as its exact type
+            template<typename F>
+            decltype(auto) visit(Object const& obj, F&& f) {
+                switch(vector_kind_of(obj)) {
+                    case VectorKind::U8:  return f(cast<std::uint8_t>(obj));
+                    case VectorKind::S64: return f(cast<std::int64_t>(obj));
+                    case VectorKind::F64: return f(cast<double>(obj));
+                    default:              throw Error{"not a numeric vector"};
+                }
+            }
+
+            template<typename T>
+            struct names;
+
+            template<> struct names<std::uint8_t> {
+                static constexpr char const* ctor   = "u8vector";
+                static constexpr char const* make   = "make-u8vector";
+                static constexpr char const* length = "u8vector-length";
+                static constexpr char const* ref    = "u8vector-ref";
+                static constexpr char const* set    = "u8vector-set!";
+            };
+
+            template<> struct names<std::int64_t> {
+                static constexpr char const* ctor   = "s64vector";
+                static constexpr char const* make   = "make-s64vector";
+                static constexpr char const* length = "s64vector-length";
+                static constexpr char const* ref    = "s64vector-ref";
+                static constexpr char const* set    = "s64vector-set!";
+            };
+
+            template<> struct names<double> {
+                static constexpr char const* ctor   = "f64vector";
+                static constexpr char const* make   = "make-f64vector";
+                static constexpr char const* length = "f64vector-length";
+                static constexpr char const* ref    = "f64vector-ref";
+                static constexpr char const* set    = "f64vector-set!";
+            };
+
+            // a scheme number as an element; exact elements must be
+            // integers in the element type's range
+            template<typename T>
+            T to_element(Object const& obj, char const* who) {
+                auto kind = number_kind_of(obj);
+                if constexpr(std::is_same_v<T, double>) {
+                    switch(kind) {
+                        case NumberKind::Fixnum:   return static_cast<double>(obj.as_fixnum());
+                        case NumberKind::Bignum:   return number_traits<BigInt>::unbox(obj).to_double();
+                        case NumberKind::Rational: return number_traits<Ratio>::unbox(obj).to_double();
+                        case NumberKind::Real:     return number_traits<double>::unbox(obj);
+                        default: throw Error{std::string{who} + ": expects real numbers"};
+                    }
+                } else {
+                    std::intmax_t val = 0;
+                    auto ok = false;
+                    if(NumberKind::Fixnum == kind) {
+                        val = obj.as_fixnum();
+                        ok = true;
+                    } else if(NumberKind::Bignum == kind) {
+                        ok = number_traits<BigInt>::unbox(obj).to_int(val);
+                    }
+                    if(!ok || val < std::numeric_limits<T>::min() || val > std::numeric_limits<T>::max()) {
+                        throw Error{std::string{who} + ": expects integers from "
+                            + std::to_string(std::numeric_limits<T>::min()) + " to "
+                            + std::to_string(std::numeric_limits<T>::max())};
+                    }
+                    return static_cast<T>(val);
+                }
+            }
+
+            template<typename T>
+            Object box(T val) {
+                if constexpr(std::is_same_v<T, double>) {
+                    return number_traits<double>::box(val);
+                } else {
+                    return number_traits<std::intptr_t>::box(static_cast<std::intptr_t>(val));
+                }
+            }
+
+            inline BigInt to_big(__int128 val) {
+                auto const half = BigInt{std::intmax_t{1} << 32};
+                auto const low  = static_cast<std::uint64_t>(val);
+                auto big = BigInt{static_cast<std::intmax_t>(val >> 64)} * half * half;
+                big = big + BigInt{static_cast<std::intmax_t>(low >> 32)} * half;
+                return big + BigInt{static_cast<std::intmax_t>(low & 0xffffffffu)};
+            }
+
+            inline Object box(__int128 val) {
+                if(Object::fixnum_min <= val && val <= Object::fixnum_max) {
+                    return Object::fixnum(static_cast<std::intptr_t>(val));
+                }
+                return number_traits<BigInt>::box(to_big(val));
+            }
+
+            inline std::size_t to_index(Object const& obj, std::size_t size, char const* who) {
+                if(!obj.is_fixnum() || obj.as_fixnum() < 0 || static_cast<std::size_t>(obj.as_fixnum()) >= size) {
+                    throw Error{std::string{who} + ": index out of range"};
+                }
+                return static_cast<std::size_t>(obj.as_fixnum());
+            }
+
+            template<typename T>
+            NumVector<T>* expect(Object const& obj, char const* who) {
+                if(vector_kind<T> != vector_kind_of(obj)) {
+                    throw Error{std::string{who} + ": expects a " + names<T>::ctor};
+                }
+                return cast<T>(obj);
+            }
+
+            // the constructors and accessors of one element type
+            template<typename T>
+            struct typed {
+                static Object ctor(Args args, void*) {
+                    auto vec = make_object<NumVector<T>>(args.size());
+                    auto data = cast<T>(vec)->data();
+                    for(auto i = 0u; i < args.size(); ++i) {
+                        data[i] = to_element<T>(args[i], names<T>::ctor);
+                    }
+                    return vec;
+                }
+
+                static Object make(Args args, void*) {
+                    auto size = args[0];
+                    if(!size.is_fixnum() || size.as_fixnum() < 0) {
+                        throw Error{std::string{names<T>::make} + ": expects a length"};
+                    }
+                    auto fill = (args.size() > 1) ? to_element<T>(args[1], names<T>::make) : T{};
+                    return make_object<NumVector<T>>(static_cast<std::size_t>(size.as_fixnum()), fill);
+                }
+
+                static Object length(Object const& vec, void*) {
+                    return Object::fixnum(static_cast<std::intptr_t>(expect<T>(vec, names<T>::length)->size()));
+                }
+
+                static Object ref(Object const& vec, Object const& k, void*) {
+                    auto v = expect<T>(vec, names<T>::ref);
+                    return box((*v)[to_index(k, v->size(), names<T>::ref)]);
+                }
+
+                static Object set(Object const& vec, Object const& k, Object const& val, void*) {
+                    auto v = expect<T>(vec, names<T>::set);
+                    (*v)[to_index(k, v->size(), names<T>::set)] = to_element<T>(val, names<T>::set);
+                    return Object::unspecified();
+                }
+
+                static Object call_length(Args args, void*) { return length(args[0], nullptr); }
+                static Object call_ref(Args args, void*)    { return ref(args[0], args[1], nullptr); }
+                static Object call_set(Args args, void*)    { return set(args[0], args[1], args[2], nullptr); }
+
+                static constexpr Primitive ctor_primitive = {
+                    names<T>::ctor, {0, Arity::variadic}, ctor, nullptr, nullptr, nullptr, nullptr
+                };
+                static constexpr Primitive make_primitive = {
+                    names<T>::make, {1, 2}, make, nullptr, nullptr, nullptr, nullptr
+                };
+                static constexpr Primitive length_primitive = {
+                    names<T>::length, {1, 1}, call_length, nullptr, length, nullptr, nullptr
+                };
+                static constexpr Primitive ref_primitive = {
+                    names<T>::ref, {2, 2}, call_ref, nullptr, nullptr, ref, nullptr
+                };
+                static constexpr Primitive set_primitive = {
+                    names<T>::set, {3, 3}, call_set, nullptr, nullptr, nullptr, set
+                };
+            };
+
+            // one operand of an elementwise operation as elements of type T:
+            // a vector of that type is used in place, anything else is
+            // converted first
+            template<typename T>
+            class Side {
+            public:
+                Side(Object const& obj, char const* who) {
+                    if(VectorKind::Count == vector_kind_of(obj)) {
+                        scalar_ = to_element<T>(obj, who);
+                        return;
+                    }
+                    visit(obj, [&] (auto vec) {
+                        using E = typename std::remove_pointer_t<decltype(vec)>::value_type;
+                        size_ = vec->size();
+                        if constexpr(std::is_same_v<E, T>) {
+                            data_ = vec->data();
+                        } else {
+                            buf_.assign(vec->data(), vec->data() + vec->size());
+                            data_ = buf_.data();
+                        }
+                    });
+                }
+
+                Side(Side const&) = delete;
+                Side& operator=(Side const&) = delete;
+
+                bool is_scalar() const {
+                    return nullptr == data_;
+                }
+
+                std::size_t size() const {
+                    return size_;
+                }
+
+                simd::Operand<T> operand() const {
+                    return is_scalar() ? simd::Operand<T>{&scalar_, true} : simd::Operand<T>{data_, false};
+                }
+
+            private:
+                T const* data_ = nullptr;
+                std::size_t size_ = 0;
+                T scalar_{};
+                std::vector<T> buf_;
+            };
+
+            // the kind a number takes next to a vector: reals are f64, and
+            // exact integers the narrowest kind that holds them
+            inline VectorKind scalar_kind(Object const& obj, char const* who) {
+                switch(number_kind_of(obj)) {
+                    case NumberKind::Fixnum: {
+                        auto val = obj.as_fixnum();
+                        return (0 <= val && val <= 0xff) ? VectorKind::U8 : VectorKind::S64;
+                    }
+                    case NumberKind::Real:
+                        return VectorKind::F64;
+                    default:
+                        throw Error{std::string{who} + ": numeric vectors combine with vectors, fixnums and reals only"};
+                }
+            }
+
+            template<typename T>
+            bool map(simd::Op op, simd::Operand<T> lhs, simd::Operand<T> rhs, T* out, std::size_t size) {
+                auto const& k = simd::kernels();
+                if constexpr(std::is_same_v<T, double>) {
+                    k.map_f64(op, lhs, rhs, out, size);
+                    return true;
+                } else if constexpr(std::is_same_v<T, std::int64_t>) {
+                    return k.map_s64(op, lhs, rhs, out, size);
+                } else {
+                    return k.map_u8(op, lhs, rhs, out, size);
+                }
+            }
+
+            template<typename T>
+            Object elementwise(char const* who, simd::Op op, Object const& lhs, Object const& rhs) {
+                Side<T> l{lhs, who}, r{rhs, who};
+                if(!l.is_scalar() && !r.is_scalar() && l.size() != r.size()) {
+                    throw Error{std::string{who} + ": vectors differ in length"};
+                }
+                auto size = l.is_scalar() ? r.size() : l.size();
+                auto vec = make_object<NumVector<T>>(size);
+                if(!map<T>(op, l.operand(), r.operand(), cast<T>(vec)->data(), size)) {
+                    throw Error{std::string{who} + ": result out of range for " + names<T>::ctor};
+                }
+                return vec;
+            }
+
+            // exact products and dot products, in 128 bits while they fit
+            // and in bignums after that
+            class ExactSum {
+            public:
+                explicit ExactSum(__int128 init)
+                    : acc_{init}
+                {}
+
+                void add_product(std::int64_t a, std::int64_t b) {
+                    auto prod = static_cast<__int128>(a) * b;
+                    if(!big_ && !__builtin_add_overflow(acc_, prod, &acc_)) {
+                        return;
+                    }
+                    spill();
+                    *big_ = *big_ + BigInt{a} * BigInt{b};
+                }
+
+                void mul(std::int64_t a) {
+                    if(!big_ && !__builtin_mul_overflow(acc_, static_cast<__int128>(a), &acc_)) {
+                        return;
+                    }
+                    spill();
+                    *big_ = *big_ * BigInt{a};
+                }
+
+                Object get() const {
+                    return big_ ? number_traits<BigInt>::box(*big_) : box(acc_);
+                }
+
+            private:
+                void spill() {
+                    if(!big_) {
+                        big_ = std::make_unique<BigInt>(to_big(acc_));
+                    }
+                }
+
+                __int128 acc_;
+                std::unique_ptr<BigInt> big_;
+            };
+
+            inline Object sum(Object const& obj, void*) {
+                auto const& k = simd::kernels();
+                return visit(obj, [&] (auto vec) {
+                    using T = typename std::remove_pointer_t<decltype(vec)>::value_type;
+                    if constexpr(std::is_same_v<T, double>) {
+                        return box(k.sum_f64(vec->data(), vec->size()));
+                    } else if constexpr(std::is_same_v<T, std::int64_t>) {
+                        return box(k.sum_s64(vec->data(), vec->size()));
+                    } else {
+                        return box(static_cast<std::int64_t>(k.sum_u8(vec->data(), vec->size())));
+                    }
+                });
+            }
+
+            inline Object product(Object const& obj, void*) {
+                return visit(obj, [&] (auto vec) {
+                    using T = typename std::remove_pointer_t<decltype(vec)>::value_type;
+                    if constexpr(std::is_same_v<T, double>) {
+                        return box(simd::kernels().product_f64(vec->data(), vec->size()));
+                    } else {
+                        ExactSum acc{1};
+                        for(auto i = std::size_t{0}; i < vec->size(); ++i) {
+                            acc.mul((*vec)[i]);
+                        }
+                        return acc.get();
+                    }
+                });
+            }
+
+            template<bool Max>
+            Object extremum(Object const& obj, void*) {
+                auto const& k = simd::kernels();
+                return visit(obj, [&] (auto vec) {
+                    using T = typename std::remove_pointer_t<decltype(vec)>::value_type;
+                    if(0 == vec->size()) {
+                        throw Error{Max ? "uvector-max: empty vector" : "uvector-min: empty vector"};
+                    }
+                    if constexpr(std::is_same_v<T, double>) {
+                        return box((Max ? k.max_f64 : k.min_f64)(vec->data(), vec->size()));
+                    } else if constexpr(std::is_same_v<T, std::int64_t>) {
+                        return box((Max ? k.max_s64 : k.min_s64)(vec->data(), vec->size()));
+                    } else {
+                        return box((Max ? k.max_u8 : k.min_u8)(vec->data(), vec->size()));
+                    }
+                });
+            }
+
+            template<typename T>
+            Object dot_as(Object const& lhs, Object const& rhs) {
+                Side<T> l{lhs, "uvector-dot"}, r{rhs, "uvector-dot"};
+                if(l.size() != r.size()) {
+                    throw Error{"uvector-dot: vectors differ in length"};
+                }
+                auto a = l.operand().data, b = r.operand().data;
+                if constexpr(std::is_same_v<T, double>) {
+                    return box(simd::kernels().dot_f64(a, b, l.size()));
+                } else {
+                    ExactSum acc{0};
+                    for(auto i = std::size_t{0}; i < l.size(); ++i) {
+                        acc.add_product(a[i], b[i]);
+                    }
+                    return acc.get();
+                }
+            }
+
+            inline Object dot(Object const& lhs, Object const& rhs, void*) {
+                auto lk = vector_kind_of(lhs), rk = vector_kind_of(rhs);
+                if(VectorKind::Count == lk || VectorKind::Count == rk) {
+                    throw Error{"uvector-dot: expects two numeric vectors"};
+                }
+                switch(lk > rk ? lk : rk) {
+                    case VectorKind::F64: return dot_as<double>(lhs, rhs);
+                    default:              return dot_as<std::int64_t>(lhs, rhs);
+                }
+            }
+
+            inline Object call_sum(Args args, void*)     { return sum(args[0], nullptr); }
+            inline Object call_product(Args args, void*) { return product(args[0], nullptr); }
+            inline Object call_min(Args args, void*)     { return extremum<false>(args[0], nullptr); }
+            inline Object call_max(Args args, void*)     { return extremum<true>(args[0], nullptr); }
+            inline Object call_dot(Args args, void*)     { return dot(args[0], args[1], nullptr); }
+
+            inline constexpr Primitive sum_primitive = {
+                "uvector-sum", {1, 1}, call_sum, nullptr, sum, nullptr, nullptr
+            };
+            inline constexpr Primitive product_primitive = {
+                "uvector-product", {1, 1}, call_product, nullptr, product, nullptr, nullptr
+            };
+            inline constexpr Primitive min_primitive = {
+                "uvector-min", {1, 1}, call_min, nullptr, extremum<false>, nullptr, nullptr
+            };
+            inline constexpr Primitive max_primitive = {
+                "uvector-max", {1, 1}, call_max, nullptr, extremum<true>, nullptr, nullptr
+            };
+            inline constexpr Primitive dot_primitive = {
+                "uvector-dot", {2, 2}, call_dot, nullptr, nullptr, dot, nullptr
+            };
+        };
+
+        // whether `obj' may take part in an elementwise operation
+        inline bool is_operand(Object const& obj) {
+            return VectorKind::Count != vector_kind_of(obj) || NumberKind::Count != number_kind_of(obj);
+        }
+
+        // `op' on each pair of elements, for operands one of which at least
+        // is a vector. the result has the higher kind of the two, except
+        // that the quotients of exact vectors are f64. exact results out of
+        // range raise an Error rather than wrap around.
+        inline Object elementwise(char const* who, simd::Op op, Object const& lhs, Object const& rhs) {
+            auto kind_of = [&] (Object const& obj) {
+                auto kind = vector_kind_of(obj);
+                return VectorKind::Count == kind ? detail::scalar_kind(obj, who) : kind;
+            };
+            auto lk = kind_of(lhs), rk = kind_of(rhs);
+            auto kind = (lk > rk) ? lk : rk;
+            if(simd::Op::Div == op) {
+                kind = VectorKind::F64;
+            }
+            switch(kind) {
+                case VectorKind::U8:  return detail::elementwise<std::uint8_t>(who, op, lhs, rhs);
+                case VectorKind::S64: return detail::elementwise<std::int64_t>(who, op, lhs, rhs);
+                default:              return detail::elementwise<double>(who, op, lhs, rhs);
+            }
+        }
+
+        // every numeric vector primitive, for registering by name
+        inline std::vector<Primitive const*> const& primitives() {
+            using U8  = detail::typed<std::uint8_t>;
+            using S64 = detail::typed<std::int64_t>;
+            using F64 = detail::typed<double>;
+            static std::vector<Primitive const*> const prims = {
+                &U8::ctor_primitive,  &U8::make_primitive,  &U8::length_primitive,  &U8::ref_primitive,  &U8::set_primitive,
+                &S64::ctor_primitive, &S64::make_primitive, &S64::length_primitive, &S64::ref_primitive, &S64::set_primitive,
+                &F64::ctor_primitive, &F64::make_primitive, &F64::length_primitive, &F64::ref_primitive, &F64::set_primitive,
+                &detail::sum_primitive, &detail::product_primitive, &detail::min_primitive,
+                &detail::max_primitive, &detail::dot_primitive
+            };
+            return prims;
+        }
+    };
+}
+
+#endif // __YASC_LIBSCHEME_UVECTOR_H_
@@ -1,16 +1,187 @@
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <fstream>
 #include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
 
+#include "lexer.h"
 #include "parser.h"
 #include "evaluator.h"
+#include "trace.h"
+#include "par/scheduler.h"
 
 #include "repl.h"
 
-int main() {
+namespace {
+    // evaluates every form in `path', printing each result; the file is
+    // mapped rather than read, so large inputs are never copied
+    bool run_file(std::string const& path, yasc::Evaluator& eval) {
+        using namespace yasc;
+        try {
+            MappedFile file{path};
+            Lexer lexer{file.data()};
+            Parser parser;
+            gc::Region region;
+            for(;;) {
+                auto ast = parser.next(lexer, region);
+                if(ast.is_null()) {
+                    return true;
+                }
+                auto result = gc::current_heap().escape(eval(ast));
+                region.release();
+                std::cout << result << std::endl;
+                gc::safepoint();
+            }
+        } catch(std::exception const& e) {
+            std::cerr << path << ": error: " << e.what() << std::endl;
+            return false;
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    // --ast evaluates with the old tree walker instead of the bytecode VM
+    // and --no-quicken runs the VM without specializing its call sites.
+    // --opt-level N sets how hard forms are optimized first (0 to 2) and
+    // --max-depth N how deeply calls may nest. --threads N runs futures on
+    // N threads rather than one per core. --profile calls (or sample)
+    // profiles the files run, or sets how the repl's ,profile does, and
+    // --profile-out FILE writes the collapsed stacks to FILE, and
+    // --trace=FILE (or --trace FILE) records a timeline of the whole session
+    // to FILE, for chrome://tracing or Perfetto. any other argument is a
+    // file to run instead of starting the repl.
+    //
+    // with YASC_HEAP_STATS=FILE set, the heap writes a report of what it
+    // holds to FILE after collections, at most every YASC_HEAP_STATS_INTERVAL
+    // milliseconds (1000 by default), and when the program exits
+    if(auto path = std::getenv("YASC_HEAP_STATS"); nullptr != path && *path) {
+        auto interval = std::getenv("YASC_HEAP_STATS_INTERVAL");
+        auto ms = (nullptr != interval) ? std::strtoull(interval, nullptr, 10) : 1000;
+        yasc::gc::current_heap().dump_to(std::make_unique<std::ofstream>(path),
+            std::chrono::milliseconds{ms});
+    }
+
+    auto mode = yasc::Evaluator::Mode::Quickening;
+    auto opt_level = 1u;
+    auto max_depth = yasc::vm::VM::default_max_depth;
+    auto profiling = false;
+    auto profile_mode = yasc::vm::Profiler::Mode::Calls;
+    std::string profile_out;
+    std::string trace_out;
+    std::vector<std::string> files;
+    for(int i = 1; i < argc; ++i) {
+        if(0 == std::strncmp(argv[i], "--trace=", 8)) {
+            trace_out = argv[i] + 8;
+        } else if(0 == std::strcmp(argv[i], "--trace")) {
+            if(i + 1 == argc) {
+                std::cerr << "--trace expects a file" << std::endl;
+                return 1;
+            }
+            trace_out = argv[++i];
+        } else if(0 == std::strcmp(argv[i], "--profile")) {
+            if(i + 1 < argc && 0 == std::strcmp(argv[i + 1], "calls")) {
+                profile_mode = yasc::vm::Profiler::Mode::Calls;
+            } else if(i + 1 < argc && 0 == std::strcmp(argv[i + 1], "sample")) {
+                profile_mode = yasc::vm::Profiler::Mode::Sampling;
+            } else {
+                std::cerr << "--profile expects calls or sample" << std::endl;
+                return 1;
+            }
+            profiling = true;
+            ++i;
+        } else if(0 == std::strcmp(argv[i], "--profile-out")) {
+            if(i + 1 == argc) {
+                std::cerr << "--profile-out expects a file" << std::endl;
+                return 1;
+            }
+            profile_out = argv[++i];
+            profiling = true;
+        } else if(0 == std::strcmp(argv[i], "--max-depth")) {
+            char* end = nullptr;
+            if(i + 1 == argc || 0 == (max_depth = std::strtoull(argv[i + 1], &end, 10)) || *end) {
+                std::cerr << "--max-depth expects a positive number" << std::endl;
+                return 1;
+            }
+            ++i;
+        } else if(0 == std::strcmp(argv[i], "--threads")) {
+            char* end = nullptr;
+            auto threads = 0ull;
+            if(i + 1 == argc || 0 == (threads = std::strtoull(argv[i + 1], &end, 10)) || *end || threads > 1024) {
+                std::cerr << "--threads expects a number from 1 to 1024" << std::endl;
+                return 1;
+            }
+            yasc::par::set_threads(static_cast<unsigned>(threads));
+            ++i;
+        } else if(0 == std::strcmp(argv[i], "--opt-level")) {
+            if(i + 1 == argc || argv[i + 1][0] < '0' || argv[i + 1][0] > '2' || argv[i + 1][1]) {
+                std::cerr << "--opt-level expects 0, 1 or 2" << std::endl;
+                return 1;
+            }
+            opt_level = static_cast<unsigned>(argv[++i][0] - '0');
+        } else if(0 == std::strcmp(argv[i], "--ast")) {
+            mode = yasc::Evaluator::Mode::Ast;
+        } else if(0 == std::strcmp(argv[i], "--no-quicken")) {
+            mode = yasc::Evaluator::Mode::Bytecode;
+        } else {
+            files.emplace_back(argv[i]);
+        }
+    }
+
+    // the trace is written once the session is over, however it ends
+    std::ofstream trace;
+    if(!trace_out.empty()) {
+        trace.open(trace_out);
+        if(!trace) {
+            std::cerr << "--trace: cannot write " << trace_out << std::endl;
+            return 1;
+        }
+        yasc::trace::start();
+    }
+    auto write_trace = [&] {
+        if(trace.is_open()) {
+            yasc::trace::stop();
+            yasc::trace::write(trace);
+        }
+    };
+
+    if(!files.empty()) {
+        yasc::Evaluator eval{mode, opt_level};
+        eval.set_max_depth(max_depth);
+        if(profiling) {
+            eval.start_profiling(profile_mode);
+        }
+        auto ok = true;
+        for(auto const& file : files) {
+            if(!(ok = run_file(file, eval))) {
+                break;
+            }
+        }
+        if(profiling) {
+            // the report goes to stderr, out of the way of the values printed
+            eval.stop_profiling();
+            eval.profiler().report(std::cerr);
+            if(!profile_out.empty()) {
+                std::ofstream stacks{profile_out};
+                eval.profiler().collapsed(stacks);
+            }
+        }
+        write_trace();
+        return ok ? 0 : 1;
+    }
+
+    yasc::Evaluator eval{mode, opt_level};
+    eval.set_max_depth(max_depth);
     yasc::Repl repl {
         yasc::Parser{},
-        yasc::Evaluator{},
+        eval,
         std::cin,
         std::cout
     };
+    repl.set_profiling(profile_mode, profile_out);
     repl.run();
+    write_trace();
 }
@@ -0,0 +1,377 @@
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <string>
+#include <system_error>
+
+#include "number_lexer.h"
+#include "error.h"
+#include "ast/bigint.h"
+#include "ast/ratio.h"
+#include "ast/number.h"
+
+namespace {
+    using namespace yasc;
+
+    // a real part of a literal, before it is boxed
+    struct Real {
+        bool   exact = true;
+        Ratio  ratio;
+        double real = 0.0;
+
+        double to_double() const {
+            return exact ? ratio.to_double() : real;
+        }
+
+        bool is_exact_zero() const {
+            return exact && 0 == ratio.sign();
+        }
+    };
+
+    char lower(char c) {
+        return static_cast<char>(c | 0x20);
+    }
+
+    // the value of `c' as a digit in any radix up to 36, or 36 if it is
+    // not one
+    int digit_value(char c) {
+        if('0' <= c && c <= '9') {
+            return c - '0';
+        }
+        auto l = lower(c);
+        return ('a' <= l && l <= 'z') ? l - 'a' + 10 : 36;
+    }
+
+    // the largest exponent an exact decimal may have. #e1e100000 would
+    // otherwise take seconds to read, and #e1e999999999 forever
+    constexpr std::int64_t max_exact_exponent = 10000;
+
+    // radix^count, by squaring
+    BigInt power(int radix, std::size_t count) {
+        auto ret = BigInt{1};
+        auto base = BigInt{radix};
+        for(; count > 0; count >>= 1) {
+            if(count & 1) {
+                ret = ret * base;
+            }
+            if(count > 1) {
+                base = base * base;
+            }
+        }
+        return ret;
+    }
+
+    class NumberLexer {
+    public:
+        explicit NumberLexer(std::string_view tok)
+            : tok_{tok}
+            , pos_{0}
+            , radix_{10}
+            , exactness_{'\0'}
+        {}
+
+        // false unless the whole token is a number
+        bool lex(Object& out) {
+            if(!prefixes()) {
+                return false;
+            }
+
+            auto rest = tok_.substr(pos_);
+            if("+i" == rest || "-i" == rest) {
+                Real unit;
+                unit.ratio = Ratio{('-' == rest[0]) ? -1 : 1};
+                out = box(Real{}, unit);
+                return true;
+            }
+
+            Real re, im;
+            auto signed_re = false, signed_im = false;
+            if(!real(re, signed_re)) {
+                return false;
+            }
+            if(at_end()) {
+                out = box(re);
+                return true;
+            }
+
+            switch(tok_[pos_]) {
+                case '@': {
+                    ++pos_;
+                    if(!real(im, signed_im) || !at_end()) {
+                        return false;
+                    }
+                    if(im.is_exact_zero()) {
+                        out = box(re);
+                    } else {
+                        check_inexact();
+                        out = number_traits<std::complex<double>>::box(std::polar(re.to_double(), im.to_double()));
+                    }
+                    return true;
+                }
+                case '+':
+                case '-': {
+                    rest = tok_.substr(pos_);
+                    if("+i" == rest || "-i" == rest) {
+                        im.ratio = Ratio{('-' == rest[0]) ? -1 : 1};
+                    } else if(!real(im, signed_im) || pos_ + 1 != tok_.size() || 'i' != lower(tok_[pos_])) {
+                        return false;
+                    }
+                    out = box(re, im);
+                    return true;
+                }
+                default:
+                    // a signed real followed by `i' is all imaginary
+                    if(!signed_re || pos_ + 1 != tok_.size() || 'i' != lower(tok_[pos_])) {
+                        return false;
+                    }
+                    out = box(Real{}, re);
+                    return true;
+            }
+        }
+
+    private:
+        bool at_end() const {
+            return pos_ == tok_.size();
+        }
+
+        // at most one radix and one exactness prefix, in either order
+        bool prefixes() {
+            while(pos_ + 1 < tok_.size() && '#' == tok_[pos_]) {
+                switch(lower(tok_[pos_ + 1])) {
+                    case 'x': if(10 != radix_) return false; radix_ = 16; break;
+                    case 'o': if(10 != radix_) return false; radix_ = 8;  break;
+                    case 'b': if(10 != radix_) return false; radix_ = 2;  break;
+                    case 'd': break;
+                    case 'e':
+                    case 'i':
+                        if('\0' != exactness_) {
+                            return false;
+                        }
+                        exactness_ = lower(tok_[pos_ + 1]);
+                        break;
+                    default:
+                        return false;
+                }
+                pos_ += 2;
+            }
+            return !at_end();
+        }
+
+        // where the run of digits in the radix starting at `from' ends
+        std::size_t digits(std::size_t from) const {
+            while(from < tok_.size() && digit_value(tok_[from]) < radix_) {
+                ++from;
+            }
+            return from;
+        }
+
+        bool real(Real& out, bool& has_sign) {
+            auto negative = false;
+            has_sign = false;
+            if(!at_end() && ('+' == tok_[pos_] || '-' == tok_[pos_])) {
+                negative = ('-' == tok_[pos_]);
+                has_sign = true;
+                ++pos_;
+            }
+            if(has_sign) {
+                auto special = tok_.substr(pos_, 5);
+                if("inf.0" == special || "nan.0" == special) {
+                    out.exact = false;
+                    out.real  = ('i' == special[0]) ? std::numeric_limits<double>::infinity()
+                                                     : std::numeric_limits<double>::quiet_NaN();
+                    out.real  = negative ? -out.real : out.real;
+                    pos_ += 5;
+                    return true;
+                }
+            }
+            return ureal(negative, out);
+        }
+
+        bool ureal(bool negative, Real& out) {
+            auto start = pos_;
+            auto end   = digits(start);
+            if(10 == radix_ && end < tok_.size() && ('.' == tok_[end] || 'e' == lower(tok_[end]))) {
+                return decimal(negative, out);
+            }
+            if(end == start) {
+                return false;
+            }
+            out.exact = true;
+            out.ratio = integer(tok_.substr(start, end - start), negative);
+            pos_ = end;
+
+            if(!at_end() && '/' == tok_[pos_]) {
+                auto den_end = digits(pos_ + 1);
+                if(den_end == pos_ + 1) {
+                    return false;
+                }
+                auto den = integer(tok_.substr(pos_ + 1, den_end - pos_ - 1), false);
+                if(0 == den.sign()) {
+                    throw Error{"division by zero"};
+                }
+                out.ratio = out.ratio / den;
+                pos_ = den_end;
+            }
+            return true;
+        }
+
+        // the digits of a word in a single from_chars, anything longer a
+        // word's worth of digits at a time
+        Ratio integer(std::string_view digits, bool negative) const {
+            std::uint64_t mag;
+            auto [ptr, ec] = std::from_chars(digits.data(), digits.data() + digits.size(), mag, radix_);
+            if(std::errc{} == ec && mag <= static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max())) {
+                auto val = static_cast<std::intmax_t>(mag);
+                return Ratio{negative ? -val : val};
+            }
+
+            // radix^chunk never overflows an int64
+            auto chunk = std::size_t{1};
+            for(auto limit = std::numeric_limits<std::int64_t>::max() / radix_, p = std::int64_t{radix_}; p <= limit; p *= radix_) {
+                ++chunk;
+            }
+            auto val = BigInt{0};
+            while(!digits.empty()) {
+                auto len = std::min(chunk, digits.size());
+                std::int64_t piece;
+                std::from_chars(digits.data(), digits.data() + len, piece, radix_);
+                val = val * power(radix_, len) + BigInt{piece};
+                digits.remove_prefix(len);
+            }
+            return Ratio{negative ? -val : val};
+        }
+
+        // digits, an optional fraction and an optional exponent, in radix
+        // 10 only. inexact unless asked for with #e, which reads the
+        // decimal exactly
+        bool decimal(bool negative, Real& out) {
+            auto start     = pos_;
+            auto int_end   = digits(start);
+            auto frac_end  = int_end;
+            if(frac_end < tok_.size() && '.' == tok_[frac_end]) {
+                frac_end = digits(frac_end + 1);
+            }
+            if(int_end == start && frac_end <= int_end + 1) {
+                return false;
+            }
+            auto end = frac_end;
+            auto exponent = std::int64_t{0};
+            if(end < tok_.size() && 'e' == lower(tok_[end])) {
+                auto exp_start = end + 1;
+                if(exp_start < tok_.size() && ('+' == tok_[exp_start] || '-' == tok_[exp_start])) {
+                    ++exp_start;
+                }
+                end = digits(exp_start);
+                if(end == exp_start) {
+                    return false;
+                }
+                // from_chars takes a minus sign but no plus
+                auto from = tok_.data() + exp_start - (('-' == tok_[exp_start - 1]) ? 1 : 0);
+                if(std::from_chars(from, tok_.data() + end, exponent).ec != std::errc{}) {
+                    throw Error{"exponent out of range in `" + std::string{tok_} + "'"};
+                }
+            }
+            pos_ = end;
+
+            if('e' == exactness_) {
+                if(exponent > max_exact_exponent || exponent < -max_exact_exponent) {
+                    throw Error{"exponent too large for an exact number in `" + std::string{tok_} + "'"};
+                }
+                auto frac_start = std::min(int_end + 1, frac_end);
+                auto whole = (int_end == start) ? Ratio{0} : integer(tok_.substr(start, int_end - start), false);
+                auto frac  = (frac_end == frac_start) ? Ratio{0} : integer(tok_.substr(frac_start, frac_end - frac_start), false);
+                auto scale = frac_end - frac_start;
+                auto mantissa = whole * Ratio{power(10, scale)} + frac;
+                auto shift = exponent - static_cast<std::int64_t>(scale);
+                out.exact = true;
+                out.ratio = (shift >= 0) ? mantissa * Ratio{power(10, static_cast<std::size_t>(shift))}
+                                         : mantissa / Ratio{power(10, static_cast<std::size_t>(-shift))};
+                out.ratio = negative ? -out.ratio : out.ratio;
+                return true;
+            }
+
+            auto [ptr, ec] = std::from_chars(tok_.data() + start, tok_.data() + end, out.real);
+            if(std::errc::result_out_of_range == ec) {
+                // from_chars leaves the value alone; strtod overflows to
+                // infinity and underflows to zero
+                out.real = std::strtod(std::string{tok_.substr(start, end - start)}.c_str(), nullptr);
+            } else if(std::errc{} != ec || tok_.data() + end != ptr) {
+                return false;
+            }
+            out.exact = false;
+            out.real  = negative ? -out.real : out.real;
+            return true;
+        }
+
+        void check_inexact() const {
+            if('e' == exactness_) {
+                throw Error{"no exact representation of `" + std::string{tok_} + "'"};
+            }
+        }
+
+        Object box(Real const& re) const {
+            if(re.exact && 'i' != exactness_) {
+                return number_traits<Ratio>::box(re.ratio);
+            }
+            if(!re.exact) {
+                check_inexact();
+            }
+            return number_traits<double>::box(re.to_double());
+        }
+
+        // complex numbers are inexact, unless the imaginary part is an
+        // exact zero and there is only the real one
+        Object box(Real const& re, Real const& im) const {
+            if(im.is_exact_zero()) {
+                return box(re);
+            }
+            check_inexact();
+            return number_traits<std::complex<double>>::box({re.to_double(), im.to_double()});
+        }
+
+        std::string_view tok_;
+        std::size_t pos_;
+        int radix_;
+        char exactness_;
+    };
+
+    // whether a token that is not a number was meant to be one: it starts
+    // with a digit, possibly after a sign or a point, or with a prefix
+    bool looks_numeric(std::string_view tok) {
+        if(tok.size() > 1 && '#' == tok[0]) {
+            auto c = lower(tok[1]);
+            return 'x' == c || 'o' == c || 'b' == c || 'd' == c || 'e' == c || 'i' == c;
+        }
+        auto skip = ('+' == tok[0] || '-' == tok[0] || '.' == tok[0]) ? 1u : 0u;
+        return tok.size() > skip && digit_value(tok[skip]) < 10;
+    }
+}
+
+namespace yasc {
+    bool lex_number(std::string_view tok, Object& out) {
+        if(tok.empty()) {
+            return false;
+        }
+
+        // most numbers in data are plain integers that fit a word
+        auto first = tok.data() + (('+' == tok[0] && tok.size() > 1 && '-' != tok[1]) ? 1 : 0);
+        std::int64_t val;
+        auto [ptr, ec] = std::from_chars(first, tok.data() + tok.size(), val);
+        if(std::errc{} == ec && tok.data() + tok.size() == ptr) {
+            out = number_traits<std::intptr_t>::box(static_cast<std::intptr_t>(val));
+            return true;
+        }
+
+        if(NumberLexer{tok}.lex(out)) {
+            return true;
+        }
+        if(looks_numeric(tok)) {
+            throw Error{"malformed number `" + std::string{tok} + "'"};
+        }
+        return false;
+    }
+}
@@ -0,0 +1,26 @@
+#ifndef __YASC_NUMBER_LEXER_H_
+#define __YASC_NUMBER_LEXER_H_
+
+#include <string_view>
+
+#include "ast/object.h"
+
+namespace yasc {
+    // reads a numeric literal as written in r7rs (section 7.1.1): exact
+    // integers and ratios, decimals with exponents, +inf.0, -inf.0, +nan.0
+    // and -nan.0, rectangular and polar complex numbers, and the #x, #o, #b
+    // and #d radix and #e and #i exactness prefixes.
+    //
+    // the token is classified and converted in a single pass with
+    // std::from_chars, and only numbers too large for a word allocate.
+    // exact integers and ratios become fixnums, bignums or ratios, inexact
+    // reals doubles, and complex numbers with an imaginary part other than
+    // an exact zero inexact complex numbers.
+    //
+    // answers false when `tok' is not written as a number at all, eg. an
+    // identifier like `-' or `...', and throws an Error when it starts like
+    // one (with a digit or a prefix) but is malformed.
+    bool lex_number(std::string_view tok, Object& out);
+}
+
+#endif // __YASC_NUMBER_LEXER_H_
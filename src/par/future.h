@@ -0,0 +1,153 @@
+#ifndef __YASC_PAR_FUTURE_H_
+#define __YASC_PAR_FUTURE_H_
+
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "../ast/value.h"
+#include "../ast/object.h"
+#include "../gc/heap.h"
+
+namespace yasc {
+    class Future;
+
+    namespace par {
+        struct Globals;
+        struct Worker;
+
+        // what a future stands for: a procedure to call with some arguments.
+        // the thread that made it -- its owner -- runs it in place, unless
+        // it was published first and another thread claimed it; whoever
+        // moves it out of Pending runs it. see scheduler.h
+        struct Task {
+            enum State : int {
+                Pending,
+                Running,
+                Done,
+                Failed,
+                Cancelled // its future died before anyone ran it
+            };
+
+            std::atomic<int> state{Pending};
+
+            // the thread running it, to tell waiting for it from waiting for
+            // ourselves
+            std::atomic<Worker const*> runner{nullptr};
+
+            // the owner's alone: (procedure . arguments) in the owner's heap,
+            // kept alive by the future, which the collector keeps `future'
+            // pointing to
+            Object  work;
+            Future* future = nullptr;
+
+            // set when the task is published: a copy of `work' in a region
+            // of its own, and of the globals it runs in. only the thread that
+            // claims it reads them
+            std::unique_ptr<gc::Region>    input;
+            Object                         input_work;
+            std::shared_ptr<Globals const> globals;
+
+            // set by another thread before it moves the task out of Running:
+            // the result in a region the owner copies it out of, or what the
+            // error said
+            std::unique_ptr<gc::Region> output;
+            Object                      result;
+            std::string                 error;
+
+            // moves a pending task to Running, if no one else did first
+            bool claim(Worker const* worker) {
+                auto expected = int{Pending};
+                if(!state.compare_exchange_strong(expected, Running, std::memory_order_acq_rel)) {
+                    return false;
+                }
+                runner.store(worker, std::memory_order_relaxed);
+                return true;
+            }
+        };
+    };
+
+    // the value of (future expr): a placeholder for what expr comes to,
+    // which (touch f) waits for. a future is only ever touched on the
+    // thread that made it; values that cross to another thread have their
+    // futures resolved first, so a copy only carries the value (or, where
+    // that could not be done, cannot be touched)
+    class Future : public Value {
+    public:
+        explicit Future(std::shared_ptr<par::Task> task)
+            : Value(Value::Type::Future)
+            , task_{std::move(task)}
+        {
+            task_->future = this;
+        }
+
+        Future(Future const& rhs)
+            : Value(Value::Type::Future)
+            , value_{rhs.value_}
+        {}
+
+        // the collector moves the owner's future around
+        Future(Future&& rhs)
+            : Value(Value::Type::Future)
+            , task_{std::move(rhs.task_)}
+            , value_{rhs.value_}
+        {
+            if(nullptr != task_) {
+                task_->future = this;
+            }
+        }
+
+        // a task no one has started is not worth starting any more
+        ~Future() {
+            if(nullptr != task_) {
+                auto expected = int{par::Task::Pending};
+                task_->state.compare_exchange_strong(expected, par::Task::Cancelled, std::memory_order_acq_rel);
+                task_->future = nullptr;
+            }
+        }
+
+        bool resolved() const {
+            return !value_.is_null();
+        }
+
+        Object const& value() const {
+            return value_;
+        }
+
+        // null once resolved
+        std::shared_ptr<par::Task> const& task() const {
+            return task_;
+        }
+
+        void resolve(Object val) {
+            gc::write_barrier(this, val);
+            value_ = val;
+            if(nullptr != task_) {
+                task_->future = nullptr;
+                task_->work   = Object{};
+                task_.reset();
+            }
+        }
+
+        std::ostream& print(std::ostream& o) const override {
+            if(resolved()) {
+                return o << "[future " << value_ << "]";
+            }
+            return o << "[future]";
+        }
+
+        void trace(gc::Tracer& t) override {
+            t(value_);
+            if(nullptr != task_) {
+                t(task_->work);
+            }
+        }
+
+    private:
+        std::shared_ptr<par::Task> task_;
+        Object value_;
+    };
+};
+
+#endif // __YASC_PAR_FUTURE_H_
@@ -0,0 +1,633 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+
+#include "scheduler.h"
+#include "../error.h"
+#include "../environment.h"
+#include "../trace.h"
+#include "../ast/pair.h"
+#include "../vm/vm.h"
+
+namespace yasc {
+    namespace par {
+        // a thread taking part: the tasks it made and kept to itself,
+        // newest at the back, which no other thread sees; and those it
+        // published for others to steal, oldest at the front
+        struct Worker {
+            std::deque<std::shared_ptr<Task>> mine;
+
+            std::mutex lock;
+            std::deque<std::shared_ptr<Task>> published;
+
+            // the globals the last task was published with
+            std::shared_ptr<Globals const> snapshot;
+        };
+
+        namespace {
+            // how long an idle thread sleeps before looking again, should
+            // it miss being woken up
+            constexpr auto nap = std::chrono::milliseconds{10};
+
+            struct Pool {
+                Pool()
+                    : size{std::max(1u, std::thread::hardware_concurrency())}
+                {}
+
+                ~Pool();
+
+                std::mutex lock; // guards `workers'
+                std::vector<std::shared_ptr<Worker>> workers;
+
+                std::mutex resize; // guards `threads'
+                std::vector<std::thread> threads;
+                std::atomic<unsigned> size;
+                std::atomic<bool> started{false};
+                std::atomic<bool> stopping{false};
+
+                // threads looking for work, and published tasks no one has
+                // taken yet: while there are more of the first, threads
+                // publish what they spawn
+                std::atomic<int> hungry{0};
+                std::atomic<int> available{0};
+
+                std::mutex idle_lock;
+                std::condition_variable idle;
+
+                std::atomic<std::uint64_t> spawned{0};
+                std::atomic<std::uint64_t> inlined{0};
+                std::atomic<std::uint64_t> published{0};
+                std::atomic<std::uint64_t> stolen{0};
+            };
+
+            Pool& pool() {
+                static Pool pool;
+                return pool;
+            }
+
+            // this thread's Worker, which is registered for as long as the
+            // thread lives
+            Worker& worker() {
+                struct Registration {
+                    std::shared_ptr<Worker> worker = std::make_shared<Worker>();
+
+                    Registration() {
+                        auto& p = pool();
+                        std::lock_guard<std::mutex> guard{p.lock};
+                        p.workers.push_back(worker);
+                    }
+
+                    // what is left unstolen goes with its owner
+                    ~Registration() {
+                        auto& p = pool();
+                        {
+                            std::lock_guard<std::mutex> guard{p.lock};
+                            p.workers.erase(std::find(p.workers.begin(), p.workers.end(), worker));
+                        }
+                        std::lock_guard<std::mutex> guard{worker->lock};
+                        p.available -= static_cast<int>(worker->published.size());
+                        worker->published.clear();
+                    }
+                };
+                thread_local Registration mine;
+                return *mine.worker;
+            }
+
+            void wake(Pool& p) {
+                std::lock_guard<std::mutex> guard{p.idle_lock};
+                p.idle.notify_all();
+            }
+
+            // sleeps until `ready' holds, counting as hungry meanwhile
+            template<typename Pred>
+            void idle(Pool& p, Pred ready) {
+                ++p.hungry;
+                {
+                    std::unique_lock<std::mutex> guard{p.idle_lock};
+                    p.idle.wait_for(guard, nap, ready);
+                }
+                --p.hungry;
+            }
+
+            // calls the procedure of `work', (procedure . arguments), with its
+            // arguments
+            Object call(vm::VM& vm, Object const& work, Context& globals) {
+                auto pair = value_cast<Pair*>(work);
+                auto proc = pair->car();
+                std::vector<Object> args;
+                for(auto cur = pair->cdr(); !cur.is_empty_list(); cur = value_cast<Pair*>(cur)->cdr()) {
+                    args.push_back(value_cast<Pair*>(cur)->car());
+                }
+                gc::ScopedRoots roots{[&] (gc::Tracer& t) {
+                    t(proc);
+                    for(auto& arg : args) {
+                        t(arg);
+                    }
+                }};
+                return vm.apply(proc, Args{args.data(), static_cast<std::uint32_t>(args.size())}, globals);
+            }
+
+            // a walk over what is reachable from the slots it visits, which
+            // collects the futures not yet resolved. it does not look into
+            // them: what their tasks hold is not needed once they are
+            class Unresolved : public gc::Tracer {
+            public:
+                explicit Unresolved(std::vector<Object>& futures)
+                    : futures_{futures}
+                {}
+
+                void operator()(Object& slot) override {
+                    if(!slot.is_heap() || !seen_.insert(slot.get()).second) {
+                        return;
+                    }
+                    if(Value::Type::Future == slot.type() && !value_cast<Future*>(slot)->resolved()) {
+                        futures_.push_back(slot);
+                        return;
+                    }
+                    gray_.push_back(slot.get());
+                }
+
+                void drain() {
+                    while(!gray_.empty()) {
+                        auto val = gray_.back();
+                        gray_.pop_back();
+                        val->trace(*this);
+                    }
+                }
+
+            private:
+                std::vector<Object>& futures_;
+                std::unordered_set<Value const*> seen_;
+                std::vector<Value*> gray_;
+            };
+
+            // touches the futures reachable from `obj', so that it can be
+            // copied to another thread; short of those this thread is running
+            // further up its stack, and those that failed, which are copied
+            // unresolved. the copy of such a future cannot be touched
+            void settle(Worker& me, Object const& obj) {
+                gc::Root root{obj};
+                std::vector<Object> futures;
+                gc::ScopedRoots roots{[&] (gc::Tracer& t) {
+                    for(auto& future : futures) {
+                        t(future);
+                    }
+                }};
+                for(auto touched = true; touched; ) {
+                    futures.clear();
+                    Unresolved walk{futures};
+                    auto start = root.get();
+                    walk(start);
+                    walk.drain();
+                    touched = false;
+                    for(std::size_t i = 0; i < futures.size(); ++i) {
+                        auto task = value_cast<Future*>(futures[i])->task();
+                        if(nullptr == task) {
+                            continue;
+                        }
+                        auto state = task->state.load(std::memory_order_acquire);
+                        if(Task::Failed == state
+                           || (Task::Running == state && &me == task->runner.load(std::memory_order_relaxed))) {
+                            continue;
+                        }
+                        touched = true;
+                        try {
+                            touch(Object{futures[i]});
+                        } catch(std::exception const&) {
+                            // left for whoever touches the future
+                        }
+                    }
+                }
+            }
+
+            // runs a task of this thread's own, which it has claimed, on the
+            // VM it is running
+            void run_here(Task& task) {
+                try {
+                    auto running = vm::VM::running();
+                    if(nullptr == running.vm) {
+                        throw Error{"future: touched outside of a running program"};
+                    }
+                    gc::Root work{task.work};
+                    auto result = call(*running.vm, work, *running.globals);
+                    task.state.store(Task::Done, std::memory_order_release);
+                    if(nullptr != task.future) {
+                        task.future->resolve(result);
+                    }
+                } catch(std::exception const& e) {
+                    task.error = e.what();
+                    task.state.store(Task::Failed, std::memory_order_release);
+                }
+            }
+
+            // the globals of a snapshot, copied into the current heap. the
+            // slots come out numbered as they were, which compiled code
+            // relies on
+            std::unique_ptr<Context> environment(Globals const& globals) {
+                auto ctx = std::make_unique<Context>();
+                auto values = globals.values;
+                gc::current_heap().copy(values);
+                for(std::size_t i = 0; i < values.size(); ++i) {
+                    ctx->set(ctx->slot(globals.names[i]), values[i]);
+                }
+                return ctx;
+            }
+
+            // runs a task published by another thread, which this one has
+            // claimed, and leaves its result in a region for the owner
+            void run_stolen(Task& task, vm::VM& vm, Context& globals) {
+                trace::Span span{"stolen task", "future"};
+                auto& heap = gc::current_heap();
+                try {
+                    gc::Root work{heap.copy(task.input_work)};
+                    task.input.reset();
+                    gc::Root result{call(vm, work, globals)};
+                    resolve(result);
+
+                    auto output = std::make_unique<gc::Region>();
+                    {
+                        gc::RegionScope scope{*output, heap};
+                        task.result = heap.copy(result);
+                    }
+                    task.output = std::move(output);
+                    task.state.store(Task::Done, std::memory_order_release);
+                } catch(std::exception const& e) {
+                    task.error = e.what();
+                    task.state.store(Task::Failed, std::memory_order_release);
+                }
+                ++pool().stolen;
+                wake(pool());
+            }
+
+            // the oldest task another thread published, claimed for `thief'
+            std::shared_ptr<Task> steal(Worker& thief) {
+                auto& p = pool();
+                if(p.available.load(std::memory_order_relaxed) <= 0) {
+                    return nullptr;
+                }
+                thread_local std::vector<std::shared_ptr<Worker>> victims;
+                {
+                    std::lock_guard<std::mutex> guard{p.lock};
+                    victims = p.workers;
+                }
+                // start somewhere else each time, so thieves spread out
+                thread_local std::size_t next = 0;
+                auto first = next++;
+                std::shared_ptr<Task> ret;
+                for(std::size_t i = 0; i < victims.size() && nullptr == ret; ++i) {
+                    auto& victim = *victims[(first + i) % victims.size()];
+                    if(&victim == &thief) {
+                        continue;
+                    }
+                    std::lock_guard<std::mutex> guard{victim.lock};
+                    while(!victim.published.empty() && nullptr == ret) {
+                        auto task = std::move(victim.published.front());
+                        victim.published.pop_front();
+                        --p.available;
+                        if(task->claim(&thief)) {
+                            ret = std::move(task);
+                        }
+                    }
+                }
+                victims.clear();
+                return ret;
+            }
+
+            // the newest task of this thread's own no one has started
+            std::shared_ptr<Task> next_own(Worker& me) {
+                while(!me.mine.empty()) {
+                    auto task = std::move(me.mine.back());
+                    me.mine.pop_back();
+                    if(task->claim(&me)) {
+                        return task;
+                    }
+                }
+                std::lock_guard<std::mutex> guard{me.lock};
+                while(!me.published.empty()) {
+                    auto task = std::move(me.published.back());
+                    me.published.pop_back();
+                    --pool().available;
+                    if(task->claim(&me)) {
+                        return task;
+                    }
+                }
+                return nullptr;
+            }
+
+            // a snapshot of `ctx', shared with the tasks published since it
+            // last changed. futures among the globals are settled first,
+            // which may run code that changes them again
+            std::shared_ptr<Globals const> snapshot(Worker& me, Context& ctx) {
+                auto current = [&] (Globals const& globals) {
+                    return globals.stamp == ctx.stamp() && globals.version == ctx.version()
+                        && globals.names.size() == ctx.size();
+                };
+                if(nullptr != me.snapshot && current(*me.snapshot)) {
+                    return me.snapshot;
+                }
+
+                for(;;) {
+                    auto version = ctx.version();
+                    auto size    = ctx.size();
+                    for(std::uint32_t i = 0; i < size; ++i) {
+                        settle(me, ctx.cell(i).value);
+                    }
+                    if(version == ctx.version() && size == ctx.size()) {
+                        break;
+                    }
+                }
+
+                auto globals = std::make_shared<Globals>();
+                globals->stamp   = ctx.stamp();
+                globals->version = ctx.version();
+                for(std::uint32_t i = 0; i < ctx.size(); ++i) {
+                    globals->names.push_back(ctx.name(i));
+                    globals->values.push_back(ctx.cell(i).value);
+                }
+                auto& heap = gc::current_heap();
+                {
+                    gc::RegionScope scope{globals->region, heap};
+                    heap.copy(globals->values);
+                }
+                me.snapshot = globals;
+                return globals;
+            }
+
+            // copies a task of ours, and the globals it runs in, for other
+            // threads to steal. returns false when it cannot be copied
+            bool publish(Worker& me, std::shared_ptr<Task> task) {
+                auto running = vm::VM::running();
+                if(nullptr == running.globals) {
+                    return false;
+                }
+                trace::Span span{"publish", "future"};
+                gc::Root work{task->work};
+                settle(me, work);
+                auto globals = snapshot(me, *running.globals);
+                if(Task::Pending != task->state.load(std::memory_order_acquire)) {
+                    return true;
+                }
+
+                auto& heap = gc::current_heap();
+                task->input = std::make_unique<gc::Region>();
+                {
+                    gc::RegionScope scope{*task->input, heap};
+                    task->input_work = heap.copy(work);
+                }
+                task->globals = std::move(globals);
+
+                auto& p = pool();
+                {
+                    std::lock_guard<std::mutex> guard{me.lock};
+                    me.published.push_back(std::move(task));
+                }
+                ++p.available;
+                ++p.published;
+                wake(p);
+                return true;
+            }
+
+            // publishes the oldest task of ours no one has started, short
+            // of the newest
+            void publish_oldest(Worker& me) {
+                while(me.mine.size() > 1) {
+                    auto task = std::move(me.mine.front());
+                    me.mine.pop_front();
+                    if(Task::Pending == task->state.load(std::memory_order_acquire)) {
+                        if(!publish(me, task)) {
+                            me.mine.push_front(std::move(task));
+                        }
+                        return;
+                    }
+                }
+            }
+
+            // runs whatever can be run until `task', which another thread
+            // is running, is done
+            void wait(Worker& me, Task& task) {
+                trace::Span span{"wait", "future"};
+                auto& p = pool();
+                while(Task::Running == task.state.load(std::memory_order_acquire)) {
+                    if(&me == task.runner.load(std::memory_order_relaxed)) {
+                        throw Error{"touch: a future cannot wait for itself"};
+                    }
+                    if(auto own = next_own(me)) {
+                        ++p.inlined;
+                        run_here(*own);
+                        continue;
+                    }
+                    auto running = vm::VM::running();
+                    if(nullptr != running.vm) {
+                        if(auto stolen = steal(me)) {
+                            auto globals = environment(*stolen->globals);
+                            run_stolen(*stolen, *running.vm, *globals);
+                            continue;
+                        }
+                    }
+                    idle(p, [&] {
+                        return Task::Running != task.state.load(std::memory_order_acquire)
+                            || p.available.load(std::memory_order_relaxed) > 0;
+                    });
+                }
+            }
+
+            // a thread of the pool: steals until told to stop. it runs what
+            // it steals on a heap and a VM of its own, in a copy of the
+            // globals kept for as long as tasks come with the same ones
+            void run_worker(unsigned index) {
+                trace::name_thread("worker " + std::to_string(index));
+                auto& p = pool();
+                gc::Heap heap;
+                gc::HeapScope scope{heap};
+                vm::VM vm;
+                std::shared_ptr<Globals const> globals;
+                std::unique_ptr<Context> context;
+                auto& me = worker();
+                while(!p.stopping.load(std::memory_order_acquire)) {
+                    if(auto task = steal(me)) {
+                        if(task->globals != globals) {
+                            context.reset();
+                            context = environment(*task->globals);
+                            globals = task->globals;
+                        }
+                        run_stolen(*task, vm, *context);
+                        // the futures the task left behind are only
+                        // reachable from it, or are touched in place
+                        me.mine.clear();
+                        continue;
+                    }
+                    idle(p, [&] {
+                        return p.stopping.load(std::memory_order_relaxed)
+                            || p.available.load(std::memory_order_relaxed) > 0;
+                    });
+                }
+            }
+
+            void start(Pool& p) {
+                std::lock_guard<std::mutex> guard{p.resize};
+                if(p.started.load(std::memory_order_relaxed)) {
+                    return;
+                }
+                for(unsigned i = 1; i < p.size; ++i) {
+                    p.threads.emplace_back(run_worker, i);
+                }
+                p.started.store(true, std::memory_order_release);
+            }
+
+            // `resize' must be held
+            void stop(Pool& p) {
+                p.stopping.store(true, std::memory_order_release);
+                wake(p);
+                for(auto& thread : p.threads) {
+                    thread.join();
+                }
+                p.threads.clear();
+                p.stopping.store(false, std::memory_order_release);
+                p.started.store(false, std::memory_order_release);
+            }
+
+            Pool::~Pool() {
+                std::lock_guard<std::mutex> guard{resize};
+                stop(*this);
+            }
+        }
+
+        std::ostream& operator<<(std::ostream& o, Stats const& stats) {
+            return o << "spawned " << stats.spawned << " futures, ran " << stats.inlined
+                     << " in place, published " << stats.published << ", " << stats.stolen << " stolen";
+        }
+
+        unsigned threads() {
+            return pool().size;
+        }
+
+        void set_threads(unsigned threads) {
+            auto& p = pool();
+            std::lock_guard<std::mutex> guard{p.resize};
+            stop(p);
+            p.size = std::max(1u, threads);
+        }
+
+        Stats stats() {
+            auto& p = pool();
+            Stats ret;
+            ret.spawned   = p.spawned;
+            ret.inlined   = p.inlined;
+            ret.published = p.published;
+            ret.stolen    = p.stolen;
+            ret.idle      = static_cast<std::uint64_t>(std::max(0, p.hungry.load()));
+            return ret;
+        }
+
+        Object spawn(Object const& proc, Args args, bool eager) {
+            auto& p = pool();
+            if(!p.started.load(std::memory_order_acquire)) {
+                start(p);
+            }
+
+            auto work = Object::empty_list();
+            for(auto i = args.size(); i > 0; --i) {
+                work = make_object<Pair>(args[i - 1], work);
+            }
+            auto task = std::make_shared<Task>();
+            task->work = make_object<Pair>(proc, work);
+            gc::Root future{make_object<Future>(task)};
+            ++p.spawned;
+
+            // alone, a thread runs every future in place when touched
+            if(p.size > 1) {
+                auto& me = worker();
+                if(eager && publish(me, task)) {
+                    return future;
+                }
+                while(!me.mine.empty() && Task::Pending != me.mine.back()->state.load(std::memory_order_relaxed)) {
+                    me.mine.pop_back();
+                }
+                me.mine.push_back(std::move(task));
+                // the newest task is always kept: it is likely to be
+                // touched next, and to be small
+                if(me.mine.size() > 1
+                   && p.hungry.load(std::memory_order_relaxed) > p.available.load(std::memory_order_relaxed)) {
+                    publish_oldest(me);
+                }
+            }
+            return future;
+        }
+
+        Object touch(Object const& obj) {
+            if(Value::Type::Future != obj.type()) {
+                return obj;
+            }
+            if(value_cast<Future*>(obj)->resolved()) {
+                return value_cast<Future*>(obj)->value();
+            }
+            auto task = value_cast<Future*>(obj)->task();
+            if(nullptr == task) {
+                throw Error{"touch: a future that was not resolved when copied to another thread"};
+            }
+
+            gc::Root future{obj};
+            auto& p = pool();
+            auto& me = worker();
+            if(task->claim(&me)) {
+                // no one started it: run it here and now
+                if(!me.mine.empty() && me.mine.back() == task) {
+                    me.mine.pop_back();
+                }
+                ++p.inlined;
+                run_here(*task);
+            } else {
+                wait(me, *task);
+                if(Task::Done == task->state.load(std::memory_order_acquire) && nullptr != task->output) {
+                    auto val = gc::current_heap().copy(task->result);
+                    value_cast<Future*>(future)->resolve(val);
+                }
+            }
+
+            auto resolved = value_cast<Future*>(future);
+            if(!resolved->resolved()) {
+                throw Error{task->error};
+            }
+            return resolved->value();
+        }
+
+        void detach() {
+            auto& me = worker();
+            me.mine.clear();
+            std::lock_guard<std::mutex> guard{me.lock};
+            pool().available -= static_cast<int>(me.published.size());
+            me.published.clear();
+        }
+
+        void resolve(Object const& obj) {
+            gc::Root root{obj};
+            std::vector<Object> futures;
+            gc::ScopedRoots roots{[&] (gc::Tracer& t) {
+                for(auto& future : futures) {
+                    t(future);
+                }
+            }};
+            for(;;) {
+                futures.clear();
+                Unresolved walk{futures};
+                auto start = root.get();
+                walk(start);
+                walk.drain();
+                if(futures.empty()) {
+                    return;
+                }
+                for(std::size_t i = 0; i < futures.size(); ++i) {
+                    touch(Object{futures[i]});
+                }
+            }
+        }
+    };
+};
@@ -0,0 +1,87 @@
+#ifndef __YASC_PAR_SCHEDULER_H_
+#define __YASC_PAR_SCHEDULER_H_
+
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "../ast/object.h"
+#include "../ast/procedure.h"
+#include "../ast/symbol.h"
+#include "../gc/heap.h"
+#include "future.h"
+
+namespace yasc {
+    // futures, run in parallel by a pool of worker threads.
+    //
+    // every thread has a heap of its own, and values never point from one
+    // heap into another: a heap is only ever touched by its thread, which
+    // makes it the thread's allocation buffer and keeps the collector
+    // single threaded. a task that changes threads is copied, with the
+    // globals it sees, into a region (see Heap::copy), and its result comes
+    // back the same way.
+    //
+    // a future starts out private to the thread that made it, which runs it
+    // in place when it is touched, at the cost of a call. only while other
+    // threads are looking for work does a thread publish some of its
+    // tasks, its oldest (and so likely largest) first, for them to steal.
+    // it keeps its newest, which it is about to touch: fine-grained
+    // futures, touched as soon as they are made, are never copied. a thread
+    // waiting for a task another thread has taken runs what it can in the
+    // meantime: its own tasks, then whatever it can steal.
+    //
+    // a stolen task runs in a copy of the globals as they were when it was
+    // published: set! on a global inside it is not seen by other threads.
+    namespace par {
+        // the globals of an environment, copied into a region that the
+        // threads running its published tasks all copy from
+        struct Globals {
+            std::uint64_t       stamp;   // of the environment
+            std::uint64_t       version; // likewise
+            gc::Region          region;
+            std::vector<Symbol> names;   // by slot
+            std::vector<Object> values;  // by slot, null where unbound
+        };
+
+        struct Stats {
+            std::uint64_t spawned   = 0; // futures made
+            std::uint64_t inlined   = 0; // run in place by their owners
+            std::uint64_t published = 0; // made available to other threads
+            std::uint64_t stolen    = 0; // run by another thread
+            std::uint64_t idle      = 0; // threads waiting for work right now
+        };
+
+        std::ostream& operator<<(std::ostream& o, Stats const& stats);
+
+        // how many threads run futures, the ones making them included;
+        // the number of cores unless set otherwise. setting it waits for
+        // the pool's threads to finish what they are running
+        unsigned threads();
+        void set_threads(unsigned threads);
+
+        Stats stats();
+
+        // a future of calling `proc' with `args' on the current thread,
+        // which must be running a VM. an `eager' one is published right
+        // away, for work known to be worth spreading
+        Object spawn(Object const& proc, Args args, bool eager = false);
+
+        // what the future `obj' comes to, waiting for it if need be, or
+        // `obj' itself when it is not a future. rethrows what the future
+        // raised
+        Object touch(Object const& obj);
+
+        // touches every future reachable from `obj', so that it can be
+        // copied to another thread
+        void resolve(Object const& obj);
+
+        // forgets the tasks of this thread that no one has started, for
+        // when it is about to leave the heap they live in for another (see
+        // Isolate). they still run, in place, when their futures are
+        // touched
+        void detach();
+    };
+};
+
+#endif // __YASC_PAR_SCHEDULER_H_
@@ -1,73 +1,166 @@
 #include <memory>
 #include <string>
+#include <string_view>
 #include <cassert>
+#include <sstream>
+#include <vector>
 
 #include "parser.h"
+#include "number_lexer.h"
+#include "error.h"
+#include "trace.h"
 #include "ast/list.h"
+#include "ast/pair.h"
 #include "ast/number.h"
 #include "ast/value.h"
+#include "ast/object.h"
 #include "ast/identifier.h"
-
-#include "libscheme/arithmetic.h"
+#include "ast/symbol.h"
+#include "gc/heap.h"
 
 namespace {
-    std::string get_token(std::string const& prog, std::string::iterator& itr) {
-        std::string token;
-        auto tok_end = prog.find_first_of(" )\n", itr - prog.begin());
-        if(prog.size() != tok_end) {
-            auto start = itr - prog.begin();
-            token = prog.substr(start, tok_end - start);
+    yasc::Object make_atom(std::string_view tok) {
+        using namespace yasc;
+        if("#t" == tok) {
+            return Object::boolean(true);
+        }
+        if("#f" == tok) {
+            return Object::boolean(false);
         }
-        return token;
+        Object num;
+        if(lex_number(tok, num)) {
+            return num;
+        }
+        return make_object<Identifier>(Symbol::intern(tok));
     }
 }
 
 namespace yasc {
-    Value::Ptr Parser::operator()(std::string prog) {
-        auto itr = prog.begin() + 1;
-        return (prog.empty())
-            ? nullptr
-            : parse(prog, itr);
+    Object Parser::operator()(std::string_view prog) {
+        Lexer lexer{prog};
+        return next(lexer);
     }
 
-    Value::Ptr Parser::parse(std::string const& prog, std::string::iterator& itr) {
-        using namespace yasc;
-        auto list = std::shared_ptr<List>{nullptr};
+    Object Parser::operator()(std::string_view prog, gc::Region& region) {
+        gc::RegionScope scope{region};
+        return (*this)(prog);
+    }
 
-        for(; itr < prog.end(); ++itr) {
-            switch(*itr) {
-                case '(':
-                    if(nullptr != list) {
-                        list->push_back(parse(prog, ++itr));
-                        break;
-                    }
-                case ')': return list;
-                case '+':
-                    list = std::make_shared<List>();
-                    list->push_back(std::make_shared<Identifier>("+", arithmetic::get_plus<Integer>()));
-                    break;
-                case '-':
-                    list = std::make_shared<List>();
-                    list->push_back(std::make_shared<Identifier>("-", arithmetic::get_plus<Integer>()));
-                    break;
-                case '*':
-                    list = std::make_shared<List>();
-                    list->push_back(std::make_shared<Identifier>("*", arithmetic::get_plus<Integer>()));
-                    break;
-                case '/':
-                    list = std::make_shared<List>();
-                    list->push_back(std::make_shared<Identifier>("/", arithmetic::get_plus<Integer>()));
+    Object Parser::next(Lexer& lexer) {
+        trace::Span span{"parse", "parse"};
+        auto tok = lexer.next();
+        if(Token::Kind::End == tok.kind) {
+            return Object{};
+        }
+        return parse(lexer, tok);
+    }
+
+    Object Parser::next(Lexer& lexer, gc::Region& region) {
+        gc::RegionScope scope{region};
+        return next(lexer);
+    }
+
+    Object Parser::atom(std::string_view tok) {
+        return make_atom(tok);
+    }
+
+    Object Parser::dotted(Object const& list) {
+        std::vector<Object> elems(value_cast<List*>(list)->begin(), value_cast<List*>(list)->end());
+        assert(elems.size() >= 2);
+        auto tail = elems.back();
+        // (a . (b c)) is (a b c), and (a . ()) is (a)
+        if(Value::Type::List == tail.type() || tail.is_empty_list()) {
+            auto ret = make_object<List>();
+            elems.pop_back();
+            if(!tail.is_empty_list()) {
+                elems.insert(elems.end(), value_cast<List*>(tail)->begin(), value_cast<List*>(tail)->end());
+            }
+            for(auto const& val : elems) {
+                value_cast<List*>(ret)->push_back(val);
+            }
+            return ret;
+        }
+        auto ret = tail;
+        for(auto i = elems.size() - 1; i > 0; --i) {
+            ret = make_object<Pair>(elems[i - 1], ret);
+        }
+        return ret;
+    }
+
+    Object Parser::parse(Lexer& lexer, Token const& tok) {
+        switch(tok.kind) {
+            case Token::Kind::Open:
+                return parse_list(lexer, tok.pos);
+            case Token::Kind::Atom:
+                if("." == tok.text) {
+                    std::ostringstream o;
+                    o << "misplaced `.' at " << tok.pos;
+                    throw Error{o.str()};
+                }
+                return make_atom(tok.text);
+            default: {
+                std::ostringstream o;
+                o << "unexpected `)' at " << tok.pos;
+                throw Error{o.str()};
+            }
+        }
+    }
+
+    // parses the elements of a list whose opening paren has been consumed
+    Object Parser::parse_list(Lexer& lexer, Position open) {
+        Nesting nesting{depth_};
+        if(nesting.deeper_than(max_nesting)) {
+            std::ostringstream o;
+            o << "lists nested more than " << max_nesting << " deep at " << open;
+            throw Error{o.str()};
+        }
+        auto result = make_object<List>();
+        auto list   = value_cast<List*>(result);
+
+        for(auto tok = lexer.next(); ; tok = lexer.next()) {
+            switch(tok.kind) {
+                case Token::Kind::Open:
+                    list->push_back(parse_list(lexer, tok.pos));
                     break;
-                case ' ': break;
-                default:
-                    auto tok = get_token(prog, itr);
-                    assert(0 != tok.size());
-                    itr += tok.size() - 1;
-                    list->push_back(std::make_shared<Integer>(std::stod(tok)));
+                case Token::Kind::Close:
+                    return (0 == list->size()) ? get_empty_list() : result;
+                case Token::Kind::Atom:
+                    if("." == tok.text) {
+                        return parse_tail(lexer, result, tok.pos);
+                    }
+                    list->push_back(make_atom(tok.text));
                     break;
+                case Token::Kind::End: {
+                    std::ostringstream o;
+                    o << "unterminated list opened at " << open;
+                    throw Error{o.str()};
+                }
             }
         }
+    }
 
-        return list;
+    // (a b ... . z) once the `.' has been consumed: exactly one datum
+    // follows, and closes the list
+    Object Parser::parse_tail(Lexer& lexer, Object const& list, Position dot) {
+        auto misplaced = [&] {
+            std::ostringstream o;
+            o << "misplaced `.' at " << dot;
+            return Error{o.str()};
+        };
+        if(0 == value_cast<List*>(list)->size()) {
+            throw misplaced();
+        }
+        auto tok = lexer.next();
+        if(Token::Kind::Open == tok.kind) {
+            value_cast<List*>(list)->push_back(parse_list(lexer, tok.pos));
+        } else if(Token::Kind::Atom == tok.kind && "." != tok.text) {
+            value_cast<List*>(list)->push_back(make_atom(tok.text));
+        } else {
+            throw misplaced();
+        }
+        if(Token::Kind::Close != lexer.next().kind) {
+            throw misplaced();
+        }
+        return dotted(list);
     }
 };
@@ -1,19 +1,47 @@
-#ifndef __PARSER_H_
-#define __PARSER_H_
-
-#include <string>
-
-#include "ast/value.h"
-
-namespace yasc {
-    class Parser {
-    public:
-        Parser() = default;
-
-        Value::Ptr operator()(std::string prog);
-    private:
-        Value::Ptr parse(std::string const& prog, std::string::iterator& itr);
-    };
-}
-
-#endif // __PARSER_H_
+#ifndef __PARSER_H_
+#define __PARSER_H_
+
+#include <cstddef>
+#include <string_view>
+
+#include "lexer.h"
+#include "ast/value.h"
+#include "ast/object.h"
+#include "gc/heap.h"
+
+namespace yasc {
+    class Parser {
+    public:
+        Parser() = default;
+
+        // the first datum in `prog', or a null Object if there is none
+        Object operator()(std::string_view prog);
+
+        // builds the AST inside `region` instead of on the collected heap
+        Object operator()(std::string_view prog, gc::Region& region);
+
+        // the next top level datum from `lexer', or a null Object once the
+        // input is exhausted. a datum may span any number of lines and
+        // blocks of input.
+        Object next(Lexer& lexer);
+        Object next(Lexer& lexer, gc::Region& region);
+
+        // the value of a single atom: a boolean, a number or an identifier
+        static Object atom(std::string_view tok);
+
+        // the elements of a list read as (a b ... . z): a chain of pairs
+        // over all of them but the last, which ends the chain. when that
+        // is a list, the whole is a List of them all
+        static Object dotted(Object const& list);
+
+    private:
+        Object parse(Lexer& lexer, Token const& tok);
+        Object parse_list(Lexer& lexer, Position open);
+        Object parse_tail(Lexer& lexer, Object const& list, Position dot);
+
+        // of the list being parsed; see max_nesting
+        std::size_t depth_ = 0;
+    };
+}
+
+#endif // __PARSER_H_
@@ -0,0 +1,160 @@
+#include <algorithm>
+#include <sstream>
+
+#include "reader.h"
+#include "parser.h"
+#include "error.h"
+#include "ast/list.h"
+#include "ast/value.h"
+
+namespace {
+    // what ends an atom, as stage one sees it
+    bool is_delimiter(char c) {
+        auto u = static_cast<unsigned char>(c);
+        return ' ' == u || static_cast<unsigned char>(u - '\t') < 5 || '(' == u || ')' == u || ';' == u;
+    }
+}
+
+namespace yasc {
+    Reader::Reader(std::string_view input, simd::Kernels const& kernels)
+        : input_{input}
+        , kernels_{&kernels}
+        , state_{}
+        , index_(std::min(batch_size, input.size()))
+        , base_{0}
+        , indexed_{0}
+        , cur_{0}
+        , count_{0}
+    {}
+
+    void Reader::index() {
+        auto size = std::min(batch_size, input_.size() - indexed_);
+        count_   = kernels_->structurals(input_.data() + indexed_, size, state_, index_.data());
+        base_    = indexed_;
+        indexed_ += size;
+        cur_     = 0;
+    }
+
+    bool Reader::advance(std::size_t& at) {
+        while(cur_ == count_) {
+            if(indexed_ == input_.size()) {
+                return false;
+            }
+            index();
+        }
+        at = base_ + index_[cur_++];
+        return true;
+    }
+
+    // only needed for errors, so it is worked out from scratch
+    Position Reader::position(std::size_t at) const {
+        auto before = input_.substr(0, at);
+        auto line_start = before.rfind('\n');
+        Position pos;
+        pos.offset = at;
+        pos.line   = static_cast<std::uint32_t>(1 + std::count(before.begin(), before.end(), '\n'));
+        pos.column = static_cast<std::uint32_t>(at - ((std::string_view::npos == line_start) ? 0 : line_start + 1) + 1);
+        return pos;
+    }
+
+    // the lists being read are kept on a stack rather than the C++ one, so
+    // deeply nested data cannot overflow it. they are still held to
+    // max_nesting, as the passes over what is read recurse
+    Object Reader::next() {
+        open_.clear();
+        opened_at_.clear();
+        dots_.clear();
+
+        auto misplaced = [&] (std::size_t at) {
+            std::ostringstream o;
+            o << "misplaced `.' at " << position(at);
+            return Error{o.str()};
+        };
+
+        for(std::size_t at; ; ) {
+            if(!advance(at)) {
+                if(open_.empty()) {
+                    return Object{};
+                }
+                std::ostringstream o;
+                o << "unterminated list opened at " << position(opened_at_.back());
+                throw Error{o.str()};
+            }
+
+            Object val;
+            switch(input_[at]) {
+                case '(':
+                    if(open_.size() == max_nesting) {
+                        std::ostringstream o;
+                        o << "lists nested more than " << max_nesting << " deep at " << position(at);
+                        throw Error{o.str()};
+                    }
+                    open_.push_back(make_object<List>());
+                    opened_at_.push_back(at);
+                    dots_.emplace_back();
+                    continue;
+                case ')': {
+                    if(open_.empty()) {
+                        std::ostringstream o;
+                        o << "unexpected `)' at " << position(at);
+                        throw Error{o.str()};
+                    }
+                    val = open_.back();
+                    auto dot = dots_.back();
+                    open_.pop_back();
+                    opened_at_.pop_back();
+                    dots_.pop_back();
+                    if(std::string_view::npos != dot.at) {
+                        if(value_cast<List*>(val)->size() != dot.before + 1) {
+                            throw misplaced(dot.at);
+                        }
+                        val = Parser::dotted(val);
+                    } else if(0 == value_cast<List*>(val)->size()) {
+                        val = get_empty_list();
+                    }
+                    break;
+                }
+                default: {
+                    auto end = at + 1;
+                    while(end < input_.size() && !is_delimiter(input_[end])) {
+                        ++end;
+                    }
+                    auto tok = input_.substr(at, end - at);
+                    if("." == tok) {
+                        // (a . b), with something before it, once per list
+                        if(open_.empty() || 0 == value_cast<List*>(open_.back())->size()
+                                || std::string_view::npos != dots_.back().at) {
+                            throw misplaced(at);
+                        }
+                        dots_.back() = Dot{at, value_cast<List*>(open_.back())->size()};
+                        continue;
+                    }
+                    val = Parser::atom(tok);
+                    break;
+                }
+            }
+
+            if(open_.empty()) {
+                return val;
+            }
+            auto list = value_cast<List*>(open_.back());
+            if(std::string_view::npos != dots_.back().at && list->size() > dots_.back().before) {
+                throw misplaced(dots_.back().at);
+            }
+            list->push_back(val);
+        }
+    }
+
+    Object Reader::next(gc::Region& region) {
+        gc::RegionScope scope{region};
+        return next();
+    }
+
+    Object Reader::all() {
+        auto result = make_object<List>();
+        for(auto datum = next(); !datum.is_null(); datum = next()) {
+            value_cast<List*>(result)->push_back(datum);
+        }
+        return (0 == value_cast<List*>(result)->size()) ? get_empty_list() : result;
+    }
+}
@@ -0,0 +1,77 @@
+#ifndef __YASC_READER_H_
+#define __YASC_READER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "lexer.h"
+#include "ast/object.h"
+#include "gc/heap.h"
+#include "libscheme/simd.h"
+
+namespace yasc {
+    // reads bulk data held in memory, eg. a MappedFile, in two stages.
+    // stage one finds the structural bytes (parens, and the first byte of
+    // each atom) of a batch of input 64 bytes at a time with the simd
+    // kernels, and stage two builds the datums by walking those offsets
+    // instead of every byte.
+    //
+    // it reads the same language as the Parser, and is meant for input too
+    // large for going through a Lexer token by token to keep up with.
+    class Reader {
+    public:
+        // how much input stage one indexes at a time; a multiple of 64
+        static constexpr std::size_t batch_size = std::size_t{1} << 18;
+
+        // reads `input', which must stay put for the reader's lifetime.
+        // `kernels' can be given to pick an instruction set other than the
+        // best one.
+        explicit Reader(std::string_view input, simd::Kernels const& kernels = simd::kernels());
+
+        // the next top level datum, or a null Object once the input is
+        // exhausted
+        Object next();
+        Object next(gc::Region& region);
+
+        // the datums left, as a list
+        Object all();
+
+    private:
+        // stores the offset of the next structural byte in `at', and answers
+        // false instead at the end of the input
+        bool advance(std::size_t& at);
+
+        // indexes the next batch of input
+        void index();
+
+        Position position(std::size_t at) const;
+
+        std::string_view input_;
+        simd::Kernels const* kernels_;
+        simd::ScanState state_;
+
+        // index_ holds count_ offsets into the batch at base_, and indexed_
+        // is where the next batch starts
+        std::vector<std::uint32_t> index_;
+        std::size_t base_;
+        std::size_t indexed_;
+        std::size_t cur_;
+        std::size_t count_;
+
+        // the lists being read, innermost last, and where they opened
+        std::vector<Object> open_;
+        std::vector<std::size_t> opened_at_;
+
+        // where each list being read had its `.', if it had one, and how
+        // many elements came before it
+        struct Dot {
+            std::size_t at = std::string_view::npos;
+            int before = 0;
+        };
+        std::vector<Dot> dots_;
+    };
+}
+
+#endif // __YASC_READER_H_
@@ -1,11 +1,18 @@
 #ifndef __YASC_REPL_H_
 #define __YASC_REPL_H_
 
+#include <algorithm>
+#include <exception>
+#include <fstream>
 #include <string>
+#include <string_view>
 #include <iostream>
 
+#include "lexer.h"
 #include "parser.h"
+#include "error.h"
 #include "evaluator.h"
+#include "gc/heap.h"
 
 namespace yasc {
     class Repl {
@@ -16,32 +23,128 @@ namespace yasc {
             , in_{in}
             , out_{out}
             , prompt_{"=> "}
+            , heap_{gc::current_heap()}
         {}
 
         void set_prompt(std::string const& prompt) {
             prompt_ = prompt;
         }
 
-        void run() {
-            out_ << "yasc 0.0 repl. :q to exit." << std::endl;
-            std::string input_str;
-            while(!in_.eof()) {
-                out_ << prompt_;
-
-                std::getline(in_, input_str);
-                if(":q" == input_str)
-                    break;
+        // how `,profile' profiles, and the file it writes the collapsed
+        // stacks to, if any
+        void set_profiling(vm::Profiler::Mode mode, std::string const& stacks = {}) {
+            profile_mode_   = mode;
+            profile_stacks_ = stacks;
+        }
 
-                auto ast = parser_(input_str);
-                auto result = eval_(*ast, Evaluator::get_scheme_context());
+        void run() {
+            out_ << "yasc 0.0 repl. :q to exit, :gc for heap statistics, "
+                    ":quick for call site specialization, :opt for the optimizer, "
+                    ",mem for what the heap holds, ,profile EXPR to profile EXPR." << std::endl;
+            Lines lines{in_, out_};
+            Lexer lexer{lines};
+            for(;;) {
+                lines.prompt(prompt_);
+                try {
+                    auto ast = parser_.next(lexer, region_);
+                    if(ast.is_null() || is_command(ast, ":q")) {
+                        break;
+                    }
+                    if(is_command(ast, ":gc")) {
+                        out_ << heap_.stats() << std::endl;
+                    } else if(is_command(ast, ":quick")) {
+                        out_ << eval_.quickening() << std::endl;
+                    } else if(is_command(ast, ":opt")) {
+                        out_ << eval_.optimizations() << std::endl;
+                    } else if(is_command(ast, ",mem")) {
+                        // collected first, so that only live values count
+                        heap_.collect_major();
+                        heap_.report(out_);
+                    } else if(is_command(ast, ",profile")) {
+                        profile(parser_.next(lexer, region_));
+                    } else {
+                        auto result = heap_.escape(eval_(ast));
+                        out_ << result;
+                        out_ << std::endl;
+                    }
+                } catch(std::exception const& e) {
+                    out_ << "error: " << e.what() << std::endl;
+                    lexer.skip_line();
+                }
 
-                out_ << *result;
-                out_ << std::endl;
+                // the form's AST is done with, and the result has been
+                // copied out of it
+                region_.release();
+                heap_.safepoint();
             }
             out_ << "Memento mori." << std::endl;
         }
 
     private:
+        // hands the lexer a line at a time, prompting for each one: with the
+        // prompt for the first line of a form and with blanks for the lines
+        // continuing it
+        class Lines : public Source {
+        public:
+            Lines(std::istream& in, std::ostream& out)
+                : in_{in}
+                , out_{out}
+            {}
+
+            void prompt(std::string const& prompt) {
+                prompt_ = prompt;
+            }
+
+            std::size_t read(char* buf, std::size_t size) override {
+                if(pending_.empty()) {
+                    out_ << prompt_ << std::flush;
+                    prompt_.assign(prompt_.size(), ' ');
+                    if(!std::getline(in_, pending_)) {
+                        return 0;
+                    }
+                    pending_ += '\n';
+                }
+                auto count = std::min(size, pending_.size());
+                pending_.copy(buf, count);
+                pending_.erase(0, count);
+                return count;
+            }
+
+        private:
+            std::istream& in_;
+            std::ostream& out_;
+            std::string prompt_;
+            std::string pending_;
+        };
+
+        // evaluates `form' under the profiler, and prints its value and
+        // the profile
+        void profile(Object const& form) {
+            if(form.is_null()) {
+                throw Error{",profile: expected a form to profile"};
+            }
+            eval_.start_profiling(profile_mode_);
+            auto result = Object{};
+            try {
+                result = heap_.escape(eval_(form));
+            } catch(...) {
+                eval_.stop_profiling();
+                throw;
+            }
+            eval_.stop_profiling();
+            out_ << result << std::endl;
+            eval_.profiler().report(out_);
+            if(!profile_stacks_.empty()) {
+                std::ofstream stacks{profile_stacks_};
+                eval_.profiler().collapsed(stacks);
+            }
+        }
+
+        static bool is_command(Object const& ast, std::string_view name) {
+            return Value::Type::Identifier == ast.type()
+                && value_cast<Identifier*>(ast)->symbol().name() == name;
+        }
+
         Parser parser_;
         Evaluator eval_;
 
@@ -49,6 +152,12 @@ namespace yasc {
         std::ostream& out_;
 
         std::string prompt_;
+
+        vm::Profiler::Mode profile_mode_ = vm::Profiler::Mode::Calls;
+        std::string profile_stacks_;
+
+        gc::Heap&  heap_;
+        gc::Region region_;
     };
 }
 #endif
@@ -0,0 +1,38 @@
+#ifndef __YASC_TEST_HELPERS_H_
+#define __YASC_TEST_HELPERS_H_
+
+#include <sstream>
+#include <string>
+
+#include "../parser.h"
+#include "../evaluator.h"
+#include "../gc/heap.h"
+
+// what the tests print and evaluate with
+template<typename T>
+std::string print(T const& val) {
+    std::ostringstream o;
+    o << val;
+    return o.str();
+}
+
+// evaluates in the evaluator's own environment, so definitions last
+inline std::string eval_in(yasc::Evaluator& evaluator, std::string const& prog) {
+    using namespace yasc;
+    gc::Region region;
+    auto ast = Parser{}(prog, region);
+    auto result = gc::current_heap().escape(evaluator(ast));
+    region.release();
+
+    auto ret = print(result);
+    gc::safepoint();
+    return ret;
+}
+
+// evaluates in a fresh environment
+inline std::string eval(std::string const& prog, yasc::Evaluator::Mode mode = yasc::Evaluator::Mode::Quickening) {
+    yasc::Evaluator evaluator{mode};
+    return eval_in(evaluator, prog);
+}
+
+#endif // __YASC_TEST_HELPERS_H_
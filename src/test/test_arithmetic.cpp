@@ -1,3 +1,7 @@
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
 #include <gtest/gtest.h>
 
 #include "../ast/list.h"
@@ -8,29 +12,29 @@
 constexpr double EPSILON = 0.001;
 #define EXPECT_EQ_REAL(tested, expected) EXPECT_NEAR(tested, expected, EPSILON)
 
+// integers go in and out as fixnums
+template<class T>
+using traits_for = yasc::number_traits<std::conditional_t<std::is_integral_v<T>, std::intptr_t, T>>;
+
 template<class T, class...Ts>
-T ast_arithmetic(yasc::Value::Ptr proc, T car, Ts...cdr) {
+T ast_arithmetic(yasc::Object proc, T car, Ts...cdr) {
     using namespace yasc;
-    std::vector<T> vec {{car, cdr...}};
-    List list{};
-    for(auto& v : vec) {
-        list.push_back(std::make_shared<Number<T>>(v));
-    }
-    auto result = value_cast<Procedure&>(*proc).apply(list);
-    return value_cast<Number<T>*>(result.get())->get();
+    std::vector<Object> args {{traits_for<T>::box(car), traits_for<Ts>::box(cdr)...}};
+    auto result = value_cast<Procedure*>(proc)->call(Args{args.data(), static_cast<std::uint32_t>(args.size())});
+    return static_cast<T>(traits_for<T>::unbox(result));
 }
 
 template<class T, class...Ts>
-T ast_plus(T arg, Ts...args) { return ast_arithmetic(yasc::arithmetic::get_plus<yasc::Number<T>>(), arg, args...); }
+T ast_plus(T arg, Ts...args) { return ast_arithmetic(yasc::arithmetic::get_plus(), arg, args...); }
 
 template<class T, class...Ts>
-T ast_minus(T arg, Ts...args) { return ast_arithmetic(yasc::arithmetic::get_minus<yasc::Number<T>>(), arg, args...); }
+T ast_minus(T arg, Ts...args) { return ast_arithmetic(yasc::arithmetic::get_minus(), arg, args...); }
 
 template<class T, class...Ts>
-T ast_multiplies(T arg, Ts...args) { return ast_arithmetic(yasc::arithmetic::get_multiplies<yasc::Number<T>>(), arg, args...); }
+T ast_multiplies(T arg, Ts...args) { return ast_arithmetic(yasc::arithmetic::get_multiplies(), arg, args...); }
 
 template<class T, class...Ts>
-T ast_divide(T arg, Ts...args) { return ast_arithmetic(yasc::arithmetic::get_divides<yasc::Number<T>>(), arg, args...); }
+T ast_divide(T arg, Ts...args) { return ast_arithmetic(yasc::arithmetic::get_divides(), arg, args...); }
 
 TEST(astEvalArithmetic, plusBinary) {
     // integer
@@ -109,10 +113,11 @@ TEST(astEvalArithmetic, multiplyAssociative) {
 }
 
 TEST(astEvalArithmetic, divideAssociative) {
-    // int
-    EXPECT_EQ(ast_divide(34, 10, 3),             1);
-    EXPECT_EQ(ast_divide(ast_divide(34, 10), 3), 1);
-    EXPECT_EQ(ast_divide(34, ast_divide(10, 3)), 11);
+    // exact
+    using yasc::Ratio;
+    EXPECT_EQ(ast_divide(Ratio{34}, Ratio{10}, Ratio{3}),             (Ratio{17, 15}));
+    EXPECT_EQ(ast_divide(ast_divide(Ratio{34}, Ratio{10}), Ratio{3}), (Ratio{17, 15}));
+    EXPECT_EQ(ast_divide(Ratio{34}, ast_divide(Ratio{10}, Ratio{3})), (Ratio{51, 5}));
 
     // real
     EXPECT_EQ_REAL(ast_divide(34.2, -10.1, 3.3),             -1.026);
@@ -128,3 +133,74 @@ TEST(astEvalArithmetic, distribution) {
     EXPECT_EQ(ast_multiplies(2, 3, ast_plus(4, 5, 6)), 90);
 }
 
+TEST(astEvalArithmetic, primitiveCallingConvention) {
+    using namespace yasc;
+    auto plus  = arithmetic::get_plus();
+    auto minus = arithmetic::get_minus();
+    auto const& prim = value_cast<Procedure*>(plus)->primitive();
+    EXPECT_NE(prim.call2, nullptr);
+    EXPECT_EQ(prim.arity.min, 0u);
+    EXPECT_EQ(prim.arity.max, Arity::variadic);
+
+    // (+) is the unity, (-) is an error
+    EXPECT_EQ(value_cast<Procedure*>(plus)->call(Args{nullptr, 0}), Object::fixnum(0));
+    EXPECT_THROW(value_cast<Procedure*>(minus)->call(Args{nullptr, 0}), Error);
+
+    // the list adapter and apply convert between the two conventions
+    auto list_prim = make_object<Procedure>([] (Object const& args) {
+        return value_cast<Pair*>(args)->cdr().is_empty_list() ? Object::boolean(true) : Object::boolean(false);
+    });
+    Object one[] = {Object::fixnum(1)};
+    EXPECT_TRUE(value_cast<Procedure*>(list_prim)->call(Args{one, 1}).is_true());
+    auto args = make_object<Pair>(Object::fixnum(4), make_object<Pair>(Object::fixnum(5), get_empty_list()));
+    EXPECT_EQ(value_cast<Procedure*>(plus)->apply(args), Object::fixnum(9));
+}
+
+TEST(astEvalArithmetic, fixnumOverflowPromotes) {
+    using namespace yasc;
+    auto plus  = arithmetic::get_plus();
+    auto times = arithmetic::get_multiplies();
+    auto call  = [] (Object proc, Object a, Object b) {
+        Object args[] = {a, b};
+        return value_cast<Procedure*>(proc)->call(Args{args, 2});
+    };
+
+    auto max = Object::fixnum(Object::fixnum_max);
+    auto sum = call(plus, max, Object::fixnum(1));
+    EXPECT_EQ(number_kind_of(sum), NumberKind::Bignum);
+    EXPECT_EQ(number_traits<BigInt>::unbox(sum), BigInt{Object::fixnum_max} + BigInt{1});
+
+    auto square = call(times, max, max);
+    EXPECT_EQ(number_kind_of(square), NumberKind::Bignum);
+    EXPECT_EQ(number_traits<BigInt>::unbox(square), BigInt{Object::fixnum_max} * BigInt{Object::fixnum_max});
+
+    // and results that fit again drop back to fixnums
+    auto back = call(plus, sum, Object::fixnum(-1));
+    EXPECT_TRUE(back.is_fixnum());
+    EXPECT_EQ(back, max);
+}
+
+TEST(astEvalArithmetic, contagion) {
+    using namespace yasc;
+    auto call = [] (Object proc, Object a, Object b) {
+        Object args[] = {a, b};
+        return value_cast<Procedure*>(proc)->call(Args{args, 2});
+    };
+    auto big  = number_traits<BigInt>::box(BigInt::parse("100000000000000000000"));
+    auto real = number_traits<double>::box(0.5);
+    auto cplx = number_traits<std::complex<double>>::box({1.0, 2.0});
+
+    EXPECT_EQ(number_kind_of(call(arithmetic::get_plus(), Object::fixnum(1), real)), NumberKind::Real);
+    EXPECT_DOUBLE_EQ(number_traits<double>::unbox(call(arithmetic::get_plus(), big, real)), 1e20 + 0.5);
+    auto sum = call(arithmetic::get_plus(), real, cplx);
+    EXPECT_EQ(number_kind_of(sum), NumberKind::Complex);
+    EXPECT_EQ(number_traits<std::complex<double>>::unbox(sum), std::complex<double>(1.5, 2.0));
+
+    EXPECT_TRUE(call(arithmetic::get_less(), Object::fixnum(3), big).is_true());
+    EXPECT_TRUE(call(arithmetic::get_equal(), Object::fixnum(2), number_traits<double>::box(2.0)).is_true());
+    EXPECT_THROW(call(arithmetic::get_less(), cplx, real), Error);
+    EXPECT_THROW(call(arithmetic::get_plus(), Object::fixnum(1), Object::boolean(true)), Error);
+    EXPECT_THROW(call(arithmetic::get_divides(), Object::fixnum(1), Object::fixnum(0)), Error);
+    EXPECT_EQ(call(arithmetic::get_modulo(), Object::fixnum(-7), Object::fixnum(2)), Object::fixnum(1));
+    EXPECT_EQ(call(arithmetic::get_remainder(), Object::fixnum(-7), Object::fixnum(2)), Object::fixnum(-1));
+}
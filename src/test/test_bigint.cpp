@@ -0,0 +1,89 @@
+#include <random>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "../error.h"
+#include "../ast/bigint.h"
+
+namespace {
+    // a random number of `digits' decimal digits
+    yasc::BigInt random_big(std::mt19937& rng, std::size_t digits, bool negative = false) {
+        std::string str = negative ? "-" : "";
+        str += static_cast<char>('1' + rng() % 9);
+        for(std::size_t i = 1; i < digits; ++i) {
+            str += static_cast<char>('0' + rng() % 10);
+        }
+        return yasc::BigInt::parse(str);
+    }
+}
+
+TEST(bigint, parseAndPrint) {
+    using yasc::BigInt;
+    for(auto str : {"0", "1", "-1", "4294967296", "-18446744073709551616",
+                    "123456789012345678901234567890", "1000000000000000000000000000001"}) {
+        EXPECT_EQ(BigInt::parse(str).to_string(), str);
+    }
+    EXPECT_EQ(BigInt::parse("+42").to_string(), "42");
+    EXPECT_EQ(BigInt::parse("-0").sign(), 0);
+    EXPECT_THROW(BigInt::parse("12a"), yasc::Error);
+    EXPECT_THROW(BigInt::parse("-"), yasc::Error);
+}
+
+TEST(bigint, machineIntegers) {
+    using yasc::BigInt;
+    std::intmax_t out = 0;
+    for(auto v : {std::intmax_t{0}, std::intmax_t{-7}, INTMAX_MAX, INTMAX_MIN}) {
+        EXPECT_TRUE(BigInt{v}.to_int(out));
+        EXPECT_EQ(out, v);
+    }
+    EXPECT_FALSE((BigInt{INTMAX_MAX} + BigInt{1}).to_int(out));
+    EXPECT_FALSE((BigInt{INTMAX_MIN} - BigInt{1}).to_int(out));
+    EXPECT_EQ(BigInt::parse("-9223372036854775808").to_string(), std::to_string(INTMAX_MIN));
+    EXPECT_DOUBLE_EQ(BigInt::parse("1000000000000000000000").to_double(), 1e21);
+}
+
+TEST(bigint, addSubtractSigns) {
+    using yasc::BigInt;
+    auto big = BigInt::parse("100000000000000000000");
+    EXPECT_EQ((big + BigInt{1}).to_string(), "100000000000000000001");
+    EXPECT_EQ((big - BigInt{1}).to_string(), "99999999999999999999");
+    EXPECT_EQ((BigInt{1} - big).to_string(), "-99999999999999999999");
+    EXPECT_EQ((-big + big).sign(), 0);
+    EXPECT_LT(-big, BigInt{0});
+    EXPECT_GT(big, BigInt{INTMAX_MAX});
+}
+
+TEST(bigint, karatsubaMatchesSchoolbook) {
+    using yasc::BigInt;
+    // (10^k + 1)^2 = 10^2k + 2 10^k + 1, across the karatsuba threshold
+    for(auto k : {5, 50, 500, 3000}) {
+        auto x = BigInt::parse("1" + std::string(k - 1, '0') + "1");
+        auto expected = "1" + std::string(k - 1, '0') + "2" + std::string(k - 1, '0') + "1";
+        EXPECT_TRUE((x * x).to_string() == expected) << k;
+    }
+
+    // (a b) c == a (b c) with operands of very different sizes
+    std::mt19937 rng{42};
+    auto a = random_big(rng, 2000), b = random_big(rng, 900, true), c = random_big(rng, 30);
+    EXPECT_EQ((a * b) * c, a * (b * c));
+    EXPECT_EQ(a * (b + c), a * b + a * c);
+}
+
+TEST(bigint, divisionIdentity) {
+    using yasc::BigInt;
+    std::mt19937 rng{7};
+    for(int i = 0; i < 200; ++i) {
+        auto a = random_big(rng, 1 + rng() % 120, rng() % 2);
+        auto b = random_big(rng, 1 + rng() % 60, rng() % 2);
+        BigInt q, r;
+        BigInt::divmod(a, b, q, r);
+        EXPECT_EQ(q * b + r, a);
+        // the remainder is smaller than the divisor, with the dividend's sign
+        EXPECT_LT((r.sign() < 0) ? -r : r, (b.sign() < 0) ? -b : b);
+        EXPECT_TRUE(0 == r.sign() || r.sign() == a.sign());
+    }
+    EXPECT_EQ((BigInt::parse("-7") / BigInt{2}).to_string(), "-3");
+    EXPECT_EQ((BigInt::parse("-7") % BigInt{2}).to_string(), "-1");
+    EXPECT_THROW(BigInt{1} / BigInt{0}, yasc::Error);
+}
@@ -0,0 +1,203 @@
+#include <cstdint>
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../error.h"
+#include "../isolate.h"
+#include "../ast/number.h"
+#include "../gc/heap.h"
+
+namespace {
+    constexpr char const* rule = "(if (> amount limit) (* (- amount limit) rate) 0)";
+
+    std::int64_t expected(std::int64_t amount, std::int64_t limit, std::int64_t rate) {
+        return amount > limit ? (amount - limit) * rate : 0;
+    }
+
+    std::int64_t twice(std::int64_t x) {
+        return 2 * x;
+    }
+}
+
+TEST(embed, compiledOnceRunsMany) {
+    yasc::Isolate isolate;
+    auto expr = isolate.compile(rule);
+    auto amount = isolate.global("amount");
+    auto limit = isolate.global("limit");
+    auto rate = isolate.global("rate");
+
+    // the inputs need only be bound by the time it runs
+    EXPECT_THROW(expr.run(), yasc::Error);
+    limit.set(100);
+    rate.set(3);
+    for(std::int64_t i = 0; i < 300; i += 7) {
+        amount.set(i);
+        EXPECT_EQ(expr.run<std::int64_t>(), expected(i, 100, 3));
+    }
+    EXPECT_EQ(amount.get<int>(), 294);
+
+    // the globals are those the isolate's programs see
+    isolate.run("(define limit 280)");
+    EXPECT_EQ(expr.run<std::int64_t>(), expected(294, 280, 3));
+    EXPECT_EQ(isolate.run("(* amount 2)"), "588");
+}
+
+TEST(embed, fixnumRunsAllocateNothing) {
+    yasc::Isolate isolate;
+    auto expr = isolate.compile(rule);
+    auto amount = isolate.global("amount");
+    isolate.global("limit").set(1000);
+    isolate.global("rate").set(7);
+    amount.set(0);
+    expr.run();
+
+    auto before = isolate.heap().stats().bytes_allocated;
+    std::int64_t sum = 0;
+    {
+        yasc::Isolate::Scope scope{isolate};
+        for(std::int64_t i = 0; i < 10000; ++i) {
+            amount.set(i);
+            sum += expr.run<std::int64_t>();
+        }
+    }
+    EXPECT_EQ(isolate.heap().stats().bytes_allocated, before);
+
+    std::int64_t want = 0;
+    for(std::int64_t i = 0; i < 10000; ++i) {
+        want += expected(i, 1000, 7);
+    }
+    EXPECT_EQ(sum, want);
+}
+
+TEST(embed, globalsConvert) {
+    yasc::Isolate isolate;
+    auto x = isolate.global("x");
+    EXPECT_THROW(x.get(), yasc::Error);
+
+    x.set(2.5);
+    EXPECT_EQ(x.get<double>(), 2.5);
+    EXPECT_EQ(isolate.run("(* x 2)"), "5.0");
+
+    // beyond a fixnum, integers are bignums both ways
+    x.set(std::int64_t{1} << 62);
+    EXPECT_EQ(x.get<std::int64_t>(), std::int64_t{1} << 62);
+    EXPECT_EQ(isolate.run("(- x (* 2 (quotient x 2)))"), "0");
+    EXPECT_THROW(x.get<std::int32_t>(), yasc::Error);
+
+    x.set(true);
+    EXPECT_TRUE(x.get<bool>());
+    x.set(U'λ');
+    EXPECT_EQ(x.get<char32_t>(), U'λ');
+    EXPECT_THROW(x.get<int>(), yasc::Error);
+
+    // objects made elsewhere are copied in
+    yasc::gc::Root list{yasc::make_object<yasc::Pair>(yasc::Object::fixnum(1), yasc::Object::empty_list())};
+    x.set(list.get());
+    EXPECT_EQ(isolate.run("(car x)"), "1");
+}
+
+TEST(embed, nativesAreTyped) {
+    yasc::Isolate isolate;
+    isolate.define_native("clamp", [] (std::int64_t x, std::int64_t lo, std::int64_t hi) {
+        return x < lo ? lo : (x > hi ? hi : x);
+    });
+    isolate.define_native("scale", [] (double x, double factor) { return x * factor; });
+    isolate.define_native("twice", twice);
+    std::vector<std::int64_t> seen;
+    isolate.define_native("note", [&seen] (std::int64_t x) { seen.push_back(x); });
+
+    EXPECT_EQ(isolate.run("(clamp 15 0 10)"), "10");
+    EXPECT_EQ(isolate.run("(scale 3 1.5)"), "4.5");
+    EXPECT_EQ(isolate.run("(twice (clamp -4 -2 2))"), "-4");
+    isolate.run("(note 1)");
+    isolate.run("(note (twice 21))");
+    EXPECT_EQ(seen, (std::vector<std::int64_t>{1, 42}));
+
+    // the arity and types come from the declaration
+    EXPECT_THROW(isolate.run("(clamp 1 2)"), yasc::Error);
+    try {
+        isolate.run("(clamp 1 2.5 3)");
+        FAIL();
+    } catch(yasc::Error const& err) {
+        EXPECT_NE(std::string{err.what()}.find("clamp: argument 2"), std::string::npos);
+    }
+
+    // and they are called from compiled expressions like any primitive
+    auto expr = isolate.compile("(clamp (twice x) 0 100)");
+    isolate.global("x").set(70);
+    EXPECT_EQ(expr.run<int>(), 100);
+
+    // until redefined
+    isolate.run("(define (twice x) (* 3 x))");
+    isolate.global("x").set(20);
+    EXPECT_EQ(expr.run<int>(), 60);
+}
+
+TEST(embed, compileTakesOneExpression) {
+    yasc::Isolate isolate;
+    EXPECT_THROW(isolate.compile(""), yasc::Error);
+    EXPECT_THROW(isolate.compile("1 2"), yasc::Error);
+    EXPECT_EQ(isolate.compile("(quote (a b))").run<yasc::Object>().type(), yasc::Value::Type::Pair);
+
+    yasc::Isolate walker{yasc::Evaluator::Mode::Ast};
+    EXPECT_THROW(walker.compile("1"), yasc::Error);
+}
+
+TEST(embed, runsFromAnyThread) {
+    yasc::Isolate isolate;
+    auto expr = isolate.compile(rule);
+    auto amount = isolate.global("amount");
+    isolate.global("limit").set(10);
+    isolate.global("rate").set(2);
+
+    // one thread after the other
+    for(std::int64_t i = 0; i < 4; ++i) {
+        std::thread{[&] {
+            amount.set(20 + i);
+            EXPECT_EQ(expr.run<std::int64_t>(), expected(20 + i, 10, 2));
+        }}.join();
+    }
+
+    // but never two at once
+    std::promise<void> entered;
+    std::promise<void> done;
+    std::thread holder{[&] {
+        yasc::Isolate::Scope scope{isolate};
+        entered.set_value();
+        done.get_future().wait();
+    }};
+    entered.get_future().wait();
+    EXPECT_THROW(expr.run(), yasc::Error);
+    done.set_value();
+    holder.join();
+    EXPECT_EQ(expr.run<std::int64_t>(), expected(23, 10, 2));
+
+    // threads of their own run an isolate each
+    std::vector<std::future<std::int64_t>> sums;
+    for(int t = 0; t < 4; ++t) {
+        sums.push_back(std::async(std::launch::async, [t] {
+            yasc::Isolate own;
+            auto expr = own.compile(rule);
+            auto amount = own.global("amount");
+            own.global("limit").set(t);
+            own.global("rate").set(t + 1);
+            std::int64_t sum = 0;
+            for(std::int64_t i = 0; i < 1000; ++i) {
+                amount.set(i);
+                sum += expr.run<std::int64_t>();
+            }
+            return sum;
+        }));
+    }
+    for(int t = 0; t < 4; ++t) {
+        std::int64_t want = 0;
+        for(std::int64_t i = 0; i < 1000; ++i) {
+            want += expected(i, t, t + 1);
+        }
+        EXPECT_EQ(sums[t].get(), want);
+    }
+}
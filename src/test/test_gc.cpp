@@ -0,0 +1,401 @@
+#include <chrono>
+#include <memory>
+#include <sstream>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "../ast/object.h"
+#include "../ast/number.h"
+#include "../ast/pair.h"
+#include "../ast/list.h"
+#include "../error.h"
+#include "../gc/heap.h"
+
+namespace {
+    // counts how many live instances have been destroyed; a moved-from husk
+    // left behind in the nursery does not count
+    struct Tracked : public yasc::Value {
+        static int destroyed;
+
+        Tracked()
+            : Value(yasc::Value::Type::Number)
+            , owner{true}
+        {}
+
+        Tracked(Tracked&& rhs)
+            : Value(yasc::Value::Type::Number)
+            , owner{rhs.owner}
+        {
+            rhs.owner = false;
+        }
+
+        ~Tracked() {
+            destroyed += owner ? 1 : 0;
+        }
+
+        std::ostream& print(std::ostream& o) const override {
+            return o << "tracked";
+        }
+
+        bool owner;
+    };
+
+    int Tracked::destroyed = 0;
+
+    yasc::gc::Config small_heap() {
+        yasc::gc::Config config;
+        config.nursery_size = 64 << 10;
+        config.chunk_size   = 16 << 10;
+        return config;
+    }
+
+    yasc::Object cons(yasc::Object car, yasc::Object cdr) {
+        return yasc::make_object<yasc::Pair>(car, cdr);
+    }
+}
+
+TEST(gc, rootedValuesSurviveMinor) {
+    using namespace yasc;
+    gc::Heap heap{small_heap()};
+    gc::HeapScope scope{heap};
+
+    gc::Root list{cons(Object::fixnum(1), cons(number_traits<double>::box(2.5), get_empty_list()))};
+    for(int i = 0; i < 1000; ++i) {
+        cons(Object::fixnum(i), get_empty_list());
+    }
+    EXPECT_TRUE(gc::Heap::is_young(list));
+
+    heap.collect_minor();
+
+    EXPECT_TRUE(gc::Heap::is_old(list));
+    auto first = value_cast<Pair*>(list.get());
+    auto second = value_cast<Pair*>(first->cdr());
+    EXPECT_EQ(first->car().as_fixnum(), 1);
+    EXPECT_EQ(number_traits<double>::unbox(second->car()), 2.5);
+    EXPECT_TRUE(second->cdr().is_empty_list());
+
+    // only the two pairs and the boxed real were worth promoting
+    auto const& stats = heap.stats();
+    EXPECT_EQ(stats.minor.collections, 1u);
+    EXPECT_EQ(stats.old_objects, 3u);
+    EXPECT_EQ(stats.nursery_bytes, 0u);
+}
+
+TEST(gc, safepointCollectsFullNursery) {
+    using namespace yasc;
+    gc::Heap heap{small_heap()};
+    gc::HeapScope scope{heap};
+
+    for(int i = 0; i < 100000; ++i) {
+        cons(Object::fixnum(i), get_empty_list());
+        heap.safepoint();
+    }
+    EXPECT_GT(heap.stats().minor.collections, 0u);
+    EXPECT_EQ(heap.stats().bytes_promoted, 0u);
+}
+
+TEST(gc, writeBarrierRemembersOldToYoung) {
+    using namespace yasc;
+    gc::Heap heap{small_heap()};
+    gc::HeapScope scope{heap};
+
+    gc::Root pair{cons(Object::fixnum(0), get_empty_list())};
+    heap.collect_minor();
+    ASSERT_TRUE(gc::Heap::is_old(pair));
+
+    // the only reference to the young pair lives in an old one
+    value_cast<Pair*>(pair.get())->set_cdr(cons(Object::fixnum(42), get_empty_list()));
+    heap.collect_minor();
+
+    auto cdr = value_cast<Pair*>(pair.get())->cdr();
+    EXPECT_TRUE(gc::Heap::is_old(cdr));
+    EXPECT_EQ(value_cast<Pair*>(cdr)->car().as_fixnum(), 42);
+}
+
+TEST(gc, listPushBackBarrier) {
+    using namespace yasc;
+    gc::Heap heap{small_heap()};
+    gc::HeapScope scope{heap};
+
+    // enough elements to fill old chunks and link young ones to them
+    gc::Root list{make_object<List>()};
+    heap.collect_minor();
+    for(int i = 0; i < 30; ++i) {
+        value_cast<List*>(list.get())->push_back(number_traits<double>::box(i));
+        heap.collect_minor();
+    }
+
+    auto expected = 0.0;
+    for(auto const& val : *value_cast<List*>(list.get())) {
+        EXPECT_TRUE(gc::Heap::is_old(val));
+        EXPECT_EQ(number_traits<double>::unbox(val), expected++);
+    }
+    EXPECT_EQ(expected, 30.0);
+}
+
+TEST(gc, majorFreesLongListsWithoutRecursing) {
+    using namespace yasc;
+    gc::Heap heap{small_heap()};
+    gc::HeapScope scope{heap};
+
+    constexpr int length = 1000000;
+    {
+        gc::Root list{get_empty_list()};
+        for(int i = 0; i < length; ++i) {
+            list = cons(Object::fixnum(i), list);
+            heap.safepoint();
+        }
+        heap.collect_major();
+        EXPECT_EQ(heap.stats().old_objects, static_cast<std::size_t>(length));
+        EXPECT_EQ(heap.stats().bytes_freed, 0u);
+    }
+
+    heap.collect_major();
+    EXPECT_EQ(heap.stats().old_objects, 0u);
+    EXPECT_EQ(heap.stats().old_bytes, 0u);
+    EXPECT_GT(heap.stats().bytes_freed, 0u);
+    EXPECT_GE(heap.stats().major.collections, 2u);
+}
+
+TEST(gc, finalizersRunExactlyOnce) {
+    using namespace yasc;
+    Tracked::destroyed = 0;
+    {
+        gc::Heap heap{small_heap()};
+        gc::HeapScope scope{heap};
+
+        gc::Root kept{make_object<Tracked>()};
+        make_object<Tracked>();
+        make_object<Tracked>();
+
+        heap.collect_minor();
+        EXPECT_EQ(Tracked::destroyed, 2);
+        EXPECT_TRUE(static_cast<Tracked*>(kept.get().get())->owner);
+
+        kept = Object{};
+        heap.collect_major();
+        EXPECT_EQ(Tracked::destroyed, 3);
+
+        make_object<Tracked>();
+    }
+    // the heap's own destructor takes care of whatever is left
+    EXPECT_EQ(Tracked::destroyed, 4);
+}
+
+TEST(gc, regionAllocationsBypassTheHeap) {
+    using namespace yasc;
+    gc::Heap heap{small_heap()};
+    gc::HeapScope scope{heap};
+    gc::Region region;
+
+    Tracked::destroyed = 0;
+    {
+        gc::RegionScope in_region{region};
+        auto pair = cons(Object::fixnum(1), cons(Object::fixnum(2), get_empty_list()));
+        EXPECT_TRUE(gc::Heap::in_region(pair));
+        EXPECT_FALSE(gc::Heap::is_young(pair));
+        make_object<Tracked>();
+    }
+    EXPECT_EQ(heap.stats().bytes_allocated, 0u);
+    EXPECT_GT(region.bytes(), 0u);
+
+    region.release();
+    EXPECT_EQ(region.bytes(), 0u);
+    EXPECT_EQ(Tracked::destroyed, 1);
+
+    EXPECT_TRUE(gc::Heap::is_young(cons(Object::fixnum(1), get_empty_list())));
+}
+
+TEST(gc, escapeCopiesValuesOutOfRegion) {
+    using namespace yasc;
+    gc::Heap heap{small_heap()};
+    gc::HeapScope scope{heap};
+    gc::Region region;
+
+    auto list = Object{};
+    {
+        gc::RegionScope in_region{region};
+        list = make_object<List>();
+        for(int i = 0; i < 100; ++i) {
+            value_cast<List*>(list)->push_back(number_traits<double>::box(i));
+        }
+    }
+
+    gc::Root escaped{heap.escape(list)};
+    EXPECT_TRUE(gc::Heap::is_young(escaped));
+    // escaping the same graph again yields the same copy
+    EXPECT_EQ(heap.escape(list), escaped.get());
+
+    region.release();
+    heap.collect_minor();
+
+    auto expected = 0.0;
+    for(auto const& val : *value_cast<List*>(escaped.get())) {
+        EXPECT_FALSE(gc::Heap::in_region(val));
+        EXPECT_EQ(number_traits<double>::unbox(val), expected++);
+    }
+    EXPECT_EQ(expected, 100.0);
+
+    // immediates and heap values pass through untouched
+    EXPECT_EQ(heap.escape(Object::fixnum(3)), Object::fixnum(3));
+    EXPECT_EQ(heap.escape(escaped.get()), escaped.get());
+}
+
+TEST(gc, copyDuplicatesGraphsBetweenHeaps) {
+    using namespace yasc;
+    gc::Heap from{small_heap()};
+    gc::Heap to{small_heap()};
+
+    auto shared = Object{};
+    auto cycle  = Object{};
+    {
+        gc::HeapScope scope{from};
+        shared = number_traits<double>::box(1.5);
+        cycle  = cons(shared, cons(shared, get_empty_list()));
+        value_cast<Pair*>(value_cast<Pair*>(cycle)->cdr())->set_cdr(cycle);
+    }
+
+    gc::HeapScope scope{to};
+    gc::Root copy{to.copy(cycle)};
+    ASSERT_NE(copy.get(), cycle);
+    EXPECT_TRUE(gc::Heap::is_young(copy));
+
+    // sharing and cycles come out as they went in
+    auto first  = value_cast<Pair*>(copy.get());
+    auto second = value_cast<Pair*>(first->cdr());
+    EXPECT_EQ(second->cdr(), copy.get());
+    EXPECT_EQ(first->car(), second->car());
+    EXPECT_NE(first->car(), shared);
+    EXPECT_EQ(number_traits<double>::unbox(first->car()), 1.5);
+
+    // and the original is left as it was
+    EXPECT_EQ(value_cast<Pair*>(cycle)->car(), shared);
+
+    // inside a region scope the copy lands in the region
+    gc::Region region;
+    {
+        gc::RegionScope in_region{region, to};
+        EXPECT_TRUE(gc::Heap::in_region(to.copy(cycle)));
+    }
+
+    EXPECT_EQ(to.copy(Object::fixnum(3)), Object::fixnum(3));
+
+    // values that cannot be copied say so
+    auto tracked = Object{};
+    {
+        gc::HeapScope in_from{from};
+        tracked = make_object<Tracked>();
+    }
+    EXPECT_THROW(to.copy(tracked), Error);
+}
+
+TEST(gc, censusCountsValuesByType) {
+    using namespace yasc;
+    gc::Heap heap{small_heap()};
+    gc::HeapScope scope{heap};
+    auto const pairs  = static_cast<std::size_t>(Value::Type::Pair);
+    auto const number = static_cast<std::size_t>(Value::Type::Number);
+
+    // spans several nursery chunks
+    gc::Root list{get_empty_list()};
+    for(int i = 0; i < 10; ++i) {
+        list = cons(number_traits<double>::box(i), list);
+    }
+    for(int i = 0; i < 2000; ++i) {
+        cons(Object::fixnum(i), get_empty_list());
+    }
+    auto const& stats = heap.census();
+    EXPECT_EQ(stats.types[pairs].allocations, 2010u);
+    EXPECT_EQ(stats.types[pairs].live, 2010u);
+    EXPECT_EQ(stats.types[number].live, 10u);
+    EXPECT_EQ(stats.types[pairs].live_bytes, stats.types[pairs].bytes);
+    EXPECT_EQ(stats.allocations, 2020u);
+
+    // only what is reachable survives
+    heap.collect_major();
+    heap.census();
+    EXPECT_EQ(stats.types[pairs].live, 10u);
+    EXPECT_EQ(stats.types[number].live, 10u);
+    EXPECT_EQ(stats.types[pairs].allocations, 2010u);
+
+    // values made in a region are counted apart, and never live
+    gc::Region region;
+    {
+        gc::RegionScope in_region{region};
+        cons(Object::fixnum(1), get_empty_list());
+        heap.copy(list.get());
+    }
+    heap.census();
+    EXPECT_EQ(stats.types[pairs].region_allocations, 11u);
+    EXPECT_EQ(stats.types[number].region_allocations, 10u);
+    EXPECT_EQ(stats.types[pairs].region_bytes, 11 * stats.types[pairs].bytes / 2010);
+    EXPECT_EQ(stats.types[pairs].allocations, 2010u);
+    EXPECT_EQ(stats.types[pairs].live, 10u);
+}
+
+TEST(gc, peakOutlastsCollections) {
+    using namespace yasc;
+    gc::Heap heap{small_heap()};
+    gc::HeapScope scope{heap};
+
+    for(int i = 0; i < 1000; ++i) {
+        cons(Object::fixnum(i), get_empty_list());
+    }
+    auto before = heap.stats().nursery_bytes;
+    heap.collect_minor();
+    auto const& stats = heap.stats();
+    EXPECT_EQ(stats.nursery_bytes, 0u);
+    EXPECT_GE(stats.peak_bytes, before);
+}
+
+TEST(gc, dumpsReportsAfterCollections) {
+    using namespace yasc;
+    gc::Heap heap{small_heap()};
+    gc::HeapScope scope{heap};
+
+    auto out = std::make_unique<std::ostringstream>();
+    auto& dumped = *out;
+    heap.dump_to(std::move(out), std::chrono::hours{1});
+
+    gc::Root pair{cons(Object::fixnum(1), get_empty_list())};
+    heap.collect_minor();
+    auto report = dumped.str();
+    EXPECT_NE(std::string::npos, report.find("pair"));
+    EXPECT_NE(std::string::npos, report.find("live bytes"));
+
+    // not again within the interval
+    heap.collect_minor();
+    EXPECT_EQ(report, dumped.str());
+}
+
+TEST(gc, statsLeaveTheStreamAsItWas) {
+    using namespace yasc;
+    gc::Heap heap{small_heap()};
+    std::ostringstream o;
+    o << heap.stats() << std::endl << 2.5 << " " << 1.0 / 3;
+    EXPECT_NE(o.str().find("\n2.5 0.333333"), std::string::npos);
+}
+
+TEST(gc, majorReusesFreedCells) {
+    using namespace yasc;
+    gc::Heap heap{small_heap()};
+    gc::HeapScope scope{heap};
+
+    auto promote = [&] (Object obj) {
+        gc::Root root{obj};
+        heap.collect_minor();
+        EXPECT_TRUE(gc::Heap::is_old(root));
+        return root.get().get();
+    };
+
+    auto first = promote(cons(Object::fixnum(1), Object::fixnum(2)));
+    heap.collect_major();
+    EXPECT_EQ(heap.stats().old_objects, 0u);
+
+    // the cell the dead pair left is the first one handed out again
+    gc::Root again{cons(Object::fixnum(3), Object::fixnum(4))};
+    heap.collect_minor();
+    EXPECT_EQ(again.get().get(), first);
+    EXPECT_EQ(heap.stats().old_objects, 1u);
+}
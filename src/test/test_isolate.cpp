@@ -0,0 +1,151 @@
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../error.h"
+#include "../isolate.h"
+#include "../ast/channel.h"
+#include "../gc/heap.h"
+
+namespace {
+    constexpr char const* fib =
+        "(define (fib n) (if (< n 2) n (+ (fib (- n 1)) (fib (- n 2)))))";
+}
+
+TEST(isolate, globalsAreItsOwn) {
+    yasc::Isolate a;
+    yasc::Isolate b;
+    a.run("(define x 1)");
+    b.run("(define x 2)");
+    EXPECT_EQ(a.run("x"), "1");
+    EXPECT_EQ(b.run("(+ x 40)"), "42");
+    EXPECT_THROW(b.run("y"), yasc::Error);
+    EXPECT_EQ(a.run("(define (twice y) (* 2 y)) (twice x)"), "2");
+    EXPECT_THROW(b.run("(twice 1)"), yasc::Error);
+    // redefining a builtin in one leaves the others alone
+    a.run("(define + -)");
+    EXPECT_EQ(a.run("(+ 5 3)"), "2");
+    EXPECT_EQ(b.run("(+ 5 3)"), "8");
+}
+
+TEST(isolate, builtinsAreShared) {
+    yasc::Isolate isolate;
+    // the builtins live outside of every heap
+    EXPECT_EQ(isolate.heap().stats().bytes_allocated, 0u);
+    EXPECT_EQ(isolate.run("car"), "[proc car]");
+
+    // and pass through collections untouched
+    isolate.run("(define keep (list + car))");
+    isolate.heap().collect_minor();
+    isolate.heap().collect_major();
+    EXPECT_EQ(isolate.run("((car keep) 1 2)"), "3");
+}
+
+TEST(isolate, channelsCopyBetweenHeaps) {
+    yasc::Isolate a;
+    yasc::Isolate b;
+    yasc::gc::Root ch{yasc::make_object<yasc::Channel>(4)};
+    a.define("ch", ch);
+    b.define("ch", ch);
+
+    a.run("(define msg (list 1 2.5 (quote sym) (s64vector 1 2)))");
+    a.run("(channel-send ch msg)");
+    EXPECT_EQ(b.run("(channel-receive ch)"), a.run("msg"));
+
+    // a channel sent over a channel is the same channel
+    a.run("(define reply (make-channel 1))");
+    a.run("(channel-send ch reply)");
+    b.run("(channel-send (channel-receive ch) 42)");
+    EXPECT_EQ(a.run("(channel-receive reply)"), "42");
+
+    EXPECT_EQ(b.run("(channel-try-receive ch (quote none))"), "none");
+    EXPECT_EQ(a.run("(channel? ch)"), "#t");
+    EXPECT_EQ(a.run("(channel? msg)"), "#f");
+}
+
+TEST(isolate, channelsRefuseWhatCannotLeave) {
+    yasc::Isolate isolate;
+    isolate.run("(define ch (make-channel 2))");
+    EXPECT_THROW(isolate.run("(channel-send ch (lambda (x) x))"), yasc::Error);
+    EXPECT_THROW(isolate.run("(channel-send ch (list 1 (lambda (x) x)))"), yasc::Error);
+    // the builtins are the same in every isolate, so they can go
+    isolate.run("(channel-send ch car)");
+    EXPECT_EQ(isolate.run("((channel-receive ch) (list 7))"), "7");
+    EXPECT_THROW(isolate.run("(make-channel 0)"), yasc::Error);
+    EXPECT_THROW(isolate.run("(channel-send 1 2)"), yasc::Error);
+}
+
+TEST(isolate, closedChannelsDrainThenRefuse) {
+    yasc::Isolate isolate;
+    isolate.run("(define ch (make-channel 2))");
+    isolate.run("(channel-send ch 1)");
+    isolate.run("(channel-close ch)");
+    EXPECT_THROW(isolate.run("(channel-send ch 2)"), yasc::Error);
+    EXPECT_EQ(isolate.run("(channel-receive ch)"), "1");
+    EXPECT_THROW(isolate.run("(channel-receive ch)"), yasc::Error);
+}
+
+TEST(isolate, poolRunsIsolatesInParallel) {
+    yasc::IsolatePool pool{4};
+    std::vector<std::shared_ptr<yasc::Isolate>> isolates;
+    std::vector<std::future<std::string>> results;
+    for(int i = 0; i < 32; ++i) {
+        isolates.push_back(std::make_shared<yasc::Isolate>());
+        results.push_back(pool.run(isolates.back(),
+            std::string{fib} + "(fib " + std::to_string(10 + i % 5) + ")"));
+    }
+    char const* expected[] = {"55", "89", "144", "233", "377"};
+    for(std::size_t i = 0; i < results.size(); ++i) {
+        EXPECT_EQ(results[i].get(), expected[i % 5]);
+    }
+
+    // errors come back through the future
+    EXPECT_THROW(pool.run(isolates.front(), "(car 1)").get(), yasc::Error);
+}
+
+TEST(isolate, producerAndConsumer) {
+    using namespace yasc;
+    // a small capacity has the producer wait for the consumer
+    gc::Root ch{make_object<Channel>(2)};
+    auto producer = std::make_shared<Isolate>();
+    auto consumer = std::make_shared<Isolate>();
+    producer->define("out", ch);
+    consumer->define("in", ch);
+
+    IsolatePool pool{2};
+    auto sum = pool.run(consumer,
+        "(define (sum acc)"
+        "  (let ((n (channel-receive in)))"
+        "    (if (= n 0) acc (sum (+ acc n)))))"
+        "(sum 0)");
+    auto sent = pool.run(producer,
+        "(define (send n)"
+        "  (channel-send out n)"
+        "  (if (= n 0) (quote done) (send (- n 1))))"
+        "(send 1000)");
+    EXPECT_EQ(sent.get(), "done");
+    EXPECT_EQ(sum.get(), "500500");
+}
+
+TEST(isolate, runsOnOneThreadAtATime) {
+    using namespace yasc;
+    gc::Root ch{make_object<Channel>(1)};
+    auto isolate = std::make_shared<Isolate>();
+    isolate->define("ch", ch);
+
+    IsolatePool pool{1};
+    auto received = pool.run(isolate, "(channel-receive ch)");
+    while(!isolate->running()) {
+        std::this_thread::yield();
+    }
+    EXPECT_THROW(isolate->run("1"), Error);
+
+    value_cast<Channel*>(ch.get())->send(Object::fixnum(5));
+    EXPECT_EQ(received.get(), "5");
+    EXPECT_FALSE(isolate->running());
+    EXPECT_EQ(isolate->run("(channel-try-receive ch #f)"), "#f");
+}
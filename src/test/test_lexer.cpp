@@ -0,0 +1,142 @@
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../lexer.h"
+#include "../parser.h"
+#include "../error.h"
+#include "../repl.h"
+#include "../gc/heap.h"
+#include "helpers.h"
+
+namespace {
+    // hands out its input a few bytes at a time, so tokens straddle reads
+    class Trickle : public yasc::Source {
+    public:
+        Trickle(std::string data, std::size_t step)
+            : data_{std::move(data)}
+            , step_{step}
+        {}
+
+        std::size_t read(char* buf, std::size_t size) override {
+            auto count = std::min({size, step_, data_.size() - pos_});
+            data_.copy(buf, count, pos_);
+            pos_ += count;
+            return count;
+        }
+
+    private:
+        std::string data_;
+        std::size_t step_;
+        std::size_t pos_ = 0;
+    };
+
+    std::vector<std::string> texts(yasc::Lexer& lexer) {
+        std::vector<std::string> ret;
+        for(auto tok = lexer.next(); yasc::Token::Kind::End != tok.kind; tok = lexer.next()) {
+            ret.emplace_back(tok.text);
+        }
+        return ret;
+    }
+}
+
+TEST(lexer, tokensAndPositions) {
+    using yasc::Token;
+    yasc::Lexer lexer{"(define x ; a comment\n  12.5)\n\tfoo"};
+    auto expect = [&] (Token::Kind kind, std::string_view text, std::uint32_t line, std::uint32_t column) {
+        auto tok = lexer.next();
+        EXPECT_EQ(tok.kind, kind);
+        EXPECT_EQ(tok.text, text);
+        EXPECT_EQ(tok.pos.line, line);
+        EXPECT_EQ(tok.pos.column, column);
+    };
+    expect(Token::Kind::Open,  "(",      1, 1);
+    expect(Token::Kind::Atom,  "define", 1, 2);
+    expect(Token::Kind::Atom,  "x",      1, 9);
+    expect(Token::Kind::Atom,  "12.5",   2, 3);
+    EXPECT_EQ(lexer.peek().kind, Token::Kind::Close);
+    EXPECT_EQ(lexer.peek().pos.offset, 28u);
+    expect(Token::Kind::Close, ")",      2, 7);
+    expect(Token::Kind::Atom,  "foo",    3, 2);
+    EXPECT_EQ(lexer.next().kind, Token::Kind::End);
+    EXPECT_EQ(lexer.next().kind, Token::Kind::End);
+}
+
+TEST(lexer, resumesAcrossReads) {
+    std::string input = "(alpha (beta 123456789) gamma) ; done\n(delta)";
+    std::vector<std::string> expected{"(", "alpha", "(", "beta", "123456789", ")", "gamma", ")", "(", "delta", ")"};
+    for(auto step : {1u, 2u, 3u, 7u, 1000u}) {
+        Trickle source{input, step};
+        yasc::Lexer lexer{source};
+        EXPECT_EQ(texts(lexer), expected) << step;
+    }
+}
+
+TEST(lexer, tokensLongerThanTheBuffer) {
+    auto big = std::string(3 * yasc::Lexer::block_size + 5, 'x');
+    Trickle source{"(a " + big + " b)", 4096};
+    yasc::Lexer lexer{source};
+    auto tokens = texts(lexer);
+    ASSERT_EQ(tokens.size(), 5u);
+    EXPECT_EQ(tokens[2], big);
+    EXPECT_EQ(tokens[3], "b");
+}
+
+TEST(lexer, parsesDatumsOneAfterAnother) {
+    using namespace yasc;
+    std::istringstream in{"(+ 1\n   2)\n7 (* 2\n3) ()"};
+    StreamSource source{in};
+    Lexer lexer{source};
+    Parser parser;
+    EXPECT_EQ(print(parser.next(lexer)), "(+ 1 2)");
+    EXPECT_EQ(print(parser.next(lexer)), "7");
+    EXPECT_EQ(print(parser.next(lexer)), "(* 2 3)");
+    EXPECT_TRUE(parser.next(lexer).is_empty_list());
+    EXPECT_TRUE(parser.next(lexer).is_null());
+}
+
+TEST(lexer, reportsWhereErrorsAre) {
+    using namespace yasc;
+    try {
+        Parser{}("(+ 1\n  (* 2 3)");
+        FAIL();
+    } catch(Error const& e) {
+        EXPECT_STREQ(e.what(), "unterminated list opened at 1:1");
+    }
+    EXPECT_THROW(Parser{}(")"), Error);
+    EXPECT_TRUE(Parser{}("  ; nothing here\n").is_null());
+}
+
+TEST(lexer, mappedFile) {
+    using namespace yasc;
+    auto path = testing::TempDir() + "yasc_lexer_test.scm";
+    {
+        std::ofstream out{path};
+        out << "(+ 1 2)\n(quote (a b))\n";
+    }
+    {
+        MappedFile file{path};
+        Lexer lexer{file.data()};
+        Parser parser;
+        EXPECT_EQ(print(parser.next(lexer)), "(+ 1 2)");
+        EXPECT_EQ(print(parser.next(lexer)), "(quote (a b))");
+        EXPECT_TRUE(parser.next(lexer).is_null());
+    }
+    std::remove(path.c_str());
+    EXPECT_THROW(MappedFile{path}, Error);
+}
+
+TEST(lexer, replReadsMultiLineForms) {
+    using namespace yasc;
+    std::istringstream in{"(+ 1\n2) 3\n)\n(* 2 2)\n:q\n"};
+    std::ostringstream out;
+    Repl{Parser{}, Evaluator{}, in, out}.run();
+    auto text = out.str();
+    EXPECT_NE(std::string::npos, text.find("3\n3\n"));
+    EXPECT_NE(std::string::npos, text.find("error: unexpected `)' at 3:1"));
+    EXPECT_NE(std::string::npos, text.find("4\n"));
+}
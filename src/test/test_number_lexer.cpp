@@ -0,0 +1,147 @@
+#include <cmath>
+#include <complex>
+#include <limits>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "../number_lexer.h"
+#include "../error.h"
+#include "../ast/number.h"
+#include "../gc/heap.h"
+#include "helpers.h"
+
+namespace {
+    yasc::Object lex(std::string const& tok) {
+        yasc::Object out;
+        EXPECT_TRUE(yasc::lex_number(tok, out)) << tok;
+        return out;
+    }
+
+    yasc::NumberKind kind(std::string const& tok) {
+        return yasc::number_kind_of(lex(tok));
+    }
+
+    double real(std::string const& tok) {
+        return yasc::number_traits<double>::unbox(lex(tok));
+    }
+
+    std::complex<double> complex(std::string const& tok) {
+        return yasc::number_traits<std::complex<double>>::unbox(lex(tok));
+    }
+}
+
+TEST(numberLexer, exactIntegers) {
+    using yasc::NumberKind;
+    EXPECT_EQ(lex("42").as_fixnum(), 42);
+    EXPECT_EQ(lex("+42").as_fixnum(), 42);
+    EXPECT_EQ(lex("-0").as_fixnum(), 0);
+    EXPECT_EQ(lex("#x1F").as_fixnum(), 31);
+    EXPECT_EQ(lex("#X-ff").as_fixnum(), -255);
+    EXPECT_EQ(lex("#o777").as_fixnum(), 511);
+    EXPECT_EQ(lex("#b-1010").as_fixnum(), -10);
+    EXPECT_EQ(lex("#d99").as_fixnum(), 99);
+    EXPECT_EQ(kind("9223372036854775808"), NumberKind::Bignum);
+    EXPECT_EQ(print(lex("-123456789012345678901234567890")), "-123456789012345678901234567890");
+    EXPECT_EQ(print(lex("#xffffffffffffffffffffffff")), "79228162514264337593543950335");
+    EXPECT_EQ(print(lex("#b1" + std::string(70, '0'))), "1180591620717411303424");
+}
+
+TEST(numberLexer, rationals) {
+    using yasc::NumberKind;
+    EXPECT_EQ(print(lex("1/3")), "1/3");
+    EXPECT_EQ(print(lex("-6/4")), "-3/2");
+    EXPECT_EQ(print(lex("8/4")), "2");
+    EXPECT_EQ(print(lex("#x10/3")), "16/3");
+    EXPECT_EQ(print(lex("123456789012345678901234567890/10")), "12345678901234567890123456789");
+    EXPECT_EQ(kind("1/3"), NumberKind::Rational);
+    EXPECT_THROW(lex("1/0"), yasc::Error);
+}
+
+TEST(numberLexer, reals) {
+    using yasc::NumberKind;
+    EXPECT_EQ(real("1.5"), 1.5);
+    EXPECT_EQ(real("-.5"), -0.5);
+    EXPECT_EQ(real("+.5"), 0.5);
+    EXPECT_EQ(real("5."), 5.0);
+    EXPECT_EQ(real("1e10"), 1e10);
+    EXPECT_EQ(real("2.5E-3"), 2.5e-3);
+    EXPECT_EQ(real("1e+2"), 100.0);
+    EXPECT_EQ(real("0.1"), 0.1);
+    EXPECT_EQ(real("1e400"), std::numeric_limits<double>::infinity());
+    EXPECT_EQ(real("1e-400"), 0.0);
+    EXPECT_EQ(real("+inf.0"), std::numeric_limits<double>::infinity());
+    EXPECT_EQ(real("-inf.0"), -std::numeric_limits<double>::infinity());
+    EXPECT_TRUE(std::isnan(real("+nan.0")));
+    EXPECT_EQ(kind("1.0"), NumberKind::Real);
+}
+
+TEST(numberLexer, exactness) {
+    using yasc::NumberKind;
+    EXPECT_EQ(print(lex("#e1.5")), "3/2");
+    EXPECT_EQ(print(lex("#e1.25e2")), "125");
+    EXPECT_EQ(print(lex("#e-1e-3")), "-1/1000");
+    EXPECT_EQ(print(lex("#x#e10")), "16");
+    EXPECT_EQ(real("#i3"), 3.0);
+    EXPECT_EQ(real("#i1/4"), 0.25);
+    EXPECT_EQ(real("#x#iff"), 255.0);
+    EXPECT_THROW(lex("#e+inf.0"), yasc::Error);
+
+    // exact exponents are bounded, so no literal takes long to read
+    EXPECT_EQ(print(lex("#e1e10000")), "1" + std::string(10000, '0'));
+    EXPECT_EQ(print(lex("#e-1.5e-10000")), "-3/2" + std::string(10000, '0'));
+    EXPECT_THROW(lex("#e1e10001"), yasc::Error);
+    EXPECT_THROW(lex("#e1e999999999"), yasc::Error);
+    EXPECT_EQ(real("1e999999999"), std::numeric_limits<double>::infinity());
+}
+
+TEST(numberLexer, complexNumbers) {
+    using yasc::NumberKind;
+    EXPECT_EQ(complex("1+2i"), std::complex<double>(1, 2));
+    EXPECT_EQ(complex("-1.5-2.5i"), std::complex<double>(-1.5, -2.5));
+    EXPECT_EQ(complex("3-i"), std::complex<double>(3, -1));
+    EXPECT_EQ(complex("+i"), std::complex<double>(0, 1));
+    EXPECT_EQ(complex("-2i"), std::complex<double>(0, -2));
+    EXPECT_EQ(complex("1/2+1/4i"), std::complex<double>(0.5, 0.25));
+    EXPECT_EQ(complex("0+inf.0i").imag(), std::numeric_limits<double>::infinity());
+    EXPECT_NEAR(complex("1@1.5707963267948966").imag(), 1.0, 1e-12);
+    EXPECT_EQ(lex("5+0i").as_fixnum(), 5);
+    EXPECT_EQ(lex("5@0").as_fixnum(), 5);
+    EXPECT_EQ(kind("1+2i"), NumberKind::Complex);
+}
+
+TEST(numberLexer, notNumbers) {
+    yasc::Object out;
+    for(auto tok : {"+", "-", "...", "->x", "x1", "+a", ".", "#\\a", "-foo"}) {
+        EXPECT_FALSE(yasc::lex_number(tok, out)) << tok;
+    }
+    for(auto tok : {"1+", "1/", "1/-2", "1/2/3", "1e", "1.2.3", "12abc", "#xg", "#x#x1", "#e#i1", "1+2", "1@", ".5x"}) {
+        EXPECT_THROW(yasc::lex_number(tok, out), yasc::Error) << tok;
+    }
+}
+
+TEST(numberLexer, printsWhatItReads) {
+    // inexact numbers keep a `.' or an exponent, and every digit they need
+    EXPECT_EQ(print(lex("1.0")), "1.0");
+    EXPECT_EQ(eval("(* 1.5 2)"), "3.0");
+    EXPECT_EQ(print(lex("123456789.123")), "123456789.123");
+    EXPECT_EQ(eval("(/ 1.0 3)"), "0.3333333333333333");
+    EXPECT_EQ(print(lex("1e22")), "1e+22");
+    EXPECT_EQ(print(lex("-0.0")), "-0.0");
+    EXPECT_EQ(print(lex("+inf.0")), "+inf.0");
+    EXPECT_EQ(print(lex("-inf.0")), "-inf.0");
+    EXPECT_EQ(print(lex("+nan.0")), "+nan.0");
+    EXPECT_EQ(eval("(- +nan.0)"), "+nan.0");
+    EXPECT_EQ(print(lex("1+2i")), "1.0+2.0i");
+    EXPECT_EQ(print(lex("1.5-0.25i")), "1.5-0.25i");
+    EXPECT_EQ(print(lex("-inf.0+nan.0i")), "-inf.0+nan.0i");
+
+    // and read back as the same number
+    for(auto tok : {"1.0", "123456789.123", "0.1", "1e22", "5e-324", "1.7976931348623157e308", "-inf.0", "1+2i", "-0.5-inf.0i"}) {
+        auto printed = print(lex(tok));
+        EXPECT_EQ(print(lex(printed)), printed) << tok;
+        EXPECT_EQ(kind(printed), kind(tok)) << tok;
+    }
+    EXPECT_EQ(real(print(lex("0.1"))), 0.1);
+    EXPECT_EQ(real(print(lex("5e-324"))), 5e-324);
+}
@@ -0,0 +1,131 @@
+#include <iterator>
+
+#include <gtest/gtest.h>
+
+#include "../ast/object.h"
+#include "../ast/number.h"
+#include "../ast/pair.h"
+#include "../ast/list.h"
+#include "../gc/heap.h"
+#include "../libscheme/lists.h"
+#include "helpers.h"
+TEST(object, fixnumRoundTrip) {
+    using namespace yasc;
+    for(auto v : {std::intptr_t{0}, std::intptr_t{1}, std::intptr_t{-1}, std::intptr_t{42},
+                  Object::fixnum_max, Object::fixnum_min}) {
+        auto obj = Object::fixnum(v);
+        EXPECT_TRUE(obj.is_fixnum());
+        EXPECT_FALSE(obj.is_heap());
+        EXPECT_EQ(obj.type(), Value::Type::Number);
+        EXPECT_EQ(obj.as_fixnum(), v);
+    }
+    EXPECT_TRUE(Object::fits_fixnum(Object::fixnum_max));
+    EXPECT_FALSE(Object::fits_fixnum(INTMAX_MAX));
+}
+
+TEST(object, immediates) {
+    using namespace yasc;
+    EXPECT_EQ(Object::boolean(true).type(),  Value::Type::Boolean);
+    EXPECT_TRUE(Object::boolean(true).as_boolean());
+    EXPECT_FALSE(Object::boolean(false).as_boolean());
+    EXPECT_NE(Object::boolean(true), Object::boolean(false));
+
+    EXPECT_EQ(Object::character('x').type(), Value::Type::Character);
+    EXPECT_EQ(Object::character('x').as_character(), U'x');
+
+    EXPECT_EQ(get_empty_list(), get_empty_list());
+    EXPECT_EQ(get_empty_list().type(), Value::Type::EmptyList);
+    EXPECT_FALSE(get_empty_list().is_heap());
+
+    EXPECT_EQ(print(Object::boolean(true)), "#t");
+    EXPECT_EQ(print(Object::character('a')), "#\\a");
+    EXPECT_EQ(print(get_empty_list()), "()");
+    EXPECT_EQ(print(Object::fixnum(-17)), "-17");
+}
+
+TEST(object, heapValues) {
+    using namespace yasc;
+    auto real = number_traits<double>::box(1.5);
+    EXPECT_TRUE(real.is_heap());
+    EXPECT_EQ(number_traits<double>::unbox(real), 1.5);
+
+    auto pair = make_object<Pair>(Object::fixnum(1), real);
+    EXPECT_EQ(pair.type(), Value::Type::Pair);
+    EXPECT_EQ(value_cast<Pair*>(pair)->cdr(), real);
+    EXPECT_EQ(print(pair), "(1 . 1.5)");
+
+    auto copy = pair;
+    EXPECT_EQ(copy, pair);
+}
+
+TEST(object, numbersCheckTheirLevel) {
+    using namespace yasc;
+    auto real = number_traits<double>::box(1.5);
+    auto big = number_traits<BigInt>::box(BigInt{std::intmax_t{1} << 62});
+    EXPECT_TRUE(detail::check_type<Real>(*real.get()));
+    EXPECT_FALSE(detail::check_type<Bignum>(*real.get()));
+    EXPECT_FALSE(detail::check_type<Complex>(*real.get()));
+    EXPECT_TRUE(detail::check_type<Bignum>(*big.get()));
+    EXPECT_FALSE(detail::check_type<Rational>(*big.get()));
+    EXPECT_FALSE(detail::check_type<Pair>(*big.get()));
+}
+
+TEST(object, listOfFixnums) {
+    using namespace yasc;
+    List list{};
+    for(int i = 0; i < 5; ++i) {
+        list.push_back(Object::fixnum(i));
+    }
+    EXPECT_EQ(list.size(), 5);
+    EXPECT_EQ(print(list), "(0 1 2 3 4)");
+
+    auto expected = 0;
+    for(auto const& v : list) {
+        EXPECT_EQ(v.as_fixnum(), expected++);
+    }
+}
+
+TEST(object, listAcrossChunks) {
+    using namespace yasc;
+    for(auto size : {0, 1, 10, 11, 12, 22, 23, 100}) {
+        List list{};
+        for(int i = 0; i < size; ++i) {
+            list.push_back(Object::fixnum(i));
+        }
+        EXPECT_EQ(list.size(), size);
+        EXPECT_EQ(std::distance(list.begin(), list.end()), size);
+        auto expected = 0;
+        for(auto const& v : list) {
+            EXPECT_EQ(v.as_fixnum(), expected++);
+        }
+        EXPECT_EQ(expected, size);
+    }
+    EXPECT_TRUE(List{}.car().is_empty_list());
+}
+
+TEST(object, listTakenApartOnce) {
+    using namespace yasc;
+    gc::Root list{make_object<List>()};
+    for(int i = 0; i < 100; ++i) {
+        value_cast<List*>(list.get())->push_back(Object::fixnum(i));
+    }
+    auto walk = [&] {
+        auto cur = list.get();
+        for(int i = 0; i < 100; ++i) {
+            EXPECT_EQ(lists::detail::car(cur, nullptr).as_fixnum(), i);
+            cur = lists::detail::cdr(cur, nullptr);
+        }
+        EXPECT_TRUE(cur.is_empty_list());
+    };
+
+    // the rest is made once, a pair per element, and then kept
+    auto& heap = gc::current_heap();
+    auto before = heap.stats().allocations;
+    walk();
+    EXPECT_EQ(heap.stats().allocations, before + 99);
+    walk();
+    EXPECT_EQ(heap.stats().allocations, before + 99);
+    EXPECT_EQ(lists::detail::cdr(list, nullptr), lists::detail::cdr(list, nullptr));
+
+    EXPECT_THROW(lists::detail::car(make_object<List>(), nullptr), Error);
+}
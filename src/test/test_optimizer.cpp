@@ -0,0 +1,110 @@
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "../parser.h"
+#include "../error.h"
+#include "../evaluator.h"
+#include "../gc/heap.h"
+#include "helpers.h"
+
+TEST(optimizer, foldsConstantCalls) {
+    yasc::Evaluator evaluator;
+    EXPECT_EQ(eval_in(evaluator, "(* 60 60 24)"), "86400");
+    EXPECT_EQ(evaluator.optimizations().folded, 1u);
+    EXPECT_EQ(eval_in(evaluator, "(+ 1 (/ 10 2))"), "6");
+    EXPECT_EQ(eval_in(evaluator, "((lambda (x) (+ x (* 2 3.5))) 1)"), "8.0");
+    EXPECT_EQ(eval_in(evaluator, "(< 1 (/ 1 3))"), "#f");
+    EXPECT_EQ(evaluator.optimizations().folded, 6u);
+
+    // a call that fails is left for the program to run into
+    EXPECT_THROW(eval_in(evaluator, "(/ 1 0)"), yasc::Error);
+    EXPECT_THROW(eval_in(evaluator, "(+ 1 (quote a))"), yasc::Error);
+    EXPECT_EQ(evaluator.optimizations().folded, 6u);
+
+    // a parameter is not the primitive it shadows
+    EXPECT_EQ(eval_in(evaluator, "((lambda (+) (+ 1 2)) -)"), "-1");
+    EXPECT_EQ(evaluator.optimizations().folded, 6u);
+}
+
+TEST(optimizer, prunesDeadBranches) {
+    yasc::Evaluator evaluator;
+    EXPECT_EQ(eval_in(evaluator, "(if #f (undefined) 2)"), "2");
+    EXPECT_EQ(eval_in(evaluator, "(if 0 1 (undefined))"), "1");
+    EXPECT_EQ(eval_in(evaluator, "(if #f 1)"), "");
+    EXPECT_EQ(eval_in(evaluator, "((lambda (x) (if #t x 0)) 5)"), "5");
+    EXPECT_EQ(evaluator.optimizations().pruned, 4u);
+    // special forms shadowed by a parameter are calls like any other
+    EXPECT_EQ(eval_in(evaluator, "((lambda (if) (if 1 2)) +)"), "3");
+    EXPECT_EQ(evaluator.optimizations().pruned, 4u);
+}
+
+TEST(optimizer, prunesBranchesOnFoldedTests) {
+    yasc::Evaluator evaluator;
+    EXPECT_EQ(eval_in(evaluator, "(if (= 1 1) 2 (undefined))"), "2");
+    EXPECT_EQ(eval_in(evaluator, "(if (< 2 1) (undefined) 3)"), "3");
+    EXPECT_EQ(eval_in(evaluator, "(if (> 1 (+ 1 1)) 4)"), "");
+    EXPECT_EQ(evaluator.optimizations().folded, 4u);
+    EXPECT_EQ(evaluator.optimizations().pruned, 3u);
+
+    // the branch taken still depends on the primitives the test was folded with
+    eval_in(evaluator, "(define (pick) (if (< 1 2) (quote less) (quote more)))");
+    EXPECT_EQ(eval_in(evaluator, "(pick)"), "less");
+    eval_in(evaluator, "(set! < >)");
+    EXPECT_EQ(eval_in(evaluator, "(pick)"), "more");
+}
+
+TEST(optimizer, flattensNestedArithmetic) {
+    yasc::Evaluator evaluator{yasc::Evaluator::Mode::Quickening, 2};
+    eval_in(evaluator, "(define (f a b c d) (- (- (- a b) c) d))");
+    EXPECT_EQ(evaluator.optimizations().flattened, 2u);
+    EXPECT_EQ(eval_in(evaluator, "(f 10 1 2 3)"), "4");
+    // only calls nested first are merged, which keeps the order floats
+    // are rounded in
+    eval_in(evaluator, "(define (g a b c) (+ a (+ b c)))");
+    EXPECT_EQ(evaluator.optimizations().flattened, 2u);
+    EXPECT_EQ(eval_in(evaluator, "(g 1e16 1.0 -1e16)"), eval_in(evaluator, "(+ 1e16 (+ 1.0 -1e16))"));
+    // (- a) negates, and is no fold of its own
+    EXPECT_EQ(eval_in(evaluator, "((lambda (a b) (- (- a) b)) 1 2)"), "-3");
+    EXPECT_EQ(evaluator.optimizations().flattened, 2u);
+}
+
+TEST(optimizer, respectsRedefinitions) {
+    yasc::Evaluator evaluator{yasc::Evaluator::Mode::Quickening, 2};
+    eval_in(evaluator, "(define (day) (* 60 60 24))");
+    eval_in(evaluator, "(define (sum a b c) (+ (+ a b) c))");
+    EXPECT_EQ(eval_in(evaluator, "(day)"), "86400");
+    EXPECT_EQ(eval_in(evaluator, "(sum 2 3 4)"), "9");
+
+    eval_in(evaluator, "(set! * +)");
+    eval_in(evaluator, "(set! + -)");
+    EXPECT_EQ(eval_in(evaluator, "(day)"), "144");
+    EXPECT_EQ(eval_in(evaluator, "(sum 2 3 4)"), "-5");
+
+    // and forms optimized after the redefinition know about it
+    EXPECT_EQ(eval_in(evaluator, "(* 60 60 24)"), "144");
+    eval_in(evaluator, "(define (+ a b) 0)");
+    EXPECT_EQ(eval_in(evaluator, "(sum 2 3 4)"), "0");
+}
+
+TEST(optimizer, levelsAgree) {
+    using yasc::Evaluator;
+    auto const progs = {
+        "(* 60 60 24)",
+        "(+ 1 (/ 10 2))",
+        "((lambda (x y) (if (< x y) (- (- y x) 1) (* (* x y) 2.5))) 3 10)",
+        "((lambda (x y) (if (< x y) (- (- y x) 1) (* (* x y) 2.5))) 10 3)",
+        "(if (= (* 2 3) 6) (quotient 100000000000000000000 7) 0)",
+        "((lambda (f) (f (f 1 2) (+ 3 (+ 4 5)))) +)",
+        "(quote (+ 1 2))"
+    };
+    for(auto prog : progs) {
+        Evaluator none{Evaluator::Mode::Quickening, 0};
+        Evaluator some{Evaluator::Mode::Quickening, 1};
+        Evaluator most{Evaluator::Mode::Quickening, 2};
+        auto expected = eval_in(none, prog);
+        EXPECT_EQ(eval_in(some, prog), expected) << prog;
+        EXPECT_EQ(eval_in(most, prog), expected) << prog;
+        EXPECT_EQ(none.optimizations().folded, 0u);
+    }
+}
@@ -0,0 +1,140 @@
+#include <chrono>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "../parser.h"
+#include "../error.h"
+#include "../evaluator.h"
+#include "../gc/heap.h"
+#include "../par/scheduler.h"
+#include "helpers.h"
+
+namespace {
+    // runs a test with `n' threads, and puts the pool back as it was
+    class Threads {
+    public:
+        explicit Threads(unsigned n)
+            : before_{yasc::par::threads()}
+        {
+            yasc::par::set_threads(n);
+        }
+
+        ~Threads() {
+            yasc::par::set_threads(before_);
+        }
+
+    private:
+        unsigned before_;
+    };
+
+    // polls `done' for up to ten seconds
+    template<typename Pred>
+    bool eventually(Pred done) {
+        auto const deadline = std::chrono::steady_clock::now() + std::chrono::seconds{10};
+        while(!done()) {
+            if(std::chrono::steady_clock::now() > deadline) {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+        }
+        return true;
+    }
+
+    constexpr char const* pfib =
+        "(define (pfib n)"
+        "  (if (< n 2)"
+        "      n"
+        "      (let ((a (future (pfib (- n 1))))"
+        "            (b (pfib (- n 2))))"
+        "        (+ (touch a) b))))";
+}
+
+TEST(parallel, touchWaitsForTheValue) {
+    Threads threads{1};
+    EXPECT_EQ(eval("(touch (future (+ 1 2)))"), "3");
+    EXPECT_EQ(eval("((lambda (x) (touch (future (* x x)))) 7)"), "49");
+    EXPECT_EQ(eval("(future? (future 1))"), "#t");
+    EXPECT_EQ(eval("(future? 1)"), "#f");
+    // anything else is its own value
+    EXPECT_EQ(eval("(touch 5)"), "5");
+    EXPECT_EQ(eval("((lambda (f) (touch f) (touch f)) (future (quote (a b))))"), "(a b)");
+}
+
+TEST(parallel, futuresRunWhenTouched) {
+    Threads threads{1};
+    yasc::Evaluator evaluator;
+    eval_in(evaluator, "(define x 0)");
+    eval_in(evaluator, "(define f (future (set! x (+ x 1))))");
+    EXPECT_EQ(eval_in(evaluator, "x"), "0");
+    eval_in(evaluator, "(touch f)");
+    eval_in(evaluator, "(touch f)");
+    EXPECT_EQ(eval_in(evaluator, "x"), "1");
+}
+
+TEST(parallel, errorsReachTheToucher) {
+    Threads threads{1};
+    EXPECT_THROW(eval("(touch (future (car 1)))"), yasc::Error);
+    EXPECT_THROW(eval("(par-map car (list 1 2))"), yasc::Error);
+    // an error that nobody touches goes unnoticed
+    EXPECT_EQ(eval("((lambda (f) 1) (future (car 1)))"), "1");
+}
+
+TEST(parallel, parMapAndParFold) {
+    Threads threads{4};
+    EXPECT_EQ(eval("(par-map (lambda (x) (* x x)) (list 1 2 3 4 5))"), "(1 4 9 16 25)");
+    EXPECT_EQ(eval("(par-map (lambda (x) x) (list))"), "()");
+    EXPECT_EQ(eval("(par-fold + 0 (list 1 2 3 4 5 6 7 8 9 10))"), "55");
+    EXPECT_EQ(eval("(par-fold + 0 (s64vector 1 2 3 4 5 6 7 8 9 10))"), "55");
+    EXPECT_EQ(eval("(par-fold * 1 (f64vector 0.5 2.0 4.0 0.25))"), "1.0");
+    // the pieces come back in order
+    EXPECT_EQ(eval("(par-map (lambda (x) (- x)) (list 1 2 3 4 5 6 7 8 9 10 11 12 13 14 15 16 17 18))"),
+              "(-1 -2 -3 -4 -5 -6 -7 -8 -9 -10 -11 -12 -13 -14 -15 -16 -17 -18)");
+}
+
+TEST(parallel, parallelFibonacci) {
+    Threads threads{4};
+    yasc::Evaluator evaluator;
+    eval_in(evaluator, pfib);
+    EXPECT_EQ(eval_in(evaluator, "(pfib 20)"), "6765");
+    // futures made while a global one runs are still published
+    eval_in(evaluator, "(define f (future (pfib 18)))");
+    EXPECT_EQ(eval_in(evaluator, "(touch f)"), "2584");
+    EXPECT_GT(yasc::par::stats().spawned, 0u);
+}
+
+TEST(parallel, stolenTasksRunInACopy) {
+    Threads threads{2};
+    yasc::Evaluator evaluator;
+    eval_in(evaluator, pfib);
+    eval_in(evaluator, "(define x 1)");
+    eval_in(evaluator, "(touch (future 0))");
+
+    // while the other thread looks for work, this one publishes the
+    // oldest of its tasks for it to take, keeping the newest
+    ASSERT_TRUE(eventually([] { return yasc::par::stats().idle > 0; }));
+    auto const before = yasc::par::stats();
+    eval_in(evaluator,
+        "(define f"
+        "  (let ((f (future ((lambda () (set! x 2) (cons x (pfib 15))))))"
+        "        (g (future 0)))"
+        "    (touch g)"
+        "    f))");
+    ASSERT_TRUE(eventually([&] { return yasc::par::stats().stolen > before.stolen; }));
+
+    EXPECT_GT(yasc::par::stats().published, before.published);
+    EXPECT_EQ(eval_in(evaluator, "(touch f)"), "(2 . 610)");
+    // the thief ran in a copy of the globals
+    EXPECT_EQ(eval_in(evaluator, "x"), "1");
+}
+
+TEST(parallel, futuresSurviveCollections) {
+    Threads threads{2};
+    yasc::Evaluator evaluator;
+    eval_in(evaluator,
+        "(define (loop n acc)"
+        "  (if (= n 0)"
+        "      acc"
+        "      (loop (- n 1) (+ acc (touch (future (car (list n))))))))");
+    EXPECT_EQ(eval_in(evaluator, "(loop 100000 0)"), "5000050000");
+}
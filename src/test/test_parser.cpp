@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+
+#include "../parser.h"
+#include "../evaluator.h"
+#include "../gc/heap.h"
+#include "helpers.h"
+
+TEST(parser, astLivesInRegion) {
+    using namespace yasc;
+    gc::Region region;
+    auto ast = Parser{}("(+ 1 (* 2 3))", region);
+    ASSERT_EQ(ast.type(), Value::Type::List);
+    EXPECT_TRUE(gc::Heap::in_region(ast));
+    EXPECT_GT(region.bytes(), 0u);
+
+    EXPECT_EQ(print(ast), "(+ 1 (* 2 3))");
+}
+
+TEST(parser, evaluateNested) {
+    EXPECT_EQ(eval("(+ 1 2 (* 4 5 (- 8 9)))"), "-17");
+    EXPECT_EQ(eval("(- 10 2 3)"), "5");
+    EXPECT_EQ(eval("(/ 100 5 2)"), "10");
+}
+
+TEST(parser, rationalLiterals) {
+    EXPECT_EQ(eval("1/3"), "1/3");
+    EXPECT_EQ(eval("-6/4"), "-3/2");
+    EXPECT_EQ(eval("8/4"), "2");
+    EXPECT_EQ(eval("(+ 1/3 2/3)"), "1");
+    EXPECT_EQ(eval("(/ 1 3)"), "1/3");
+    EXPECT_EQ(eval("(* 2/3 0.5)"), "0.3333333333333333");
+    EXPECT_EQ(eval("(< 1/3 0.34 35/100)"), "#t");
+    EXPECT_THROW(eval("1/0"), yasc::Error);
+    EXPECT_THROW(eval("1/-2"), yasc::Error);
+}
+
+TEST(parser, dottedPairs) {
+    using namespace yasc;
+    gc::Region region;
+    auto ast = Parser{}("(1 (2) . 3)", region);
+    ASSERT_EQ(ast.type(), Value::Type::Pair);
+    EXPECT_EQ(print(ast), "(1 (2) . 3)");
+
+    EXPECT_EQ(eval("(cdr (quote (1 . 2)))"), "2");
+    EXPECT_EQ(eval("(car (cdr (quote (1 (2 3) . 4))))"), "(2 3)");
+    EXPECT_EQ(eval("(cdr (cdr (quote (1 (2 3) . 4))))"), "4");
+    EXPECT_EQ(eval("(quote (1 . (2 3)))"), "(1 2 3)");
+    // a dotted list is data, not a form
+    EXPECT_THROW(eval("(+ 1 . 2)"), Error);
+
+    for(auto bad : {"(. 1)", "(1 .)", "(1 . 2 3)", "(1 . . 2)", "(1 . )", "."}) {
+        SCOPED_TRACE(bad);
+        EXPECT_THROW(Parser{}(bad, region), Error);
+    }
+}
+
+TEST(parser, printsWhatItParses) {
+    using namespace yasc;
+    gc::Region region;
+    // one space between elements, none inside the parens
+    for(auto text : {"(a b)", "(1 . 2)", "(a (b c) . d)", "((a) (b . c) ())", "(quote (1 2.5 #t))", "()", "x"}) {
+        EXPECT_EQ(print(Parser{}(text, region)), text);
+    }
+    EXPECT_EQ(print(Parser{}("(  a\n(b  . ( c ))  )", region)), "(a (b c))");
+    EXPECT_EQ(eval("(cons 1 (cons (list 2 3) 4))"), "(1 (2 3) . 4)");
+    region.release();
+}
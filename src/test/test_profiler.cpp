@@ -0,0 +1,144 @@
+#include <sstream>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "../parser.h"
+#include "../error.h"
+#include "../evaluator.h"
+#include "../repl.h"
+#include "../gc/heap.h"
+#include "helpers.h"
+
+namespace {
+    yasc::vm::Profiler::Entry const* find(yasc::vm::Profiler const& profiler, std::string const& name) {
+        for(auto entry : profiler.entries()) {
+            if(entry->name == name) {
+                return entry;
+            }
+        }
+        return nullptr;
+    }
+
+    constexpr auto fib = "(define (fib n) (if (< n 2) n (+ (fib (- n 1)) (fib (- n 2)))))";
+
+    // a tail call replaces its caller in the profile, as it does on the
+    // stack, so these keep `toplevel' on it
+    constexpr auto fib10 = "(+ 0 (fib 10))";
+}
+
+TEST(profiler, countsCallsAndTimesThem) {
+    using yasc::vm::Profiler;
+    yasc::Evaluator evaluator;
+    eval_in(evaluator, fib);
+    evaluator.start_profiling(Profiler::Mode::Calls);
+    EXPECT_EQ(eval_in(evaluator, fib10), "55");
+    evaluator.stop_profiling();
+
+    auto const& profiler = evaluator.profiler();
+    ASSERT_NE(find(profiler, "fib"), nullptr);
+    EXPECT_EQ(find(profiler, "fib")->calls, 177u);
+    EXPECT_EQ(find(profiler, "toplevel")->calls, 1u);
+    // quickened calls of primitives are counted as well
+    EXPECT_EQ(find(profiler, "<")->calls, 177u);
+    EXPECT_EQ(find(profiler, "-")->calls, 176u);
+    EXPECT_EQ(find(profiler, "+")->calls, 89u);
+
+    auto top = find(profiler, "toplevel");
+    auto total = yasc::vm::Profiler::clock::duration{0};
+    for(auto entry : profiler.entries()) {
+        EXPECT_LE(entry->exclusive, entry->inclusive) << entry->name;
+        EXPECT_LE(entry->inclusive, top->inclusive) << entry->name;
+        total += entry->exclusive;
+    }
+    EXPECT_EQ(total, top->inclusive);
+
+    // nothing is counted once stopped
+    eval_in(evaluator, "(fib 5)");
+    EXPECT_EQ(find(profiler, "fib")->calls, 177u);
+}
+
+TEST(profiler, chargesAllocationsToTheAllocator) {
+    using yasc::vm::Profiler;
+    yasc::Evaluator evaluator;
+    eval_in(evaluator, "(define (make n) (if (= n 0) (quote ()) (cons n (make (- n 1)))))");
+    evaluator.start_profiling(Profiler::Mode::Calls);
+    eval_in(evaluator, "(make 100)");
+    evaluator.stop_profiling();
+
+    auto const& profiler = evaluator.profiler();
+    EXPECT_EQ(find(profiler, "cons")->calls, 100u);
+    EXPECT_EQ(find(profiler, "cons")->allocations, 100u);
+    EXPECT_GT(find(profiler, "cons")->bytes, 0u);
+    EXPECT_EQ(find(profiler, "make")->allocations, 0u);
+}
+
+TEST(profiler, collapsesStacks) {
+    using yasc::vm::Profiler;
+    yasc::Evaluator evaluator;
+    eval_in(evaluator, fib);
+    evaluator.start_profiling(Profiler::Mode::Calls);
+    eval_in(evaluator, "(+ 0 (fib 15))");
+    evaluator.stop_profiling();
+
+    std::ostringstream stacks;
+    evaluator.profiler().collapsed(stacks);
+    std::istringstream lines{stacks.str()};
+    auto count = 0;
+    for(std::string line; std::getline(lines, line); ++count) {
+        // a path of names, outermost first, then its weight
+        auto space = line.rfind(' ');
+        ASSERT_NE(space, std::string::npos) << line;
+        EXPECT_EQ(line.compare(0, 8, "toplevel"), 0) << line;
+        EXPECT_GT(std::stoull(line.substr(space + 1)), 0u) << line;
+    }
+    EXPECT_GT(count, 0);
+    EXPECT_NE(stacks.str().find("toplevel;fib;fib;fib"), std::string::npos);
+}
+
+TEST(profiler, unwindsOnErrors) {
+    using yasc::vm::Profiler;
+    yasc::Evaluator evaluator;
+    eval_in(evaluator, "(define (f x) (car x))");
+    evaluator.start_profiling(Profiler::Mode::Calls);
+    EXPECT_THROW(eval_in(evaluator, "(f 1)"), yasc::Error);
+    EXPECT_EQ(evaluator.profiler().depth(), 0u);
+    EXPECT_EQ(eval_in(evaluator, "(f (quote (1)))"), "1");
+    evaluator.stop_profiling();
+    EXPECT_EQ(find(evaluator.profiler(), "f")->calls, 2u);
+    EXPECT_EQ(find(evaluator.profiler(), "toplevel")->active, 0u);
+}
+
+TEST(profiler, samplesTheFrameStack) {
+    using yasc::vm::Profiler;
+    yasc::Evaluator evaluator;
+    eval_in(evaluator, fib);
+    evaluator.start_profiling(Profiler::Mode::Sampling);
+    // the timer counts cpu time, so keep busy until a few samples are in
+    for(auto i = 0; i < 100 && evaluator.profiler().samples() < 5; ++i) {
+        eval_in(evaluator, "(+ 0 (fib 20))");
+    }
+    evaluator.stop_profiling();
+
+    auto const& profiler = evaluator.profiler();
+    ASSERT_GE(profiler.samples(), 5u);
+    EXPECT_EQ(find(profiler, "toplevel")->on_stack, profiler.samples());
+    EXPECT_GT(find(profiler, "fib")->samples, 0u);
+    // calls are not counted when sampling
+    EXPECT_EQ(find(profiler, "fib")->calls, 0u);
+
+    std::ostringstream stacks;
+    profiler.collapsed(stacks);
+    EXPECT_NE(stacks.str().find("toplevel;fib;fib"), std::string::npos);
+}
+
+TEST(profiler, fromTheRepl) {
+    using namespace yasc;
+    std::istringstream in{"(define (sq x) (* x x))\n,profile (sq 12)\n:q\n"};
+    std::ostringstream out;
+    Repl{Parser{}, Evaluator{}, in, out}.run();
+    auto report = out.str();
+    EXPECT_NE(std::string::npos, report.find("144\n"));
+    EXPECT_NE(std::string::npos, report.find("procedure"));
+    EXPECT_NE(std::string::npos, report.find("\nsq "));
+}
@@ -0,0 +1,104 @@
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <random>
+
+#include <gtest/gtest.h>
+
+#include "../error.h"
+#include "../ast/bigint.h"
+#include "../ast/ratio.h"
+
+namespace {
+    constexpr auto word_max = std::numeric_limits<std::int64_t>::max();
+    constexpr auto word_min = std::numeric_limits<std::int64_t>::min();
+
+    // the same operations done naively on bignums and reduced afterwards
+    yasc::Ratio reference(char op, yasc::Ratio const& lhs, yasc::Ratio const& rhs) {
+        auto a = lhs.numerator(), b = lhs.denominator();
+        auto c = rhs.numerator(), d = rhs.denominator();
+        switch(op) {
+            case '+': return yasc::Ratio{a * d + c * b, b * d};
+            case '-': return yasc::Ratio{a * d - c * b, b * d};
+            case '*': return yasc::Ratio{a * c, b * d};
+            default:  return yasc::Ratio{a * d, b * c};
+        }
+    }
+}
+
+TEST(rational, canonicalForm) {
+    using yasc::Ratio;
+    EXPECT_EQ(Ratio(2, -4).to_string(), "-1/2");
+    EXPECT_EQ(Ratio(-3, -9).to_string(), "1/3");
+    EXPECT_EQ(Ratio(0, -5).to_string(), "0");
+    EXPECT_EQ(Ratio(0, -5).denominator(), yasc::BigInt{1});
+    EXPECT_TRUE(Ratio(12, 4).is_integer());
+    EXPECT_EQ(Ratio(1, 2), Ratio(50, 100));
+    EXPECT_THROW(Ratio(1, 0), yasc::Error);
+
+    EXPECT_EQ(Ratio::parse("-10/4").to_string(), "-5/2");
+    EXPECT_EQ(Ratio::parse("123456789012345678901234567890/10").to_string(), "12345678901234567890123456789");
+    EXPECT_THROW(Ratio::parse("1/"), yasc::Error);
+    EXPECT_THROW(Ratio::parse("1/+2"), yasc::Error);
+    EXPECT_THROW(Ratio::parse("1/2/3"), yasc::Error);
+}
+
+TEST(rational, binaryGcd) {
+    std::mt19937_64 rng{7};
+    EXPECT_EQ(yasc::binary_gcd(0, 12), 12u);
+    EXPECT_EQ(yasc::binary_gcd(12, 0), 12u);
+    for(auto i = 0; i < 10000; ++i) {
+        auto a = rng() >> (rng() % 64);
+        auto b = rng() >> (rng() % 64);
+        EXPECT_EQ(yasc::binary_gcd(a, b), std::gcd(a, b));
+    }
+}
+
+TEST(rational, wordOverflowUsesBignums) {
+    using yasc::Ratio;
+    using yasc::BigInt;
+    auto sum = Ratio{word_max} + Ratio{1};
+    EXPECT_EQ(sum.numerator(), BigInt{word_max} + BigInt{1});
+    EXPECT_EQ((-Ratio{word_min}).numerator(), -BigInt{word_min});
+
+    // denominators that only overflow once multiplied
+    auto tiny = Ratio{1, word_max} * Ratio{1, word_max - 1};
+    EXPECT_EQ(tiny.denominator(), BigInt{word_max} * BigInt{word_max - 1});
+
+    // and results that fit again go back to words
+    std::intmax_t out = 0;
+    EXPECT_TRUE((sum - Ratio{1}).to_int(out));
+    EXPECT_EQ(out, word_max);
+    EXPECT_EQ(tiny / tiny, Ratio{1});
+    EXPECT_LT(tiny, Ratio(1, word_max));
+    EXPECT_THROW(tiny / Ratio{0}, yasc::Error);
+}
+
+TEST(rational, matchesBignumReference) {
+    using yasc::Ratio;
+    std::mt19937_64 rng{42};
+    auto random = [&] {
+        // mostly word sized, some small, now and then with a shared factor
+        auto bits = 1 + rng() % 63;
+        auto num  = static_cast<std::int64_t>(rng() >> (64 - bits)) * ((rng() & 1) ? -1 : 1);
+        auto den  = static_cast<std::int64_t>(rng() >> (64 - 1 - rng() % 63)) | 1;
+        return (rng() % 4) ? Ratio{num, den} : Ratio{num / 8 * 6, 6};
+    };
+    for(auto i = 0; i < 4000; ++i) {
+        auto a = random(), b = random();
+        for(auto op : {'+', '-', '*', '/'}) {
+            if('/' == op && 0 == b.sign()) {
+                continue;
+            }
+            Ratio got;
+            switch(op) {
+                case '+': got = a + b; break;
+                case '-': got = a - b; break;
+                case '*': got = a * b; break;
+                default:  got = a / b; break;
+            }
+            ASSERT_EQ(got.to_string(), reference(op, a, b).to_string()) << a << " " << op << " " << b;
+        }
+        EXPECT_EQ(compare(a, b), (a - b).sign());
+    }
+}
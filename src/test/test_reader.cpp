@@ -0,0 +1,174 @@
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../reader.h"
+#include "../lexer.h"
+#include "../parser.h"
+#include "../error.h"
+#include "../evaluator.h"
+#include "../gc/heap.h"
+#include "../libscheme/simd.h"
+#include "helpers.h"
+
+namespace {
+    // every datum of `input', printed, as the Parser reads them
+    std::vector<std::string> parsed(std::string const& input) {
+        yasc::Lexer lexer{input};
+        yasc::Parser parser;
+        std::vector<std::string> ret;
+        for(auto datum = parser.next(lexer); !datum.is_null(); datum = parser.next(lexer)) {
+            ret.push_back(print(datum));
+        }
+        return ret;
+    }
+
+    std::vector<std::string> read(std::string const& input, yasc::simd::Kernels const& kernels) {
+        yasc::Reader reader{input, kernels};
+        std::vector<std::string> ret;
+        for(auto datum = reader.next(); !datum.is_null(); datum = reader.next()) {
+            ret.push_back(print(datum));
+        }
+        return ret;
+    }
+
+    // nested lists of atoms, with comments and assorted whitespace between
+    // them
+    std::string make_sample(std::mt19937_64& rng, std::size_t size) {
+        static char const* const pieces[] = {
+            "(", "(", ")", ")", " ", "  ", "\n", "\t", "\r\n", "foo", "x", "-12", "3/4", "2.5",
+            "#t", "123456789012345678901234567890", "; a (comment) ;\n", ";;\n", "a;b\n"
+        };
+        std::uniform_int_distribution<std::size_t> pick{0, std::size(pieces) - 1};
+        std::string ret;
+        auto depth = 0;
+        while(ret.size() < size) {
+            std::string piece = pieces[pick(rng)];
+            if(")" == piece && 0 == depth) {
+                continue;
+            }
+            depth += ("(" == piece) - (")" == piece);
+            // atoms need something between them to stay apart
+            ret += piece;
+            ret += ' ';
+        }
+        return ret + std::string(depth, ')');
+    }
+}
+
+TEST(reader, kernelsFindTheSameStructurals) {
+    using namespace yasc;
+    std::mt19937_64 rng{13};
+    auto const& all = simd::available();
+    for(auto size : {0u, 1u, 63u, 64u, 65u, 200u, 5000u}) {
+        auto input = make_sample(rng, size);
+        std::vector<std::uint32_t> expected(input.size() + 1);
+        simd::ScanState ref_state;
+        expected.resize(all.front()->structurals(input.data(), input.size(), ref_state, expected.data()));
+        for(auto k : all) {
+            SCOPED_TRACE(std::string{k->name} + " size " + std::to_string(input.size()));
+            std::vector<std::uint32_t> out(input.size() + 1);
+            simd::ScanState state;
+            out.resize(k->structurals(input.data(), input.size(), state, out.data()));
+            EXPECT_EQ(out, expected);
+            EXPECT_EQ(state.in_comment, ref_state.in_comment);
+        }
+    }
+}
+
+TEST(reader, structurals) {
+    using namespace yasc;
+    std::string input = "(ab (c) ;(no) x\n  12)";
+    for(auto k : simd::available()) {
+        SCOPED_TRACE(k->name);
+        std::vector<std::uint32_t> out(input.size());
+        simd::ScanState state;
+        out.resize(k->structurals(input.data(), input.size(), state, out.data()));
+        EXPECT_EQ(out, (std::vector<std::uint32_t>{0, 1, 4, 5, 6, 18, 20}));
+    }
+}
+
+TEST(reader, matchesTheParser) {
+    using namespace yasc;
+    std::mt19937_64 rng{17};
+    for(auto size : {std::size_t{10}, std::size_t{100}, std::size_t{1000}, 3 * Reader::batch_size}) {
+        auto input = make_sample(rng, size);
+        auto expected = parsed(input);
+        for(auto k : simd::available()) {
+            SCOPED_TRACE(std::string{k->name} + " size " + std::to_string(input.size()));
+            EXPECT_EQ(read(input, *k), expected);
+        }
+    }
+}
+
+TEST(reader, atomsAcrossBatches) {
+    using namespace yasc;
+    // an atom and a comment that both straddle the end of the first batch
+    std::string input(Reader::batch_size - 3, ' ');
+    input += "abcdef ; ((\n(x) " + std::string(Reader::batch_size - 6, ' ') + ";(y)\n(z)";
+    EXPECT_EQ(read(input, simd::kernels()), (std::vector<std::string>{"abcdef", "(x)", "(z)"}));
+}
+
+TEST(reader, reportsWhereErrorsAre) {
+    using namespace yasc;
+    std::string message;
+    try {
+        Reader{"(a\n (b c)"}.all();
+    } catch(Error const& e) {
+        message = e.what();
+    }
+    EXPECT_EQ(message, "unterminated list opened at 1:1");
+    try {
+        Reader{"(a)\n  b)"}.all();
+    } catch(Error const& e) {
+        message = e.what();
+    }
+    EXPECT_EQ(message, "unexpected `)' at 2:4");
+
+    // as deep as the parser takes, and no deeper
+    auto deep = std::string(max_nesting, '(') + std::string(max_nesting, ')');
+    EXPECT_EQ(read(deep, simd::kernels()), parsed(deep));
+    try {
+        Reader{"x\n(" + deep + ")"}.all();
+    } catch(Error const& e) {
+        message = e.what();
+    }
+    EXPECT_EQ(message, "lists nested more than 1000 deep at 2:1001");
+}
+
+TEST(reader, dottedPairs) {
+    using namespace yasc;
+    auto input = "(1 . 2) (a (b) . (c)) (x . ((y) . z))";
+    EXPECT_EQ(read(input, simd::kernels()), parsed(input));
+    EXPECT_EQ(parsed(input), (std::vector<std::string>{"(1 . 2)", "(a (b) c)", "(x (y) . z)"}));
+    for(auto bad : {"(. 1)", "(1 .)", "(1 . 2 3)", "(1 . . 2)", "."}) {
+        SCOPED_TRACE(bad);
+        EXPECT_THROW(Reader{bad}.all(), Error);
+        EXPECT_THROW(parsed(bad), Error);
+    }
+}
+
+TEST(reader, readAll) {
+    using namespace yasc;
+    auto path = testing::TempDir() + "yasc_reader_test.scm";
+    {
+        std::ofstream out{path};
+        out << "(1 2) ; two\nthree\n()\n";
+    }
+    EXPECT_EQ(print(Reader{"(1 2) three ()"}.all()), "((1 2) three ())");
+    EXPECT_EQ(print(Reader{" ; nothing"}.all()), "()");
+
+    gc::Region region;
+    auto ast = Parser{}("(read-all (quote " + path + "))", region);
+    auto result = gc::current_heap().escape(Evaluator{}(ast, Evaluator::get_scheme_context()));
+    region.release();
+    EXPECT_EQ(print(result), "((1 2) three ())");
+
+    std::remove(path.c_str());
+    EXPECT_THROW(Evaluator{}(Parser{}("(read-all (quote " + path + "))"), Evaluator::get_scheme_context()), Error);
+    EXPECT_THROW(Evaluator{}(Parser{}("(read-all 1)"), Evaluator::get_scheme_context()), Error);
+}
@@ -0,0 +1,92 @@
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../parser.h"
+#include "../ast/symbol.h"
+#include "../ast/list.h"
+#include "../ast/identifier.h"
+#include "../gc/heap.h"
+
+TEST(symbol, internIsUnique) {
+    using yasc::Symbol;
+    auto a = Symbol::intern("assoc");
+    auto b = Symbol::intern(std::string{"ass"} + "oc");
+    auto c = Symbol::intern("eq?");
+
+    EXPECT_EQ(a, b);
+    EXPECT_NE(a, c);
+    EXPECT_EQ(a.hash(), std::hash<std::string_view>{}("assoc"));
+    EXPECT_EQ(&a.name(), &b.name());
+
+    std::ostringstream o;
+    o << a;
+    EXPECT_EQ(o.str(), "assoc");
+}
+
+TEST(symbol, parserSharesSymbols) {
+    using namespace yasc;
+    gc::Region region;
+    auto ast = Parser{}("(f x x)", region);
+
+    auto list = value_cast<List*>(ast);
+    auto itr = list->begin();
+    auto f = value_cast<Identifier*>(*itr++);
+    auto x = value_cast<Identifier*>(*itr++);
+    auto y = value_cast<Identifier*>(*itr++);
+    EXPECT_EQ(f->symbol(), Symbol::intern("f"));
+    EXPECT_EQ(x->symbol(), y->symbol());
+    EXPECT_TRUE(*x == *y);
+    region.release();
+}
+
+TEST(symbol, collectDropsUnusedSymbols) {
+    using namespace yasc;
+    auto& table = SymbolTable::global();
+    table.collect();
+
+    auto kept = Symbol::intern("symbol-test-kept");
+    {
+        auto dropped = Symbol::intern("symbol-test-dropped");
+        auto copy = dropped;
+        EXPECT_EQ(table.collect(), 0u);
+    }
+    auto size = table.size();
+    EXPECT_EQ(table.collect(), 1u);
+    EXPECT_EQ(table.size(), size - 1);
+    EXPECT_EQ(kept, Symbol::intern("symbol-test-kept"));
+}
+
+TEST(symbol, internWhileCollecting) {
+    using namespace yasc;
+    auto& table = SymbolTable::global();
+    auto kept = Symbol::intern("symbol-test-shared");
+
+    // every thread sees the same symbols while others add and drop names
+    std::vector<std::thread> threads;
+    std::vector<int> wrong(4, 0);
+    for(int t = 0; t < 4; ++t) {
+        threads.emplace_back([t, &kept, &wrong] {
+            for(int i = 0; i < 2000; ++i) {
+                auto name = "symbol-test-" + std::to_string(i % 300);
+                auto a = Symbol::intern(name);
+                auto b = Symbol::intern(name);
+                if(a != b || a.name() != name || kept != Symbol::intern("symbol-test-shared")) {
+                    ++wrong[t];
+                }
+            }
+        });
+    }
+    for(int i = 0; i < 200; ++i) {
+        table.collect();
+    }
+    for(auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(wrong, std::vector<int>(4, 0));
+    table.collect();
+    EXPECT_EQ(kept, Symbol::intern("symbol-test-shared"));
+}
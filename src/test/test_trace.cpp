@@ -0,0 +1,135 @@
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../parser.h"
+#include "../evaluator.h"
+#include "../trace.h"
+#include "../gc/heap.h"
+
+namespace {
+    std::size_t count(std::vector<yasc::trace::Event> const& events, char const* name) {
+        return static_cast<std::size_t>(std::count_if(events.begin(), events.end(), [&] (auto const& event) {
+            return 0 == std::strcmp(event.name, name);
+        }));
+    }
+}
+
+TEST(trace, recordsNothingWhenOff) {
+    using namespace yasc;
+    trace::start();
+    trace::stop();
+    {
+        trace::Span span{"off", "test"};
+    }
+    EXPECT_TRUE(trace::events().empty());
+}
+
+TEST(trace, nestsSpans) {
+    using namespace yasc;
+    trace::start();
+    {
+        trace::Span outer{"outer", "test"};
+        trace::Span inner{"inner", "test"};
+    }
+    trace::stop();
+
+    auto events = trace::events();
+    ASSERT_EQ(events.size(), 2u);
+    auto const& outer = events[0];
+    auto const& inner = events[1];
+    EXPECT_STREQ(outer.name, "outer");
+    EXPECT_STREQ(inner.name, "inner");
+    EXPECT_EQ(outer.thread, inner.thread);
+    EXPECT_LE(outer.start, inner.start);
+    EXPECT_GE(outer.start + outer.duration, inner.start + inner.duration);
+}
+
+TEST(trace, coversParsingEvaluationPrimitivesAndCollections) {
+    using namespace yasc;
+    Evaluator evaluator;
+    trace::start();
+    {
+        gc::Region region;
+        auto ast = Parser{}("(car (list 1 2))", region);
+        auto result = gc::current_heap().escape(evaluator(ast));
+        region.release();
+        EXPECT_EQ(result, Object::fixnum(1));
+        gc::current_heap().collect_minor();
+    }
+    trace::stop();
+
+    auto events = trace::events();
+    EXPECT_EQ(count(events, "parse"), 1u);
+    EXPECT_EQ(count(events, "eval"), 1u);
+    EXPECT_EQ(count(events, "compile"), 1u);
+    EXPECT_EQ(count(events, "run"), 1u);
+    EXPECT_EQ(count(events, "list"), 1u);
+    EXPECT_EQ(count(events, "car"), 1u);
+    EXPECT_EQ(count(events, "minor gc"), 1u);
+}
+
+TEST(trace, keepsEventsBeyondARing) {
+    using namespace yasc;
+    constexpr std::size_t spans = 100000;
+    trace::start();
+    for(std::size_t i = 0; i < spans; ++i) {
+        trace::Span span{"many", "test"};
+    }
+    trace::stop();
+    EXPECT_EQ(trace::events().size(), spans);
+}
+
+TEST(trace, separatesThreads) {
+    using namespace yasc;
+    constexpr std::size_t threads = 4;
+    constexpr std::size_t spans = 20000;
+    trace::start();
+    std::vector<std::thread> workers;
+    for(std::size_t i = 0; i < threads; ++i) {
+        workers.emplace_back([] {
+            for(std::size_t j = 0; j < spans; ++j) {
+                trace::Span span{"worker", "test"};
+            }
+        });
+    }
+    for(auto& worker : workers) {
+        worker.join();
+    }
+    trace::stop();
+
+    auto events = trace::events();
+    ASSERT_EQ(events.size(), threads * spans);
+    std::vector<std::uint32_t> seen;
+    for(auto const& event : events) {
+        if(seen.empty() || seen.back() != event.thread) {
+            seen.push_back(event.thread);
+        }
+    }
+    // sorted by thread, and each thread's events were numbered apart
+    EXPECT_EQ(seen.size(), threads);
+}
+
+TEST(trace, writesChromeTraceJson) {
+    using namespace yasc;
+    trace::start();
+    trace::name_thread("main");
+    {
+        trace::Span span{"quote\"d", "test"};
+    }
+    trace::stop();
+
+    std::ostringstream o;
+    trace::write(o);
+    auto json = o.str();
+    EXPECT_EQ(0u, json.find("{\"traceEvents\":["));
+    EXPECT_NE(std::string::npos, json.find("\"name\":\"quote\\\"d\",\"cat\":\"test\",\"ph\":\"X\""));
+    EXPECT_NE(std::string::npos, json.find("\"ph\":\"M\""));
+    EXPECT_NE(std::string::npos, json.find("\"args\":{\"name\":\"main\"}"));
+    EXPECT_NE(std::string::npos, json.find("\"displayTimeUnit\":\"ns\"}"));
+}
@@ -0,0 +1,208 @@
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../parser.h"
+#include "../error.h"
+#include "../evaluator.h"
+#include "../gc/heap.h"
+#include "../ast/uvector.h"
+#include "../libscheme/simd.h"
+#include "helpers.h"
+
+namespace {
+    using yasc::simd::Op;
+    using yasc::simd::Operand;
+
+    // sizes around every vector width, so each kernel runs its main loop
+    // and its tail
+    std::vector<std::size_t> const sizes = {1, 2, 3, 7, 15, 16, 17, 31, 33, 63, 64, 65, 255, 1000, 4099};
+
+    template<typename T>
+    std::vector<T> random(std::mt19937_64& rng, std::size_t size, T lo, T hi) {
+        std::vector<T> ret(size);
+        for(auto& val : ret) {
+            if constexpr(std::is_floating_point_v<T>) {
+                val = std::uniform_real_distribution<T>{lo, hi}(rng);
+            } else {
+                val = static_cast<T>(std::uniform_int_distribution<std::int64_t>{lo, hi}(rng));
+            }
+        }
+        return ret;
+    }
+}
+
+TEST(uvector, kernelsMatchScalar) {
+    auto const& all = yasc::simd::available();
+    ASSERT_GE(all.size(), 2u);
+    auto const& ref = *all.front();
+    std::mt19937_64 rng{11};
+    for(auto size : sizes) {
+        auto f  = random<double>(rng, size, -100.0, 100.0);
+        auto g  = random<double>(rng, size, -100.0, 100.0);
+        auto s  = random<std::int64_t>(rng, size, std::numeric_limits<std::int64_t>::min(), std::numeric_limits<std::int64_t>::max());
+        auto s2 = random<std::int64_t>(rng, size, -1000000, 1000000);
+        auto u  = random<std::uint8_t>(rng, size, 0, 255);
+        auto u2 = random<std::uint8_t>(rng, size, 0, 15);
+        for(auto k : all) {
+            SCOPED_TRACE(std::string{k->name} + " size " + std::to_string(size));
+            // reassociating changes the rounding, but not by much
+            EXPECT_NEAR(k->sum_f64(f.data(), size), ref.sum_f64(f.data(), size), 1e-9 * size);
+            EXPECT_NEAR(k->dot_f64(f.data(), g.data(), size), ref.dot_f64(f.data(), g.data(), size), 1e-6 * size);
+            EXPECT_EQ(k->min_f64(f.data(), size), ref.min_f64(f.data(), size));
+            EXPECT_EQ(k->max_f64(f.data(), size), ref.max_f64(f.data(), size));
+
+            EXPECT_TRUE(k->sum_s64(s.data(), size) == ref.sum_s64(s.data(), size));
+            EXPECT_EQ(k->min_s64(s.data(), size), ref.min_s64(s.data(), size));
+            EXPECT_EQ(k->max_s64(s.data(), size), ref.max_s64(s.data(), size));
+
+            EXPECT_EQ(k->sum_u8(u.data(), size), ref.sum_u8(u.data(), size));
+            EXPECT_EQ(k->min_u8(u.data(), size), ref.min_u8(u.data(), size));
+            EXPECT_EQ(k->max_u8(u.data(), size), ref.max_u8(u.data(), size));
+
+            for(auto op : {Op::Add, Op::Sub, Op::Mul, Op::Div}) {
+                std::vector<double> out(size), expected(size);
+                k->map_f64(op, {f.data(), false}, {g.data(), false}, out.data(), size);
+                ref.map_f64(op, {f.data(), false}, {g.data(), false}, expected.data(), size);
+                EXPECT_EQ(out, expected);
+                k->map_f64(op, {f.data(), false}, {g.data(), true}, out.data(), size);
+                ref.map_f64(op, {f.data(), false}, {g.data(), true}, expected.data(), size);
+                EXPECT_EQ(out, expected);
+            }
+            for(auto op : {Op::Add, Op::Sub, Op::Mul}) {
+                std::vector<std::int64_t> out(size), expected(size);
+                EXPECT_TRUE(k->map_s64(op, {s2.data(), false}, {s2.data(), true}, out.data(), size));
+                EXPECT_TRUE(ref.map_s64(op, {s2.data(), false}, {s2.data(), true}, expected.data(), size));
+                EXPECT_EQ(out, expected);
+
+                // bytes small enough not to overflow, and minuends no
+                // smaller than the subtrahends
+                std::vector<std::uint8_t> bytes(size), expected_bytes(size), lhs(u2);
+                if(Op::Sub == op) {
+                    for(auto i = std::size_t{0}; i < size; ++i) {
+                        lhs[i] = std::max(u[i], u2[i]);
+                    }
+                }
+                EXPECT_TRUE(k->map_u8(op, {lhs.data(), false}, {u2.data(), false}, bytes.data(), size));
+                EXPECT_TRUE(ref.map_u8(op, {lhs.data(), false}, {u2.data(), false}, expected_bytes.data(), size));
+                EXPECT_EQ(bytes, expected_bytes);
+            }
+        }
+    }
+}
+
+TEST(uvector, exactKernelsDetectOverflow) {
+    constexpr auto max = std::numeric_limits<std::int64_t>::max();
+    constexpr auto min = std::numeric_limits<std::int64_t>::min();
+    for(auto k : yasc::simd::available()) {
+        SCOPED_TRACE(k->name);
+        for(auto size : sizes) {
+            // the offending element is last, so it lands in the tail or in
+            // the last full vector depending on the size
+            std::vector<std::int64_t> s(size, 1), out(size);
+            std::vector<std::uint8_t> u(size, 1), bytes(size);
+            s.back() = max;
+            u.back() = 255;
+            std::int64_t one = 1, two = 2;
+            std::uint8_t uone = 1, utwo = 2;
+            EXPECT_FALSE(k->map_s64(Op::Add, {s.data(), false}, {&one, true}, out.data(), size));
+            EXPECT_FALSE(k->map_s64(Op::Mul, {s.data(), false}, {&two, true}, out.data(), size));
+            EXPECT_FALSE(k->map_u8(Op::Add, {u.data(), false}, {&uone, true}, bytes.data(), size));
+            EXPECT_FALSE(k->map_u8(Op::Mul, {u.data(), false}, {&utwo, true}, bytes.data(), size));
+            EXPECT_FALSE(k->map_u8(Op::Sub, {&uone, true}, {u.data(), false}, bytes.data(), size));
+            s.back() = min;
+            EXPECT_FALSE(k->map_s64(Op::Sub, {s.data(), false}, {&one, true}, out.data(), size));
+            EXPECT_TRUE(k->map_s64(Op::Add, {s.data(), false}, {&one, true}, out.data(), size));
+            EXPECT_EQ(out.back(), min + 1);
+        }
+    }
+}
+
+TEST(uvector, exactSums) {
+    constexpr auto max = std::numeric_limits<std::int64_t>::max();
+    constexpr auto min = std::numeric_limits<std::int64_t>::min();
+    for(auto k : yasc::simd::available()) {
+        SCOPED_TRACE(k->name);
+        std::vector<std::int64_t> highs(1001, max), lows(1001, min);
+        EXPECT_TRUE(k->sum_s64(highs.data(), highs.size()) == static_cast<__int128>(max) * 1001);
+        EXPECT_TRUE(k->sum_s64(lows.data(), lows.size()) == static_cast<__int128>(min) * 1001);
+        std::vector<std::uint8_t> bytes(100000, 255);
+        EXPECT_EQ(k->sum_u8(bytes.data(), bytes.size()), 255u * 100000);
+        EXPECT_EQ(k->sum_f64(nullptr, 0), 0.0);
+        EXPECT_EQ(k->product_f64(nullptr, 0), 1.0);
+    }
+}
+
+TEST(uvector, primitives) {
+    EXPECT_EQ(eval("(u8vector 1 2 255)"), "#u8(1 2 255)");
+    EXPECT_EQ(eval("(make-s64vector 3 -7)"), "#s64(-7 -7 -7)");
+    EXPECT_EQ(eval("(f64vector 1 1/2 2.5)"), "#f64(1.0 0.5 2.5)");
+    EXPECT_EQ(eval("(s64vector-length (make-s64vector 5))"), "5");
+    EXPECT_EQ(eval("(s64vector-ref (s64vector 4 5 6) 2)"), "6");
+    EXPECT_EQ(eval("(s64vector-ref (s64vector 9223372036854775807) 0)"), "9223372036854775807");
+    EXPECT_EQ(eval("((lambda (v) (u8vector-set! v 0 9) v) (make-u8vector 2))"), "#u8(9 0)");
+    EXPECT_THROW(eval("(u8vector 256)"), yasc::Error);
+    EXPECT_THROW(eval("(s64vector 1.5)"), yasc::Error);
+    EXPECT_THROW(eval("(u8vector-ref (u8vector 1) 1)"), yasc::Error);
+    EXPECT_THROW(eval("(u8vector-length (s64vector 1))"), yasc::Error);
+}
+
+TEST(uvector, wrongKindIsAnError) {
+    using namespace yasc;
+    // each typed primitive takes its own kind of vector only
+    for(auto [call, message] : {std::pair{"(u8vector-ref (f64vector 1.5) 0)", "u8vector-ref: expects a u8vector"},
+                                std::pair{"(s64vector-set! (u8vector 1) 0 2)", "s64vector-set!: expects a s64vector"},
+                                std::pair{"(f64vector-length (s64vector 1 2))", "f64vector-length: expects a f64vector"}}) {
+        try {
+            eval(call);
+            ADD_FAILURE() << call;
+        } catch(Error const& err) {
+            EXPECT_STREQ(err.what(), message);
+        }
+    }
+
+    // and a cast tells the kinds apart as well
+    auto f64 = make_object<F64Vector>(std::size_t{2}, 1.5);
+    auto u8  = make_object<U8Vector>(std::size_t{2});
+    EXPECT_TRUE(detail::check_type<F64Vector>(*f64));
+    EXPECT_FALSE(detail::check_type<U8Vector>(*f64));
+    EXPECT_FALSE(detail::check_type<S64Vector>(*f64));
+    EXPECT_TRUE(detail::check_type<U8Vector>(*u8));
+    EXPECT_FALSE(detail::check_type<F64Vector>(*u8));
+}
+
+TEST(uvector, elementwiseArithmetic) {
+    EXPECT_EQ(eval("(+ (s64vector 1 2) (s64vector 3 4))"), "#s64(4 6)");
+    EXPECT_EQ(eval("(* 2 (f64vector 1.5 -2))"), "#f64(3.0 -4.0)");
+    EXPECT_EQ(eval("(- (u8vector 10 20) 5)"), "#u8(5 15)");
+    EXPECT_EQ(eval("(+ (u8vector 1 2) 1000)"), "#s64(1001 1002)");
+    EXPECT_EQ(eval("(+ (u8vector 1 2) (f64vector 0.5 0.5))"), "#f64(1.5 2.5)");
+    EXPECT_EQ(eval("(/ (s64vector 1 3) 2)"), "#f64(0.5 1.5)");
+    EXPECT_EQ(eval("(- (s64vector 1 -2))"), "#s64(-1 2)");
+    EXPECT_EQ(eval("(+ (s64vector 1) (s64vector 2) (s64vector 3))"), "#s64(6)");
+    EXPECT_THROW(eval("(+ (u8vector 200) (u8vector 100))"), yasc::Error);
+    EXPECT_THROW(eval("(* (s64vector 9223372036854775807) 2)"), yasc::Error);
+    EXPECT_THROW(eval("(+ (s64vector 1 2) (s64vector 1))"), yasc::Error);
+    EXPECT_THROW(eval("(+ (s64vector 1) 1/2)"), yasc::Error);
+    EXPECT_THROW(eval("(< (s64vector 1) (s64vector 2))"), yasc::Error);
+}
+
+TEST(uvector, reductions) {
+    EXPECT_EQ(eval("(uvector-sum (u8vector 255 255 255))"), "765");
+    EXPECT_EQ(eval("(uvector-sum (s64vector 9223372036854775807 9223372036854775807))"), "18446744073709551614");
+    EXPECT_EQ(eval("(uvector-sum (f64vector 0.5 0.25))"), "0.75");
+    EXPECT_EQ(eval("(uvector-product (s64vector 4294967296 4294967296 2))"), "36893488147419103232");
+    EXPECT_EQ(eval("(uvector-min (s64vector 3 -1 2))"), "-1");
+    EXPECT_EQ(eval("(uvector-max (u8vector 3 9 2))"), "9");
+    EXPECT_EQ(eval("(uvector-dot (s64vector 1 2 3) (u8vector 4 5 6))"), "32");
+    EXPECT_EQ(eval("(uvector-dot (f64vector 0.5 2) (s64vector 2 3))"), "7.0");
+    EXPECT_EQ(eval("(uvector-dot (s64vector 9223372036854775807 9223372036854775807) (s64vector 2 2))"),
+              "36893488147419103228");
+    EXPECT_THROW(eval("(uvector-min (f64vector))"), yasc::Error);
+    EXPECT_THROW(eval("(uvector-dot (s64vector 1) (s64vector 1 2))"), yasc::Error);
+}
@@ -0,0 +1,399 @@
+#include <cstddef>
+#include <sstream>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "../parser.h"
+#include "../error.h"
+#include "../evaluator.h"
+#include "../repl.h"
+#include "../gc/heap.h"
+#include "../ast/list.h"
+#include "../ast/identifier.h"
+#include "../ast/symbol.h"
+#include "helpers.h"
+
+TEST(vm, matchesAstWalker) {
+    using yasc::Evaluator;
+    for(auto prog : {"(+ 1 2 (* 4 5 (- 8 9)))", "(- 10 2 3)", "(/ 100 5 2)", "42", "#t"}) {
+        EXPECT_EQ(eval(prog), eval(prog, Evaluator::Mode::Ast)) << prog;
+    }
+}
+
+TEST(vm, lambdaAndCall) {
+    EXPECT_EQ(eval("((lambda (x y) (+ x y)) 1 2)"), "3");
+    EXPECT_EQ(eval("((lambda () 7))"), "7");
+    EXPECT_EQ(eval("((lambda (f) (f 2 3)) *)"), "6");
+    EXPECT_EQ(eval("((lambda (x) 1 2 x) 5)"), "5");
+}
+
+TEST(vm, ifAndQuote) {
+    EXPECT_EQ(eval("(if #t 1 2)"), "1");
+    EXPECT_EQ(eval("(if #f 1 2)"), "2");
+    EXPECT_EQ(eval("(+ 1 (if #f 1 2))"), "3");
+    EXPECT_EQ(eval("(if #f 1)"), "");
+    EXPECT_EQ(eval("(quote (a b))"), "(a b)");
+    // special forms are only special while they are not shadowed
+    EXPECT_EQ(eval("((lambda (if) (if 1 2)) +)"), "3");
+}
+
+TEST(vm, tailCallsRunInConstantStack) {
+    // a chain of a million nested tail calls through a lambda passed to itself
+    EXPECT_EQ(eval("((lambda (f) (f f 1000000)) "
+                   "(lambda (self n) (if n (self self #f) 9)))"), "9");
+}
+
+TEST(vm, reportsErrors) {
+    EXPECT_THROW(eval("((lambda (x) x))"), yasc::Error);
+    EXPECT_THROW(eval("(undefined 1)"), yasc::Error);
+    EXPECT_THROW(eval("(1 2)"), yasc::Error);
+}
+
+TEST(vm, numericTower) {
+    EXPECT_EQ(eval("(* 99999999999 99999999999 99999999999)"), "999999999970000000000299999999999");
+    EXPECT_EQ(eval("(- (* 4611686018427387903 2) 4611686018427387903)"), "4611686018427387903");
+    EXPECT_EQ(eval("(quotient 100000000000000000000000 7)"), "14285714285714285714285");
+    EXPECT_EQ(eval("(+ 1 2.5)"), "3.5");
+    EXPECT_EQ(eval("(- 5)"), "-5");
+    EXPECT_EQ(eval("(< 1 2 3)"), "#t");
+    EXPECT_EQ(eval("(< 1 3 2)"), "#f");
+    EXPECT_EQ(eval("(= 100000000000000000000 100000000000000000000)"), "#t");
+}
+
+TEST(vm, flatClosuresCaptureByValue) {
+    EXPECT_EQ(eval("(((lambda (x) (lambda (y) (+ x y))) 1) 2)"), "3");
+    // z is captured through the middle lambda, which never mentions it
+    EXPECT_EQ(eval("((((lambda (x z) (lambda (y) (lambda () (- x y z)))) 10 1) 2))"), "7");
+    // a captured variable shadowed by a parameter resolves to the parameter
+    EXPECT_EQ(eval("(((lambda (x) (lambda (x) x)) 1) 2)"), "2");
+}
+
+TEST(vm, globalsAreIndexed) {
+    using namespace yasc;
+    auto ctx = Evaluator::get_scheme_context();
+    auto slot = ctx.slot("+");
+    EXPECT_EQ(ctx.slot("+"), slot);
+    EXPECT_EQ(ctx.name(slot).name(), "+");
+
+    // mentioning an unknown name reserves an unbound slot for it
+    auto size = ctx.size();
+    EXPECT_TRUE(ctx.at(ctx.slot("nope")).is_null());
+    EXPECT_EQ(ctx.size(), size + 1);
+    EXPECT_THROW(static_cast<Context const&>(ctx).at(Symbol::intern("nope")), Error);
+
+    // only binding a slot moves the version on, reading it does not
+    auto version = ctx.version();
+    EXPECT_FALSE(ctx.at(slot).is_null());
+    EXPECT_EQ(ctx.version(), version);
+    ctx.set(ctx.slot("nope"), Object::fixnum(1));
+    EXPECT_GT(ctx.version(), version);
+    EXPECT_EQ(ctx.at(ctx.slot("nope")).as_fixnum(), 1);
+}
+
+TEST(vm, closuresSurviveCollections) {
+    using namespace yasc;
+    gc::Config config;
+    config.nursery_size = 64 << 10;
+    config.chunk_size   = 16 << 10;
+    gc::Heap heap{config};
+    gc::HeapScope scope{heap};
+
+    auto ctx = Evaluator::get_scheme_context();
+    ctx["positive?"] = make_object<Procedure>([] (Object const& args) {
+        return Object::boolean(value_cast<Pair*>(args)->car().as_fixnum() > 0);
+    });
+
+    // builds a chain of 20000 closures, each capturing the previous one, while
+    // the collector moves them out of the nursery
+    gc::Region region;
+    auto ast = Parser{}("((lambda (f) (f f 20000 (lambda () 3))) "
+                        "(lambda (self n k) (if (positive? n) (self self (- n 1) (lambda () (+ (k) 0))) (k))))", region);
+    auto result = Evaluator{}(ast, ctx);
+    region.release();
+
+    EXPECT_EQ(result, Object::fixnum(3));
+    EXPECT_GT(heap.stats().minor.collections, 0u);
+}
+
+TEST(vm, definitionsPersist) {
+    yasc::Evaluator evaluator;
+    EXPECT_EQ(eval_in(evaluator, "(define x 5)"), "");
+    EXPECT_EQ(eval_in(evaluator, "x"), "5");
+    EXPECT_EQ(eval_in(evaluator, "(define (square n) (* n n))"), "");
+    EXPECT_EQ(eval_in(evaluator, "(square x)"), "25");
+    EXPECT_EQ(eval_in(evaluator, "(set! x 6)"), "");
+    EXPECT_EQ(eval_in(evaluator, "(square x)"), "36");
+    EXPECT_EQ(eval_in(evaluator, "(define (fact n) (if (< n 2) 1 (* n (fact (- n 1)))))"), "");
+    EXPECT_EQ(eval_in(evaluator, "(fact 25)"), "15511210043330985984000000");
+    EXPECT_EQ(eval_in(evaluator, "square"), "[closure square]");
+
+    // code refers to the global, not to the value it had when compiled
+    eval_in(evaluator, "(define (f) (g))");
+    EXPECT_THROW(eval_in(evaluator, "(f)"), yasc::Error);
+    eval_in(evaluator, "(define (g) 1)");
+    EXPECT_EQ(eval_in(evaluator, "(f)"), "1");
+    eval_in(evaluator, "(define (g) 2)");
+    EXPECT_EQ(eval_in(evaluator, "(f)"), "2");
+    eval_in(evaluator, "(define + -)");
+    EXPECT_EQ(eval_in(evaluator, "(+ 5 3)"), "2");
+
+    // another evaluator has an environment of its own
+    yasc::Evaluator other;
+    EXPECT_THROW(eval_in(other, "x"), yasc::Error);
+    EXPECT_EQ(eval_in(other, "(+ 5 3)"), "8");
+}
+
+TEST(vm, definitionErrors) {
+    yasc::Evaluator evaluator;
+    EXPECT_THROW(eval_in(evaluator, "(set! nope 1)"), yasc::Error);
+    EXPECT_THROW(eval_in(evaluator, "((lambda () (define y 1) y))"), yasc::Error);
+    EXPECT_THROW(eval_in(evaluator, "((lambda (a) (set! a 1)) 2)"), yasc::Error);
+    EXPECT_THROW(eval_in(evaluator, "(define 1 2)"), yasc::Error);
+    EXPECT_THROW(eval_in(evaluator, "(define (1 a) a)"), yasc::Error);
+    EXPECT_THROW(eval_in(evaluator, "(define x)"), yasc::Error);
+}
+
+TEST(vm, namedLetNameCannotBeAssigned) {
+    yasc::Evaluator evaluator;
+    eval_in(evaluator, "(define loop 1)");
+    try {
+        eval_in(evaluator, "(let loop ((i 0)) (set! loop 5) i)");
+        FAIL();
+    } catch(yasc::Error const& err) {
+        EXPECT_NE(std::string{err.what()}.find("cannot assign the local variable `loop'"), std::string::npos);
+    }
+    // the global of the same name is left alone
+    EXPECT_EQ(eval_in(evaluator, "loop"), "1");
+    // and so is it from a lambda nested in the loop
+    EXPECT_THROW(eval_in(evaluator, "(let loop ((i 0)) ((lambda () (set! loop 5))))"), yasc::Error);
+    EXPECT_EQ(eval_in(evaluator, "loop"), "1");
+}
+
+TEST(vm, codeRelinksInAnotherEnvironment) {
+    using namespace yasc;
+    Evaluator first, second;
+    eval_in(first, "(define (seven) (+ 3 4))");
+    eval_in(second, "(define + *)");
+    // the closure made in the first environment now runs in the second,
+    // so it must look its globals up there
+    auto closure = first.globals()["seven"];
+    second.globals()["seven"] = closure;
+    EXPECT_EQ(eval_in(second, "(seven)"), "12");
+    EXPECT_EQ(eval_in(first, "(seven)"), "7");
+}
+
+TEST(vm, globalsSurviveCollections) {
+    using namespace yasc;
+    gc::Config config;
+    config.nursery_size = 64 << 10;
+    config.chunk_size   = 16 << 10;
+    gc::Heap heap{config};
+    gc::HeapScope scope{heap};
+
+    Evaluator evaluator;
+    eval_in(evaluator, "(define data (quote (1 2 3)))");
+    eval_in(evaluator, "(define (adder n) (lambda (x) (+ x n)))");
+    eval_in(evaluator, "(define add3 (adder 3))");
+    for(auto i = 0; i < 2000; ++i) {
+        eval_in(evaluator, "((lambda (l) (adder l)) (quote (a b c d e f g h)))");
+    }
+    EXPECT_GT(heap.stats().minor.collections, 0u);
+    EXPECT_EQ(eval_in(evaluator, "data"), "(1 2 3)");
+    EXPECT_EQ(eval_in(evaluator, "(add3 4)"), "7");
+}
+
+TEST(vm, replKeepsDefinitions) {
+    using namespace yasc;
+    std::istringstream in{"(define (twice x) (* 2 x))\n(define y 21)\n(twice y)\n:q\n"};
+    std::ostringstream out;
+    Repl{Parser{}, Evaluator{}, in, out}.run();
+    EXPECT_NE(std::string::npos, out.str().find("42\n"));
+}
+
+TEST(vm, quickenedCallsMatchGenericOnes) {
+    using yasc::Evaluator;
+    // each site sees one level of the tower after the other, some of them
+    // overflowing into the next
+    auto const operands = {"1 2", "4611686018427387903 4611686018427387903", "2.5 1.5",
+                           "1/3 1/6", "100000000000000000000 3", "7 2.5", "-3 7"};
+    for(auto op : {"+", "-", "*", "/", "quotient", "<", "=", ">="}) {
+        Evaluator quick{Evaluator::Mode::Quickening}, generic{Evaluator::Mode::Bytecode};
+        auto define = std::string{"(define (f a b) ("} + op + " a b))";
+        eval_in(quick, define);
+        eval_in(generic, define);
+        for(auto args : operands) {
+            auto call = std::string{"(f "} + args + ")";
+            for(auto i = 0; i < 3; ++i) {
+                std::string expected, got;
+                try { expected = eval_in(generic, call); } catch(yasc::Error const& e) { expected = e.what(); }
+                try { got = eval_in(quick, call); } catch(yasc::Error const& e) { got = e.what(); }
+                EXPECT_EQ(got, expected) << op << " " << args;
+            }
+        }
+    }
+}
+
+TEST(vm, quickeningCountsHitsAndMisses) {
+    using yasc::Evaluator;
+    Evaluator evaluator;
+    eval_in(evaluator, "(define (sum n acc) (if (= n 0) acc (sum (- n 1) (+ acc n))))");
+    EXPECT_EQ(eval_in(evaluator, "(sum 1000 0)"), "500500");
+    auto stats = evaluator.quickening();
+    // `=', `-' and `+' quicken on their first call and then always hit
+    EXPECT_EQ(stats.quickened, 3u);
+    EXPECT_EQ(stats.hits, 1000u + 999u + 999u);
+    EXPECT_EQ(stats.misses, 0u);
+
+    // adding fixnums to a real misses once at `+', which stays generic
+    // while its operands are mixed
+    EXPECT_EQ(eval_in(evaluator, "(sum 10 0.5)"), "55.5");
+    stats = evaluator.quickening();
+    EXPECT_EQ(stats.misses, 1u);
+    EXPECT_EQ(stats.quickened, 3u);
+
+    // calling another primitive through a site misses, and quickens it again
+    eval_in(evaluator, "(define (apply2 f a b) (f a b))");
+    EXPECT_EQ(eval_in(evaluator, "(apply2 + 1 2)"), "3");
+    EXPECT_EQ(eval_in(evaluator, "(apply2 * 3 4)"), "12");
+    EXPECT_EQ(evaluator.quickening().misses, 2u);
+    EXPECT_EQ(evaluator.quickening().quickened, 5u);
+
+    // a site that keeps flipping gives up after a few rewrites
+    for(auto i = 0; i < 20; ++i) {
+        eval_in(evaluator, (i % 2) ? "(apply2 + 1 2)" : "(apply2 + 1.5 2.5)");
+    }
+    EXPECT_LT(evaluator.quickening().quickened, 10u);
+
+    Evaluator generic{Evaluator::Mode::Bytecode};
+    EXPECT_EQ(eval_in(generic, "((lambda (a) (+ a 1)) 2)"), "3");
+    EXPECT_EQ(generic.quickening().quickened, 0u);
+}
+
+TEST(vm, letAndNamedLet) {
+    EXPECT_EQ(eval("(let ((x 1) (y 2)) (+ x y))"), "3");
+    EXPECT_EQ(eval("(let () 5)"), "5");
+    // the inits do not see the variables
+    EXPECT_EQ(eval("((lambda (x) (let ((x 10) (y x)) (- x y))) 1)"), "9");
+    EXPECT_EQ(eval("(let ((+ -)) (+ 1 2))"), "-1");
+    EXPECT_EQ(eval("(let loop ((i 0) (acc 0)) (if (= i 10) acc (loop (+ i 1) (+ acc i))))"), "45");
+    EXPECT_EQ(eval("(let loop () 7)"), "7");
+    // a closure made in the loop body can call the loop
+    EXPECT_EQ(eval("(let count ((n 3)) (if (= n 0) 0 ((lambda () (+ 1 (count (- n 1)))))))"), "3");
+    // the loop's name shadows a global, but not its own inits
+    EXPECT_EQ(eval("(let + ((a (+ 1 1))) a)"), "2");
+    EXPECT_THROW(eval("(let ((x)) x)"), yasc::Error);
+    EXPECT_THROW(eval("(let loop)"), yasc::Error);
+}
+
+TEST(vm, namedLetLoopsInConstantSpace) {
+    EXPECT_EQ(eval("(let loop ((i 0)) (if (= i 10000000) i (loop (+ i 1))))"), "10000000");
+}
+
+TEST(vm, deepRecursionIsAnError) {
+    using yasc::Evaluator;
+    Evaluator evaluator;
+    eval_in(evaluator, "(define (depth n) (if (= n 0) 0 (+ 1 (depth (- n 1)))))");
+    EXPECT_EQ(eval_in(evaluator, "(depth 100000)"), "100000");
+
+    evaluator.set_max_depth(1000);
+    EXPECT_EQ(eval_in(evaluator, "(depth 900)"), "900");
+    EXPECT_THROW(eval_in(evaluator, "(depth 2000)"), yasc::Error);
+    // the stack is unwound, and tail calls never count
+    EXPECT_EQ(eval_in(evaluator, "(depth 10)"), "10");
+    EXPECT_EQ(eval_in(evaluator, "(let loop ((i 0)) (if (= i 5000) i (loop (+ i 1))))"), "5000");
+}
+
+TEST(vm, deepNestingIsAnError) {
+    using namespace yasc;
+    auto nested = [] (std::size_t n) {
+        std::string ret;
+        for(std::size_t i = 0; i < n; ++i) {
+            ret += "(+ 1 ";
+        }
+        return ret + "0" + std::string(n, ')');
+    };
+    for(auto mode : {Evaluator::Mode::Quickening, Evaluator::Mode::Ast}) {
+        EXPECT_EQ(eval(nested(max_nesting), mode), std::to_string(max_nesting));
+    }
+    Evaluator unoptimized{Evaluator::Mode::Quickening, 0};
+    EXPECT_EQ(eval_in(unoptimized, nested(max_nesting)), std::to_string(max_nesting));
+    EXPECT_THROW(eval(nested(max_nesting + 1)), Error);
+    EXPECT_THROW(eval(nested(30000)), Error);
+    EXPECT_THROW(eval("(quote " + std::string(200000, '(') + std::string(200000, ')') + ")"), Error);
+
+    // forms built elsewhere are held to the same bounds by the passes
+    // over them
+    auto built = [] (std::size_t n) {
+        gc::Root form{Object::fixnum(0)};
+        for(std::size_t i = 0; i < n; ++i) {
+            auto list = make_object<List>();
+            value_cast<List*>(list)->push_back(make_object<Identifier>(Symbol::intern("+")));
+            value_cast<List*>(list)->push_back(Object::fixnum(1));
+            value_cast<List*>(list)->push_back(form.get());
+            form = list;
+        }
+        return form.get();
+    };
+    EXPECT_EQ(print(Evaluator{}(built(max_nesting))), std::to_string(max_nesting));
+    EXPECT_THROW(Evaluator{}(built(max_nesting + 1)), Error);
+    EXPECT_THROW(unoptimized(built(2 * max_nesting + 1)), Error);
+    EXPECT_EQ(eval_in(unoptimized, "(+ 1 1)"), "2");
+    gc::safepoint();
+
+    // data built while running may nest deeper, and still prints
+    auto deep = eval("(let loop ((i 0) (x (quote ()))) (if (= i 100000) x (loop (+ i 1) (cons x (quote ())))))");
+    EXPECT_EQ(deep.size(), 100000 * 2 + 2);
+    EXPECT_EQ(deep.substr(0, 4), "((((");
+}
+
+TEST(vm, listPrimitives) {
+    EXPECT_EQ(eval("(cons 1 2)"), "(1 . 2)");
+    EXPECT_EQ(eval("(cons 1 (cons 2 (quote ())))"), "(1 2)");
+    EXPECT_EQ(eval("(car (quote (a b)))"), "a");
+    EXPECT_EQ(eval("(cdr (quote (a b)))"), "(b)");
+    EXPECT_EQ(eval("(list 1 (+ 1 1) (quote c))"), "(1 2 c)");
+    EXPECT_EQ(eval("(null? (cdr (list 1)))"), "#t");
+    EXPECT_EQ(eval("(pair? (quote ()))"), "#f");
+    EXPECT_EQ(eval("(eq? (quote a) (car (quote (a))))"), "#t");
+    EXPECT_EQ(eval("(not (eq? (quote a) (quote b)))"), "#t");
+    EXPECT_THROW(eval("(car 1)"), yasc::Error);
+}
+
+TEST(vm, quotedDataOutliveTheirForm) {
+    using yasc::Evaluator;
+    Evaluator evaluator;
+    eval_in(evaluator, "(define (syms) (quote (alpha (beta 2.5) gamma)))");
+    // the form above has been released, and its memory handed to these
+    for(auto i = 0; i < 100; ++i) {
+        eval_in(evaluator, "(quote (delta epsilon zeta eta theta))");
+    }
+    EXPECT_EQ(eval_in(evaluator, "(syms)"), "(alpha (beta 2.5) gamma)");
+    EXPECT_EQ(eval_in(evaluator, "(car (cdr (syms)))"), "(beta 2.5)");
+}
+
+TEST(vm, heapStats) {
+    using namespace yasc;
+    gc::Heap heap;
+    gc::HeapScope scope{heap};
+    Evaluator evaluator;
+
+    eval_in(evaluator, "(define xs (list 1.5 2.5 3.5))");
+    auto stats = eval_in(evaluator, "(heap-stats)");
+    EXPECT_EQ("heap", eval_in(evaluator, "(car (car (heap-stats)))"));
+    EXPECT_NE(std::string::npos, stats.find("(peak . "));
+    EXPECT_NE(std::string::npos, stats.find("(allocations . "));
+    EXPECT_NE(std::string::npos, stats.find("(types (number "));
+    EXPECT_NE(std::string::npos, stats.find("(pair "));
+}
+
+TEST(vm, replReportsMemory) {
+    using namespace yasc;
+    std::istringstream in{"(define xs (list 1 2 3))\n,mem\n:q\n"};
+    std::ostringstream out;
+    Repl{Parser{}, Evaluator{}, in, out}.run();
+    auto report = out.str();
+    EXPECT_NE(std::string::npos, report.find("MB/s"));
+    EXPECT_NE(std::string::npos, report.find("live bytes"));
+    EXPECT_NE(std::string::npos, report.find("\npair "));
+}
@@ -0,0 +1,217 @@
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <utility>
+
+#include "trace.h"
+
+namespace {
+    using yasc::trace::Event;
+
+    // events a thread holds before its ring has to be drained
+    constexpr std::size_t capacity = std::size_t{1} << 14;
+
+    // a thread's events, pushed by the thread alone and taken out by
+    // whoever holds the registry's lock
+    struct Ring {
+        explicit Ring(std::uint32_t thread)
+            : thread{thread}
+            , name{"thread " + std::to_string(thread)}
+            , events{new Event[capacity]}
+        {}
+
+        std::uint32_t const thread;
+        std::string name;
+        std::unique_ptr<Event[]> const events;
+        std::atomic<std::size_t> head{0}; // the next slot the thread writes
+        std::atomic<std::size_t> tail{0}; // the next slot to be drained
+    };
+
+    struct Registry {
+        std::mutex lock;
+        std::vector<std::shared_ptr<Ring>> rings; // outlive their threads
+        std::vector<Event> recorded;
+    };
+
+    Registry& registry() {
+        static Registry registry;
+        return registry;
+    }
+
+    std::atomic<std::int64_t> epoch{0};
+
+    std::int64_t ticks() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    Ring& ring() {
+        thread_local std::shared_ptr<Ring> mine;
+        if(nullptr == mine) {
+            auto& reg = registry();
+            std::lock_guard<std::mutex> guard{reg.lock};
+            mine = std::make_shared<Ring>(static_cast<std::uint32_t>(reg.rings.size() + 1));
+            reg.rings.push_back(mine);
+        }
+        return *mine;
+    }
+
+    // moves what `ring' holds into the record. the registry must be locked
+    void drain(Registry& reg, Ring& ring) {
+        auto head = ring.head.load(std::memory_order_acquire);
+        auto tail = ring.tail.load(std::memory_order_relaxed);
+        for(; tail != head; ++tail) {
+            reg.recorded.push_back(ring.events[tail % capacity]);
+        }
+        ring.tail.store(tail, std::memory_order_release);
+    }
+
+    void append_string(std::string& out, std::string_view str) {
+        static constexpr char hex[] = "0123456789abcdef";
+        out += '"';
+        for(auto c : str) {
+            auto u = static_cast<unsigned char>(c);
+            if('"' == c || '\\' == c) {
+                out += '\\';
+                out += c;
+            } else if(u < 0x20) {
+                out += "\\u00";
+                out += hex[u >> 4];
+                out += hex[u & 0xf];
+            } else {
+                out += c;
+            }
+        }
+        out += '"';
+    }
+
+    void append_number(std::string& out, std::uint64_t n) {
+        char buf[24];
+        auto end = std::to_chars(buf, buf + sizeof(buf), n).ptr;
+        out.append(buf, end);
+    }
+
+    // nanoseconds as microseconds, which the format counts in
+    void append_micros(std::string& out, std::int64_t ns) {
+        if(ns < 0) {
+            out += '-';
+            ns = -ns;
+        }
+        append_number(out, static_cast<std::uint64_t>(ns) / 1000);
+        auto frac = static_cast<unsigned>(static_cast<std::uint64_t>(ns) % 1000);
+        char digits[] = {'.', static_cast<char>('0' + frac / 100),
+            static_cast<char>('0' + frac / 10 % 10), static_cast<char>('0' + frac % 10)};
+        out.append(digits, sizeof(digits));
+    }
+}
+
+namespace yasc {
+    namespace trace {
+        std::int64_t detail::now() {
+            return ticks() - epoch.load(std::memory_order_relaxed);
+        }
+
+        void detail::record(char const* name, char const* category, std::int64_t start) {
+            auto end = now();
+            auto& mine = ring();
+            auto head = mine.head.load(std::memory_order_relaxed);
+            if(head - mine.tail.load(std::memory_order_acquire) == capacity) {
+                auto& reg = registry();
+                std::lock_guard<std::mutex> guard{reg.lock};
+                drain(reg, mine);
+            }
+            mine.events[head % capacity] = Event{name, category, mine.thread, start, end - start};
+            mine.head.store(head + 1, std::memory_order_release);
+        }
+
+        void start() {
+            auto& reg = registry();
+            std::lock_guard<std::mutex> guard{reg.lock};
+            for(auto& ring : reg.rings) {
+                ring->tail.store(ring->head.load(std::memory_order_acquire), std::memory_order_release);
+            }
+            reg.recorded.clear();
+            epoch.store(ticks(), std::memory_order_relaxed);
+            detail::enabled.store(true, std::memory_order_release);
+        }
+
+        void stop() {
+            detail::enabled.store(false, std::memory_order_release);
+        }
+
+        void name_thread(std::string name) {
+            auto& mine = ring();
+            std::lock_guard<std::mutex> guard{registry().lock};
+            mine.name = std::move(name);
+        }
+
+        std::vector<Event> events() {
+            auto& reg = registry();
+            std::vector<Event> ret;
+            {
+                std::lock_guard<std::mutex> guard{reg.lock};
+                for(auto& ring : reg.rings) {
+                    drain(reg, *ring);
+                }
+                ret = reg.recorded;
+            }
+            std::stable_sort(ret.begin(), ret.end(), [] (Event const& a, Event const& b) {
+                return (a.thread != b.thread) ? a.thread < b.thread : a.start < b.start;
+            });
+            return ret;
+        }
+
+        void write(std::ostream& o) {
+            auto const recorded = events();
+            std::vector<std::pair<std::uint32_t, std::string>> threads;
+            {
+                auto& reg = registry();
+                std::lock_guard<std::mutex> guard{reg.lock};
+                for(auto const& ring : reg.rings) {
+                    threads.emplace_back(ring->thread, ring->name);
+                }
+            }
+
+            // a trace runs to millions of events, so they are formatted by
+            // hand into a buffer written out a block at a time
+            std::string out = "{\"traceEvents\":[";
+            auto first = true;
+            auto separate = [&] {
+                out += first ? "\n" : ",\n";
+                first = false;
+                if(out.size() >= (std::size_t{1} << 16)) {
+                    o.write(out.data(), static_cast<std::streamsize>(out.size()));
+                    out.clear();
+                }
+            };
+            for(auto const& [thread, name] : threads) {
+                separate();
+                out += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":";
+                append_number(out, thread);
+                out += ",\"args\":{\"name\":";
+                append_string(out, name);
+                out += "}}";
+            }
+            for(auto const& event : recorded) {
+                separate();
+                out += "{\"name\":";
+                append_string(out, event.name);
+                out += ",\"cat\":";
+                append_string(out, event.category);
+                out += ",\"ph\":\"X\",\"pid\":1,\"tid\":";
+                append_number(out, event.thread);
+                out += ",\"ts\":";
+                append_micros(out, event.start);
+                out += ",\"dur\":";
+                append_micros(out, event.duration);
+                out += '}';
+            }
+            out += "\n],\"displayTimeUnit\":\"ns\"}\n";
+            o.write(out.data(), static_cast<std::streamsize>(out.size()));
+            o.flush();
+        }
+    };
+};
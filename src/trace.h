@@ -0,0 +1,85 @@
+#ifndef __YASC_TRACE_H_
+#define __YASC_TRACE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace yasc {
+    // a timeline of what the interpreter did: spans around parsing, each top
+    // level form, primitive calls and collections, written out in the Chrome
+    // Trace format that chrome://tracing and Perfetto load.
+    //
+    // tracing is always compiled in and off until start(). while it is off a
+    // Span costs a relaxed load and a branch. while it is on, each thread
+    // records into a ring of its own without locking; a full ring is drained
+    // into the shared record under a lock, as are all of them by write()
+    namespace trace {
+        struct Event {
+            // static strings, which are never copied
+            char const*   name;
+            char const*   category;
+            std::uint32_t thread;   // numbered from 1 in the order they first traced
+            std::int64_t  start;    // nanoseconds since start()
+            std::int64_t  duration; // likewise
+        };
+
+        namespace detail {
+            inline std::atomic<bool> enabled{false};
+
+            std::int64_t now();
+            void record(char const* name, char const* category, std::int64_t start);
+        };
+
+        inline bool enabled() {
+            return detail::enabled.load(std::memory_order_relaxed);
+        }
+
+        // starts recording afresh, dropping what was recorded before
+        void start();
+
+        // stops recording; what was recorded is kept until the next start()
+        void stop();
+
+        // names this thread in the trace, eg. for a pool's workers
+        void name_thread(std::string name);
+
+        // every event recorded so far, by thread and then start
+        std::vector<Event> events();
+
+        // the events recorded so far, as Chrome Trace JSON
+        void write(std::ostream& o);
+
+        // times the scope it is declared in, if tracing is on as it starts
+        class Span {
+        public:
+            Span(char const* name, char const* category)
+                : name_{enabled() ? name : nullptr}
+                , category_{category}
+                , start_{0}
+            {
+                if(nullptr != name_) {
+                    start_ = detail::now();
+                }
+            }
+
+            ~Span() {
+                if(nullptr != name_) {
+                    detail::record(name_, category_, start_);
+                }
+            }
+
+            Span(Span const&) = delete;
+            Span& operator=(Span const&) = delete;
+
+        private:
+            char const*  name_;
+            char const*  category_;
+            std::int64_t start_;
+        };
+    };
+};
+
+#endif // __YASC_TRACE_H_
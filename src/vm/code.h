@@ -0,0 +1,307 @@
+#ifndef __YASC_VM_CODE_H_
+#define __YASC_VM_CODE_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../ast/value.h"
+#include "../ast/object.h"
+#include "../ast/number.h"
+#include "../ast/procedure.h"
+#include "../gc/heap.h"
+#include "../environment.h"
+
+namespace yasc {
+    namespace vm {
+        enum class Opcode : std::uint8_t {
+            Const,        // push constants[arg]
+            Local,        // push slot `arg` of the current frame
+            Free,         // push captured variable `arg` of the running closure
+            Self,         // push the running closure itself
+            Global,       // push global `arg` of the code's globals
+            DefineGlobal, // bind global `arg` to the top of the stack, which
+                          // becomes unspecified
+            SetGlobal,    // like DefineGlobal, but the global must be bound
+            MakeClosure,  // pop the variables captured by the Code in
+                          // constants[arg] and push a closure over them
+            Call,         // call the procedure below the topmost `arg` values
+            TailCall,     // like Call, but replaces the current frame
+            Return,       // return the top of the stack to the caller
+            Jump,         // continue at instruction `arg`
+            JumpIfFalse,  // pop, and continue at instruction `arg` if it was #f
+            Pop,          // drop the top of the stack
+            Assume,       // push whether assumption `arg` of the code holds
+
+            // only ever found in threaded code, where the VM rewrites a Call
+            // or TailCall of two arguments into one of these once it has
+            // seen what the call site is given; see Site
+            CallQuick,
+            TailCallQuick
+        };
+
+        struct Instruction {
+            Opcode        op;
+            std::uint32_t arg;
+        };
+
+        // a call site no Site was allocated for
+        constexpr std::uint16_t no_site = 0xffff;
+
+        // an Instruction with its opcode resolved to the address of the VM's
+        // handler for it, see VM::run
+        struct Threaded {
+            void const*   handler;
+            Opcode        op;
+            std::uint16_t site; // of a call of two arguments
+            std::uint32_t arg;
+        };
+
+        // that the global the code knows as `global' still holds a procedure
+        // running `primitive', which the optimizer relied on
+        struct Assumption {
+            std::uint32_t    global;
+            Primitive const* primitive;
+        };
+
+        // what a call of two arguments has been specialized to: calling an
+        // arithmetic primitive on two numbers of one level of the tower is
+        // then a guard and a direct call to the entry of the primitive's
+        // table for that level
+        struct Site {
+            Primitive const* primitive = nullptr;
+            Object (*fast)(Object const& lhs, Object const& rhs) = nullptr;
+            NumberKind kind = NumberKind::Count;
+            std::uint8_t rewrites = 0; // times it has been specialized
+        };
+    };
+
+    // the compiled body of a lambda (or of a top level form, which is
+    // compiled as a lambda without parameters)
+    class Code : public Value {
+    public:
+        Code(std::string name, std::uint32_t arity)
+            : Value(Value::Type::Code)
+            , name_{std::move(name)}
+            , arity_{arity}
+            , depth_{arity}
+            , max_depth_{arity}
+            , captures_{0}
+            , linked_{0}
+        {}
+
+        // appends an instruction and returns its index
+        std::uint32_t emit(vm::Opcode op, std::uint32_t arg = 0) {
+            using vm::Opcode;
+            switch(op) {
+                case Opcode::Const:
+                case Opcode::Local:
+                case Opcode::Free:
+                case Opcode::Self:
+                case Opcode::Global:
+                case Opcode::Assume:      ++depth_;       break;
+                case Opcode::MakeClosure:
+                    depth_ += 1 - value_cast<Code*>(constants_[arg])->captures();
+                    break;
+                case Opcode::Call:
+                case Opcode::TailCall:
+                case Opcode::CallQuick:
+                case Opcode::TailCallQuick: depth_ -= arg; break;
+                case Opcode::Return:
+                case Opcode::JumpIfFalse:
+                case Opcode::Pop:         --depth_;       break;
+                case Opcode::DefineGlobal:
+                case Opcode::SetGlobal:
+                case Opcode::Jump:                        break;
+            }
+            max_depth_ = std::max(max_depth_, depth_);
+            instructions_.push_back({op, arg});
+            return static_cast<std::uint32_t>(instructions_.size() - 1);
+        }
+
+        // points the jump at `at` to `target`
+        void patch(std::uint32_t at, std::uint32_t target) {
+            instructions_[at].arg = target;
+        }
+
+        std::uint32_t add_constant(Object val) {
+            auto itr = std::find(constants_.begin(), constants_.end(), val);
+            if(constants_.end() != itr) {
+                return static_cast<std::uint32_t>(itr - constants_.begin());
+            }
+            constants_.push_back(val);
+            return static_cast<std::uint32_t>(constants_.size() - 1);
+        }
+
+        // the index among this code's globals of global `slot'; the
+        // Global, DefineGlobal and SetGlobal instructions take these
+        std::uint32_t add_global(std::uint32_t slot) {
+            auto itr = std::find(globals_.begin(), globals_.end(), slot);
+            if(globals_.end() != itr) {
+                return static_cast<std::uint32_t>(itr - globals_.begin());
+            }
+            globals_.push_back(slot);
+            return static_cast<std::uint32_t>(globals_.size() - 1);
+        }
+
+        // the index of an assumption about global `global', as taken by the
+        // Assume instruction
+        std::uint32_t add_assumption(std::uint32_t global, Primitive const& primitive) {
+            auto same = [&] (vm::Assumption const& a) {
+                return a.global == global && a.primitive == &primitive;
+            };
+            auto itr = std::find_if(assumptions_.begin(), assumptions_.end(), same);
+            if(assumptions_.end() != itr) {
+                return static_cast<std::uint32_t>(itr - assumptions_.begin());
+            }
+            assumptions_.push_back({global, &primitive});
+            return static_cast<std::uint32_t>(assumptions_.size() - 1);
+        }
+
+        // the compiler rewinds the tracked stack depth at the start of an
+        // `else' branch, which starts from the same depth as the `then'
+        std::uint32_t depth() const {
+            return depth_;
+        }
+
+        void set_depth(std::uint32_t depth) {
+            depth_ = depth;
+        }
+
+        std::string const& name() const {
+            return name_;
+        }
+
+        std::uint32_t arity() const {
+            return arity_;
+        }
+
+        // how many variables a closure over this code copies out of the
+        // enclosing frames when it is made
+        std::uint32_t captures() const {
+            return captures_;
+        }
+
+        void set_captures(std::uint32_t captures) {
+            captures_ = captures;
+        }
+
+        // stack slots a frame running this code needs, parameters included
+        std::uint32_t max_stack() const {
+            return max_depth_;
+        }
+
+        std::uint32_t size() const {
+            return static_cast<std::uint32_t>(instructions_.size());
+        }
+
+        std::vector<vm::Instruction> const& instructions() const {
+            return instructions_;
+        }
+
+        std::vector<Object> const& constants() const {
+            return constants_;
+        }
+
+        // filled in by the VM the first time the code runs
+        std::vector<vm::Threaded>& threaded() {
+            return threaded_;
+        }
+
+        // one per call of two arguments, filled in along with threaded()
+        std::vector<vm::Site>& sites() {
+            return sites_;
+        }
+
+        std::vector<vm::Assumption> const& assumptions() const {
+            return assumptions_;
+        }
+
+        // the global slots the code refers to
+        std::vector<std::uint32_t> const& globals() const {
+            return globals_;
+        }
+
+        // the cells of those globals in the environment the code last ran
+        // in, whose stamp is linked(); filled in by the VM
+        std::vector<GlobalCell*>& cells() {
+            return cells_;
+        }
+
+        std::uint64_t linked() const {
+            return linked_;
+        }
+
+        void set_linked(std::uint64_t stamp) {
+            linked_ = stamp;
+        }
+
+        std::ostream& print(std::ostream& o) const override {
+            o << "[code " << name_ << "]";
+            return o;
+        }
+
+        void trace(gc::Tracer& t) override {
+            for(auto& constant : constants_) {
+                t(constant);
+            }
+        }
+
+    private:
+        std::string name_;
+        std::uint32_t arity_;
+        std::uint32_t depth_;
+        std::uint32_t max_depth_;
+        std::uint32_t captures_;
+
+        std::vector<vm::Instruction> instructions_;
+        std::vector<Object> constants_;
+        std::vector<vm::Threaded> threaded_;
+        std::vector<vm::Site> sites_;
+
+        std::vector<vm::Assumption> assumptions_;
+
+        std::vector<std::uint32_t> globals_;
+        std::vector<GlobalCell*> cells_;
+        std::uint64_t linked_;
+    };
+
+    // a flat closure: the values of the variables its code captures are
+    // copied in when it is made, so reaching one is a single index
+    class Closure : public Value {
+    public:
+        Closure(Object code, Object const* captured = nullptr, std::uint32_t count = 0)
+            : Value(Value::Type::Closure)
+            , code_{code}
+            , captured_(captured, captured + count)
+        {}
+
+        Code* code() const {
+            return value_cast<Code*>(code_);
+        }
+
+        Object const* captured() const {
+            return captured_.data();
+        }
+
+        std::ostream& print(std::ostream& o) const override {
+            o << "[closure " << code()->name() << "]";
+            return o;
+        }
+
+        void trace(gc::Tracer& t) override {
+            t(code_);
+            for(auto& val : captured_) {
+                t(val);
+            }
+        }
+
+    private:
+        Object code_;
+        std::vector<Object> captured_;
+    };
+}; // end of namespace yasc
+
+#endif // __YASC_VM_CODE_H_
@@ -0,0 +1,352 @@
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "compiler.h"
+#include "optimizer.h"
+#include "../error.h"
+#include "../ast/list.h"
+#include "../ast/identifier.h"
+#include "../ast/procedure.h"
+#include "../gc/heap.h"
+#include "../libscheme/lists.h"
+#include "../libscheme/parallel.h"
+
+namespace {
+    std::vector<yasc::Object> elements(yasc::List const& list) {
+        std::vector<yasc::Object> elems;
+        elems.reserve(list.size());
+        for(auto const& val : list) {
+            elems.push_back(val);
+        }
+        return elems;
+    }
+
+    bool is_identifier(yasc::Object const& val, yasc::Symbol const& name) {
+        return yasc::Value::Type::Identifier == val.type()
+            && yasc::value_cast<yasc::Identifier*>(val)->symbol() == name;
+    }
+
+    // the index of `name' in `names', or -1
+    long index_of(std::vector<yasc::Symbol> const& names, yasc::Symbol const& name) {
+        auto itr = std::find(names.begin(), names.end(), name);
+        return (names.end() == itr) ? -1 : itr - names.begin();
+    }
+}
+
+namespace yasc {
+    namespace vm {
+        Object Compiler::compile(Object const& expr) {
+            auto code = make_object<Code>("toplevel", 0);
+            Scope scope{{}, {}, nullptr};
+            compile(expr, *value_cast<Code*>(code), scope, true);
+            return code;
+        }
+
+        void Compiler::compile(Object const& expr, Code& code, Scope& scope, bool tail) {
+            switch(expr.type()) {
+                case Value::Type::Identifier:
+                    compile_variable(value_cast<Identifier*>(expr)->symbol(), code, scope);
+                    break;
+                case Value::Type::List: {
+                    Nesting nesting{depth_};
+                    if(nesting.deeper_than(2 * max_nesting)) {
+                        throw Error{"forms nested more than " + std::to_string(2 * max_nesting) + " deep"};
+                    }
+                    static auto const lambda = Symbol::intern("lambda");
+                    static auto const if_    = Symbol::intern("if");
+                    static auto const quote  = Symbol::intern("quote");
+                    static auto const define = Symbol::intern("define");
+                    static auto const set    = Symbol::intern("set!");
+                    static auto const let    = Symbol::intern("let");
+                    static auto const future = Symbol::intern("future");
+
+                    auto const& form = *value_cast<List*>(expr);
+                    auto const& head = form.car();
+                    auto bound = [&] (Symbol const& name) {
+                        for(auto s = &scope; nullptr != s; s = s->parent) {
+                            if(index_of(s->locals, name) >= 0 || (nullptr != s->self && *s->self == name)) {
+                                return true;
+                            }
+                        }
+                        return false;
+                    };
+                    if(is_identifier(head, assuming())) {
+                        compile_assuming(form, code, scope, tail);
+                        return;
+                    } else if(is_identifier(head, lambda) && !bound(lambda)) {
+                        compile_lambda(form, code, scope);
+                    } else if(is_identifier(head, if_) && !bound(if_)) {
+                        // both branches return on their own in tail position
+                        compile_if(form, code, scope, tail);
+                        return;
+                    } else if(is_identifier(head, quote) && !bound(quote)) {
+                        compile_quote(form, code);
+                    } else if(is_identifier(head, define) && !bound(define)) {
+                        compile_define(form, code, scope);
+                    } else if(is_identifier(head, set) && !bound(set)) {
+                        compile_set(form, code, scope);
+                    } else if(is_identifier(head, let) && !bound(let)) {
+                        // the body is called, as a tail call in tail position
+                        compile_let(form, code, scope, tail);
+                        return;
+                    } else if(is_identifier(head, future) && !bound(future)) {
+                        compile_future(form, code, scope);
+                    } else {
+                        compile_call(form, code, scope, tail);
+                        return;
+                    }
+                    break;
+                }
+                case Value::Type::Pair:
+                    throw Error{"cannot evaluate a dotted list, quote it"};
+                default:
+                    // everything else evaluates to itself
+                    code.emit(Opcode::Const, code.add_constant(constant(expr)));
+                    break;
+            }
+            if(tail) {
+                code.emit(Opcode::Return);
+            }
+        }
+
+        void Compiler::compile_variable(Symbol const& name, Code& code, Scope& scope) {
+            auto local = index_of(scope.locals, name);
+            if(local >= 0) {
+                code.emit(Opcode::Local, static_cast<std::uint32_t>(local));
+                return;
+            }
+            if(nullptr != scope.self && *scope.self == name) {
+                code.emit(Opcode::Self);
+                return;
+            }
+
+            auto captured = index_of(scope.captures, name);
+            if(captured < 0) {
+                // a variable of an enclosing lambda is captured on first use;
+                // the enclosing lambda pushes its value when making the closure
+                for(auto s = scope.parent; nullptr != s; s = s->parent) {
+                    if(index_of(s->locals, name) >= 0 || index_of(s->captures, name) >= 0
+                            || (nullptr != s->self && *s->self == name)) {
+                        captured = static_cast<long>(scope.captures.size());
+                        scope.captures.push_back(name);
+                        break;
+                    }
+                }
+            }
+            if(captured >= 0) {
+                code.emit(Opcode::Free, static_cast<std::uint32_t>(captured));
+                return;
+            }
+
+            code.emit(Opcode::Global, code.add_global(globals_.slot(name)));
+        }
+
+        void Compiler::compile_call(List const& form, Code& code, Scope& scope, bool tail) {
+            auto argc = std::uint32_t{0};
+            for(auto const& val : form) {
+                compile(val, code, scope, false);
+                ++argc;
+            }
+            // the first value pushed was the procedure itself
+            code.emit(tail ? Opcode::TailCall : Opcode::Call, argc - 1);
+        }
+
+        void Compiler::compile_lambda(List const& form, Code& code, Scope& scope) {
+            auto elems = elements(form);
+            if(elems.size() < 3) {
+                throw Error{"lambda: expected (lambda (params...) body...)"};
+            }
+            if(Value::Type::List != elems[1].type() && !elems[1].is_empty_list()) {
+                throw Error{"lambda: parameters must be a list"};
+            }
+            auto params = elems[1].is_empty_list() ? std::vector<Object>{} : elements(*value_cast<List*>(elems[1]));
+            compile_closure("lambda", params, elems.begin() + 2, elems.end(), code, scope);
+        }
+
+        template<typename Itr>
+        void Compiler::compile_closure(std::string name, std::vector<Object> const& params, Itr begin, Itr end,
+                                       Code& code, Scope& scope, Symbol const* self) {
+            Scope inner{{}, {}, &scope, self};
+            for(auto const& param : params) {
+                if(Value::Type::Identifier != param.type()) {
+                    throw Error{name + ": parameters must be identifiers"};
+                }
+                inner.locals.push_back(value_cast<Identifier*>(param)->symbol());
+            }
+
+            auto body = make_object<Code>(std::move(name), static_cast<std::uint32_t>(inner.locals.size()));
+            compile_body(begin, end, *value_cast<Code*>(body), inner);
+            value_cast<Code*>(body)->set_captures(static_cast<std::uint32_t>(inner.captures.size()));
+
+            for(auto const& name : inner.captures) {
+                compile_variable(name, code, scope);
+            }
+            code.emit(Opcode::MakeClosure, code.add_constant(body));
+        }
+
+        void Compiler::compile_if(List const& form, Code& code, Scope& scope, bool tail) {
+            auto elems = elements(form);
+            if(elems.size() != 3 && elems.size() != 4) {
+                throw Error{"if: expected (if test consequent [alternative])"};
+            }
+            auto alternative = (elems.size() == 4) ? elems[3] : Object::unspecified();
+
+            compile(elems[1], code, scope, false);
+            auto to_alternative = code.emit(Opcode::JumpIfFalse);
+            auto depth = code.depth();
+
+            compile(elems[2], code, scope, tail);
+            auto to_end = tail ? 0 : code.emit(Opcode::Jump);
+
+            code.patch(to_alternative, code.size());
+            code.set_depth(depth);
+            compile(alternative, code, scope, tail);
+
+            if(!tail) {
+                code.patch(to_end, code.size());
+            }
+        }
+
+        void Compiler::compile_quote(List const& form, Code& code) {
+            auto elems = elements(form);
+            if(elems.size() != 2) {
+                throw Error{"quote: expected (quote datum)"};
+            }
+            code.emit(Opcode::Const, code.add_constant(lists::to_pairs(constant(elems[1]))));
+        }
+
+        // (define name expr) or (define (name params...) body...), which
+        // binds a global; there are no internal definitions yet
+        void Compiler::compile_define(List const& form, Code& code, Scope& scope) {
+            auto elems = elements(form);
+            if(nullptr != scope.parent) {
+                throw Error{"define: only allowed at top level"};
+            }
+            if(elems.size() >= 3 && Value::Type::List == elems[1].type()) {
+                // the parameters are the rest of the signature
+                auto params = elements(*value_cast<List*>(elems[1]));
+                if(Value::Type::Identifier != params[0].type()) {
+                    throw Error{"define: expected (define (name params...) body...)"};
+                }
+                auto const symbol = value_cast<Identifier*>(params[0])->symbol();
+                params.erase(params.begin());
+                compile_closure(symbol.name(), params, elems.begin() + 2, elems.end(), code, scope);
+                code.emit(Opcode::DefineGlobal, code.add_global(globals_.slot(symbol)));
+                return;
+            }
+            if(elems.size() != 3 || Value::Type::Identifier != elems[1].type()) {
+                throw Error{"define: expected (define name expr)"};
+            }
+            compile(elems[2], code, scope, false);
+            code.emit(Opcode::DefineGlobal, code.add_global(globals_.slot(value_cast<Identifier*>(elems[1])->symbol())));
+        }
+
+        // (set! name expr), for globals only: closures copy the variables
+        // they capture, so assigning a local could not be seen by them. the
+        // name of a named let is as local as its variables
+        void Compiler::compile_set(List const& form, Code& code, Scope& scope) {
+            auto elems = elements(form);
+            if(elems.size() != 3 || Value::Type::Identifier != elems[1].type()) {
+                throw Error{"set!: expected (set! name expr)"};
+            }
+            auto const& name = value_cast<Identifier*>(elems[1])->symbol();
+            for(auto s = &scope; nullptr != s; s = s->parent) {
+                if(index_of(s->locals, name) >= 0 || (nullptr != s->self && *s->self == name)) {
+                    throw Error{"set!: cannot assign the local variable `" + name.name() + "'"};
+                }
+            }
+            compile(elems[2], code, scope, false);
+            code.emit(Opcode::SetGlobal, code.add_global(globals_.slot(name)));
+        }
+
+        // checks each assumption in turn, and compiles both forms: like an
+        // `if' whose test is all of them holding
+        void Compiler::compile_assuming(List const& form, Code& code, Scope& scope, bool tail) {
+            auto elems = elements(form);
+            std::vector<std::uint32_t> to_original;
+            for(auto i = 3u; i + 1 < elems.size(); i += 2) {
+                auto global = code.add_global(globals_.slot(value_cast<Identifier*>(elems[i])->symbol()));
+                auto const& primitive = value_cast<Procedure*>(elems[i + 1])->primitive();
+                code.emit(Opcode::Assume, code.add_assumption(global, primitive));
+                to_original.push_back(code.emit(Opcode::JumpIfFalse));
+            }
+            auto depth = code.depth();
+
+            compile(elems[1], code, scope, tail);
+            auto to_end = tail ? 0 : code.emit(Opcode::Jump);
+
+            for(auto at : to_original) {
+                code.patch(at, code.size());
+            }
+            code.set_depth(depth);
+            compile(elems[2], code, scope, tail);
+
+            if(!tail) {
+                code.patch(to_end, code.size());
+            }
+        }
+
+        // (let ((var init)...) body...) calls a lambda over the variables
+        // with the inits. (let name ((var init)...) body...) does the same,
+        // but the body sees that lambda as `name', so calling it in tail
+        // position loops
+        void Compiler::compile_let(List const& form, Code& code, Scope& scope, bool tail) {
+            auto elems = elements(form);
+            auto named = elems.size() > 1 && Value::Type::Identifier == elems[1].type();
+            auto first = named ? 2u : 1u;
+            if(elems.size() < first + 2
+                    || (Value::Type::List != elems[first].type() && !elems[first].is_empty_list())) {
+                throw Error{"let: expected (let [name] ((var init)...) body...)"};
+            }
+
+            std::vector<Object> params, inits;
+            if(!elems[first].is_empty_list()) {
+                for(auto const& binding : *value_cast<List*>(elems[first])) {
+                    if(Value::Type::List != binding.type() || 2 != value_cast<List*>(binding)->size()) {
+                        throw Error{"let: expected (var init) bindings"};
+                    }
+                    auto pair = elements(*value_cast<List*>(binding));
+                    params.push_back(pair[0]);
+                    inits.push_back(pair[1]);
+                }
+            }
+
+            if(named) {
+                auto const& name = value_cast<Identifier*>(elems[1])->symbol();
+                compile_closure(name.name(), params, elems.begin() + first + 1, elems.end(), code, scope, &name);
+            } else {
+                compile_closure("let", params, elems.begin() + first + 1, elems.end(), code, scope);
+            }
+            for(auto const& init : inits) {
+                compile(init, code, scope, false);
+            }
+            code.emit(tail ? Opcode::TailCall : Opcode::Call, static_cast<std::uint32_t>(inits.size()));
+        }
+
+        // (future expr) hands a thunk of expr to the scheduler, which runs
+        // it when it is touched, or on another thread before that
+        void Compiler::compile_future(List const& form, Code& code, Scope& scope) {
+            auto elems = elements(form);
+            if(elems.size() != 2) {
+                throw Error{"future: expected (future expr)"};
+            }
+            code.emit(Opcode::Const, code.add_constant(make_object<Procedure>(parallel::future_primitive())));
+            compile_closure("future", {}, elems.begin() + 1, elems.end(), code, scope);
+            code.emit(Opcode::Call, 1);
+        }
+
+        template<typename Itr>
+        void Compiler::compile_body(Itr begin, Itr end, Code& code, Scope& scope) {
+            for(; begin + 1 != end; ++begin) {
+                compile(*begin, code, scope, false);
+                code.emit(Opcode::Pop);
+            }
+            compile(*begin, code, scope, true);
+        }
+
+        Object Compiler::constant(Object const& val) {
+            return gc::current_heap().escape(val);
+        }
+    };
+};
@@ -0,0 +1,83 @@
+#ifndef __YASC_VM_COMPILER_H_
+#define __YASC_VM_COMPILER_H_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "../ast/value.h"
+#include "../ast/object.h"
+#include "../ast/symbol.h"
+#include "../environment.h"
+#include "code.h"
+
+namespace yasc {
+    class List;
+
+    namespace vm {
+        // translates a parsed form into bytecode for the VM. understands the
+        // `lambda', `if', `quote', `define', `set!', `let' (named or not) and
+        // `future' special forms, and
+        // the <assuming> forms left by the Optimizer; everything else is a
+        // constant, a variable reference or a procedure call.
+        //
+        // every variable is resolved while compiling, to a slot of the
+        // current frame, of the running closure or of the global table.
+        class Compiler {
+        public:
+            explicit Compiler(Context& globals)
+                : globals_{globals}
+            {}
+
+            // compiles `expr' into the body of a procedure of no arguments.
+            // constants are copied out of the parser's region, so the result
+            // does not keep the AST alive.
+            Object compile(Object const& expr);
+
+        private:
+            // the variables visible inside one lambda: its parameters, and
+            // those of enclosing lambdas it has captured so far. the body
+            // of a named let also sees the loop itself under its name
+            struct Scope {
+                std::vector<Symbol> locals;
+                std::vector<Symbol> captures;
+                Scope* parent;
+                Symbol const* self = nullptr;
+            };
+
+            void compile(Object const& expr, Code& code, Scope& scope, bool tail);
+            void compile_variable(Symbol const& name, Code& code, Scope& scope);
+            void compile_call(List const& form, Code& code, Scope& scope, bool tail);
+            void compile_lambda(List const& form, Code& code, Scope& scope);
+            void compile_if(List const& form, Code& code, Scope& scope, bool tail);
+            void compile_quote(List const& form, Code& code);
+            void compile_define(List const& form, Code& code, Scope& scope);
+            void compile_set(List const& form, Code& code, Scope& scope);
+            void compile_assuming(List const& form, Code& code, Scope& scope, bool tail);
+            void compile_let(List const& form, Code& code, Scope& scope, bool tail);
+            void compile_future(List const& form, Code& code, Scope& scope);
+
+            // compiles a closure named `name' over `params' with `body...',
+            // and pushes it. the body refers to the closure as `self', when
+            // given
+            template<typename Itr>
+            void compile_closure(std::string name, std::vector<Object> const& params, Itr begin, Itr end,
+                                 Code& code, Scope& scope, Symbol const* self = nullptr);
+
+            // compiles `body...' as the tail of a procedure, including the
+            // final return
+            template<typename Itr>
+            void compile_body(Itr begin, Itr end, Code& code, Scope& scope);
+
+            Object constant(Object const& val);
+
+            Context& globals_;
+            // of the form being compiled. the optimizer's guards keep the
+            // original form inside them, so an optimized form may nest up
+            // to twice as deep as what was read
+            std::size_t depth_ = 0;
+        };
+    };
+};
+
+#endif // __YASC_VM_COMPILER_H_
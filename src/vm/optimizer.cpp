@@ -0,0 +1,317 @@
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "optimizer.h"
+#include "../error.h"
+#include "../ast/list.h"
+#include "../ast/identifier.h"
+#include "../ast/procedure.h"
+#include "../ast/number.h"
+#include "../libscheme/arithmetic.h"
+
+namespace {
+    std::vector<yasc::Object> elements(yasc::Object const& list) {
+        std::vector<yasc::Object> elems;
+        for(auto const& val : *yasc::value_cast<yasc::List*>(list)) {
+            elems.push_back(val);
+        }
+        return elems;
+    }
+
+    yasc::Object make_form(std::vector<yasc::Object> const& elems) {
+        auto list = yasc::make_object<yasc::List>();
+        for(auto const& val : elems) {
+            yasc::value_cast<yasc::List*>(list)->push_back(val);
+        }
+        return list;
+    }
+
+    bool is_identifier(yasc::Object const& val, yasc::Symbol const& name) {
+        return yasc::Value::Type::Identifier == val.type()
+            && yasc::value_cast<yasc::Identifier*>(val)->symbol() == name;
+    }
+
+    // whatever is not a list or a variable evaluates to itself
+    bool is_literal(yasc::Object const& val) {
+        return yasc::Value::Type::List != val.type() && yasc::Value::Type::Identifier != val.type();
+    }
+
+    bool is_guard(yasc::Object const& val) {
+        return yasc::Value::Type::List == val.type()
+            && is_identifier(yasc::value_cast<yasc::List*>(val)->car(), yasc::vm::assuming());
+    }
+}
+
+namespace yasc {
+    namespace vm {
+        std::ostream& operator<<(std::ostream& o, OptimizationStats const& stats) {
+            return o << "folded " << stats.folded << " calls, pruned " << stats.pruned
+                     << " branches, flattened " << stats.flattened << " calls, inlined "
+                     << stats.inlined << " primitives";
+        }
+
+        Symbol const& assuming() {
+            static auto const name = Symbol::intern("#<assuming primitives>");
+            return name;
+        }
+
+        Object Optimizer::optimize(Object const& expr) {
+            if(0 == level_) {
+                return expr;
+            }
+            return optimize(expr, Scope{{}, nullptr});
+        }
+
+        Object Optimizer::optimize(Object const& expr, Scope const& scope) {
+            if(Value::Type::List != expr.type()) {
+                return expr;
+            }
+            Nesting nesting{depth_};
+            if(nesting.deeper_than(max_nesting)) {
+                throw Error{"forms nested more than " + std::to_string(max_nesting) + " deep"};
+            }
+
+            static auto const lambda = Symbol::intern("lambda");
+            static auto const if_    = Symbol::intern("if");
+            static auto const quote  = Symbol::intern("quote");
+            static auto const define = Symbol::intern("define");
+            static auto const set    = Symbol::intern("set!");
+            static auto const let    = Symbol::intern("let");
+
+            // the same special forms as the compiler's, under the same rules;
+            // malformed ones are left for the compiler to report
+            auto const& head = value_cast<List*>(expr)->car();
+            auto special = [&] (Symbol const& name) {
+                if(!is_identifier(head, name)) {
+                    return false;
+                }
+                for(auto s = &scope; nullptr != s; s = s->parent) {
+                    if(s->locals.end() != std::find(s->locals.begin(), s->locals.end(), name)) {
+                        return false;
+                    }
+                }
+                return true;
+            };
+            auto with_params = [&] (std::vector<Object> const& params, std::size_t body) {
+                Scope inner{{}, &scope};
+                for(auto const& param : params) {
+                    if(Value::Type::Identifier != param.type()) {
+                        return expr;
+                    }
+                    inner.locals.push_back(value_cast<Identifier*>(param)->symbol());
+                }
+                return optimize_from(expr, body, inner);
+            };
+
+            if(special(quote)) {
+                return expr;
+            }
+            if(special(let)) {
+                return optimize_let(expr, scope);
+            }
+            if(special(if_)) {
+                return optimize_if(expr, scope);
+            }
+            if(special(lambda) || special(define) || special(set)) {
+                auto elems = elements(expr);
+                if(elems.size() < 3) {
+                    return expr;
+                }
+                if(special(lambda)) {
+                    if(elems[1].is_empty_list()) {
+                        return with_params({}, 2);
+                    }
+                    return (Value::Type::List == elems[1].type()) ? with_params(elements(elems[1]), 2) : expr;
+                }
+                if(special(define) && Value::Type::List == elems[1].type()) {
+                    auto params = elements(elems[1]);
+                    params.erase(params.begin());
+                    return with_params(params, 2);
+                }
+                return (3 == elems.size()) ? optimize_from(expr, 2, scope) : expr;
+            }
+            return optimize_call(expr, scope);
+        }
+
+        // the inits are optimized where the let is, the body where its
+        // variables (and the name of a named let) are bound
+        Object Optimizer::optimize_let(Object const& expr, Scope const& scope) {
+            auto elems = elements(expr);
+            auto named = elems.size() > 1 && Value::Type::Identifier == elems[1].type();
+            auto first = named ? 2u : 1u;
+            if(elems.size() < first + 2
+                    || (Value::Type::List != elems[first].type() && !elems[first].is_empty_list())) {
+                return expr;
+            }
+
+            Scope inner{{}, &scope};
+            if(named) {
+                inner.locals.push_back(value_cast<Identifier*>(elems[1])->symbol());
+            }
+            auto bindings = elems[first].is_empty_list() ? std::vector<Object>{} : elements(elems[first]);
+            auto changed = false;
+            for(auto& binding : bindings) {
+                if(Value::Type::List != binding.type() || 2 != value_cast<List*>(binding)->size()
+                        || Value::Type::Identifier != value_cast<List*>(binding)->car().type()) {
+                    return expr;
+                }
+                auto pair = elements(binding);
+                inner.locals.push_back(value_cast<Identifier*>(pair[0])->symbol());
+                if(optimize_elements(pair, 1, scope)) {
+                    binding = make_form(pair);
+                    changed = true;
+                }
+            }
+            if(changed) {
+                elems[first] = make_form(bindings);
+            }
+            changed = optimize_elements(elems, first + 1, inner) || changed;
+            return changed ? make_form(elems) : expr;
+        }
+
+        Object Optimizer::optimize_if(Object const& expr, Scope const& scope) {
+            auto elems = elements(expr);
+            if(elems.size() != 3 && elems.size() != 4) {
+                return expr;
+            }
+            auto changed = optimize_elements(elems, 1, scope);
+
+            // a test folded to a literal holds only while the primitives it
+            // was folded with do, so the branch taken is guarded like it
+            auto guarded = is_guard(elems[1]);
+            auto test = guarded ? *++value_cast<List*>(elems[1])->begin() : elems[1];
+            if(is_literal(test)) {
+                ++stats_.pruned;
+                auto taken = test.is_true() ? elems[2] : ((4 == elems.size()) ? elems[3] : Object::unspecified());
+                if(!guarded) {
+                    return taken;
+                }
+                auto guard = elements(elems[1]);
+                guard[1] = taken;
+                guard[2] = expr;
+                return make_form(guard);
+            }
+            return changed ? make_form(elems) : expr;
+        }
+
+        Object Optimizer::optimize_call(Object const& expr, Scope const& scope) {
+            auto elems = elements(expr);
+            auto changed = optimize_elements(elems, 0, scope);
+
+            auto proc = known_primitive(elems[0], scope);
+            if(proc.is_null()) {
+                return changed ? make_form(elems) : expr;
+            }
+            auto const& prim = value_cast<Procedure*>(proc)->primitive();
+
+            Assumptions assumptions{{elems[0], proc}};
+
+            // a guarded argument stands for what it was optimized to, as
+            // long as the call's own guard checks its assumptions too
+            auto optimized = [] (Object const& arg) {
+                return is_guard(arg) ? *++value_cast<List*>(arg)->begin() : arg;
+            };
+            auto assume = [&] (Object const& arg) {
+                if(!is_guard(arg)) {
+                    return;
+                }
+                auto guard = elements(arg);
+                for(auto i = 3u; i + 1 < guard.size(); i += 2) {
+                    auto const& name = value_cast<Identifier*>(guard[i])->symbol();
+                    auto same = [&] (auto const& a) {
+                        return value_cast<Identifier*>(a.first)->symbol() == name;
+                    };
+                    if(std::none_of(assumptions.begin(), assumptions.end(), same)) {
+                        assumptions.emplace_back(guard[i], guard[i + 1]);
+                    }
+                }
+            };
+            auto guarded = [&] (Object const& value) {
+                std::vector<Object> guard{make_object<Identifier>(assuming()), value, expr};
+                for(auto const& [name, primitive] : assumptions) {
+                    guard.push_back(name);
+                    guard.push_back(primitive);
+                }
+                return make_form(guard);
+            };
+
+            // a pure primitive on numbers can be called right away. one that
+            // fails is left for the program to run into
+            std::vector<Object> args;
+            for(auto i = 1u; i < elems.size(); ++i) {
+                auto arg = optimized(elems[i]);
+                if(NumberKind::Count == number_kind_of(arg)) {
+                    break;
+                }
+                args.push_back(arg);
+            }
+            if(args.size() + 1 == elems.size()) {
+                try {
+                    auto value = value_cast<Procedure*>(proc)->call(Args{args.data(), static_cast<std::uint32_t>(args.size())});
+                    for(auto i = 1u; i < elems.size(); ++i) {
+                        assume(elems[i]);
+                    }
+                    ++stats_.folded;
+                    return guarded(value);
+                } catch(Error const&) {
+                }
+            }
+
+            // (op (op a b...) c...) is (op a b... c...) for an op folding left
+            if(level_ >= 2 && arithmetic::left_fold(prim) && elems.size() >= 2) {
+                auto inner = optimized(elems[1]);
+                if(Value::Type::List == inner.type()) {
+                    // the inner call's head is either the same global or the
+                    // primitive itself, inlined by an earlier flattening
+                    auto nested = elements(inner);
+                    auto same = is_identifier(nested[0], value_cast<Identifier*>(elems[0])->symbol())
+                        || (Value::Type::Procedure == nested[0].type()
+                            && &value_cast<Procedure*>(nested[0])->primitive() == &prim);
+                    if(same && nested.size() >= 3) {
+                        assume(elems[1]);
+                        nested[0] = proc;
+                        nested.insert(nested.end(), elems.begin() + 2, elems.end());
+                        ++stats_.flattened;
+                        ++stats_.inlined;
+                        return guarded(make_form(nested));
+                    }
+                }
+            }
+            return changed ? make_form(elems) : expr;
+        }
+
+        Object Optimizer::optimize_from(Object const& expr, std::size_t first, Scope const& scope) {
+            auto elems = elements(expr);
+            return optimize_elements(elems, first, scope) ? make_form(elems) : expr;
+        }
+
+        bool Optimizer::optimize_elements(std::vector<Object>& elems, std::size_t first, Scope const& scope) {
+            auto changed = false;
+            for(auto i = first; i < elems.size(); ++i) {
+                auto val = optimize(elems[i], scope);
+                changed = changed || !(val == elems[i]);
+                elems[i] = val;
+            }
+            return changed;
+        }
+
+        Object Optimizer::known_primitive(Object const& head, Scope const& scope) const {
+            if(Value::Type::Identifier != head.type()) {
+                return Object{};
+            }
+            auto const& name = value_cast<Identifier*>(head)->symbol();
+            for(auto s = &scope; nullptr != s; s = s->parent) {
+                if(s->locals.end() != std::find(s->locals.begin(), s->locals.end(), name)) {
+                    return Object{};
+                }
+            }
+            auto val = globals_.lookup(name);
+            if(val.is_null() || Value::Type::Procedure != val.type()
+                    || nullptr == arithmetic::dispatch_table(value_cast<Procedure*>(val)->primitive())) {
+                return Object{};
+            }
+            return val;
+        }
+    };
+};
@@ -0,0 +1,93 @@
+#ifndef __YASC_VM_OPTIMIZER_H_
+#define __YASC_VM_OPTIMIZER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+#include "../ast/value.h"
+#include "../ast/object.h"
+#include "../ast/symbol.h"
+#include "../environment.h"
+
+namespace yasc {
+    class List;
+
+    namespace vm {
+        // what the optimizer did, over every form it was given
+        struct OptimizationStats {
+            std::uint64_t folded    = 0; // calls replaced by their value
+            std::uint64_t pruned    = 0; // `if's replaced by the branch taken
+            std::uint64_t flattened = 0; // calls merged into the call around them
+            std::uint64_t inlined   = 0; // primitives referred to directly
+        };
+
+        std::ostream& operator<<(std::ostream& o, OptimizationStats const& stats);
+
+        // the head of the forms the optimizer guards what it did with. its
+        // name has a space in it, so no token can name it and it cannot clash
+        // with a program's own names:
+        //
+        //     (<assuming> optimized original name primitive...)
+        //
+        // evaluates `optimized' while every global `name' still holds its
+        // `primitive', and `original' once any of them has been redefined.
+        Symbol const& assuming();
+
+        // rewrites a parsed form before it is compiled. at level 1 it
+        // evaluates the calls of arithmetic primitives whose arguments are
+        // all numbers, and drops the branch an `if' on a literal never
+        // takes; level 2 also merges (+ (+ a b) c) into (+ a b c), calling
+        // the primitive directly. level 0 leaves forms alone.
+        //
+        // the primitives are only known while their globals are not
+        // redefined, so whatever depends on one is wrapped in <assuming>,
+        // which the compiler turns into a check of the globals involved.
+        class Optimizer {
+        public:
+            Optimizer(Context& globals, unsigned level, OptimizationStats& stats)
+                : globals_{globals}
+                , level_{level}
+                , stats_{stats}
+            {}
+
+            // the new form shares what it did not change with `expr'
+            Object optimize(Object const& expr);
+
+        private:
+            struct Scope {
+                std::vector<Symbol> locals;
+                Scope const* parent;
+            };
+
+            // the globals a rewritten form assumes, with the primitive each
+            // held when it was rewritten
+            using Assumptions = std::vector<std::pair<Object, Object>>;
+
+            Object optimize(Object const& expr, Scope const& scope);
+            Object optimize_call(Object const& expr, Scope const& scope);
+            Object optimize_if(Object const& expr, Scope const& scope);
+            Object optimize_let(Object const& expr, Scope const& scope);
+
+            // optimizes the elements of the form `expr' from `first' on, and
+            // copies it if any of them changed
+            Object optimize_from(Object const& expr, std::size_t first, Scope const& scope);
+
+            // optimizes `elems' from `first' on, answering whether any changed
+            bool optimize_elements(std::vector<Object>& elems, std::size_t first, Scope const& scope);
+
+            // the pure primitive the global `head' refers to, or null
+            Object known_primitive(Object const& head, Scope const& scope) const;
+
+            Context& globals_;
+            unsigned level_;
+            OptimizationStats& stats_;
+            // of the form being optimized; see max_nesting
+            std::size_t depth_ = 0;
+        };
+    };
+};
+
+#endif // __YASC_VM_OPTIMIZER_H_
@@ -0,0 +1,291 @@
+#include <algorithm>
+#include <iomanip>
+#include <utility>
+
+#include <signal.h>
+#include <sys/time.h>
+
+#include "profiler.h"
+#include "../gc/heap.h"
+
+namespace {
+    double to_ms(std::chrono::steady_clock::duration d) {
+        return std::chrono::duration<double, std::milli>(d).count();
+    }
+
+    double percent(double part, double whole) {
+        return (whole > 0) ? 100 * part / whole : 0;
+    }
+
+    // a deep recursion makes for a deep tree, which must not be taken
+    // apart recursively
+    template<typename Node>
+    void clear(Node& root) {
+        std::vector<std::unique_ptr<Node>> doomed;
+        doomed.swap(root.children);
+        while(!doomed.empty()) {
+            auto node = std::move(doomed.back());
+            doomed.pop_back();
+            for(auto& child : node->children) {
+                doomed.push_back(std::move(child));
+            }
+        }
+    }
+}
+
+namespace yasc {
+    namespace vm {
+        Profiler::~Profiler() {
+            stop();
+            clear(root_);
+        }
+
+        void Profiler::start(Mode mode, std::chrono::microseconds interval) {
+            stop();
+            clear(root_);
+            root_.exclusive = clock::duration{0};
+            root_.samples   = 0;
+            entries_.clear();
+            open_.clear();
+            samples_ = 0;
+
+            mode_     = mode;
+            running_  = true;
+            counting_ = Mode::Calls == mode_;
+            if(Mode::Sampling == mode_) {
+                struct sigaction action{};
+                action.sa_handler = &Profiler::on_signal;
+                action.sa_flags   = SA_RESTART;
+                sigemptyset(&action.sa_mask);
+                sigaction(SIGPROF, &action, nullptr);
+
+                itimerval timer{};
+                timer.it_interval.tv_sec  = static_cast<time_t>(interval.count() / 1000000);
+                timer.it_interval.tv_usec = static_cast<suseconds_t>(interval.count() % 1000000);
+                timer.it_value = timer.it_interval;
+                setitimer(ITIMER_PROF, &timer, nullptr);
+            }
+        }
+
+        void Profiler::stop() {
+            if(running_ && Mode::Sampling == mode_) {
+                itimerval timer{};
+                setitimer(ITIMER_PROF, &timer, nullptr);
+                // SIGPROF would otherwise end the process, were one still
+                // on its way
+                signal(SIGPROF, SIG_IGN);
+                pending_ = 0;
+            }
+            running_  = false;
+            counting_ = false;
+        }
+
+        void Profiler::on_signal(int) {
+            pending_ = 1;
+        }
+
+        Profiler::Entry* Profiler::entry(std::string_view name) {
+            auto itr = entries_.find(name);
+            if(entries_.end() != itr) {
+                return itr->second.get();
+            }
+            auto entry = std::make_unique<Entry>();
+            entry->name = std::string{name};
+            auto ret = entry.get();
+            entries_.emplace(std::string_view{ret->name}, std::move(entry));
+            return ret;
+        }
+
+        Profiler::Node* Profiler::Node::child(Entry* of) {
+            for(auto& node : children) {
+                if(node->entry == of) {
+                    return node.get();
+                }
+            }
+            children.push_back(std::make_unique<Node>(Node{of, {}}));
+            return children.back().get();
+        }
+
+        Profiler::Node* Profiler::Node::child(std::string_view name) {
+            for(auto& node : children) {
+                if(node->entry->name == name) {
+                    return node.get();
+                }
+            }
+            return nullptr;
+        }
+
+        void Profiler::count(std::string_view name) {
+            auto parent = open_.empty() ? &root_ : open_.back().node;
+            auto node = parent->child(name);
+            if(nullptr == node) {
+                node = parent->child(entry(name));
+            }
+            ++node->entry->calls;
+            ++node->entry->active;
+            auto const& stats = gc::current_heap().stats();
+            open_.push_back({node, clock::now(), clock::duration{0},
+                stats.allocations, stats.bytes_allocated});
+        }
+
+        void Profiler::uncount() {
+            if(open_.empty()) {
+                return;
+            }
+            auto const now = clock::now();
+            auto const& stats = gc::current_heap().stats();
+            auto call = open_.back();
+            open_.pop_back();
+
+            auto elapsed     = now - call.start;
+            auto allocations = stats.allocations - call.allocations;
+            auto bytes       = stats.bytes_allocated - call.bytes;
+
+            auto callee = call.node->entry;
+            callee->exclusive   += elapsed - call.callees;
+            callee->allocations += allocations - call.callee_allocations;
+            callee->bytes       += bytes - call.callee_bytes;
+            call.node->exclusive += elapsed - call.callees;
+            // a recursive call is already timed by its outermost activation
+            if(0 == --callee->active) {
+                callee->inclusive += elapsed;
+            }
+
+            if(!open_.empty()) {
+                auto& caller = open_.back();
+                caller.callees            += elapsed;
+                caller.callee_allocations += allocations;
+                caller.callee_bytes       += bytes;
+            }
+        }
+
+        void Profiler::unwind(std::size_t depth) {
+            while(open_.size() > depth) {
+                leave();
+            }
+        }
+
+        void Profiler::sample(std::vector<std::string_view> const& stack) {
+            pending_ = 0;
+            if(!running_ || Mode::Sampling != mode_ || stack.empty()) {
+                return;
+            }
+            ++samples_;
+            auto node = &root_;
+            std::vector<Entry*> seen;
+            for(auto name : stack) {
+                auto on = entry(name);
+                node = node->child(on);
+                if(seen.end() == std::find(seen.begin(), seen.end(), on)) {
+                    seen.push_back(on);
+                    ++on->on_stack;
+                }
+            }
+            ++node->samples;
+            ++node->entry->samples;
+        }
+
+        std::vector<Profiler::Entry const*> Profiler::entries() const {
+            std::vector<Entry const*> ret;
+            for(auto const& [name, entry] : entries_) {
+                ret.push_back(entry.get());
+            }
+            std::sort(ret.begin(), ret.end(), [] (Entry const* a, Entry const* b) {
+                if(a->samples != b->samples) {
+                    return a->samples > b->samples;
+                }
+                if(a->exclusive != b->exclusive) {
+                    return a->exclusive > b->exclusive;
+                }
+                return a->name < b->name;
+            });
+            return ret;
+        }
+
+        void Profiler::report(std::ostream& o) const {
+            auto const sorted = entries();
+            std::size_t width = 9;
+            for(auto entry : sorted) {
+                width = std::max(width, entry->name.size());
+            }
+            auto flags = o.flags();
+            auto precision = o.precision();
+            o << std::fixed << std::setprecision(3) << std::left;
+
+            if(Mode::Sampling == mode_) {
+                o << samples_ << " samples" << std::endl;
+                o << std::setw(static_cast<int>(width)) << "procedure" << std::right
+                  << std::setw(10) << "self" << std::setw(9) << "self %"
+                  << std::setw(10) << "total" << std::setw(9) << "total %" << std::endl;
+                for(auto entry : sorted) {
+                    o << std::left << std::setw(static_cast<int>(width)) << entry->name << std::right
+                      << std::setw(10) << entry->samples
+                      << std::setw(8) << std::setprecision(1) << percent(entry->samples, samples_) << '%'
+                      << std::setw(10) << entry->on_stack
+                      << std::setw(8) << percent(entry->on_stack, samples_) << '%' << std::endl;
+                }
+            } else {
+                auto total = clock::duration{0};
+                for(auto entry : sorted) {
+                    total += entry->exclusive;
+                }
+                o << std::setw(static_cast<int>(width)) << "procedure" << std::right
+                  << std::setw(12) << "calls" << std::setw(12) << "incl ms"
+                  << std::setw(12) << "excl ms" << std::setw(9) << "excl %"
+                  << std::setw(12) << "allocs" << std::setw(14) << "bytes" << std::endl;
+                for(auto entry : sorted) {
+                    o << std::left << std::setw(static_cast<int>(width)) << entry->name << std::right
+                      << std::setw(12) << entry->calls
+                      << std::setw(12) << std::setprecision(3) << to_ms(entry->inclusive)
+                      << std::setw(12) << to_ms(entry->exclusive)
+                      << std::setw(8) << std::setprecision(1)
+                      << percent(to_ms(entry->exclusive), to_ms(total)) << '%'
+                      << std::setw(12) << entry->allocations
+                      << std::setw(14) << entry->bytes << std::endl;
+                }
+            }
+            o.flags(flags);
+            o.precision(precision);
+        }
+
+        void Profiler::collapsed(std::ostream& o) const {
+            // depth first, without recursing; `path' holds the names from the
+            // root down to the node last visited
+            struct Pending {
+                Node const* node;
+                std::size_t next;   // child to visit next
+                std::size_t parent; // length of the path down to its parent
+                std::size_t own;    // and down to itself
+            };
+            std::string path;
+            std::vector<Pending> pending;
+            for(auto const& child : root_.children) {
+                pending.push_back({child.get(), 0, 0, 0});
+                while(!pending.empty()) {
+                    auto& top = pending.back();
+                    if(0 == top.next) {
+                        path.resize(top.parent);
+                        if(0 != top.parent) {
+                            path += ';';
+                        }
+                        path += top.node->entry->name;
+                        top.own = path.size();
+                        auto weight = (Mode::Sampling == mode_) ? top.node->samples
+                            : static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(top.node->exclusive).count());
+                        if(0 != weight) {
+                            o << path << ' ' << weight << '\n';
+                        }
+                    }
+                    if(top.next == top.node->children.size()) {
+                        pending.pop_back();
+                        continue;
+                    }
+                    auto child = top.node->children[top.next++].get();
+                    auto own = top.own;
+                    pending.push_back({child, 0, own, 0});
+                }
+            }
+            o << std::flush;
+        }
+    };
+};
@@ -0,0 +1,166 @@
+#ifndef __YASC_VM_PROFILER_H_
+#define __YASC_VM_PROFILER_H_
+
+#include <chrono>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace yasc {
+    namespace vm {
+        // what the VM spent its time on, per procedure. closures are known by
+        // the name of their code (the name they were defined with, `lambda'
+        // or `toplevel'), primitives by theirs.
+        //
+        // in Calls mode the VM reports every call and return, and each
+        // procedure is charged the time and the allocations between the two,
+        // less those of its callees. in Sampling mode a profiling timer
+        // (SIGPROF) asks for a sample, and the VM walks its frames at the
+        // next call or return; this costs next to nothing between samples,
+        // but only one sampling profiler may run at a time.
+        //
+        // both keep a tree of the call stacks seen, which collapsed() prints
+        // in the folded format flame graph tools read. a tail call replaces
+        // its caller there just as it does on the VM's stack.
+        class Profiler {
+        public:
+            enum class Mode {
+                Calls,
+                Sampling
+            };
+
+            using clock = std::chrono::steady_clock;
+
+            static constexpr std::chrono::microseconds default_interval{1000};
+
+            struct Entry {
+                std::string   name;
+                std::uint64_t calls       = 0;
+                clock::duration inclusive{0}; // outermost activations only
+                clock::duration exclusive{0};
+                std::uint64_t allocations = 0; // exclusive, as is bytes
+                std::uint64_t bytes       = 0;
+                std::uint64_t samples     = 0; // on top of the stack
+                std::uint64_t on_stack    = 0; // anywhere in it, once a sample
+
+                unsigned active = 0; // activations currently on the stack
+            };
+
+            Profiler() = default;
+            ~Profiler();
+
+            Profiler(Profiler const&) = delete;
+            Profiler& operator=(Profiler const&) = delete;
+
+            // starts profiling afresh, dropping what was collected before
+            void start(Mode mode, std::chrono::microseconds interval = default_interval);
+
+            // stops the sampling timer; what was collected is kept
+            void stop();
+
+            bool running() const {
+                return running_;
+            }
+
+            Mode mode() const {
+                return mode_;
+            }
+
+            // procedures by exclusive time (or samples), most first
+            std::vector<Entry const*> entries() const;
+
+            std::uint64_t samples() const {
+                return samples_;
+            }
+
+            // the flat report: a line per procedure
+            void report(std::ostream& o) const;
+
+            // a line per call stack seen, outermost procedure first, with its
+            // exclusive time in microseconds (or its samples)
+            void collapsed(std::ostream& o) const;
+
+            // called by the VM. in Calls mode enter() and leave() bracket
+            // every call; in Sampling mode they do nothing, and once due()
+            // the VM hands sample() the names on its stack, outermost first
+            void enter(std::string_view name) {
+                if(counting_) {
+                    count(name);
+                }
+            }
+
+            void leave() {
+                if(counting_) {
+                    uncount();
+                }
+            }
+
+            // forgets the calls above the outermost `depth', which an error
+            // unwound
+            void unwind(std::size_t depth);
+
+            std::size_t depth() const {
+                return open_.size();
+            }
+
+            bool due() const {
+                return 0 != pending_;
+            }
+
+            void sample(std::vector<std::string_view> const& stack);
+
+        private:
+            // a call stack, as a path from the root of the tree
+            struct Node {
+                Entry* entry;
+                std::vector<std::unique_ptr<Node>> children;
+                clock::duration exclusive{0};
+                std::uint64_t samples = 0;
+
+                Node* child(Entry* of);
+
+                // the callees seen from here are few, and looking one up by
+                // name beats hashing it
+                Node* child(std::string_view name);
+            };
+
+            // a call in progress
+            struct Open {
+                Node*             node;
+                clock::time_point start;
+                clock::duration   callees{0};
+                std::uint64_t     allocations;
+                std::uint64_t     bytes;
+                std::uint64_t     callee_allocations = 0;
+                std::uint64_t     callee_bytes       = 0;
+            };
+
+            void count(std::string_view name);
+            void uncount();
+
+            Entry* entry(std::string_view name);
+
+            static void on_signal(int);
+
+            static inline volatile std::sig_atomic_t pending_ = 0;
+
+            Mode mode_ = Mode::Calls;
+            bool running_ = false;
+            bool counting_ = false; // running in Calls mode
+
+            // keyed by views of the entries' own names
+            std::unordered_map<std::string_view, std::unique_ptr<Entry>> entries_;
+            Node root_{nullptr, {}};
+            std::vector<Open> open_;
+            std::uint64_t samples_ = 0;
+        };
+    };
+};
+
+#endif // __YASC_VM_PROFILER_H_
@@ -0,0 +1,540 @@
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "vm.h"
+#include "../error.h"
+#include "../ast/procedure.h"
+#include "../gc/heap.h"
+#include "../libscheme/arithmetic.h"
+
+#if defined(__GNUC__)
+#   define YASC_VM_COMPUTED_GOTO 1
+#else
+#   define YASC_VM_COMPUTED_GOTO 0
+#endif
+
+namespace {
+    // a call site specialized this many times has seen too many kinds of
+    // operands to be worth guarding, and stays generic
+    constexpr std::uint8_t max_rewrites = 4;
+
+    void const* handler(void* const* labels, yasc::vm::Opcode op) {
+        return (nullptr != labels) ? labels[static_cast<std::size_t>(op)] : nullptr;
+    }
+
+    // every call of two arguments is given a Site, in case it quickens
+    void thread(yasc::Code& code, void* const* labels) {
+        using yasc::vm::Opcode;
+        auto& threaded = code.threaded();
+        auto& sites    = code.sites();
+        threaded.reserve(code.size());
+        for(auto const& insn : code.instructions()) {
+            auto site = yasc::vm::no_site;
+            if((Opcode::Call == insn.op || Opcode::TailCall == insn.op)
+                    && 2 == insn.arg && sites.size() < yasc::vm::no_site) {
+                site = static_cast<std::uint16_t>(sites.size());
+                sites.emplace_back();
+            }
+            threaded.push_back({handler(labels, insn.op), insn.op, site, insn.arg});
+        }
+    }
+
+    // resolves the globals `code' refers to to their cells in `globals'.
+    // done again only when the code runs in another environment
+    void link(yasc::Code& code, yasc::Context& globals) {
+        auto& cells = code.cells();
+        cells.clear();
+        for(auto slot : code.globals()) {
+            cells.push_back(&globals.cell(slot));
+        }
+        code.set_linked(globals.stamp());
+    }
+
+    [[noreturn]] void unbound(yasc::GlobalCell const& cell) {
+        throw yasc::Error{"unbound variable `" + cell.name.name() + "'"};
+    }
+
+    thread_local yasc::vm::VM::Running running_now;
+}
+
+namespace yasc {
+    namespace vm {
+        Object VM::run(Object const& code, Context& globals) {
+            return apply(make_object<Closure>(code), Args{nullptr, 0}, globals);
+        }
+
+        Object VM::apply(Object const& proc, Args args, Context& globals) {
+            struct Current {
+                Running prev;
+                ~Current() {
+                    running_now = prev;
+                }
+            } current{running_now};
+            running_now = Running{this, &globals};
+
+            switch(proc.type()) {
+                case Value::Type::Closure:
+                    return execute(proc, args, globals);
+                case Value::Type::Procedure:
+                    return value_cast<Procedure*>(proc)->call(args);
+                default:
+                    throw Error{"attempt to call a non-procedure"};
+            }
+        }
+
+        VM::Running VM::running() {
+            return running_now;
+        }
+
+        Object VM::execute(Object closure, Args args, Context& globals) {
+#if YASC_VM_COMPUTED_GOTO
+            // must list the handlers in the order of Opcode
+            static void* const labels[] = {
+                &&op_Const,
+                &&op_Local,
+                &&op_Free,
+                &&op_Self,
+                &&op_Global,
+                &&op_DefineGlobal,
+                &&op_SetGlobal,
+                &&op_MakeClosure,
+                &&op_Call,
+                &&op_TailCall,
+                &&op_Return,
+                &&op_Jump,
+                &&op_JumpIfFalse,
+                &&op_Pop,
+                &&op_Assume,
+                &&op_CallQuick,
+                &&op_TailCallQuick
+            };
+#   define VM_OP(name) op_##name:
+#   define VM_NEXT() do { insn = ip++; goto *insn->handler; } while(0)
+#else
+            static void* const* const labels = nullptr;
+#   define VM_OP(name) case Opcode::name:
+#   define VM_NEXT() continue
+#endif
+
+            // run() may be re-entered from a primitive, so only ever unwind
+            // down to where this invocation started
+            auto const bottom_frame = frames_.size();
+            auto const bottom = std::size_t(top_);
+            auto const profiled = (nullptr != profiler_) ? profiler_->depth() : 0;
+
+            struct Unwind {
+                VM& vm;
+                std::size_t frames;
+                std::size_t top;
+                std::size_t profiled;
+                ~Unwind() {
+                    vm.frames_.resize(frames);
+                    vm.top_ = top;
+                    if(nullptr != vm.profiler_) {
+                        vm.profiler_->unwind(profiled);
+                    }
+                }
+            } unwind{*this, bottom_frame, bottom, profiled};
+
+            // the globals are a root of their own
+            gc::ScopedRoots roots{[this] (gc::Tracer& t) {
+                for(std::size_t i = 0; i < top_; ++i) {
+                    t(stack_[i]);
+                }
+                for(auto& frame : frames_) {
+                    t(frame.closure);
+                }
+            }};
+
+            Object*            sp;
+            Object*            fp;
+            Code*              code;
+            Object const*      consts;
+            Object const*      captured;
+            GlobalCell* const* cells;
+            Site*              sites;
+            Threaded const*    ip;
+            Threaded const*    insn;
+
+            // makes room for `slots' more values above `sp'
+            auto reserve = [&] (std::size_t slots) {
+                auto used = static_cast<std::size_t>(sp - stack_.data());
+                if(used + slots > stack_.size()) {
+                    auto frame = static_cast<std::size_t>(fp - stack_.data());
+                    stack_.resize(std::max(2 * stack_.size(), used + slots + 256));
+                    sp = stack_.data() + used;
+                    fp = stack_.data() + frame;
+                }
+            };
+
+            // the only point where a collection may happen; everything the
+            // VM holds is reachable from the stack and the frames
+            auto safepoint = [&] {
+                top_ = static_cast<std::size_t>(sp - stack_.data());
+                gc::safepoint();
+            };
+
+            // loads the registers, bar the instruction pointer, from the
+            // innermost frame. needed whenever a collection may have moved
+            // the running closure
+            auto reload = [&] {
+                auto const& frame = frames_.back();
+                auto closure = value_cast<Closure*>(frame.closure);
+                code     = closure->code();
+                if(code->linked() != globals.stamp()) {
+                    link(*code, globals);
+                }
+                consts   = code->constants().data();
+                cells    = code->cells().data();
+                sites    = code->sites().data();
+                captured = closure->captured();
+                fp       = stack_.data() + frame.base;
+            };
+
+            auto resume = [&] {
+                reload();
+                ip = frames_.back().ip;
+            };
+
+            // hands the profiler the names on the frame stack, outermost first
+            auto sample = [&] {
+                std::vector<std::string_view> stack;
+                stack.reserve(frames_.size());
+                for(auto const& frame : frames_) {
+                    stack.push_back(value_cast<Closure*>(frame.closure)->code()->name());
+                }
+                profiler_->sample(stack);
+            };
+
+            // calls a primitive with its arguments in place on the stack. it
+            // may re-enter run(), which can grow (and so move) the stack and
+            // collect under us
+            auto call_primitive = [&] (Object* callee, std::uint32_t argc) {
+                auto used = static_cast<std::size_t>(sp - stack_.data());
+                top_ = used;
+                auto proc = value_cast<Procedure*>(*callee);
+                if(nullptr != counter_) {
+                    counter_->enter(proc->primitive().name);
+                }
+                auto result = proc->call(Args{callee + 1, argc});
+                if(nullptr != counter_) {
+                    counter_->leave();
+                }
+                sp = stack_.data() + used;
+                reload();
+                return result;
+            };
+
+            // points the instruction `at' of the running code to the handler
+            // of `op' instead
+            auto rewrite = [&] (Threaded const* at, Opcode op) {
+                auto& insn   = code->threaded()[static_cast<std::size_t>(at - code->threaded().data())];
+                insn.op      = op;
+                insn.handler = handler(labels, op);
+            };
+
+            // specializes the call `at' of a primitive, whose two arguments
+            // follow `callee', to the level of the tower they are both on
+            auto quicken = [&] (Threaded const* at, Object const* callee, Opcode quick) {
+                auto& site = sites[at->site];
+                if(!quicken_ || max_rewrites == site.rewrites) {
+                    return;
+                }
+                auto kind = number_kind_of(callee[1]);
+                if(NumberKind::Count == kind || number_kind_of(callee[2]) != kind) {
+                    return;
+                }
+                auto const& prim = value_cast<Procedure*>(*callee)->primitive();
+                auto table = arithmetic::dispatch_table(prim);
+                if(nullptr == table) {
+                    // nothing to specialize it to, now or later
+                    site.rewrites = max_rewrites;
+                    return;
+                }
+                site.primitive = &prim;
+                site.fast      = arithmetic::specialization(*table, kind);
+                site.kind      = kind;
+                ++site.rewrites;
+                rewrite(at, quick);
+                ++stats_.quickened;
+            };
+
+            // whether the call after `callee' is still the one its site was
+            // specialized to
+            auto guard = [&] (Site const& site, Object const* callee) {
+                return Value::Type::Procedure == callee->type()
+                    && &value_cast<Procedure*>(*callee)->primitive() == site.primitive
+                    && number_kind_of(callee[1]) == site.kind
+                    && number_kind_of(callee[2]) == site.kind;
+            };
+
+            // a frame for `closure', whose first slot is at `base'. nesting
+            // is bounded so that runaway recursion is an error rather than
+            // the end of the process
+            auto push_frame = [&] (Object const& closure, Object* base) {
+                if(frames_.size() >= max_depth_) {
+                    throw Error{"stack overflow: more than " + std::to_string(max_depth_) + " nested calls"};
+                }
+                frames_.push_back({closure, nullptr, static_cast<std::size_t>(base - stack_.data())});
+            };
+
+            // starts running the innermost frame, whose arguments are in place.
+            // a sample the profiler asked for is taken here too
+            auto enter = [&] (std::uint32_t argc) {
+                safepoint();
+                resume();
+                if(nullptr != profiler_ && profiler_->due()) {
+                    sample();
+                }
+                if(argc != code->arity()) {
+                    throw Error{"wrong number of arguments to " + code->name()
+                        + ": expected " + std::to_string(code->arity())
+                        + ", got " + std::to_string(argc)};
+                }
+                if(code->threaded().empty()) {
+                    thread(*code, labels);
+                    sites = code->sites().data();
+                }
+                ip = code->threaded().data();
+                reserve(code->max_stack() - argc);
+            };
+
+            // the arguments may be in use further down our own stack, which
+            // making room can move
+            auto argv = args.begin();
+            auto const argc = args.size();
+            auto const on_stack = !stack_.empty() && argv >= stack_.data() && argv < stack_.data() + stack_.size();
+            auto const offset = on_stack ? static_cast<std::size_t>(argv - stack_.data()) : 0;
+            if(stack_.empty()) {
+                stack_.resize(1024);
+            }
+            sp = stack_.data() + bottom;
+            fp = sp;
+            reserve(1 + argc);
+            if(on_stack) {
+                argv = stack_.data() + offset;
+            }
+            auto callee = sp;
+            *sp++ = closure;
+            sp = std::copy(argv, argv + argc, sp);
+            push_frame(*callee, callee + 1);
+            enter(argc);
+            if(nullptr != counter_) {
+                counter_->enter(code->name());
+            }
+
+            auto result = Object{};
+
+#if YASC_VM_COMPUTED_GOTO
+            VM_NEXT();
+#else
+            for(;;) {
+                insn = ip++;
+                switch(insn->op) {
+#endif
+            VM_OP(Const) {
+                *sp++ = consts[insn->arg];
+                VM_NEXT();
+            }
+
+            VM_OP(Local) {
+                *sp++ = fp[insn->arg];
+                VM_NEXT();
+            }
+
+            VM_OP(Free) {
+                *sp++ = captured[insn->arg];
+                VM_NEXT();
+            }
+
+            // a frame's closure sits just below its first slot
+            VM_OP(Self) {
+                *sp++ = fp[-1];
+                VM_NEXT();
+            }
+
+            VM_OP(Global) {
+                auto const& val = cells[insn->arg]->value;
+                if(val.is_null()) {
+                    unbound(*cells[insn->arg]);
+                }
+                *sp++ = val;
+                VM_NEXT();
+            }
+
+            VM_OP(DefineGlobal) {
+                cells[insn->arg]->value = sp[-1];
+                globals.changed();
+                sp[-1] = Object::unspecified();
+                VM_NEXT();
+            }
+
+            VM_OP(SetGlobal) {
+                auto cell = cells[insn->arg];
+                if(cell->value.is_null()) {
+                    unbound(*cell);
+                }
+                cell->value = sp[-1];
+                globals.changed();
+                sp[-1] = Object::unspecified();
+                VM_NEXT();
+            }
+
+            VM_OP(MakeClosure) {
+                auto body = consts[insn->arg];
+                auto n    = value_cast<Code*>(body)->captures();
+                sp -= n;
+                *sp = make_object<Closure>(body, sp, n);
+                ++sp;
+                VM_NEXT();
+            }
+
+            VM_OP(Call) {
+            generic_call:
+                auto argc   = insn->arg;
+                auto callee = sp - argc - 1;
+                switch(callee->type()) {
+                    case Value::Type::Closure:
+                        frames_.back().ip = ip;
+                        push_frame(*callee, callee + 1);
+                        enter(argc);
+                        if(nullptr != counter_) {
+                            counter_->enter(code->name());
+                        }
+                        break;
+                    case Value::Type::Procedure: {
+                        if(no_site != insn->site) {
+                            quicken(insn, callee, Opcode::CallQuick);
+                        }
+                        auto value = call_primitive(callee, argc);
+                        sp -= argc + 1;
+                        *sp++ = value;
+                        break;
+                    }
+                    default:
+                        throw Error{"attempt to call a non-procedure"};
+                }
+                VM_NEXT();
+            }
+
+            VM_OP(TailCall) {
+            generic_tail_call:
+                auto argc   = insn->arg;
+                auto callee = sp - argc - 1;
+                switch(callee->type()) {
+                    case Value::Type::Closure:
+                        // slide the callee and its arguments over our frame
+                        sp = std::move(callee, sp, fp - 1);
+                        frames_.back().closure = fp[-1];
+                        if(nullptr != counter_) {
+                            counter_->leave();
+                        }
+                        enter(argc);
+                        if(nullptr != counter_) {
+                            counter_->enter(code->name());
+                        }
+                        VM_NEXT();
+                    case Value::Type::Procedure:
+                        if(no_site != insn->site) {
+                            quicken(insn, callee, Opcode::TailCallQuick);
+                        }
+                        result = call_primitive(callee, argc);
+                        goto do_return;
+                    default:
+                        throw Error{"attempt to call a non-procedure"};
+                }
+            }
+
+            VM_OP(Return) {
+                result = sp[-1];
+            do_return:
+                if(nullptr != counter_) {
+                    counter_->leave();
+                }
+                frames_.pop_back();
+                sp = fp - 1;
+                *sp++ = result;
+                if(frames_.size() == bottom_frame) {
+                    return result;
+                }
+                resume();
+                VM_NEXT();
+            }
+
+            VM_OP(Jump) {
+                ip = code->threaded().data() + insn->arg;
+                VM_NEXT();
+            }
+
+            VM_OP(JumpIfFalse) {
+                if(!(--sp)->is_true()) {
+                    ip = code->threaded().data() + insn->arg;
+                }
+                VM_NEXT();
+            }
+
+            VM_OP(Pop) {
+                --sp;
+                VM_NEXT();
+            }
+
+            VM_OP(Assume) {
+                auto const& assumption = code->assumptions()[insn->arg];
+                auto const& val = cells[assumption.global]->value;
+                *sp++ = Object::boolean(!val.is_null() && Value::Type::Procedure == val.type()
+                    && &value_cast<Procedure*>(val)->primitive() == assumption.primitive);
+                VM_NEXT();
+            }
+
+            // the specialized implementations allocate at most, they never
+            // reach a safepoint
+            VM_OP(CallQuick) {
+                auto callee = sp - 3;
+                auto const& site = sites[insn->site];
+                if(guard(site, callee)) {
+                    ++stats_.hits;
+                    if(nullptr != counter_) {
+                        counter_->enter(site.primitive->name);
+                    }
+                    *callee = site.fast(callee[1], callee[2]);
+                    if(nullptr != counter_) {
+                        counter_->leave();
+                    }
+                    sp = callee + 1;
+                    VM_NEXT();
+                }
+                ++stats_.misses;
+                rewrite(insn, Opcode::Call);
+                goto generic_call;
+            }
+
+            VM_OP(TailCallQuick) {
+                auto callee = sp - 3;
+                auto const& site = sites[insn->site];
+                if(guard(site, callee)) {
+                    ++stats_.hits;
+                    if(nullptr != counter_) {
+                        counter_->enter(site.primitive->name);
+                    }
+                    result = site.fast(callee[1], callee[2]);
+                    if(nullptr != counter_) {
+                        counter_->leave();
+                    }
+                    goto do_return;
+                }
+                ++stats_.misses;
+                rewrite(insn, Opcode::TailCall);
+                goto generic_tail_call;
+            }
+#if !YASC_VM_COMPUTED_GOTO
+                }
+            }
+#endif
+
+#undef VM_OP
+#undef VM_NEXT
+        }
+    };
+};
@@ -0,0 +1,113 @@
+#ifndef __YASC_VM_VM_H_
+#define __YASC_VM_VM_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include "../ast/value.h"
+#include "../ast/object.h"
+#include "../environment.h"
+#include "code.h"
+#include "profiler.h"
+
+namespace yasc {
+    namespace vm {
+        // how often quickened call sites found what they were specialized to
+        struct QuickeningStats {
+            std::uint64_t quickened = 0; // call sites rewritten, again or not
+            std::uint64_t hits      = 0; // calls whose guard held
+            std::uint64_t misses    = 0; // calls whose guard failed, reverting the site
+        };
+
+        inline std::ostream& operator<<(std::ostream& o, QuickeningStats const& stats) {
+            return o << "quickened " << stats.quickened << " call sites, "
+                     << stats.hits << " hits, " << stats.misses << " misses";
+        }
+
+        // a stack machine running Code produced by the Compiler. where the
+        // compiler supports it (gcc, clang) instructions are dispatched with
+        // computed gotos straight to their handlers.
+        //
+        // calls of two arguments quicken: the first time one calls an
+        // arithmetic primitive on two numbers of the same level it is
+        // rewritten into a guarded call straight to the primitive's
+        // implementation for that level, and back when the guard fails.
+        class VM {
+        public:
+            // frames live on a stack of the VM's own rather than on the C++
+            // stack, and tail calls reuse theirs; only this many calls
+            // that are not tail calls may be nested
+            static constexpr std::size_t default_max_depth = std::size_t{1} << 20;
+
+            explicit VM(bool quicken = true)
+                : quicken_{quicken}
+            {}
+
+            // beyond `depth' nested calls, a call throws an Error instead
+            void set_max_depth(std::size_t depth) {
+                max_depth_ = depth;
+            }
+
+            std::size_t max_depth() const {
+                return max_depth_;
+            }
+
+            // runs a Code of no arguments, as returned by Compiler::compile
+            Object run(Object const& code, Context& globals);
+
+            // calls `proc', a closure or a primitive, with `args' in
+            // `globals'; how primitives call back into scheme. `args' may be
+            // on this VM's stack
+            Object apply(Object const& proc, Args args, Context& globals);
+
+            // the VM innermost on this thread's C++ stack and the globals it
+            // runs in, for primitives that call back; null outside of one
+            struct Running {
+                VM*      vm      = nullptr;
+                Context* globals = nullptr;
+            };
+
+            static Running running();
+
+            QuickeningStats const& quickening() const {
+                return stats_;
+            }
+
+            // reports to `profiler', once it has been started, or to no one
+            // when null: every call and return in Calls mode, the frames
+            // at the next call once it asks for a sample otherwise. it must
+            // outlive the VM or be replaced first
+            void set_profiler(Profiler* profiler) {
+                profiler_ = profiler;
+                counter_  = (nullptr != profiler && Profiler::Mode::Calls == profiler->mode()) ? profiler : nullptr;
+            }
+
+        private:
+            Object execute(Object closure, Args args, Context& globals);
+
+            struct Frame {
+                Object          closure;
+                Threaded const* ip;   // where to resume once the callee returns
+                std::size_t     base; // index of the frame's first slot
+            };
+
+            std::vector<Object> stack_;
+            std::vector<Frame>  frames_;
+
+            // stack slots in use as of the last safepoint or primitive call
+            std::size_t top_ = 0;
+
+            std::size_t max_depth_ = default_max_depth;
+
+            bool quicken_;
+            QuickeningStats stats_;
+
+            Profiler* profiler_ = nullptr;
+            Profiler* counter_  = nullptr; // the profiler in Calls mode
+        };
+    };
+};
+
+#endif // __YASC_VM_VM_H_